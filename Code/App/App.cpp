@@ -1,8 +1,12 @@
 #include "App.h"
 
+#include <Sim/Benchmark.h>
 #include <Sim/World.h>
 
 #include <Core/Containers/UniquePtr.h>
+#include <Core/Mem/FrameArena.h>
+#include <Core/Mem/MemStats.h>
+#include <Core/Time/Timer.h>
 
 #include <imgui.h>
 
@@ -16,11 +20,86 @@ public:
     };
 
     Mode mMode = Mode::kTitle;
-    UniquePtr<World> mWorld;
+    UniquePtr<World, DeleteDeletor> mWorld;
+
+    // Used by World > New
+    int mErosionIterations = 100;
+
+    // Shown by Stats > Memory
+    bool mShowMemory = false;
+
+    // Since the last update
+    Timer mFrameTimer;
 };
 
 AppState* gAppState = nullptr;
 
+const uint32_t kNewWorldSize = 512;
+
+// Memory allocated in each category, live, to see which systems own its growth
+void AppRenderMemory()
+{
+    if (!ImGui::Begin("Memory", &gAppState->mShowMemory))
+    {
+        ImGui::End();
+        return;
+    }
+
+    // The main thread's counts are batched, other threads' lag by at most a batch
+    MemStats::FlushThreadCounters();
+    if (ImGui::Button("Reset Peaks"))
+    {
+        MemStats::ResetPeaks();
+    }
+
+    const float kMegabyte = 1024.0f * 1024.0f;
+    if (ImGui::BeginTable("Categories", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("MB");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableSetupColumn("Peak MB");
+        ImGui::TableSetupColumn("Budget MB");
+        ImGui::TableHeadersRow();
+
+        const uint32_t numCategories = MemStats::GetNumCategories();
+        for (uint32_t i = 0; i < numCategories; ++i)
+        {
+            const uint8_t category = (uint8_t)i;
+            MemStats::CategoryStats stats;
+            MemStats::GetStats(category, stats);
+            const bool overBudget = (stats.m_Budget != 0) && (stats.m_Bytes > stats.m_Budget);
+
+            ImGui::PushID(i);
+            ImGui::TableNextRow();
+            if (overBudget)
+            {
+                ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, IM_COL32(160, 40, 40, 255));
+            }
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(stats.m_Name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", (double)((float)stats.m_Bytes / kMegabyte));
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)stats.m_NumAllocs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", (double)((float)stats.m_PeakBytes / kMegabyte));
+            ImGui::TableNextColumn();
+
+            // 0 for no budget
+            float budget = (float)stats.m_Budget / kMegabyte;
+            ImGui::SetNextItemWidth(-1.0f);
+            if (ImGui::InputFloat("##Budget", &budget, 0.0f, 0.0f, "%.1f", ImGuiInputTextFlags_EnterReturnsTrue))
+            {
+                MemStats::SetBudget(category, (uint64_t)(Math::Max(budget, 0.0f) * kMegabyte));
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
 void AppInit()
 {
     gAppState = new AppState;
@@ -28,7 +107,15 @@ void AppInit()
 
 void AppUpdate()
 {
+    const float seconds = gAppState->mFrameTimer.GetElapsed();
+    gAppState->mFrameTimer.Start();
+    if (gAppState->mWorld.Get())
+    {
+        gAppState->mWorld->Update(seconds);
+    }
 
+    // Scratch memory from this tick is no longer needed
+    FrameArena::EndFrame();
 }
 
 void AppRenderUI()
@@ -41,8 +128,9 @@ void AppRenderUI()
             {
                 if (ImGui::MenuItem("New"))
                 {
-                    gAppState->mWorld = new World;
+                    gAppState->mWorld = new World(kNewWorldSize, kNewWorldSize, (uint32_t)gAppState->mErosionIterations);
                 }
+                ImGui::SliderInt("Erosion Iterations", &gAppState->mErosionIterations, 0, 1000);
                 if (ImGui::MenuItem("Load"))
                 {
 
@@ -53,13 +141,112 @@ void AppRenderUI()
                 }
                 ImGui::EndMenu();
             }
+            if (ImGui::BeginMenu("Benchmark"))
+            {
+                if (ImGui::MenuItem("Settlement LOD"))
+                {
+                    Benchmark::SettlementLod();
+                }
+                if (ImGui::MenuItem("Scheduled Events"))
+                {
+                    Benchmark::ScheduledEvents();
+                }
+                if (ImGui::MenuItem("Agents"))
+                {
+                    Benchmark::Agents();
+                }
+                if (ImGui::MenuItem("Job Assignment"))
+                {
+                    Benchmark::JobAssignment();
+                }
+                if (ImGui::MenuItem("Trade Network"))
+                {
+                    Benchmark::TradeNetwork();
+                }
+                if (ImGui::MenuItem("Road Network"))
+                {
+                    Benchmark::RoadNetwork();
+                }
+                if (ImGui::MenuItem("Land Regions"))
+                {
+                    Benchmark::Regions();
+                }
+                if (ImGui::MenuItem("Hydrology"))
+                {
+                    Benchmark::Hydrology();
+                }
+                if (ImGui::MenuItem("Erosion"))
+                {
+                    Benchmark::Erosion();
+                }
+                if (ImGui::MenuItem("Territory Cells"))
+                {
+                    Benchmark::TerritoryCells();
+                }
+                if (ImGui::MenuItem("Nav Mesh"))
+                {
+                    Benchmark::NavMesh();
+                }
+                if (ImGui::MenuItem("Nearest Sites"))
+                {
+                    Benchmark::NearestSites();
+                }
+                if (ImGui::MenuItem("Footprints"))
+                {
+                    Benchmark::Footprints();
+                }
+                if (ImGui::MenuItem("Hash Map"))
+                {
+                    Benchmark::HashMap();
+                }
+                if (ImGui::MenuItem("Small Allocations"))
+                {
+                    Benchmark::SmallAllocations();
+                }
+                if (ImGui::MenuItem("Array Growth"))
+                {
+                    Benchmark::ArrayGrowth();
+                }
+                if (ImGui::MenuItem("Sorting"))
+                {
+                    Benchmark::Sorting();
+                }
+                if (ImGui::MenuItem("Pooled Objects"))
+                {
+                    Benchmark::PooledObjects();
+                }
+                if (ImGui::MenuItem("Large Pages"))
+                {
+                    Benchmark::LargePages();
+                }
+                if (ImGui::MenuItem("Queues"))
+                {
+                    Benchmark::Queues();
+                }
+                if (ImGui::MenuItem("World"))
+                {
+                    Benchmark::World();
+                }
+                ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("Stats"))
+            {
+                ImGui::MenuItem("Memory", nullptr, &gAppState->mShowMemory);
+                ImGui::EndMenu();
+            }
             ImGui::EndMainMenuBar();
         }
     }
+
+    if (gAppState->mShowMemory)
+    {
+        AppRenderMemory();
+    }
 }
 
 void AppDone()
 {
     delete gAppState;
+    FrameArena::FreeThreadMemory();
 }
 
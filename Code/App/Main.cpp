@@ -7,11 +7,27 @@
 #include <SDL.h>
 #include <SDL_opengl.h>
 
+#include <Core/Mem/Mem.h>
+#include <Core/Mem/MemStats.h>
+
 #include <stdio.h>
 
 // Tell Windows we are DPI Aware so that it doesn't try to scale the app
 BOOL dpi_result = SetProcessDPIAware();
 
+// Dear ImGui's memory comes from the same allocator as the rest of the app, counted as UI
+static void* ImGuiAlloc(size_t size, void* user_data)
+{
+    const MemCategoryScope scope(*(const uint8_t*)user_data);
+    return ALLOC(size);
+}
+
+static void ImGuiFree(void* ptr, void* user_data)
+{
+    (void)user_data;
+    FREE(ptr);
+}
+
 // Main code
 int main(int argc, char*argv[])
 {
@@ -53,6 +69,8 @@ int main(int argc, char*argv[])
 
     // Setup Dear ImGui
     IMGUI_CHECKVERSION();
+    static const uint8_t ui_memory = MemStats::GetCategory("UI");
+    ImGui::SetAllocatorFunctions(ImGuiAlloc, ImGuiFree, (void*)&ui_memory);
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
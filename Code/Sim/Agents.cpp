@@ -0,0 +1,241 @@
+#include "Agents.h"
+
+#include <Sim/ParallelFor.h>
+
+#include <Core/Process/Atomic.h>
+
+#include <emmintrin.h>
+#include <string.h>
+
+namespace
+{
+    const size_t kAgentLanes = 4;
+    const size_t kAgentAlignment = 64;
+    const size_t kAgentMinCapacity = 1024;
+    const size_t kAgentChunkSize = 16 * 1024;
+    const float kAgentMinDistanceSq = 1e-12f;
+
+    template <class T>
+    void AgentResizeColumn(T*& column, size_t size, size_t capacity)
+    {
+        T* newColumn = static_cast<T*>(ALLOC(capacity * sizeof(T), kAgentAlignment));
+        if (column)
+        {
+            memcpy(newColumn, column, size * sizeof(T));
+            FREE(column);
+        }
+        memset(newColumn + size, 0, (capacity - size) * sizeof(T));
+        column = newColumn;
+    }
+
+    template <class T>
+    void AgentFreeColumn(T*& column)
+    {
+        FREE(column);
+        column = nullptr;
+    }
+
+    __m128 AgentSelect(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+}
+
+AgentStore::AgentStore()
+{
+}
+
+AgentStore::~AgentStore()
+{
+    AgentFreeColumn(mPosX);
+    AgentFreeColumn(mPosY);
+    AgentFreeColumn(mVelX);
+    AgentFreeColumn(mVelY);
+    AgentFreeColumn(mTargetX);
+    AgentFreeColumn(mTargetY);
+    AgentFreeColumn(mTimer);
+    AgentFreeColumn(mState);
+    AgentFreeColumn(mTaskId);
+    AgentFreeColumn(mCarried);
+    AgentFreeColumn(mCarriedResource);
+    AgentFreeColumn(mOwner);
+}
+
+uint32_t AgentStore::AddTask(const Task& task)
+{
+    mTasks.Append(task);
+    return (uint32_t)(mTasks.GetSize() - 1);
+}
+
+uint32_t AgentStore::Add(float x, float y, uint64_t owner)
+{
+    if (mSize == mCapacity)
+    {
+        Reserve(Math::Max(mCapacity * 2, kAgentMinCapacity));
+    }
+
+    const size_t agent = mSize++;
+    mPosX[agent] = x;
+    mPosY[agent] = y;
+    mTargetX[agent] = x;
+    mTargetY[agent] = y;
+    mOwner[agent] = owner;
+    return (uint32_t)agent;
+}
+
+void AgentStore::Remove(uint32_t agent)
+{
+    ASSERT(agent < mSize);
+    const size_t last = --mSize;
+    mPosX[agent] = mPosX[last];
+    mPosY[agent] = mPosY[last];
+    mVelX[agent] = mVelX[last];
+    mVelY[agent] = mVelY[last];
+    mTargetX[agent] = mTargetX[last];
+    mTargetY[agent] = mTargetY[last];
+    mTimer[agent] = mTimer[last];
+    mState[agent] = mState[last];
+    mTaskId[agent] = mTaskId[last];
+    mCarried[agent] = mCarried[last];
+    mCarriedResource[agent] = mCarriedResource[last];
+    mOwner[agent] = mOwner[last];
+
+    // The vacated lane is still ticked, so it must be idle
+    mState[last] = kIdle;
+    mVelX[last] = 0.0f;
+    mVelY[last] = 0.0f;
+}
+
+void AgentStore::Reserve(size_t capacity)
+{
+    capacity = Math::RoundUp(capacity, kAgentLanes);
+    if (capacity <= mCapacity)
+    {
+        return;
+    }
+    AgentResizeColumn(mPosX, mSize, capacity);
+    AgentResizeColumn(mPosY, mSize, capacity);
+    AgentResizeColumn(mVelX, mSize, capacity);
+    AgentResizeColumn(mVelY, mSize, capacity);
+    AgentResizeColumn(mTargetX, mSize, capacity);
+    AgentResizeColumn(mTargetY, mSize, capacity);
+    AgentResizeColumn(mTimer, mSize, capacity);
+    AgentResizeColumn(mState, mSize, capacity);
+    AgentResizeColumn(mTaskId, mSize, capacity);
+    AgentResizeColumn(mCarried, mSize, capacity);
+    AgentResizeColumn(mCarriedResource, mSize, capacity);
+    AgentResizeColumn(mOwner, mSize, capacity);
+    mCapacity = capacity;
+}
+
+void AgentStore::Assign(uint32_t agent, uint32_t task)
+{
+    ASSERT((agent < mSize) && (task < mTasks.GetSize()));
+    mTaskId[agent] = task;
+    mState[agent] = kToWork;
+    mTargetX[agent] = mTasks[task].mWorkX;
+    mTargetY[agent] = mTasks[task].mWorkY;
+}
+
+void AgentStore::Tick(float seconds)
+{
+    // Whole vectors only, the padding lanes are idle
+    const size_t count = Math::RoundUp(mSize, kAgentLanes);
+    ParallelFor(count, kAgentChunkSize, [this, seconds](size_t begin, size_t end)
+    {
+        TickRange(begin, end, seconds);
+    });
+}
+
+void AgentStore::TickRange(size_t begin, size_t end, float seconds)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 dt = _mm_set1_ps(seconds);
+    const __m128 speed = _mm_set1_ps(mSpeed);
+    const __m128 step = _mm_set1_ps(mSpeed * seconds);
+    const __m128 stepSq = _mm_mul_ps(step, step);
+    const __m128 minDistanceSq = _mm_set1_ps(kAgentMinDistanceSq);
+    const __m128i moveBit = _mm_set1_epi32(1);
+    const __m128i working = _mm_set1_epi32(kWorking);
+
+    for (size_t i = begin; i < end; i += kAgentLanes)
+    {
+        const __m128i state = _mm_load_si128(reinterpret_cast<const __m128i*>(mState + i));
+        const __m128 moving = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(state, moveBit), moveBit));
+
+        // Head straight for the target at full speed, stopping on it when within a step
+        const __m128 px = _mm_load_ps(mPosX + i);
+        const __m128 py = _mm_load_ps(mPosY + i);
+        const __m128 tx = _mm_load_ps(mTargetX + i);
+        const __m128 ty = _mm_load_ps(mTargetY + i);
+        const __m128 dx = _mm_sub_ps(tx, px);
+        const __m128 dy = _mm_sub_ps(ty, py);
+        const __m128 distanceSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        const __m128 arrived = _mm_and_ps(moving, _mm_cmple_ps(distanceSq, stepSq));
+        const __m128 walking = _mm_andnot_ps(arrived, moving);
+
+        const __m128 scale = _mm_and_ps(walking, _mm_mul_ps(speed, _mm_rsqrt_ps(_mm_max_ps(distanceSq, minDistanceSq))));
+        const __m128 vx = _mm_mul_ps(dx, scale);
+        const __m128 vy = _mm_mul_ps(dy, scale);
+        _mm_store_ps(mVelX + i, vx);
+        _mm_store_ps(mVelY + i, vy);
+        _mm_store_ps(mPosX + i, AgentSelect(arrived, tx, _mm_add_ps(px, _mm_mul_ps(vx, dt))));
+        _mm_store_ps(mPosY + i, AgentSelect(arrived, ty, _mm_add_ps(py, _mm_mul_ps(vy, dt))));
+
+        // Count down work
+        const __m128 isWorking = _mm_castsi128_ps(_mm_cmpeq_epi32(state, working));
+        const __m128 timer = _mm_sub_ps(_mm_load_ps(mTimer + i), _mm_and_ps(isWorking, dt));
+        _mm_store_ps(mTimer + i, timer);
+        const __m128 workDone = _mm_and_ps(isWorking, _mm_cmple_ps(timer, zero));
+
+        // State changes are rare and need the task, so they're handled a lane at a time
+        const int transitions = _mm_movemask_ps(_mm_or_ps(arrived, workDone));
+        if (transitions)
+        {
+            for (uint32_t lane = 0; lane < kAgentLanes; ++lane)
+            {
+                if (transitions & (1 << lane))
+                {
+                    Transition((uint32_t)(i + lane));
+                }
+            }
+        }
+    }
+}
+
+void AgentStore::Transition(uint32_t agent)
+{
+    const Task& task = mTasks[mTaskId[agent]];
+    switch (mState[agent])
+    {
+        case kToWork:
+        {
+            mState[agent] = kWorking;
+            mTimer[agent] = task.mWorkTime;
+            break;
+        }
+        case kWorking:
+        {
+            mState[agent] = kToHome;
+            mCarried[agent] = task.mYield;
+            mCarriedResource[agent] = task.mResource;
+            mTargetX[agent] = task.mHomeX;
+            mTargetY[agent] = task.mHomeY;
+            break;
+        }
+        case kToHome:
+        {
+            AtomicInc(&mDeliveries);
+            mState[agent] = kToWork;
+            mCarried[agent] = 0.0f;
+            mTargetX[agent] = task.mWorkX;
+            mTargetY[agent] = task.mWorkY;
+            break;
+        }
+        default:
+        {
+            ASSERT(false);
+            break;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Population agents (workers, soldiers, traders) stored as one aligned array per field,
+// so ticking them runs over contiguous memory four agents at a time. Agent indices are
+// not stable: removing an agent moves the last agent into its place.
+class AgentStore
+{
+public:
+    enum State : uint32_t
+    {
+        kIdle = 0,
+        kToWork = 1,        // Moving states are odd
+        kWorking = 2,
+        kToHome = 3,
+    };
+
+    // A work loop: walk to the work site, work, carry the yield home, repeat
+    struct Task
+    {
+        float mWorkX;
+        float mWorkY;
+        float mHomeX;
+        float mHomeY;
+        float mWorkTime;    // Seconds
+        float mYield;
+        uint32_t mResource;
+    };
+
+    AgentStore();
+    ~AgentStore();
+
+    AgentStore(const AgentStore&) = delete;
+    AgentStore& operator=(const AgentStore&) = delete;
+
+    uint32_t AddTask(const Task& task);
+    const Task& GetTask(uint32_t task) const { return mTasks[task]; }
+
+    uint32_t Add(float x, float y, uint64_t owner);
+    void Remove(uint32_t agent);
+    void Reserve(size_t capacity);
+
+    // Start the agent on a task, walking to work from wherever it is
+    void Assign(uint32_t agent, uint32_t task);
+
+    // Tiles per second
+    void SetSpeed(float speed) { mSpeed = speed; }
+
+    // Move on by one fixed step, World::kTickSeconds when ticked by the world
+    void Tick(float seconds);
+
+    size_t GetSize() const { return mSize; }
+    float GetX(uint32_t agent) const { return mPosX[agent]; }
+    float GetY(uint32_t agent) const { return mPosY[agent]; }
+    State GetState(uint32_t agent) const { return (State)mState[agent]; }
+    uint32_t GetTaskId(uint32_t agent) const { return mTaskId[agent]; }
+    float GetCarried(uint32_t agent) const { return mCarried[agent]; }
+    uint32_t GetCarriedResource(uint32_t agent) const { return mCarriedResource[agent]; }
+    uint64_t GetOwner(uint32_t agent) const { return mOwner[agent]; }
+
+    // Loads carried home since the store was created
+    uint64_t GetDeliveries() const { return mDeliveries; }
+
+private:
+    void TickRange(size_t begin, size_t end, float seconds);
+    void Transition(uint32_t agent);
+
+    size_t mSize = 0;
+    size_t mCapacity = 0;   // Always a whole number of vectors, unused lanes are idle
+
+    float* mPosX = nullptr;
+    float* mPosY = nullptr;
+    float* mVelX = nullptr;
+    float* mVelY = nullptr;
+    float* mTargetX = nullptr;
+    float* mTargetY = nullptr;
+    float* mTimer = nullptr;
+    uint32_t* mState = nullptr;
+    uint32_t* mTaskId = nullptr;
+    float* mCarried = nullptr;
+    uint32_t* mCarriedResource = nullptr;
+    uint64_t* mOwner = nullptr;
+
+    Array<Task> mTasks;
+    float mSpeed = 1.5f;
+    volatile uint64_t mDeliveries = 0;
+};
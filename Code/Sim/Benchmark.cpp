@@ -0,0 +1,2341 @@
+#include "Benchmark.h"
+
+#include <Sim/Agents.h>
+#include <Sim/Erosion.h>
+#include <Sim/Footprints.h>
+#include <Sim/Hydrology.h>
+#include <Sim/JobAssigner.h>
+#include <Sim/NavMesh.h>
+#include <Sim/NearestSites.h>
+#include <Sim/ParallelFor.h>
+#include <Sim/Regions.h>
+#include <Sim/RoadNetwork.h>
+#include <Sim/TerritoryCells.h>
+#include <Sim/TimingWheel.h>
+#include <Sim/TradeNetwork.h>
+#include <Sim/World.h>
+
+#include <Mathematics/ThreadSafeQueue.h>
+
+#include <Core/Containers/FlatHashMap.h>
+#include <Core/Containers/IntrusiveMPSCQueue.h>
+#include <Core/Containers/MPSCQueue.h>
+#include <Core/Containers/SPSCQueue.h>
+#include <Core/Containers/UnorderedMap.h>
+#include <Core/Math/Random.h>
+#include <Core/Mem/FrameArena.h>
+#include <Core/Mem/LargePages.h>
+#include <Core/Mem/Mem.h>
+#include <Core/Mem/MemStats.h>
+#include <Core/Mem/ObjectPool.h>
+#include <Core/Process/Thread.h>
+#include <Core/Strings/AStackString.h>
+#include <Core/Time/Timer.h>
+#include <Core/Tracing/Tracing.h>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    // Hashed value noise in [0, 1], interpolated between lattice points the given spacing apart
+    class BenchmarkValueNoise
+    {
+    public:
+        BenchmarkValueNoise(uint32_t size, uint32_t spacing, uint32_t seed)
+            : mSpacing(spacing)
+            , mLatticeSize(size / spacing + 2)
+        {
+            mLattice.SetSize((size_t)mLatticeSize * mLatticeSize);
+            for (uint32_t y = 0; y < mLatticeSize; ++y)
+            {
+                for (uint32_t x = 0; x < mLatticeSize; ++x)
+                {
+                    uint32_t h = (x * 0x8da6b343u) ^ (y * 0xd8163841u) ^ (seed * 0xcb1ab31fu);
+                    h ^= h >> 15;
+                    h *= 0x2c1b3c6du;
+                    h ^= h >> 12;
+                    mLattice[x + (size_t)mLatticeSize * y] = (float)(h & 0xFFFF) / 65535.0f;
+                }
+            }
+        }
+
+        float Get(uint32_t x, uint32_t y) const
+        {
+            const float* lattice = &mLattice[x / mSpacing + (size_t)mLatticeSize * (y / mSpacing)];
+            const float fx = (float)(x % mSpacing) / mSpacing;
+            const float fy = (float)(y % mSpacing) / mSpacing;
+            const float top = lattice[0] + (lattice[1] - lattice[0]) * fx;
+            const float bottom = lattice[mLatticeSize] + (lattice[mLatticeSize + 1] - lattice[mLatticeSize]) * fx;
+            return top + (bottom - top) * fy;
+        }
+
+    private:
+        uint32_t mSpacing;
+        uint32_t mLatticeSize;
+        Array<float> mLattice;
+    };
+
+    // Place a settlement at a random distance within [minDistance, maxDistance) of the focus
+    void BenchmarkPlaceSettlement(Settlement& settlement, Random& random, float minDistance, float maxDistance)
+    {
+        const float angle = random.GetRandFloat() * 6.2831853f;
+        const float distance = minDistance + random.GetRandFloat() * (maxDistance - minDistance);
+        settlement.mX = (uint32_t)(4096.0f + cosf(angle) * distance);
+        settlement.mY = (uint32_t)(4096.0f + sinf(angle) * distance);
+    }
+
+    double BenchmarkPolygonArea(const Array<TerritoryCells::Point>& points)
+    {
+        double area = 0.0;
+        for (size_t i = 0; i < points.GetSize(); ++i)
+        {
+            const TerritoryCells::Point& a = points[i];
+            const TerritoryCells::Point& b = points[(i + 1) % points.GetSize()];
+            area += (double)a.mX * b.mY - (double)b.mX * a.mY;
+        }
+        return area * 0.5;
+    }
+
+    // Whether a point is on a walkable tile, or on the edge or corner of one
+    bool BenchmarkIsClear(const ::NavMesh& navMesh, float x, float y)
+    {
+        const uint32_t tx = Math::Min((uint32_t)x, navMesh.GetWidth() - 1);
+        const uint32_t ty = Math::Min((uint32_t)y, navMesh.GetHeight() - 1);
+        for (uint32_t dy = 0; dy < 2; ++dy)
+        {
+            for (uint32_t dx = 0; dx < 2; ++dx)
+            {
+                if (((dx == 0) || ((x == (float)tx) && (tx > 0))) && ((dy == 0) || ((y == (float)ty) && (ty > 0))) && navMesh.IsWalkable(tx - dx, ty - dy))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // One thread of the small allocation benchmark. Blocks are allocated into its own list
+    // and freed from the list it's given, its own or another thread's.
+    class BenchmarkAllocThread
+    {
+    public:
+        static uint32_t AllocMain(void* userData)
+        {
+            BenchmarkAllocThread& thread = *(BenchmarkAllocThread*)userData;
+            const Timer timer;
+            for (uint32_t i = 0; i < thread.mNumBlocks; ++i)
+            {
+                thread.mBlocks[i] = ALLOC((*thread.mSizes)[i]);
+            }
+            thread.mMS = timer.GetElapsedMS();
+            return 0;
+        }
+
+        static uint32_t FreeMain(void* userData)
+        {
+            BenchmarkAllocThread& thread = *(BenchmarkAllocThread*)userData;
+            const Timer timer;
+            for (uint32_t i = 0; i < thread.mNumBlocks; ++i)
+            {
+                FREE(thread.mFreeBlocks[i]);
+            }
+            thread.mMS = timer.GetElapsedMS();
+            return 0;
+        }
+
+        // Allocating and freeing in turn, as short lived scratch allocations are
+        static uint32_t ChurnMain(void* userData)
+        {
+            BenchmarkAllocThread& thread = *(BenchmarkAllocThread*)userData;
+            const Timer timer;
+            for (uint32_t round = 0; round < thread.mNumRounds; ++round)
+            {
+                for (uint32_t i = 0; i < thread.mNumBlocks; ++i)
+                {
+                    thread.mBlocks[i] = ALLOC((*thread.mSizes)[i]);
+                }
+                for (uint32_t i = 0; i < thread.mNumBlocks; ++i)
+                {
+                    FREE(thread.mBlocks[i]);
+                }
+            }
+            thread.mMS = timer.GetElapsedMS();
+            return 0;
+        }
+
+        const Array<uint32_t>* mSizes = nullptr;
+        void** mBlocks = nullptr;
+        void** mFreeBlocks = nullptr;
+        uint32_t mNumBlocks = 0;
+        uint32_t mNumRounds = 0;
+        float mMS = 0.0f;
+    };
+
+    // Runs the threads to completion, returning the wall clock time
+    float BenchmarkRunThreads(Array<BenchmarkAllocThread>& threads, Thread::ThreadEntryFunction function)
+    {
+        const Timer timer;
+        Array<Thread::ThreadHandle> handles;
+        for (BenchmarkAllocThread& thread : threads)
+        {
+            handles.Append(Thread::CreateThread(function, "BenchmarkAlloc", 64 * 1024, &thread));
+        }
+        for (const Thread::ThreadHandle handle : handles)
+        {
+            Thread::WaitForThread(handle);
+            Thread::CloseHandle(handle);
+        }
+        return timer.GetElapsedMS();
+    }
+
+    // A plain record, as for land or buildings, which Array relocates as memory
+    struct BenchmarkRecord
+    {
+        uint32_t mId;
+        uint32_t mOwner;
+        float mX;
+        float mY;
+    };
+
+    // The same record with a move constructor of its own, so Array moves it one at a time
+    class BenchmarkMovedRecord
+    {
+    public:
+        explicit BenchmarkMovedRecord(const BenchmarkRecord& record)
+            : mRecord(record)
+        {
+        }
+        BenchmarkMovedRecord(const BenchmarkMovedRecord& other) = default;
+        BenchmarkMovedRecord(BenchmarkMovedRecord&& other)
+            : mRecord(other.mRecord)
+        {
+        }
+
+        BenchmarkRecord mRecord;
+    };
+
+    // Appends records one at a time, returning the time taken
+    template <class T>
+    float BenchmarkAppendRecords(Array<T>& records, uint32_t count)
+    {
+        const Timer timer;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const BenchmarkRecord record = { i, i & 0xFF, (float)i, (float)(count - i) };
+            records.Append(T(record));
+        }
+        return timer.GetElapsedMS();
+    }
+
+    // Fills records with random chunk IDs, as for agents to be grouped by chunk
+    void BenchmarkFillRecords(Array<BenchmarkRecord>& records, uint32_t count)
+    {
+        Random random(count);
+        records.SetSize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t chunk = (random.GetRand() << 5) ^ random.GetRand();
+            records[i] = { i, chunk, (float)chunk, 0.0f };
+        }
+    }
+
+    bool BenchmarkRecordChunkLess(const BenchmarkRecord& a, const BenchmarkRecord& b)
+    {
+        return a.mOwner < b.mOwner;
+    }
+
+    // A unit kept by pointer, as buildings and other units refer to it
+    struct BenchmarkUnit
+    {
+        float mX;
+        float mY;
+        float mVelX;
+        float mVelY;
+        uint64_t mOwner;
+        uint32_t mState;
+        uint32_t mPadding[9];
+    };
+
+    // Creates units, then several times destroys a random half and creates them again, as
+    // units are born and die over a session. Returns the time taken.
+    template <class CREATE, class DESTROY>
+    float BenchmarkChurnUnits(Array<BenchmarkUnit*>& units, uint32_t count, uint32_t rounds, const CREATE& create, const DESTROY& destroy)
+    {
+        const Timer timer;
+        Random random(count);
+        units.SetSize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            units[i] = create(i);
+        }
+        for (uint32_t round = 0; round < rounds; ++round)
+        {
+            for (uint32_t i = 0; i < count / 2; ++i)
+            {
+                BenchmarkUnit*& unit = units[random.GetRandIndex(count)];
+                if (unit)
+                {
+                    destroy(unit);
+                    unit = nullptr;
+                }
+            }
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (!units[i])
+                {
+                    units[i] = create(i);
+                }
+            }
+        }
+        return timer.GetElapsedMS();
+    }
+
+    void BenchmarkMoveUnit(BenchmarkUnit& unit)
+    {
+        unit.mX += unit.mVelX;
+        unit.mY += unit.mVelY;
+    }
+
+    // Reads the tiles around random points of a map, as agents and pathfinding look at the
+    // land around them. Returns the time taken.
+    float BenchmarkSampleLand(const Array<Land>& land, uint32_t size, uint32_t samples, float& outSum)
+    {
+        const Timer timer;
+        Random random(size);
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < samples; ++i)
+        {
+            const uint32_t x = 1 + random.GetRandIndex(size - 2);
+            const uint32_t y = 1 + random.GetRandIndex(size - 2);
+            const Land* centre = &land[x + (size_t)size * y];
+            sum += centre->mElevation + centre[-1].mForested + centre[1].mForested + centre[-(ptrdiff_t)size].mSoil + centre[size].mSoil;
+        }
+        outSum += sum;
+        return timer.GetElapsedMS();
+    }
+
+    // A command or event handed between threads, which links itself into an intrusive queue
+    struct BenchmarkQueueItem : public IntrusiveMPSCQueueNode
+    {
+        uint64_t mValue;
+    };
+
+    // Push and pop for each queue, so one benchmark runs them all
+    bool BenchmarkQueuePush(gte::ThreadSafeQueue<uint64_t>& queue, BenchmarkQueueItem& item)
+    {
+        return queue.Push(item.mValue);
+    }
+    bool BenchmarkQueuePop(gte::ThreadSafeQueue<uint64_t>& queue, uint64_t& value)
+    {
+        return queue.Pop(value);
+    }
+    bool BenchmarkQueuePush(MPSCQueue<uint64_t>& queue, BenchmarkQueueItem& item)
+    {
+        return queue.Push(item.mValue);
+    }
+    bool BenchmarkQueuePop(MPSCQueue<uint64_t>& queue, uint64_t& value)
+    {
+        return queue.Pop(value);
+    }
+    bool BenchmarkQueuePush(SPSCQueue<uint64_t>& queue, BenchmarkQueueItem& item)
+    {
+        return queue.Push(item.mValue);
+    }
+    bool BenchmarkQueuePop(SPSCQueue<uint64_t>& queue, uint64_t& value)
+    {
+        return queue.Pop(value);
+    }
+    bool BenchmarkQueuePush(IntrusiveMPSCQueue<BenchmarkQueueItem>& queue, BenchmarkQueueItem& item)
+    {
+        queue.Push(&item);
+        return true;
+    }
+    bool BenchmarkQueuePop(IntrusiveMPSCQueue<BenchmarkQueueItem>& queue, uint64_t& value)
+    {
+        const BenchmarkQueueItem* item = queue.Pop();
+        if (item)
+        {
+            value = item->mValue;
+        }
+        return (item != nullptr);
+    }
+
+    template <class Queue>
+    class BenchmarkQueueProducer
+    {
+    public:
+        // Pushes its items, numbered in the low bits, waiting while the queue is full
+        static uint32_t ThreadMain(void* userData)
+        {
+            BenchmarkQueueProducer& producer = *(BenchmarkQueueProducer*)userData;
+            for (uint32_t i = 0; i < producer.mNumItems; ++i)
+            {
+                BenchmarkQueueItem& item = producer.mItems[i];
+                item.mValue = ((uint64_t)producer.mIndex << 32) | i;
+                while (!BenchmarkQueuePush(*producer.mQueue, item))
+                {
+                    Thread::Sleep(0);
+                }
+            }
+            return 0;
+        }
+
+        Queue* mQueue = nullptr;
+        BenchmarkQueueItem* mItems = nullptr;
+        uint32_t mIndex = 0;
+        uint32_t mNumItems = 0;
+    };
+
+    // Producer threads pushing to the calling thread until it's popped all their items,
+    // returning the wall clock time. Counts items popped out of each producer's order.
+    template <class Queue>
+    float BenchmarkRunQueue(Queue& queue, Array<BenchmarkQueueItem>& items, uint32_t numProducers, uint32_t numItems, uint32_t& outOfOrder)
+    {
+        Array<BenchmarkQueueProducer<Queue>> producers;
+        producers.SetSize(numProducers);
+        Array<uint32_t> expected;
+        expected.SetSize(numProducers);
+
+        const Timer timer;
+        Array<Thread::ThreadHandle> handles;
+        for (uint32_t p = 0; p < numProducers; ++p)
+        {
+            producers[p].mQueue = &queue;
+            producers[p].mItems = &items[(size_t)p * numItems];
+            producers[p].mIndex = p;
+            producers[p].mNumItems = numItems;
+            expected[p] = 0;
+            handles.Append(Thread::CreateThread(BenchmarkQueueProducer<Queue>::ThreadMain, "BenchmarkQueue", 64 * 1024, &producers[p]));
+        }
+        const uint64_t total = (uint64_t)numProducers * numItems;
+        for (uint64_t popped = 0; popped < total;)
+        {
+            uint64_t value;
+            if (BenchmarkQueuePop(queue, value))
+            {
+                const uint32_t p = (uint32_t)(value >> 32);
+                outOfOrder += ((uint32_t)value != expected[p]);
+                expected[p] = (uint32_t)value + 1;
+                ++popped;
+            }
+            else
+            {
+                Thread::Sleep(0);
+            }
+        }
+        const float ms = timer.GetElapsedMS();
+        for (const Thread::ThreadHandle handle : handles)
+        {
+            Thread::WaitForThread(handle);
+            Thread::CloseHandle(handle);
+        }
+        return ms;
+    }
+
+    // Plain Dijkstra over a list of roads, to check and compare against the road network.
+    // Heap items are the cost's bits above the node, positive floats sort as their bits.
+    float BenchmarkRoadDijkstra(const Array<uint32_t>& roadStart, const Array<uint32_t>& roadTo, const Array<float>& roadCost, uint32_t from, uint32_t to)
+    {
+        Array<float> costs;
+        costs.SetSize(roadStart.GetSize() - 1);
+        for (float& cost : costs)
+        {
+            cost = FLT_MAX;
+        }
+        Array<uint64_t> heap;
+        costs[from] = 0.0f;
+        heap.Append(from);
+        while (!heap.IsEmpty())
+        {
+            const uint32_t node = (uint32_t)heap[0];
+            const uint32_t bits = (uint32_t)(heap[0] >> 32);
+            const uint64_t last = heap.Top();
+            heap.Pop();
+            size_t i = 0;
+            for (size_t child = 1; child < heap.GetSize(); child = i * 2 + 1)
+            {
+                child += ((child + 1) < heap.GetSize()) && (heap[child + 1] < heap[child]);
+                if (last <= heap[child])
+                {
+                    break;
+                }
+                heap[i] = heap[child];
+                i = child;
+            }
+            if (!heap.IsEmpty())
+            {
+                heap[i] = last;
+            }
+
+            float cost;
+            memcpy(&cost, &bits, sizeof(cost));
+            if (cost > costs[node])
+            {
+                continue;
+            }
+            if (node == to)
+            {
+                return cost;
+            }
+            for (uint32_t road = roadStart[node]; road < roadStart[node + 1]; ++road)
+            {
+                const float next = cost + roadCost[road];
+                if (next < costs[roadTo[road]])
+                {
+                    costs[roadTo[road]] = next;
+                    uint32_t nextBits;
+                    memcpy(&nextBits, &next, sizeof(nextBits));
+                    const uint64_t item = ((uint64_t)nextBits << 32) | roadTo[road];
+                    size_t j = heap.GetSize();
+                    heap.Append(item);
+                    for (; (j > 0) && (item < heap[(j - 1) / 2]); j = (j - 1) / 2)
+                    {
+                        heap[j] = heap[(j - 1) / 2];
+                    }
+                    heap[j] = item;
+                }
+            }
+        }
+        return FLT_MAX;
+    }
+
+    class BenchmarkTimerCounter : public TimerHandler
+    {
+    public:
+        void OnTimers(uint64_t /*tick*/, const Array<uint64_t>& payloads) override
+        {
+            mBatches++;
+            mFired += payloads.GetSize();
+            for (uint64_t payload : payloads)
+            {
+                mChecksum += payload;
+            }
+        }
+
+        uint64_t mBatches = 0;
+        uint64_t mFired = 0;
+        uint64_t mChecksum = 0;
+    };
+}
+
+void Benchmark::SettlementLod()
+{
+    struct Mix
+    {
+        const char* mName;
+        float mNear;
+        float mMid; // The rest are far
+    };
+    const Mix mixes[] =
+    {
+        { "all full", 1.0f, 0.0f },
+        { "10/30/60", 0.1f, 0.3f },
+        { "1/9/90", 0.01f, 0.09f },
+        { "all far", 0.0f, 0.0f },
+    };
+    const uint32_t counts[] = { 1000, 4000, 16000, 64000 };
+    const uint32_t kBuildingsPerSettlement = 8;
+    const uint32_t kTicks = 256;
+
+    SettlementSim sim;
+    sim.SetFocus(4096.0f, 4096.0f);
+    const Array<SettlementSim::Tier>& tiers = sim.GetTiers();
+
+    OUTPUT("SettlementLod: tiers");
+    for (const SettlementSim::Tier& tier : tiers)
+    {
+        OUTPUT(" [%s every %u]", tier.mAggregated ? "aggregated" : "full", tier.mTickInterval);
+    }
+    OUTPUT("\n%-10s %8s %12s %12s\n", "Mix", "Count", "us/tick", "ns/settle");
+
+    for (const Mix& mix : mixes)
+    {
+        for (uint32_t count : counts)
+        {
+            Random random(count);
+            Array<Settlement> settlements;
+            settlements.SetSize(count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                Settlement& settlement = settlements[i];
+                settlement.mId = i + 1;
+                settlement.mPopulation = 100.0f;
+                settlement.mFood = 100.0f;
+                settlement.mLastTick = sim.GetTick();
+                for (uint32_t b = 0; b < kBuildingsPerSettlement; ++b)
+                {
+                    Building& building = settlement.mBuildings.EmplaceBack();
+                    building.mWorkers = 1 + (b & 3);
+                    building.mFoodPerWorker = (b & 1) ? 0.2f : 0.0f;
+                    building.mWoodPerWorker = (b & 1) ? 0.0f : 0.1f;
+                }
+
+                const float r = (float)i / (float)count;
+                if (r < mix.mNear)
+                {
+                    BenchmarkPlaceSettlement(settlement, random, 0.0f, tiers[0].mMaxDistance);
+                }
+                else if (r < mix.mNear + mix.mMid)
+                {
+                    BenchmarkPlaceSettlement(settlement, random, tiers[0].mMaxDistance + 1.0f, tiers[1].mMaxDistance);
+                }
+                else
+                {
+                    BenchmarkPlaceSettlement(settlement, random, tiers[1].mMaxDistance + 1.0f, 4000.0f);
+                }
+            }
+
+            // Settle into tiers before timing
+            sim.Tick(settlements);
+
+            const Timer timer;
+            for (uint32_t t = 0; t < kTicks; ++t)
+            {
+                sim.Tick(settlements);
+            }
+            const float us = timer.GetElapsedMS() * 1000.0f / (float)kTicks;
+            OUTPUT("%-10s %8u %12.1f %12.1f\n", mix.mName, count, (double)us, (double)(us * 1000.0f / (float)count));
+        }
+    }
+}
+
+void Benchmark::ScheduledEvents()
+{
+    const uint32_t kTimers = 10 * 1000 * 1000;
+    const uint32_t kMaxDelay = 1 << 17; // Spans the first three levels of the wheel
+    const uint16_t kTypes = 4;
+    const uint32_t kCancelEvery = 10;
+
+    TimingWheel wheel;
+    BenchmarkTimerCounter counters[kTypes];
+    for (uint16_t type = 0; type < kTypes; ++type)
+    {
+        wheel.SetHandler(type, &counters[type]);
+    }
+    wheel.Reserve(kTimers);
+
+    Random random(kTimers);
+    Array<TimingWheel::Handle> handles;
+    handles.SetCapacity(kTimers / kCancelEvery + 1);
+
+    Timer timer;
+    for (uint32_t i = 0; i < kTimers; ++i)
+    {
+        const uint32_t delay = ((random.GetRand() << 15) | random.GetRand()) & (kMaxDelay - 1);
+        const TimingWheel::Handle handle = wheel.Schedule((uint16_t)(i % kTypes), delay, i);
+        if ((i % kCancelEvery) == 0)
+        {
+            handles.Append(handle);
+        }
+    }
+    const float scheduleMS = timer.GetElapsedMS();
+
+    timer.Start();
+    for (TimingWheel::Handle handle : handles)
+    {
+        wheel.Cancel(handle);
+    }
+    const float cancelMS = timer.GetElapsedMS();
+    const size_t pending = wheel.GetNumPending();
+
+    float worstTickMS = 0.0f;
+    timer.Start();
+    while (wheel.GetNumPending())
+    {
+        const Timer tickTimer;
+        wheel.Advance();
+        worstTickMS = Math::Max(worstTickMS, tickTimer.GetElapsedMS());
+    }
+    const float advanceMS = timer.GetElapsedMS();
+
+    uint64_t fired = 0;
+    uint64_t batches = 0;
+    for (const BenchmarkTimerCounter& counter : counters)
+    {
+        fired += counter.mFired;
+        batches += counter.mBatches;
+    }
+
+    OUTPUT("ScheduledEvents: %u timers, delays up to %u ticks, %u types\n", kTimers, kMaxDelay, kTypes);
+    OUTPUT("  schedule %8.1f ms %8.1f ns/timer\n", (double)scheduleMS, (double)(scheduleMS * 1e6f / (float)kTimers));
+    OUTPUT("  cancel   %8.1f ms %8.1f ns/timer (%u cancelled)\n", (double)cancelMS, (double)(cancelMS * 1e6f / (float)handles.GetSize()), (uint32_t)handles.GetSize());
+    OUTPUT("  advance  %8.1f ms %8.1f ns/fired (%llu ticks, %llu fired of %llu, %llu batches, worst tick %.2f ms)\n",
+           (double)advanceMS, (double)(advanceMS * 1e6f / (float)fired), (unsigned long long)wheel.GetTick(),
+           (unsigned long long)fired, (unsigned long long)pending, (unsigned long long)batches, (double)worstTickMS);
+}
+
+void Benchmark::Agents()
+{
+    const uint32_t kAgents = 1000 * 1000;
+    const uint32_t kSettlements = 1000;
+    const uint32_t kTasksPerSettlement = 8;
+    const uint32_t kTicks = 200;
+    const float kTickSeconds = ::World::kTickSeconds;
+    const float kWorldSize = 8192.0f;
+
+    AgentStore agents;
+    agents.Reserve(kAgents);
+    Random random(kAgents);
+    for (uint32_t s = 0; s < kSettlements; ++s)
+    {
+        const float homeX = random.GetRandFloat() * kWorldSize;
+        const float homeY = random.GetRandFloat() * kWorldSize;
+        for (uint32_t t = 0; t < kTasksPerSettlement; ++t)
+        {
+            AgentStore::Task task;
+            task.mHomeX = homeX;
+            task.mHomeY = homeY;
+            task.mWorkX = homeX + (random.GetRandFloat() - 0.5f) * 64.0f;
+            task.mWorkY = homeY + (random.GetRandFloat() - 0.5f) * 64.0f;
+            task.mWorkTime = 2.0f + random.GetRandFloat() * 8.0f;
+            task.mYield = 1.0f;
+            task.mResource = t & 1;
+            agents.AddTask(task);
+        }
+    }
+    for (uint32_t i = 0; i < kAgents; ++i)
+    {
+        const uint32_t settlement = i % kSettlements;
+        const uint32_t task = settlement * kTasksPerSettlement + random.GetRandIndex(kTasksPerSettlement);
+        const AgentStore::Task& t = agents.GetTask(task);
+        const uint32_t agent = agents.Add(t.mHomeX, t.mHomeY, settlement + 1);
+        agents.Assign(agent, task);
+    }
+
+    float worstMS = 0.0f;
+    const Timer timer;
+    for (uint32_t t = 0; t < kTicks; ++t)
+    {
+        const Timer tickTimer;
+        agents.Tick(kTickSeconds);
+        worstMS = Math::Max(worstMS, tickTimer.GetElapsedMS());
+    }
+    const float ms = timer.GetElapsedMS() / (float)kTicks;
+
+    OUTPUT("Agents: %u agents, %u ticks at 20 Hz on %u threads\n", kAgents, kTicks, ParallelForGetNumThreads());
+    OUTPUT("  %.2f ms/tick (worst %.2f ms), %.1f%% of the tick interval, %.2f ns/agent, %llu deliveries\n",
+           (double)ms, (double)worstMS, (double)(ms * 100.0f / (kTickSeconds * 1000.0f)), (double)(ms * 1e6f / (float)kAgents),
+           (unsigned long long)agents.GetDeliveries());
+}
+
+void Benchmark::JobAssignment()
+{
+    const uint32_t counts[] = { 1000, 4000, 16000, 64000, 100000 };
+    const uint32_t kSlotsPerJob = 4;
+    const float kWorldSize = 4096.0f;
+    const uint32_t kRepeats = 4;
+
+    OUTPUT("JobAssignment: %u slots per job, %u threads\n", kSlotsPerJob, ParallelForGetNumThreads());
+    OUTPUT("%8s %8s %10s %10s %8s %8s %10s %10s\n", "Workers", "Jobs", "us", "ns/worker", "Rounds", "Filled", "Greedy", "Auction");
+
+    JobAssigner assigner;
+    for (uint32_t count : counts)
+    {
+        // Jobs and workers both scale, keeping the world the same size
+        Random random(count);
+        assigner.Clear();
+        const uint32_t numJobs = count / kSlotsPerJob;
+        for (uint32_t i = 0; i < numJobs; ++i)
+        {
+            assigner.AddJob(i, random.GetRandFloat() * kWorldSize, random.GetRandFloat() * kWorldSize, kSlotsPerJob, (i % 8) ? 0 : 1);
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            assigner.AddWorker(i, random.GetRandFloat() * kWorldSize, random.GetRandFloat() * kWorldSize, (i % 4) ? 0 : 1);
+        }
+
+        const Timer timer;
+        for (uint32_t r = 0; r < kRepeats; ++r)
+        {
+            assigner.Solve();
+        }
+        const float us = timer.GetElapsedMS() * 1000.0f / (float)kRepeats;
+
+        const size_t filled = assigner.GetAssignedWorkers().GetSize();
+        OUTPUT("%8u %8u %10.1f %10.1f %8u %8u %10.1f %10.1f\n", count, numJobs, (double)us, (double)(us * 1000.0f / (float)count),
+               assigner.GetRounds(), (uint32_t)filled, (double)(assigner.GetGreedyDistance() / (float)filled), (double)(assigner.GetDistance() / (float)filled));
+    }
+}
+
+void Benchmark::TradeNetwork()
+{
+    const uint32_t kSettlements = 5000;
+    const uint32_t kRoadsPerSettlement = 3;
+    const float kWorldSize = 8192.0f;
+    const uint32_t kChanges = 16;
+
+    // Settlements joined by roads to their nearest neighbours
+    Random random(kSettlements);
+    Array<float> xs;
+    Array<float> ys;
+    Array<uint32_t> roads; // Pairs of settlements
+    ::TradeNetwork network;
+    network.Reserve(kSettlements);
+    for (uint32_t i = 0; i < kSettlements; ++i)
+    {
+        xs.Append(random.GetRandFloat() * kWorldSize);
+        ys.Append(random.GetRandFloat() * kWorldSize);
+        network.AddNode(i + 1);
+    }
+    auto roadCost = [&](uint32_t a, uint32_t b)
+    {
+        const float dx = xs[a] - xs[b];
+        const float dy = ys[a] - ys[b];
+        return sqrtf(dx * dx + dy * dy);
+    };
+    for (uint32_t a = 0; a < kSettlements; ++a)
+    {
+        uint32_t nearest[kRoadsPerSettlement];
+        float nearestCost[kRoadsPerSettlement];
+        for (uint32_t k = 0; k < kRoadsPerSettlement; ++k)
+        {
+            nearest[k] = a;
+            nearestCost[k] = FLT_MAX;
+        }
+        for (uint32_t b = 0; b < kSettlements; ++b)
+        {
+            const float cost = roadCost(a, b);
+            if ((b == a) || (cost >= nearestCost[kRoadsPerSettlement - 1]))
+            {
+                continue;
+            }
+            uint32_t k = kRoadsPerSettlement - 1;
+            while ((k > 0) && (cost < nearestCost[k - 1]))
+            {
+                nearest[k] = nearest[k - 1];
+                nearestCost[k] = nearestCost[k - 1];
+                --k;
+            }
+            nearest[k] = b;
+            nearestCost[k] = cost;
+        }
+        for (uint32_t k = 0; k < kRoadsPerSettlement; ++k)
+        {
+            network.SetEdge(a, nearest[k], nearestCost[k]);
+            roads.Append(a);
+            roads.Append(nearest[k]);
+        }
+    }
+
+    Timer timer;
+    uint32_t numRun = network.Update();
+    OUTPUT("TradeNetwork: %u settlements, %u threads, %.1f MB of costs\n", kSettlements, ParallelForGetNumThreads(), (double)network.GetMemoryUsed() / (1024.0 * 1024.0));
+    OUTPUT("  full build        %10.1f ms %6u sources\n", (double)timer.GetElapsedMS(), numRun);
+
+    // Terrain making single roads dearer or cheaper, then settlements coming and going
+    struct Change
+    {
+        const char* mName;
+        float mScale;
+    };
+    const Change changes[] = { { "road dearer", 1.5f }, { "road cheaper", 0.5f } };
+    for (const Change& change : changes)
+    {
+        float ms = 0.0f;
+        uint32_t sources = 0;
+        for (uint32_t i = 0; i < kChanges; ++i)
+        {
+            const uint32_t road = random.GetRandIndex((uint32_t)roads.GetSize() / 2);
+            const uint32_t a = roads[road * 2];
+            const uint32_t b = roads[road * 2 + 1];
+            const float cost = roadCost(a, b) * change.mScale;
+            timer.Start();
+            network.SetEdge(a, b, cost);
+            sources += network.Update();
+            ms += timer.GetElapsedMS();
+        }
+        OUTPUT("  %-17s %10.2f ms %6u sources (mean of %u)\n", change.mName, (double)(ms / kChanges), sources / kChanges, kChanges);
+    }
+
+    float removeMS = 0.0f;
+    float addMS = 0.0f;
+    uint32_t removeSources = 0;
+    uint32_t addSources = 0;
+    for (uint32_t i = 0; i < kChanges; ++i)
+    {
+        const uint32_t node = random.GetRandIndex(kSettlements);
+        timer.Start();
+        network.RemoveNode(node);
+        removeSources += network.Update();
+        removeMS += timer.GetElapsedMS();
+
+        // A new settlement on a road to its old neighbour
+        const uint32_t neighbour = (node + 1) % kSettlements;
+        timer.Start();
+        const uint32_t added = network.AddNode(kSettlements + i + 1);
+        network.SetEdge(added, neighbour, roadCost(node, neighbour));
+        addSources += network.Update();
+        addMS += timer.GetElapsedMS();
+    }
+    OUTPUT("  remove settlement %10.2f ms %6u sources (mean of %u)\n", (double)(removeMS / kChanges), removeSources / kChanges, kChanges);
+    OUTPUT("  add settlement    %10.2f ms %6u sources (mean of %u)\n", (double)(addMS / kChanges), addSources / kChanges, kChanges);
+}
+
+void Benchmark::RoadNetwork()
+{
+    const uint32_t kGridSize = 256;
+    const uint32_t kSpacing = 32;
+    const uint32_t kQueries = 10000;
+    const uint32_t kChecks = 32;
+    const uint32_t kChanges = 8;
+
+    // Junctions on a jittered grid, most joined to their neighbours by roads of varying quality
+    Random random(kGridSize);
+    ::RoadNetwork network;
+    for (uint32_t y = 0; y < kGridSize; ++y)
+    {
+        for (uint32_t x = 0; x < kGridSize; ++x)
+        {
+            network.AddJunction(x * kSpacing + random.GetRandIndex(kSpacing / 2), y * kSpacing + random.GetRandIndex(kSpacing / 2));
+        }
+    }
+    Array<uint32_t> roads; // Pairs of junctions
+    Array<float> roadCosts;
+    auto buildRoad = [&](uint32_t a, uint32_t b)
+    {
+        const float dx = (float)network.GetJunctionX(a) - (float)network.GetJunctionX(b);
+        const float dy = (float)network.GetJunctionY(a) - (float)network.GetJunctionY(b);
+        const float cost = sqrtf(dx * dx + dy * dy) * (1.0f + random.GetRandFloat());
+        network.BuildRoad(a, b, cost);
+        roads.Append(a);
+        roads.Append(b);
+        roadCosts.Append(cost);
+    };
+    for (uint32_t y = 0; y < kGridSize; ++y)
+    {
+        for (uint32_t x = 0; x < kGridSize; ++x)
+        {
+            const uint32_t junction = x + y * kGridSize;
+            if ((x + 1 < kGridSize) && (random.GetRandIndex(8) != 0))
+            {
+                buildRoad(junction, junction + 1);
+            }
+            if ((y + 1 < kGridSize) && (random.GetRandIndex(8) != 0))
+            {
+                buildRoad(junction, junction + kGridSize);
+            }
+            if ((x + 1 < kGridSize) && (y + 1 < kGridSize) && (random.GetRandIndex(8) == 0))
+            {
+                buildRoad(junction, junction + kGridSize + 1);
+            }
+        }
+    }
+
+    Array<uint32_t> roadStart;
+    Array<uint32_t> roadTo;
+    Array<float> roadCost;
+    auto flattenRoads = [&]()
+    {
+        const uint32_t numJunctions = network.GetNumJunctions();
+        roadStart.SetSize(numJunctions + 1);
+        memset(roadStart.Begin(), 0, roadStart.GetSize() * sizeof(uint32_t));
+        for (uint32_t road = 0; road < roadCosts.GetSize(); ++road)
+        {
+            ++roadStart[roads[road * 2] + 1];
+            ++roadStart[roads[road * 2 + 1] + 1];
+        }
+        for (uint32_t junction = 0; junction < numJunctions; ++junction)
+        {
+            roadStart[junction + 1] += roadStart[junction];
+        }
+        Array<uint32_t> next(roadStart);
+        roadTo.SetSize(roadCosts.GetSize() * 2);
+        roadCost.SetSize(roadCosts.GetSize() * 2);
+        for (uint32_t road = 0; road < roadCosts.GetSize(); ++road)
+        {
+            const uint32_t a = roads[road * 2];
+            const uint32_t b = roads[road * 2 + 1];
+            roadTo[next[a]] = b;
+            roadCost[next[a]++] = roadCosts[road];
+            roadTo[next[b]] = a;
+            roadCost[next[b]++] = roadCosts[road];
+        }
+    };
+
+    RoadQuery query;
+    auto check = [&]()
+    {
+        flattenRoads();
+        uint32_t wrong = 0;
+        float dijkstraMS = 0.0f;
+        for (uint32_t i = 0; i < kChecks; ++i)
+        {
+            const uint32_t from = random.GetRandIndex(network.GetNumJunctions());
+            const uint32_t to = random.GetRandIndex(network.GetNumJunctions());
+            const Timer timer;
+            const float expected = BenchmarkRoadDijkstra(roadStart, roadTo, roadCost, from, to);
+            dijkstraMS += timer.GetElapsedMS();
+            const float cost = query.Find(network, from, to);
+            wrong += (fabsf(cost - expected) > expected * 1e-4f) ? 1 : 0;
+        }
+        OUTPUT("  checked %u routes against Dijkstra, %u wrong, Dijkstra %.2f ms per route\n", kChecks, wrong, (double)(dijkstraMS / kChecks));
+    };
+
+    network.Flush();
+    OUTPUT("RoadNetwork: %u junctions, %u roads, %u shortcuts\n", network.GetNumJunctions(), (uint32_t)roadCosts.GetSize(), network.GetNumShortcuts());
+    OUTPUT("  contraction       %10.1f ms\n", (double)network.GetContractionMS());
+    check();
+
+    Array<uint32_t> junctions;
+    uint64_t visited = 0;
+    uint64_t length = 0;
+    Timer timer;
+    for (uint32_t i = 0; i < kQueries; ++i)
+    {
+        query.Find(network, random.GetRandIndex(network.GetNumJunctions()), random.GetRandIndex(network.GetNumJunctions()), &junctions);
+        visited += query.GetNumVisited();
+        length += junctions.GetSize();
+    }
+    OUTPUT("  query             %10.2f us, %u junctions visited, %u on the route\n", (double)(timer.GetElapsedMS() * 1000.0f / kQueries),
+           (uint32_t)(visited / kQueries), (uint32_t)(length / kQueries));
+
+    // Roads destroyed and built, re-contracted from the previous order
+    auto changeRoads = [&]()
+    {
+        const uint32_t road = random.GetRandIndex((uint32_t)roadCosts.GetSize());
+        network.DestroyRoad(roads[road * 2], roads[road * 2 + 1]);
+        roads.EraseIndex(road * 2 + 1);
+        roads.EraseIndex(road * 2);
+        roadCosts.EraseIndex(road);
+        for (;;)
+        {
+            const uint32_t junction = random.GetRandIndex(network.GetNumJunctions() - kGridSize - 1);
+            bool exists = false;
+            for (uint32_t other = 0; (other < roadCosts.GetSize()) && !exists; ++other)
+            {
+                exists = (roads[other * 2] == junction) && (roads[other * 2 + 1] == junction + kGridSize + 1);
+            }
+            if (!exists)
+            {
+                buildRoad(junction, junction + kGridSize + 1);
+                return;
+            }
+        }
+    };
+    float contractionMS = 0.0f;
+    uint32_t recontracted = 0;
+    for (uint32_t i = 0; i < kChanges; ++i)
+    {
+        changeRoads();
+        network.Flush();
+        contractionMS += network.GetContractionMS();
+        recontracted += network.GetNumRecontracted();
+    }
+    OUTPUT("  re-contraction    %10.1f ms, %u junctions re-searched (mean of %u)\n", (double)(contractionMS / kChanges), recontracted / kChanges, kChanges);
+    check();
+
+    // Queries carry on against the previous hierarchy until the new one is swapped in
+    changeRoads();
+    network.Update();
+    uint32_t queriesDuring = 0;
+    timer.Start();
+    while (network.IsContracting())
+    {
+        query.Find(network, random.GetRandIndex(network.GetNumJunctions()), random.GetRandIndex(network.GetNumJunctions()));
+        ++queriesDuring;
+        network.Update();
+    }
+    OUTPUT("  %u queries answered during a %.1f ms background re-contraction\n", queriesDuring, (double)timer.GetElapsedMS());
+    check();
+}
+
+void Benchmark::Regions()
+{
+    const uint32_t kSize = 8192;
+    const uint32_t kNoiseScale = 16;
+    const uint32_t kChanges = 1000;
+
+    // Value noise thresholded near where land stops percolating, so there are many regions
+    // of all sizes and changes often join or split them
+    auto hash = [](uint32_t x, uint32_t y)
+    {
+        uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u;
+        h ^= h >> 15;
+        h *= 0x2c1b3c6du;
+        h ^= h >> 12;
+        return (float)(h & 0xFFFF) / 65535.0f;
+    };
+    Array<float> speeds;
+    speeds.SetSize((size_t)kSize * kSize);
+    ParallelFor(kSize, 16, [&](size_t begin, size_t end)
+    {
+        for (uint32_t y = (uint32_t)begin; y < end; ++y)
+        {
+            const uint32_t cy = y / kNoiseScale;
+            const float fy = (float)(y % kNoiseScale) / kNoiseScale;
+            for (uint32_t x = 0; x < kSize; ++x)
+            {
+                const uint32_t cx = x / kNoiseScale;
+                const float fx = (float)(x % kNoiseScale) / kNoiseScale;
+                const float top = hash(cx, cy) + (hash(cx + 1, cy) - hash(cx, cy)) * fx;
+                const float bottom = hash(cx, cy + 1) + (hash(cx + 1, cy + 1) - hash(cx, cy + 1)) * fx;
+                speeds[x + (size_t)kSize * y] = ((top + (bottom - top) * fy) < 0.5f) ? 1.0f : 0.0f;
+            }
+        }
+    });
+
+    RegionMap regions;
+    Timer timer;
+    regions.Init(kSize, kSize, speeds);
+    OUTPUT("Regions: %ux%u tiles, %u threads\n", kSize, kSize, ParallelForGetNumThreads());
+    OUTPUT("  label             %10.1f ms, %u regions\n", (double)timer.GetElapsedMS(), regions.GetNumRegions());
+
+    Random random(kSize);
+    float totalMS = 0.0f;
+    float maxMS = 0.0f;
+    for (uint32_t i = 0; i < kChanges; ++i)
+    {
+        const uint32_t x = random.GetRandIndex(kSize);
+        const uint32_t y = random.GetRandIndex(kSize);
+        float& speed = speeds[x + (size_t)kSize * y];
+        speed = (speed > 0.0f) ? 0.0f : 1.0f;
+        timer.Start();
+        regions.SetPassable(x, y, speed > 0.0f);
+        const float ms = timer.GetElapsedMS();
+        totalMS += ms;
+        maxMS = Math::Max(maxMS, ms);
+    }
+    OUTPUT("  change tile       %10.3f ms, max %.3f ms (mean of %u), %u regions\n", (double)(totalMS / kChanges), (double)maxMS, kChanges, regions.GetNumRegions());
+
+    // The changed labels must split the map the same way as labelling it from scratch
+    RegionMap fresh;
+    fresh.Init(kSize, kSize, speeds);
+    Array<uint32_t> freshToChanged;
+    Array<uint32_t> changedToFresh;
+    freshToChanged.SetSize(kSize * kSize / 2 + 2);
+    changedToFresh.SetSize(kSize * kSize / 2 + 2);
+    memset(freshToChanged.Begin(), 0xFF, freshToChanged.GetSize() * sizeof(uint32_t));
+    memset(changedToFresh.Begin(), 0xFF, changedToFresh.GetSize() * sizeof(uint32_t));
+    uint32_t wrong = 0;
+    for (uint32_t y = 0; y < kSize; ++y)
+    {
+        for (uint32_t x = 0; x < kSize; ++x)
+        {
+            const uint32_t a = fresh.GetRegion(x, y);
+            const uint32_t b = regions.GetRegion(x, y);
+            if (freshToChanged[a] == 0xFFFFFFFF)
+            {
+                freshToChanged[a] = b;
+            }
+            if (changedToFresh[b] == 0xFFFFFFFF)
+            {
+                changedToFresh[b] = a;
+            }
+            wrong += ((freshToChanged[a] != b) || (changedToFresh[b] != a)) ? 1 : 0;
+        }
+    }
+    OUTPUT("  checked against labelling from scratch, %u regions, %u tiles wrong\n", fresh.GetNumRegions(), wrong);
+}
+
+void Benchmark::Hydrology()
+{
+    const uint32_t kSize = 8192;
+    const uint32_t kRiverFlow = 10000;
+
+    // Octaves of value noise, rough enough to leave plenty of depressions to fill
+    Array<BenchmarkValueNoise*> octaves;
+    for (uint32_t spacing = 1024; spacing >= 4; spacing /= 4)
+    {
+        octaves.Append(new BenchmarkValueNoise(kSize, spacing, spacing));
+    }
+    Array<uint16_t> heights;
+    heights.SetSize((size_t)kSize * kSize);
+    ParallelFor(kSize, 16, [&](size_t begin, size_t end)
+    {
+        for (uint32_t y = (uint32_t)begin; y < end; ++y)
+        {
+            for (uint32_t x = 0; x < kSize; ++x)
+            {
+                float height = 0.0f;
+                float amplitude = 0.5f;
+                for (const BenchmarkValueNoise* octave : octaves)
+                {
+                    height += octave->Get(x, y) * amplitude;
+                    amplitude *= 0.5f;
+                }
+                heights[x + (size_t)kSize * y] = (uint16_t)(height * 65535.0f);
+            }
+        }
+    });
+    for (BenchmarkValueNoise* octave : octaves)
+    {
+        delete octave;
+    }
+
+    ::Hydrology hydrology;
+    const Timer timer;
+    hydrology.Run(kSize, kSize, heights);
+    const float totalMS = timer.GetElapsedMS();
+    OUTPUT("Hydrology: %ux%u tiles, %u threads\n", kSize, kSize, ParallelForGetNumThreads());
+    OUTPUT("  fill              %10.1f ms\n", (double)hydrology.GetFillMS());
+    OUTPUT("  directions        %10.1f ms\n", (double)hydrology.GetDirectionMS());
+    OUTPUT("  flow              %10.1f ms\n", (double)hydrology.GetFlowMS());
+    OUTPUT("  total             %10.1f ms\n", (double)totalMS);
+
+    // Every tile's water leaves the map once
+    uint64_t lakeTiles = 0;
+    uint64_t riverTiles = 0;
+    uint64_t outflow = 0;
+    uint32_t basins = 0;
+    for (uint32_t y = 0; y < kSize; ++y)
+    {
+        for (uint32_t x = 0; x < kSize; ++x)
+        {
+            lakeTiles += (hydrology.GetFilled(x, y) > heights[x + (size_t)kSize * y]) ? 1 : 0;
+            riverTiles += (hydrology.GetFlow(x, y) >= kRiverFlow) ? 1 : 0;
+            if (hydrology.GetDirection(x, y) == ::Hydrology::kOffMap)
+            {
+                outflow += hydrology.GetFlow(x, y);
+                ++basins;
+            }
+        }
+    }
+    OUTPUT("  %.1f%% lake tiles, %.2f%% river tiles, %u basins, %llu tiles drained off the map\n", (double)lakeTiles * 100.0 / ((double)kSize * kSize),
+           (double)riverTiles * 100.0 / ((double)kSize * kSize), basins, (unsigned long long)outflow);
+}
+
+void Benchmark::Erosion()
+{
+    const uint32_t kSize = 8192;
+    const uint32_t kIterations = 10;
+    const float kRelief = 256.0f;
+
+    Array<BenchmarkValueNoise*> octaves;
+    for (uint32_t spacing = 1024; spacing >= 4; spacing /= 4)
+    {
+        octaves.Append(new BenchmarkValueNoise(kSize, spacing, spacing));
+    }
+    Array<float> heights;
+    heights.SetSize((size_t)kSize * kSize);
+    ParallelFor(kSize, 16, [&](size_t begin, size_t end)
+    {
+        for (uint32_t y = (uint32_t)begin; y < end; ++y)
+        {
+            for (uint32_t x = 0; x < kSize; ++x)
+            {
+                float height = 0.0f;
+                float amplitude = 0.5f * kRelief;
+                for (const BenchmarkValueNoise* octave : octaves)
+                {
+                    height += octave->Get(x, y) * amplitude;
+                    amplitude *= 0.25f;
+                }
+                heights[x + (size_t)kSize * y] = height;
+            }
+        }
+    });
+    for (BenchmarkValueNoise* octave : octaves)
+    {
+        delete octave;
+    }
+
+    OUTPUT("Erosion: %ux%u tiles, %u iterations, %u threads\n", kSize, kSize, kIterations, ParallelForGetNumThreads());
+    Array<float> results[2];
+    for (uint32_t simd = 0; simd < 2; ++simd)
+    {
+        ::Erosion erosion;
+        erosion.SetSimd(simd == 1);
+        if ((simd == 1) && !erosion.IsUsingSimd())
+        {
+            OUTPUT("  AVX2 not supported\n");
+            break;
+        }
+        results[simd] = heights;
+        erosion.Run(kSize, kSize, results[simd], kIterations);
+        float fastestMS = FLT_MAX;
+        for (const float ms : erosion.GetIterationMS())
+        {
+            fastestMS = Math::Min(fastestMS, ms);
+        }
+        OUTPUT("  %-6s  %8.1f ms per iteration, fastest %8.1f ms, %6.2f ns per tile\n", (simd == 1) ? "AVX2" : "scalar", (double)erosion.GetMeanIterationMS(),
+               (double)fastestMS, (double)erosion.GetMeanIterationMS() * 1e6 / ((double)kSize * kSize));
+    }
+
+    // The two paths should match exactly, and material only moves around
+    double totalBefore = 0.0;
+    double totalAfter = 0.0;
+    double totalChange = 0.0;
+    uint64_t mismatches = 0;
+    for (size_t i = 0; i < heights.GetSize(); ++i)
+    {
+        totalBefore += heights[i];
+        totalAfter += results[0][i];
+        totalChange += fabs((double)results[0][i] - heights[i]);
+        if (!results[1].IsEmpty() && (results[1][i] != results[0][i]))
+        {
+            ++mismatches;
+        }
+    }
+    OUTPUT("  mean change %.4f tiles, mass change %.4f%%, %llu tiles differ between paths\n", totalChange / (double)heights.GetSize(),
+           (totalAfter - totalBefore) * 100.0 / totalBefore, (unsigned long long)mismatches);
+}
+
+void Benchmark::TerritoryCells()
+{
+    const uint32_t kSize = 8192;
+    const uint32_t kSites = 5000;
+    const uint32_t kChanges = 1000;
+    const uint32_t kChecked = 200;
+
+    Random random(kSites);
+    Array<uint64_t> ids;
+    Array<uint32_t> xs;
+    Array<uint32_t> ys;
+    uint64_t nextId = 1;
+    ::TerritoryCells cells;
+    cells.Init(kSize, kSize);
+
+    Timer timer;
+    for (uint32_t i = 0; i < kSites; ++i)
+    {
+        ids.Append(nextId++);
+        xs.Append(random.GetRandIndex(kSize));
+        ys.Append(random.GetRandIndex(kSize));
+        cells.AddSite(ids.Top(), xs.Top(), ys.Top());
+    }
+    const float buildMS = timer.GetElapsedMS();
+
+    // Destroy a random settlement and found another elsewhere
+    uint64_t rebuilt = 0;
+    timer.Start();
+    for (uint32_t i = 0; i < kChanges; ++i)
+    {
+        const uint32_t index = random.GetRandIndex(kSites);
+        cells.RemoveSite(ids[index]);
+        rebuilt += cells.GetLastRebuildCount();
+        ids[index] = nextId++;
+        xs[index] = random.GetRandIndex(kSize);
+        ys[index] = random.GetRandIndex(kSize);
+        cells.AddSite(ids[index], xs[index], ys[index]);
+        rebuilt += cells.GetLastRebuildCount();
+    }
+    const float changeMS = timer.GetElapsedMS();
+
+    OUTPUT("Territory cells: %u settlements on %ux%u tiles\n", kSites, kSize, kSize);
+    OUTPUT("  build             %10.1f ms\n", (double)buildMS);
+    OUTPUT("  found or destroy  %10.3f ms, %.1f cells rebuilt\n", (double)changeMS / (kChanges * 2), (double)rebuilt / (kChanges * 2));
+
+    // Cells tile the map, and match clipping the map by every other settlement's bisector
+    double totalArea = 0.0;
+    uint32_t numVertices = 0;
+    for (uint32_t i = 0; i < kSites; ++i)
+    {
+        const Array<::TerritoryCells::Point>& cell = cells.GetCell(ids[i]);
+        totalArea += BenchmarkPolygonArea(cell);
+        numVertices += (uint32_t)cell.GetSize();
+    }
+    uint32_t wrong = 0;
+    Array<::TerritoryCells::Point> points;
+    Array<::TerritoryCells::Point> clipped;
+    for (uint32_t i = 0; i < kChecked; ++i)
+    {
+        const uint32_t site = random.GetRandIndex(kSites);
+        const double sx = xs[site] + 0.5;
+        const double sy = ys[site] + 0.5;
+        points.SetSize(4);
+        points[0] = { 0.0f, 0.0f };
+        points[1] = { (float)kSize, 0.0f };
+        points[2] = { (float)kSize, (float)kSize };
+        points[3] = { 0.0f, (float)kSize };
+        for (uint32_t other = 0; other < kSites; ++other)
+        {
+            const double dx = xs[other] + 0.5 - sx;
+            const double dy = ys[other] + 0.5 - sy;
+            if ((dx == 0.0) && (dy == 0.0))
+            {
+                continue;
+            }
+            const double offset = dx * (sx + dx * 0.5) + dy * (sy + dy * 0.5);
+            clipped.Clear();
+            for (size_t p = 0; p < points.GetSize(); ++p)
+            {
+                const ::TerritoryCells::Point& a = points[p];
+                const ::TerritoryCells::Point& b = points[(p + 1) % points.GetSize()];
+                const double da = dx * a.mX + dy * a.mY - offset;
+                const double db = dx * b.mX + dy * b.mY - offset;
+                if (da <= 0.0)
+                {
+                    clipped.Append(a);
+                }
+                if (((da < 0.0) != (db < 0.0)) && (da != 0.0) && (db != 0.0))
+                {
+                    const double t = da / (da - db);
+                    clipped.Append({ (float)(a.mX + (b.mX - a.mX) * t), (float)(a.mY + (b.mY - a.mY) * t) });
+                }
+            }
+            points.Swap(clipped);
+        }
+        const double area = BenchmarkPolygonArea(points);
+        if (fabs(BenchmarkPolygonArea(cells.GetCell(ids[site])) - area) > 1e-3 * area + 1e-2)
+        {
+            ++wrong;
+        }
+    }
+    OUTPUT("  %.1f vertices per cell, area %.4f%% of the map, %u of %u checked cells wrong\n", (double)numVertices / kSites,
+           totalArea * 100.0 / ((double)kSize * kSize), wrong, kChecked);
+}
+
+void Benchmark::NavMesh()
+{
+    const uint32_t kSize = 2048;
+    const uint32_t kBuildings = 2000;
+    const uint32_t kChanges = 200;
+    const uint32_t kPaths = 1000;
+    const float kSampleSpacing = 0.05f;
+
+    // Impassable blobs of terrain
+    BenchmarkValueNoise noise(kSize, 32, 1);
+    Array<float> speeds;
+    speeds.SetSize((size_t)kSize * kSize);
+    for (uint32_t y = 0; y < kSize; ++y)
+    {
+        for (uint32_t x = 0; x < kSize; ++x)
+        {
+            speeds[x + (size_t)kSize * y] = (noise.Get(x, y) < 0.75f) ? 1.0f : 0.0f;
+        }
+    }
+
+    ::NavMesh navMesh;
+    Timer timer;
+    navMesh.Init(kSize, kSize, speeds);
+    const float initMS = timer.GetElapsedMS();
+
+    Random random(kBuildings);
+    struct Footprint
+    {
+        uint32_t mX0, mY0, mX1, mY1;
+    };
+    Array<Footprint> buildings;
+    auto randomFootprint = [&]()
+    {
+        Footprint footprint;
+        footprint.mX0 = random.GetRandIndex(kSize - 8);
+        footprint.mY0 = random.GetRandIndex(kSize - 8);
+        footprint.mX1 = footprint.mX0 + 2 + random.GetRandIndex(7);
+        footprint.mY1 = footprint.mY0 + 2 + random.GetRandIndex(7);
+        return footprint;
+    };
+    timer.Start();
+    for (uint32_t i = 0; i < kBuildings; ++i)
+    {
+        buildings.Append(randomFootprint());
+        navMesh.AddObstacle(buildings.Top().mX0, buildings.Top().mY0, buildings.Top().mX1, buildings.Top().mY1);
+    }
+    navMesh.Update();
+    const float buildingsMS = timer.GetElapsedMS();
+
+    // Move random buildings, retriangulating after each removal and placement
+    uint32_t rebuilt = 0;
+    timer.Start();
+    for (uint32_t i = 0; i < kChanges; ++i)
+    {
+        Footprint& footprint = buildings[random.GetRandIndex(kBuildings)];
+        navMesh.RemoveObstacle(footprint.mX0, footprint.mY0, footprint.mX1, footprint.mY1);
+        navMesh.Update();
+        rebuilt += navMesh.GetLastRebuildCount();
+        footprint = randomFootprint();
+        navMesh.AddObstacle(footprint.mX0, footprint.mY0, footprint.mX1, footprint.mY1);
+        navMesh.Update();
+        rebuilt += navMesh.GetLastRebuildCount();
+    }
+    const float changeMS = timer.GetElapsedMS();
+
+    OUTPUT("Nav mesh: %ux%u tiles, %u buildings, %u triangles\n", kSize, kSize, kBuildings, navMesh.GetNumTriangles());
+    OUTPUT("  init              %10.1f ms\n", (double)initMS);
+    OUTPUT("  place buildings   %10.1f ms\n", (double)buildingsMS);
+    OUTPUT("  place or remove   %10.3f ms, %.1f sectors retriangulated\n", (double)changeMS / (kChanges * 2), (double)rebuilt / (kChanges * 2));
+
+    // Paths between random walkable tiles, checked against tile regions and for crossing
+    // blocked tiles
+    for (size_t i = 0; i < speeds.GetSize(); ++i)
+    {
+        speeds[i] = navMesh.IsWalkable((uint32_t)(i % kSize), (uint32_t)(i / kSize)) ? 1.0f : 0.0f;
+    }
+    RegionMap regions;
+    regions.Init(kSize, kSize, speeds);
+
+    Array<::NavMesh::Point> path;
+    double pathMS = 0.0;
+    uint32_t found = 0;
+    uint32_t wrongReachability = 0;
+    uint32_t blockedPaths = 0;
+    double lengthRatio = 0.0;
+    for (uint32_t i = 0; i < kPaths; ++i)
+    {
+        uint32_t x0, y0, x1, y1;
+        do
+        {
+            x0 = random.GetRandIndex(kSize);
+            y0 = random.GetRandIndex(kSize);
+        } while (!navMesh.IsWalkable(x0, y0));
+        do
+        {
+            x1 = random.GetRandIndex(kSize);
+            y1 = random.GetRandIndex(kSize);
+        } while (!navMesh.IsWalkable(x1, y1));
+
+        const ::NavMesh::Point start = { (float)x0 + 0.5f, (float)y0 + 0.5f };
+        const ::NavMesh::Point end = { (float)x1 + 0.5f, (float)y1 + 0.5f };
+        timer.Start();
+        const bool reachable = navMesh.FindPath(start, end, path);
+        pathMS += timer.GetElapsedMS();
+        if (reachable != regions.IsConnected(x0, y0, x1, y1))
+        {
+            ++wrongReachability;
+        }
+        if (!reachable)
+        {
+            continue;
+        }
+        ++found;
+
+        double length = 0.0;
+        bool blocked = false;
+        for (size_t p = 1; p < path.GetSize(); ++p)
+        {
+            const float dx = path[p].mX - path[p - 1].mX;
+            const float dy = path[p].mY - path[p - 1].mY;
+            const float segment = sqrtf(dx * dx + dy * dy);
+            length += segment;
+            const uint32_t samples = (uint32_t)(segment / kSampleSpacing) + 1;
+            for (uint32_t s = 0; s <= samples; ++s)
+            {
+                const float t = (float)s / (float)samples;
+                blocked |= !BenchmarkIsClear(navMesh, path[p - 1].mX + dx * t, path[p - 1].mY + dy * t);
+            }
+        }
+        blockedPaths += blocked ? 1 : 0;
+        const float dx = end.mX - start.mX;
+        const float dy = end.mY - start.mY;
+        lengthRatio += length / Math::Max(sqrt((double)dx * dx + (double)dy * dy), 1.0);
+    }
+    OUTPUT("  find path         %10.3f ms, %u of %u found, %.3f times the straight line\n", pathMS / kPaths, found, kPaths, lengthRatio / Math::Max(found, 1u));
+    OUTPUT("  %u paths disagree with tile regions, %u paths cross blocked tiles\n", wrongReachability, blockedPaths);
+}
+
+void Benchmark::NearestSites()
+{
+    const float kSize = 4096.0f;
+    const uint32_t kSites = 50000;
+    const uint32_t kAgents = 100000;
+    const uint32_t kMoves = 1000;
+    const uint32_t kChecked = 1000;
+    const uint32_t kNeighbours[] = { 1, 8 };
+
+    Random random(kSites);
+    Array<float> siteX;
+    Array<float> siteY;
+    ::NearestSites sites;
+    for (uint32_t i = 0; i < kSites; ++i)
+    {
+        siteX.Append(random.GetRandFloat() * kSize);
+        siteY.Append(random.GetRandFloat() * kSize);
+        sites.AddSite(i + 1, siteX[i], siteY[i]);
+    }
+    Timer timer;
+    sites.Flush();
+    const float buildMS = timer.GetElapsedMS();
+
+    Array<float> agentX;
+    Array<float> agentY;
+    agentX.SetSize(kAgents);
+    agentY.SetSize(kAgents);
+    for (uint32_t i = 0; i < kAgents; ++i)
+    {
+        agentX[i] = random.GetRandFloat() * kSize;
+        agentY[i] = random.GetRandFloat() * kSize;
+    }
+
+    OUTPUT("Nearest sites: %u sites, %u agents, %u threads\n", kSites, kAgents, ParallelForGetNumThreads());
+    OUTPUT("  build             %10.1f ms, %.1f ms on the build thread\n", (double)buildMS, (double)sites.GetBuildMS());
+
+    Array<uint64_t> ids;
+    Array<float> distancesSq;
+    for (const uint32_t k : kNeighbours)
+    {
+        ids.SetSize((size_t)kAgents * k);
+        distancesSq.SetSize((size_t)kAgents * k);
+        timer.Start();
+        sites.FindNearest(agentX.Begin(), agentY.Begin(), kAgents, k, ids.Begin(), distancesSq.Begin());
+        const float queryMS = timer.GetElapsedMS();
+
+        // Brute force over a sample of agents, comparing distances as ties may swap ids. The
+        // compiler may fuse the multiply adds here but not in the tree's SIMD tests.
+        uint32_t wrong = 0;
+        float best[::NearestSites::kMaxNeighbours];
+        for (uint32_t c = 0; c < kChecked; ++c)
+        {
+            const uint32_t agent = random.GetRandIndex(kAgents);
+            for (uint32_t j = 0; j < k; ++j)
+            {
+                best[j] = FLT_MAX;
+            }
+            for (uint32_t s = 0; s < kSites; ++s)
+            {
+                const float dx = siteX[s] - agentX[agent];
+                const float dy = siteY[s] - agentY[agent];
+                const float distanceSq = dx * dx + dy * dy;
+                uint32_t j = k;
+                for (; (j > 0) && (best[j - 1] > distanceSq); --j)
+                {
+                    if (j < k)
+                    {
+                        best[j] = best[j - 1];
+                    }
+                }
+                if (j < k)
+                {
+                    best[j] = distanceSq;
+                }
+            }
+            for (uint32_t j = 0; j < k; ++j)
+            {
+                const uint64_t id = ids[(size_t)agent * k + j];
+                if (id == 0)
+                {
+                    ++wrong;
+                    break;
+                }
+                const float dx = siteX[(uint32_t)id - 1] - agentX[agent];
+                const float dy = siteY[(uint32_t)id - 1] - agentY[agent];
+                const float tolerance = best[j] * 1e-5f + 1e-5f;
+                if ((fabsf(distancesSq[(size_t)agent * k + j] - best[j]) > tolerance) || (fabsf(dx * dx + dy * dy - best[j]) > tolerance))
+                {
+                    ++wrong;
+                    break;
+                }
+            }
+        }
+        OUTPUT("  %2u nearest        %10.2f ms per batch, %u of %u sampled agents wrong\n", k, (double)queryMS, wrong, kChecked);
+    }
+
+    // Queries carry on against the previous tree while moved sites are rebuilt
+    for (uint32_t i = 0; i < kMoves; ++i)
+    {
+        const uint32_t site = random.GetRandIndex(kSites);
+        siteX[site] = random.GetRandFloat() * kSize;
+        siteY[site] = random.GetRandFloat() * kSize;
+        sites.MoveSite(site + 1, siteX[site], siteY[site]);
+    }
+    timer.Start();
+    sites.Update();
+    const float startMS = timer.GetElapsedMS();
+    uint32_t batches = 0;
+    ids.SetSize(kAgents);
+    timer.Start();
+    while (sites.IsRebuilding())
+    {
+        sites.FindNearest(agentX.Begin(), agentY.Begin(), kAgents, 1, ids.Begin());
+        ++batches;
+        sites.Update();
+    }
+    OUTPUT("  rebuild after %u moves: %.2f ms to start, %u batches answered in the %.1f ms until it was swapped in\n", kMoves, (double)startMS, batches, (double)timer.GetElapsedMS());
+}
+
+void Benchmark::Footprints()
+{
+    const uint32_t kSize = 2048;
+    const uint32_t kBuildings = 10000;
+    const uint32_t kUnits = 2000;
+    const uint32_t kTicks = 200;
+    const uint32_t kPlacementsPerTick = 20;
+    const uint32_t kRemovalsPerTick = 5;
+    const float kUnitSize = 0.5f;
+    const float kUnitStep = 0.25f;
+
+    // The same changes go to one updated incrementally and one sorted from scratch each tick
+    FootprintOverlaps incremental;
+    FootprintOverlaps rebuilt;
+    incremental.Init(kSize, kSize);
+    rebuilt.Init(kSize, kSize);
+    Random random(kBuildings);
+    Array<bool> isBuilding;
+    Array<uint32_t> buildings;
+    auto randomFootprint = [&]()
+    {
+        const uint32_t x = random.GetRandIndex(kSize - 8);
+        const uint32_t y = random.GetRandIndex(kSize - 8);
+        return FootprintOverlaps::FromTiles(x, y, x + 2 + random.GetRandIndex(7), y + 2 + random.GetRandIndex(7));
+    };
+    auto add = [&](const FootprintOverlaps::Rectangle& rectangle, bool building)
+    {
+        const uint32_t handle = incremental.Add(rectangle);
+        const uint32_t check = rebuilt.Add(rectangle);
+        ASSERT(handle == check);
+        (void)check;
+        if (handle >= isBuilding.GetSize())
+        {
+            isBuilding.SetSize(handle + 1);
+        }
+        isBuilding[handle] = building;
+        return handle;
+    };
+    auto overlapsBuilding = [&](uint32_t handle, Array<uint32_t>& others)
+    {
+        incremental.GetOverlaps(handle, others);
+        for (const uint32_t other : others)
+        {
+            if (isBuilding[other])
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Place buildings, dropping any that overlap another
+    Timer timer;
+    Array<uint32_t> others;
+    uint32_t attempts = 0;
+    while (buildings.GetSize() < kBuildings)
+    {
+        const uint32_t handle = add(randomFootprint(), true);
+        ++attempts;
+        incremental.Update();
+        if (overlapsBuilding(handle, others))
+        {
+            incremental.Remove(handle);
+            rebuilt.Remove(handle);
+            incremental.Update();
+        }
+        else
+        {
+            buildings.Append(handle);
+        }
+    }
+    const float placeMS = timer.GetElapsedMS();
+    rebuilt.Rebuild();
+
+    Array<uint32_t> units;
+    for (uint32_t i = 0; i < kUnits; ++i)
+    {
+        const float x = random.GetRandFloat() * (float)(kSize - 1);
+        const float y = random.GetRandFloat() * (float)(kSize - 1);
+        units.Append(add({ x, y, x + kUnitSize, y + kUnitSize }, false));
+    }
+    incremental.Update();
+    rebuilt.Rebuild();
+
+    // Each tick every unit steps, a few buildings are removed and new ones are placed,
+    // then the placements are validated against the updated overlaps
+    double incrementalMS = 0.0;
+    double rebuildMS = 0.0;
+    uint32_t mismatches = 0;
+    uint32_t placed = 0;
+    Array<uint32_t> candidates;
+    for (uint32_t tick = 0; tick < kTicks; ++tick)
+    {
+        for (const uint32_t unit : units)
+        {
+            FootprintOverlaps::Rectangle rectangle = incremental.GetRectangle(unit);
+            rectangle.mMinX = Math::Clamp(rectangle.mMinX + (random.GetRandFloat() - 0.5f) * 2.0f * kUnitStep, 0.0f, (float)kSize - 1.0f);
+            rectangle.mMinY = Math::Clamp(rectangle.mMinY + (random.GetRandFloat() - 0.5f) * 2.0f * kUnitStep, 0.0f, (float)kSize - 1.0f);
+            rectangle.mMaxX = rectangle.mMinX + kUnitSize;
+            rectangle.mMaxY = rectangle.mMinY + kUnitSize;
+            incremental.SetRectangle(unit, rectangle);
+            rebuilt.SetRectangle(unit, rectangle);
+        }
+        for (uint32_t i = 0; i < kRemovalsPerTick; ++i)
+        {
+            const uint32_t index = random.GetRandIndex((uint32_t)buildings.GetSize());
+            incremental.Remove(buildings[index]);
+            rebuilt.Remove(buildings[index]);
+            buildings[index] = buildings.Top();
+            buildings.Pop();
+        }
+        candidates.Clear();
+        for (uint32_t i = 0; i < kPlacementsPerTick; ++i)
+        {
+            candidates.Append(add(randomFootprint(), true));
+        }
+
+        timer.Start();
+        incremental.Update();
+        incrementalMS += timer.GetElapsedMS();
+        timer.Start();
+        rebuilt.Rebuild();
+        rebuildMS += timer.GetElapsedMS();
+        mismatches += (incremental.GetNumOverlaps() != rebuilt.GetNumOverlaps()) ? 1 : 0;
+
+        // Candidates overlapping a building or each other are dropped, their removal is
+        // part of the next tick's batch
+        for (const uint32_t candidate : candidates)
+        {
+            if (overlapsBuilding(candidate, others))
+            {
+                incremental.Remove(candidate);
+                rebuilt.Remove(candidate);
+            }
+            else
+            {
+                buildings.Append(candidate);
+                ++placed;
+            }
+        }
+    }
+    incremental.Update();
+
+    // Brute force check of the final overlaps
+    Array<FootprintOverlaps::Pair> pairs;
+    incremental.GetOverlaps(pairs);
+    Array<uint32_t> handles;
+    handles.Append(buildings);
+    handles.Append(units);
+    uint32_t expected = 0;
+    for (size_t i = 0; i < handles.GetSize(); ++i)
+    {
+        const FootprintOverlaps::Rectangle a = incremental.GetRectangle(handles[i]);
+        for (size_t j = i + 1; j < handles.GetSize(); ++j)
+        {
+            const FootprintOverlaps::Rectangle b = incremental.GetRectangle(handles[j]);
+            if ((a.mMinX <= b.mMaxX) && (b.mMinX <= a.mMaxX) && (a.mMinY <= b.mMaxY) && (b.mMinY <= a.mMaxY))
+            {
+                ++expected;
+            }
+        }
+    }
+
+    OUTPUT("Footprints: %u buildings placed from %u attempts, %u units, %u ticks\n", kBuildings, attempts, kUnits, kTicks);
+    OUTPUT("  place one at a time %8.3f ms per attempt\n", (double)placeMS / attempts);
+    OUTPUT("  incremental update  %8.3f ms per tick\n", incrementalMS / kTicks);
+    OUTPUT("  sort from scratch   %8.3f ms per tick\n", rebuildMS / kTicks);
+    OUTPUT("  %u buildings placed while running, %u ticks with differing overlaps\n", placed, mismatches);
+    OUTPUT("  %u overlapping pairs, %u by brute force\n", (uint32_t)pairs.GetSize(), expected);
+}
+
+void Benchmark::HashMap()
+{
+    const uint32_t kKeys = 100000;
+    const uint32_t kLookups = 1000000;
+    const uint32_t kSmallMaps = 1000;
+    const uint32_t kSmallMapKeys = 10;
+
+    Array<AString> keys;
+    Array<AString> missing;
+    keys.SetSize(kKeys);
+    missing.SetSize(kKeys);
+    for (uint32_t i = 0; i < kKeys; ++i)
+    {
+        keys[i].Format("settlement_%u", i);
+        missing[i].Format("missing_%u", i);
+    }
+    Random random(kKeys);
+    Array<uint32_t> order;
+    order.SetSize(kLookups);
+    for (uint32_t& index : order)
+    {
+        index = random.GetRandIndex(kKeys);
+    }
+
+    Timer timer;
+    UnorderedMap<AString, uint32_t> chained;
+    for (uint32_t i = 0; i < kKeys; ++i)
+    {
+        chained.Insert(keys[i], i);
+    }
+    const float chainedInsertMS = timer.GetElapsedMS();
+    timer.Start();
+    uint64_t chainedSum = 0;
+    for (const uint32_t index : order)
+    {
+        chainedSum += chained.Find(keys[index])->m_Value;
+    }
+    const float chainedHitMS = timer.GetElapsedMS();
+    timer.Start();
+    uint32_t chainedMisses = 0;
+    for (const uint32_t index : order)
+    {
+        chainedMisses += (chained.Find(missing[index]) == nullptr) ? 1 : 0;
+    }
+    const float chainedMissMS = timer.GetElapsedMS();
+
+    timer.Start();
+    FlatHashMap<AString, uint32_t> flat;
+    for (uint32_t i = 0; i < kKeys; ++i)
+    {
+        flat.Insert(keys[i], i);
+    }
+    const float flatInsertMS = timer.GetElapsedMS();
+    timer.Start();
+    uint64_t flatSum = 0;
+    for (const uint32_t index : order)
+    {
+        flatSum += flat.Find(keys[index])->m_Value;
+    }
+    const float flatHitMS = timer.GetElapsedMS();
+    timer.Start();
+    uint32_t flatMisses = 0;
+    for (const uint32_t index : order)
+    {
+        flatMisses += (flat.Find(missing[index]) == nullptr) ? 1 : 0;
+    }
+    const float flatMissMS = timer.GetElapsedMS();
+    timer.Start();
+    for (uint32_t i = 0; i < kKeys; i += 2)
+    {
+        flat.Erase(keys[i]);
+    }
+    const float flatEraseMS = timer.GetElapsedMS();
+    uint32_t flatWrong = 0;
+    for (uint32_t i = 0; i < kKeys; ++i)
+    {
+        const auto* found = flat.Find(keys[i].Get());
+        flatWrong += ((found != nullptr) != ((i & 1) != 0)) ? 1 : 0;
+    }
+
+    // The chained map's buckets, one node per entry, and the flat map's slots, leaving
+    // out the strings' own memory
+    const size_t chainedBytes = sizeof(void*) * 65536 + (sizeof(AString) + sizeof(uint32_t) + sizeof(void*)) * kKeys;
+    const size_t flatBytes = flat.GetMemoryUsage();
+
+    // Many small maps, as for per-settlement lookups
+    timer.Start();
+    size_t smallChainedBytes = 0;
+    for (uint32_t m = 0; m < kSmallMaps; ++m)
+    {
+        UnorderedMap<AString, uint32_t> map;
+        for (uint32_t i = 0; i < kSmallMapKeys; ++i)
+        {
+            map.Insert(keys[m * kSmallMapKeys + i], i);
+        }
+        smallChainedBytes += sizeof(void*) * 65536 + (sizeof(AString) + sizeof(uint32_t) + sizeof(void*)) * kSmallMapKeys;
+    }
+    const float smallChainedMS = timer.GetElapsedMS();
+    timer.Start();
+    size_t smallFlatBytes = 0;
+    for (uint32_t m = 0; m < kSmallMaps; ++m)
+    {
+        FlatHashMap<AString, uint32_t> map;
+        for (uint32_t i = 0; i < kSmallMapKeys; ++i)
+        {
+            map.Insert(keys[m * kSmallMapKeys + i], i);
+        }
+        smallFlatBytes += map.GetMemoryUsage();
+    }
+    const float smallFlatMS = timer.GetElapsedMS();
+
+    OUTPUT("Hash map: %u string keys, %u lookups\n", kKeys, kLookups);
+    OUTPUT("                      UnorderedMap    FlatHashMap\n");
+    OUTPUT("  insert              %10.2f ms  %10.2f ms\n", (double)chainedInsertMS, (double)flatInsertMS);
+    OUTPUT("  find, present       %10.2f ms  %10.2f ms\n", (double)chainedHitMS, (double)flatHitMS);
+    OUTPUT("  find, missing       %10.2f ms  %10.2f ms\n", (double)chainedMissMS, (double)flatMissMS);
+    OUTPUT("  table memory        %10.2f MB  %10.2f MB\n", chainedBytes / (1024.0 * 1024.0), flatBytes / (1024.0 * 1024.0));
+    OUTPUT("  %u maps of %u       %10.2f ms  %10.2f ms\n", kSmallMaps, kSmallMapKeys, (double)smallChainedMS, (double)smallFlatMS);
+    OUTPUT("  their memory        %10.2f MB  %10.2f MB\n", smallChainedBytes / (1024.0 * 1024.0), smallFlatBytes / (1024.0 * 1024.0));
+    OUTPUT("  FlatHashMap erase half %.2f ms, %u wrong after, sums %s, misses %u and %u\n", (double)flatEraseMS, flatWrong, (chainedSum == flatSum) ? "match" : "differ", chainedMisses, flatMisses);
+}
+
+void Benchmark::SmallAllocations()
+{
+    const uint32_t kBlocksPerThread = 20000;
+    const uint32_t kChurnRounds = 20;
+    const uint32_t kMaxThreads = 32;
+
+    // The small block allocator's sizes, up to 256 bytes
+    Array<uint32_t> sizes;
+    sizes.SetSize(kBlocksPerThread);
+    Random random(kBlocksPerThread);
+    for (uint32_t& size : sizes)
+    {
+        size = 1 + random.GetRandIndex(256);
+    }
+    Array<void*> blocks;
+    blocks.SetSize((size_t)kBlocksPerThread * kMaxThreads);
+
+    OUTPUT("Small allocations: %u per thread, sizes 1 to 256 bytes, wall clock time\n", kBlocksPerThread);
+    OUTPUT("  threads   alloc+free x%u    M/s   alloc, free on another thread    M/s\n", kChurnRounds);
+    for (uint32_t numThreads = 1; numThreads <= kMaxThreads; numThreads *= 2)
+    {
+        Array<BenchmarkAllocThread> threads;
+        threads.SetSize(numThreads);
+        for (uint32_t t = 0; t < numThreads; ++t)
+        {
+            threads[t].mSizes = &sizes;
+            threads[t].mBlocks = &blocks[(size_t)t * kBlocksPerThread];
+            threads[t].mNumBlocks = kBlocksPerThread;
+            threads[t].mNumRounds = kChurnRounds;
+        }
+        const float churnMS = BenchmarkRunThreads(threads, BenchmarkAllocThread::ChurnMain);
+
+        // Each thread frees the blocks the next one allocated, as when results are handed
+        // from workers to the main thread
+        for (uint32_t t = 0; t < numThreads; ++t)
+        {
+            threads[t].mFreeBlocks = threads[(t + 1) % numThreads].mBlocks;
+        }
+        float handOffMS = 0.0f;
+        for (uint32_t round = 0; round < kChurnRounds; ++round)
+        {
+            handOffMS += BenchmarkRunThreads(threads, BenchmarkAllocThread::AllocMain);
+            handOffMS += BenchmarkRunThreads(threads, BenchmarkAllocThread::FreeMain);
+        }
+
+        const double numChurn = 2.0 * kChurnRounds * kBlocksPerThread * numThreads;
+        OUTPUT("  %7u   %13.2f ms %7.1f   %26.2f ms %7.1f\n", numThreads, (double)churnMS, numChurn / (churnMS * 1000.0), (double)handOffMS, numChurn / (handOffMS * 1000.0));
+    }
+}
+
+void Benchmark::ArrayGrowth()
+{
+    const uint32_t kRecords = 100 * 1000 * 1000;
+    const double gigabytes = (double)kRecords * sizeof(BenchmarkRecord) / (1024.0 * 1024.0 * 1024.0);
+
+    // Each array is freed before the next is made, so only one is in memory at a time
+    float presizedMS;
+    {
+        Array<BenchmarkRecord> records;
+        records.SetCapacity(kRecords);
+        presizedMS = BenchmarkAppendRecords(records, kRecords);
+    }
+    float relocatedMS;
+    {
+        Array<BenchmarkRecord> records;
+        relocatedMS = BenchmarkAppendRecords(records, kRecords);
+    }
+    float movedMS;
+    {
+        Array<BenchmarkMovedRecord> records;
+        movedMS = BenchmarkAppendRecords(records, kRecords);
+    }
+
+    OUTPUT("Array growth: %u records of %u bytes appended one at a time, %.2f GB\n", kRecords, (uint32_t)sizeof(BenchmarkRecord), gigabytes);
+    OUTPUT("                              time       GB/s\n");
+    OUTPUT("  capacity reserved    %10.2f ms %10.2f\n", (double)presizedMS, gigabytes / (presizedMS * 0.001));
+    OUTPUT("  relocated            %10.2f ms %10.2f\n", (double)relocatedMS, gigabytes / (relocatedMS * 0.001));
+    OUTPUT("  moved one at a time  %10.2f ms %10.2f\n", (double)movedMS, gigabytes / (movedMS * 0.001));
+}
+
+void Benchmark::Sorting()
+{
+    // Shell sort is near quadratic, so it's left out of the larger sizes
+    const uint32_t kShellSortMax = 100 * 1000;
+    const uint32_t kMaxRecords = 100 * 1000 * 1000;
+    const uint32_t numThreads = SortJobs::GetDefaultNumThreads();
+
+    OUTPUT("Sorting: records of %u bytes by a random 20 bit chunk ID, parallel sort on %u threads\n", (uint32_t)sizeof(BenchmarkRecord), numThreads);
+    OUTPUT("     records     shell sort      introsort     radix sort  parallel sort\n");
+    for (uint32_t count = 1000; count <= kMaxRecords; count *= 10)
+    {
+        Array<BenchmarkRecord> records;
+        float shellMS = 0.0f;
+        if (count <= kShellSortMax)
+        {
+            BenchmarkFillRecords(records, count);
+            const Timer timer;
+            ShellSort(records.Begin(), records.End(), BenchmarkRecordChunkLess);
+            shellMS = timer.GetElapsedMS();
+        }
+
+        BenchmarkFillRecords(records, count);
+        Timer timer;
+        records.Sort(BenchmarkRecordChunkLess);
+        const float introMS = timer.GetElapsedMS();
+
+        BenchmarkFillRecords(records, count);
+        timer.Start();
+        records.SortByKey([](const BenchmarkRecord& record) { return record.mOwner; });
+        const float radixMS = timer.GetElapsedMS();
+
+        BenchmarkFillRecords(records, count);
+        timer.Start();
+        records.SortParallel(BenchmarkRecordChunkLess);
+        const float parallelMS = timer.GetElapsedMS();
+
+        if (count <= kShellSortMax)
+        {
+            OUTPUT("  %10u  %10.2f ms  %10.2f ms  %10.2f ms  %10.2f ms\n", count, (double)shellMS, (double)introMS, (double)radixMS, (double)parallelMS);
+        }
+        else
+        {
+            OUTPUT("  %10u              -  %10.2f ms  %10.2f ms  %10.2f ms\n", count, (double)introMS, (double)radixMS, (double)parallelMS);
+        }
+    }
+}
+
+void Benchmark::PooledObjects()
+{
+    const uint32_t kUnits = 1000 * 1000;
+    const uint32_t kChurnRounds = 5;
+    const uint32_t kTicks = 20;
+    const auto initUnit = [](BenchmarkUnit& unit, uint32_t i)
+    {
+        unit = {};
+        unit.mVelX = (float)(i & 7);
+        unit.mVelY = 1.0f;
+        unit.mOwner = i;
+    };
+
+    // Each unit allocated on its own, and ticked through the array of pointers to them
+    float heapChurnMS;
+    float heapTickMS;
+    {
+        Array<BenchmarkUnit*> units;
+        heapChurnMS = BenchmarkChurnUnits(units, kUnits, kChurnRounds,
+            [&](uint32_t i) { BenchmarkUnit* unit = FNEW(BenchmarkUnit); initUnit(*unit, i); return unit; },
+            [](BenchmarkUnit* unit) { FDELETE unit; });
+        const Timer timer;
+        for (uint32_t tick = 0; tick < kTicks; ++tick)
+        {
+            for (BenchmarkUnit* unit : units)
+            {
+                BenchmarkMoveUnit(*unit);
+            }
+        }
+        heapTickMS = timer.GetElapsedMS() / kTicks;
+        for (BenchmarkUnit* unit : units)
+        {
+            FDELETE unit;
+        }
+    }
+
+    // Units in a pool, ticked in address order
+    float poolChurnMS;
+    float poolTickMS;
+    size_t poolPages;
+    {
+        ObjectPool<BenchmarkUnit> pool;
+        Array<BenchmarkUnit*> units;
+        poolChurnMS = BenchmarkChurnUnits(units, kUnits, kChurnRounds,
+            [&](uint32_t i) { BenchmarkUnit* unit = pool.Create(); initUnit(*unit, i); return unit; },
+            [&](BenchmarkUnit* unit) { pool.Destroy(unit); });
+        const Timer timer;
+        for (uint32_t tick = 0; tick < kTicks; ++tick)
+        {
+            pool.ForEach([](BenchmarkUnit& unit) { BenchmarkMoveUnit(unit); });
+        }
+        poolTickMS = timer.GetElapsedMS() / kTicks;
+        poolPages = pool.GetNumPages();
+    }
+
+    OUTPUT("Pooled objects: %u units of %u bytes, a random half replaced %u times, then ticked\n", kUnits, (uint32_t)sizeof(BenchmarkUnit), kChurnRounds);
+    OUTPUT("                      create/destroy        tick\n");
+    OUTPUT("  allocated each     %13.2f ms %8.2f ms\n", (double)heapChurnMS, (double)heapTickMS);
+    OUTPUT("  object pool        %13.2f ms %8.2f ms   %u pages of 64 KB\n", (double)poolChurnMS, (double)poolTickMS, (uint32_t)poolPages);
+}
+
+void Benchmark::LargePages()
+{
+    const uint32_t kSize = 4096;
+    const uint32_t kSamples = 20 * 1000 * 1000;
+    const double megabytes = (double)kSize * kSize * sizeof(Land) / (1024.0 * 1024.0);
+
+    // Each map is freed before the next is made, so only one is in memory at a time
+    float sum = 0.0f;
+    float heapMS;
+    {
+        Array<Land> land;
+        land.SetSize((size_t)kSize * kSize);
+        heapMS = BenchmarkSampleLand(land, kSize, kSamples, sum);
+    }
+    float largePagesMS;
+    ::LargePages::Stats stats;
+    {
+        LargePageArray<Land> land;
+        land.SetSize((size_t)kSize * kSize);
+        largePagesMS = BenchmarkSampleLand(land, kSize, kSamples, sum);
+        ::LargePages::GetStats(stats);
+    }
+
+    const double toMB = 1.0 / (1024.0 * 1024.0);
+    OUTPUT("Large pages: %u random samples of the tiles around a point on a %ux%u map, %.0f MB, sample sum %.0f\n", kSamples, kSize, kSize, megabytes, (double)sum);
+    OUTPUT("                          time      ns/sample\n");
+    OUTPUT("  heap             %10.2f ms %10.2f\n", (double)heapMS, heapMS * 1000000.0 / kSamples);
+    OUTPUT("  large pages      %10.2f ms %10.2f\n", (double)largePagesMS, largePagesMS * 1000000.0 / kSamples);
+    OUTPUT("  %u regions, %.0f MB mapped, %.0f MB resident, %.0f MB on large pages, %.0f MB from the reserved pool\n", stats.m_NumRegions,
+           stats.m_MappedBytes * toMB, stats.m_ResidentBytes * toMB, stats.m_LargePageBytes * toMB, stats.m_ExplicitBytes * toMB);
+}
+
+void Benchmark::Queues()
+{
+    const uint32_t kItemsPerProducer = 500000;
+    const uint32_t kCapacity = 1024;
+    const uint32_t kMaxProducers = 8;
+
+    Array<BenchmarkQueueItem> items;
+    items.SetSize((size_t)kItemsPerProducer * kMaxProducers);
+
+    uint32_t outOfOrder = 0;
+    OUTPUT("Queues: 1 to %u producer threads pushing %u items each to one consumer, capacity %u, wall clock ms (M items/s)\n", kMaxProducers, kItemsPerProducer, kCapacity);
+    OUTPUT("  producers   gte::ThreadSafeQueue       MPSCQueue    IntrusiveMPSCQueue       SPSCQueue\n");
+    for (uint32_t numProducers = 1; numProducers <= kMaxProducers; numProducers *= 2)
+    {
+        const double numItems = (double)kItemsPerProducer * numProducers;
+        float mutexMS;
+        {
+            gte::ThreadSafeQueue<uint64_t> queue(kCapacity);
+            mutexMS = BenchmarkRunQueue(queue, items, numProducers, kItemsPerProducer, outOfOrder);
+        }
+        float mpscMS;
+        {
+            MPSCQueue<uint64_t> queue(kCapacity);
+            mpscMS = BenchmarkRunQueue(queue, items, numProducers, kItemsPerProducer, outOfOrder);
+        }
+        float intrusiveMS;
+        {
+            IntrusiveMPSCQueue<BenchmarkQueueItem> queue;
+            intrusiveMS = BenchmarkRunQueue(queue, items, numProducers, kItemsPerProducer, outOfOrder);
+        }
+
+        // Only for one producer
+        AStackString<> spsc("-");
+        if (numProducers == 1)
+        {
+            SPSCQueue<uint64_t> queue(kCapacity);
+            const float spscMS = BenchmarkRunQueue(queue, items, numProducers, kItemsPerProducer, outOfOrder);
+            spsc.Format("%.1f (%5.1f)", (double)spscMS, numItems / (spscMS * 1000.0));
+        }
+
+        OUTPUT("  %9u   %12.1f (%5.1f)   %7.1f (%5.1f)   %12.1f (%5.1f)   %14s\n", numProducers, (double)mutexMS, numItems / (mutexMS * 1000.0), (double)mpscMS,
+               numItems / (mpscMS * 1000.0), (double)intrusiveMS, numItems / (intrusiveMS * 1000.0), spsc.Get());
+    }
+    OUTPUT("  %u items popped out of their producer's order\n", outOfOrder);
+}
+
+void Benchmark::World()
+{
+    const uint32_t kSize = 512;
+    const uint32_t kSettlements = 200;
+    const uint32_t kAgentsPerSettlement = 100;
+    const uint32_t kUnits = 2000;
+    const uint32_t kWarmupFrames = 300;
+    const uint32_t kFrames = 300;
+    const float kFrameSeconds = 1.0f / 60.0f;
+    const float kUnitSize = 0.5f;
+    const float kUnitStep = 0.25f;
+
+    ::World world(kSize, kSize, 0);
+    Random random(kSettlements);
+    for (uint32_t i = 0; i < kSettlements; ++i)
+    {
+        AStackString<> name;
+        name.Format("Settlement %u", i);
+        Settlement& settlement = world.FoundSettlement(name, 8 + random.GetRandIndex(kSize - 16), 8 + random.GetRandIndex(kSize - 16));
+        Building& building = settlement.mBuildings.EmplaceBack();
+        building.mWorkers = 4;
+        building.mFoodPerWorker = 0.2f;
+        building.mWoodPerWorker = 0.1f;
+    }
+
+    // A road from each settlement to the next, and agents working around each
+    const Array<Settlement>& settlements = world.GetSettlements();
+    for (uint32_t i = 1; i < kSettlements; ++i)
+    {
+        world.BuildRoad(settlements[i - 1].mX, settlements[i - 1].mY, settlements[i].mX, settlements[i].mY);
+    }
+    AgentStore& agents = world.GetAgents();
+    agents.Reserve((size_t)kSettlements * kAgentsPerSettlement);
+    for (const Settlement& settlement : settlements)
+    {
+        for (uint32_t i = 0; i < kAgentsPerSettlement; ++i)
+        {
+            AgentStore::Task task;
+            task.mHomeX = (float)settlement.mX + 0.5f;
+            task.mHomeY = (float)settlement.mY + 0.5f;
+            task.mWorkX = task.mHomeX + (random.GetRandFloat() - 0.5f) * 16.0f;
+            task.mWorkY = task.mHomeY + (random.GetRandFloat() - 0.5f) * 16.0f;
+            task.mWorkTime = 2.0f + random.GetRandFloat() * 8.0f;
+            task.mYield = 1.0f;
+            task.mResource = i & 1;
+            agents.Assign(agents.Add(task.mHomeX, task.mHomeY, settlement.mId), agents.AddTask(task));
+        }
+    }
+
+    // Units wandering the map, for the footprint overlaps to follow
+    FootprintOverlaps& footprints = world.GetFootprints();
+    Array<uint32_t> units;
+    for (uint32_t i = 0; i < kUnits; ++i)
+    {
+        const float x = random.GetRandFloat() * ((float)kSize - 1.0f);
+        const float y = random.GetRandFloat() * ((float)kSize - 1.0f);
+        units.Append(footprints.Add({ x, y, x + kUnitSize, y + kUnitSize }));
+    }
+
+    // As the app runs it, with frame memory released after each update
+    auto runFrame = [&]()
+    {
+        for (const uint32_t unit : units)
+        {
+            FootprintOverlaps::Rectangle rectangle = footprints.GetRectangle(unit);
+            rectangle.mMinX = Math::Clamp(rectangle.mMinX + (random.GetRandFloat() - 0.5f) * 2.0f * kUnitStep, 0.0f, (float)kSize - 1.0f);
+            rectangle.mMinY = Math::Clamp(rectangle.mMinY + (random.GetRandFloat() - 0.5f) * 2.0f * kUnitStep, 0.0f, (float)kSize - 1.0f);
+            rectangle.mMaxX = rectangle.mMinX + kUnitSize;
+            rectangle.mMaxY = rectangle.mMinY + kUnitSize;
+            footprints.SetRectangle(unit, rectangle);
+        }
+        world.Update(kFrameSeconds);
+        FrameArena::EndFrame();
+    };
+    for (uint32_t frame = 0; frame < kWarmupFrames; ++frame)
+    {
+        runFrame();
+    }
+
+    // Allocations are counted by category. Those on worker threads reach the totals in
+    // batches, so they may only show in a later frame.
+    uint64_t previous[MemStats::MAX_CATEGORIES] = {};
+    uint64_t allocations[MemStats::MAX_CATEGORIES] = {};
+    auto countAllocations = [&]()
+    {
+        MemStats::FlushThreadCounters();
+        uint64_t total = 0;
+        for (uint32_t category = 0; category < MemStats::GetNumCategories(); ++category)
+        {
+            MemStats::CategoryStats stats;
+            MemStats::GetStats((uint8_t)category, stats);
+            const uint64_t made = stats.m_TotalAllocs - previous[category];
+            previous[category] = stats.m_TotalAllocs;
+            allocations[category] += made;
+            total += made;
+        }
+        return total;
+    };
+    countAllocations();
+    memset(allocations, 0, sizeof(allocations));
+
+    float totalMS = 0.0f;
+    float worstMS = 0.0f;
+    uint32_t allocatingFrames = 0;
+    uint64_t totalAllocations = 0;
+    for (uint32_t frame = 0; frame < kFrames; ++frame)
+    {
+        const Timer timer;
+        runFrame();
+        const float ms = timer.GetElapsedMS();
+        totalMS += ms;
+        worstMS = Math::Max(worstMS, ms);
+
+        const uint64_t frameAllocations = countAllocations();
+        allocatingFrames += (frameAllocations > 0) ? 1 : 0;
+        totalAllocations += frameAllocations;
+    }
+
+    OUTPUT("World: %ux%u tiles, %u settlements, %u agents, %u moving units, %u threads\n", kSize, kSize, kSettlements,
+           kSettlements * kAgentsPerSettlement, kUnits, ParallelForGetNumThreads());
+    OUTPUT("  %.2f ms/frame at %.0f frames a second (worst %.2f ms) after %u frames to warm up\n", (double)(totalMS / (float)kFrames),
+           (double)(1.0f / kFrameSeconds), (double)worstMS, kWarmupFrames);
+    OUTPUT("  %u of %u frames allocated from the heap, %.2f allocations per frame\n", allocatingFrames, kFrames,
+           (double)totalAllocations / (double)kFrames);
+    uint64_t unexpected = 0;
+    for (uint32_t category = 0; category < MemStats::GetNumCategories(); ++category)
+    {
+        if (allocations[category])
+        {
+            MemStats::CategoryStats stats;
+            MemStats::GetStats((uint8_t)category, stats);
+            OUTPUT("    %-16s %10.2f per frame\n", stats.m_Name, (double)allocations[category] / (double)kFrames);
+            if (strcmp(stats.m_Name, "Footprints") != 0)
+            {
+                unexpected += allocations[category];
+            }
+        }
+    }
+
+    // Only the footprint overlaps are expected to allocate, from GTE's overlap set
+    if (unexpected > 0)
+    {
+        OUTPUT("  FAILED: %llu allocations outside the footprint overlaps\n", (unsigned long long)unexpected);
+    }
+    ASSERT(unexpected == 0);
+}
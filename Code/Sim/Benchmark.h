@@ -0,0 +1,69 @@
+#pragma once
+
+// Timings of sim systems at scale, results are written with OUTPUT
+namespace Benchmark
+{
+    // Tick cost against settlement count for several level of detail tier mixes
+    void SettlementLod();
+
+    // Schedule, cancel and delivery cost of the timing wheel with 10M pending timers
+    void ScheduledEvents();
+
+    // Tick cost of 1M agents working tasks, against the 50 ms available at 20 Hz
+    void Agents();
+
+    // Worker to job assignment cost as workers and jobs grow to 100k
+    void JobAssignment();
+
+    // Building and incrementally updating trade route costs between 5000 settlements
+    void TradeNetwork();
+
+    // Contraction, query and background re-contraction cost of a 65k junction road network
+    void RoadNetwork();
+
+    // Labelling an 8192x8192 map's land regions, and relabelling as tiles change passability
+    void Regions();
+
+    // Filling depressions and accumulating flow over an 8192x8192 heightmap
+    void Hydrology();
+
+    // Per iteration cost of eroding an 8192x8192 heightmap, with and without AVX2
+    void Erosion();
+
+    // Building and updating the territory polygons of 5000 settlements as they're founded and destroyed
+    void TerritoryCells();
+
+    // Building a navigation mesh over a 2048x2048 map, placing and removing buildings, and finding paths
+    void NavMesh();
+
+    // Finding the nearest 1 and 8 of 50000 sites to 100000 agents, and rebuilding as sites move
+    void NearestSites();
+
+    // Keeping the overlaps between 10000 building footprints and 2000 moving units up to date, validating placements each tick
+    void Footprints();
+
+    // Inserting and finding 100000 string keys, and many small maps, in UnorderedMap and FlatHashMap
+    void HashMap();
+
+    // Small allocations and frees on 1 to 32 threads, on the thread that allocated them and on another
+    void SmallAllocations();
+
+    // Appending 100M plain records to an Array, relocated as memory as it grows or moved one at a time
+    void ArrayGrowth();
+
+    // Sorting 1K to 100M records by chunk ID with shell sort, introsort, radix sort and parallel sort
+    void Sorting();
+
+    // Creating, destroying and ticking 1M units allocated one at a time and in an object pool
+    void PooledObjects();
+
+    // Random reads around points of a 4096x4096 map of land in heap memory and in large pages
+    void LargePages();
+
+    // 1 to 8 producer threads handing items to one consumer through a mutex and lock-free queues
+    void Queues();
+
+    // Frame cost of a populated 512x512 world, and the heap allocations its warmed up frames still make,
+    // which fails if any come from outside the footprint overlaps
+    void World();
+}
@@ -0,0 +1,280 @@
+#include "Erosion.h"
+
+#include <Sim/ParallelFor.h>
+
+#include <Core/Env/Assert.h>
+#include <Core/Math/Conversions.h>
+#include <Core/Time/Timer.h>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+    #define EROSION_AVX2
+#else
+    #include <immintrin.h>
+    #define EROSION_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    const uint32_t kErosionChunkRows = 16;
+
+    // Per iteration, heights and water are in units of the tile spacing
+    const float kErosionRain = 0.01f;
+    const float kErosionEvaporation = 0.02f;
+    // Fraction of the difference in water level that flows to each lower neighbour, at most
+    // a quarter so a tile can't send more water than it has
+    const float kErosionFlow = 0.125f;
+    // Sediment a tile's water can carry per unit of water flowing out of it
+    const float kErosionCapacity = 4.0f;
+    const float kErosionErodeRate = 0.05f;
+    const float kErosionDepositRate = 0.1f;
+    // Keeps the sediment concentration finite on dry tiles
+    const float kErosionMinWater = 1e-4f;
+    // Height difference to a neighbour above which a slope slumps, and the fraction of the
+    // excess that moves
+    const float kErosionTalus = 0.7f;
+    const float kErosionThermalRate = 0.1f;
+
+    // Rows above, at and below the row being updated, clamped to the map so tiles off the
+    // map are copies of the edge tiles and nothing flows to them
+    struct ErosionRow
+    {
+        const float* mHeights[3];
+        const float* mWater[3];
+        const float* mSediment[3];
+        float* mOutHeights;
+        float* mOutWater;
+        float* mOutSediment;
+    };
+
+    void ErosionTile(const ErosionRow& row, uint32_t x, uint32_t left, uint32_t right)
+    {
+        const float h = row.mHeights[1][x];
+        const float w = row.mWater[1][x];
+        const float s = row.mSediment[1][x];
+        const float level = h + w;
+        const float concentration = s / (w + kErosionMinWater);
+
+        // Left, right, up and down
+        const float* const neighbourHeights[4] = { row.mHeights[1] + left, row.mHeights[1] + right, row.mHeights[0] + x, row.mHeights[2] + x };
+        const float* const neighbourWater[4] = { row.mWater[1] + left, row.mWater[1] + right, row.mWater[0] + x, row.mWater[2] + x };
+        const float* const neighbourSediment[4] = { row.mSediment[1] + left, row.mSediment[1] + right, row.mSediment[0] + x, row.mSediment[2] + x };
+
+        float outflow = 0.0f;
+        float inflow = 0.0f;
+        float sedimentInflow = 0.0f;
+        float slump = 0.0f;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const float nh = *neighbourHeights[i];
+            const float nw = *neighbourWater[i];
+            const float ns = *neighbourSediment[i];
+            const float nLevel = nh + nw;
+            const float in = Math::Min(nw, Math::Max(nLevel - level, 0.0f));
+            outflow = outflow + Math::Min(w, Math::Max(level - nLevel, 0.0f));
+            inflow = inflow + in;
+            sedimentInflow = sedimentInflow + in * (ns / (nw + kErosionMinWater));
+            slump = slump + (Math::Max((h - nh) - kErosionTalus, 0.0f) - Math::Max((nh - h) - kErosionTalus, 0.0f));
+        }
+        outflow = outflow * kErosionFlow;
+
+        // Erode towards the water's capacity, or deposit the sediment over it
+        float sediment = (s - outflow * concentration) + sedimentInflow * kErosionFlow;
+        const float excess = sediment - outflow * kErosionCapacity;
+        const float change = excess * ((excess > 0.0f) ? kErosionDepositRate : kErosionErodeRate);
+        sediment = sediment - change;
+
+        row.mOutHeights[x] = (h + change) - slump * kErosionThermalRate;
+        row.mOutWater[x] = ((w - outflow) + inflow * kErosionFlow) * (1.0f - kErosionEvaporation) + kErosionRain;
+        row.mOutSediment[x] = sediment;
+    }
+
+    // Same as ErosionTile for tiles [x0, x1), which must have neighbours on both sides
+    EROSION_AVX2 void ErosionTilesAvx2(const ErosionRow& row, uint32_t x0, uint32_t x1)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 minWater = _mm256_set1_ps(kErosionMinWater);
+        const __m256 flow = _mm256_set1_ps(kErosionFlow);
+        const __m256 capacity = _mm256_set1_ps(kErosionCapacity);
+        const __m256 depositRate = _mm256_set1_ps(kErosionDepositRate);
+        const __m256 erodeRate = _mm256_set1_ps(kErosionErodeRate);
+        const __m256 talus = _mm256_set1_ps(kErosionTalus);
+        const __m256 thermalRate = _mm256_set1_ps(kErosionThermalRate);
+        const __m256 keep = _mm256_set1_ps(1.0f - kErosionEvaporation);
+        const __m256 rain = _mm256_set1_ps(kErosionRain);
+
+        for (uint32_t x = x0; x < x1; x += 8)
+        {
+            const __m256 h = _mm256_loadu_ps(row.mHeights[1] + x);
+            const __m256 w = _mm256_loadu_ps(row.mWater[1] + x);
+            const __m256 s = _mm256_loadu_ps(row.mSediment[1] + x);
+            const __m256 level = _mm256_add_ps(h, w);
+            const __m256 concentration = _mm256_div_ps(s, _mm256_add_ps(w, minWater));
+
+            const float* const neighbourHeights[4] = { row.mHeights[1] + x - 1, row.mHeights[1] + x + 1, row.mHeights[0] + x, row.mHeights[2] + x };
+            const float* const neighbourWater[4] = { row.mWater[1] + x - 1, row.mWater[1] + x + 1, row.mWater[0] + x, row.mWater[2] + x };
+            const float* const neighbourSediment[4] = { row.mSediment[1] + x - 1, row.mSediment[1] + x + 1, row.mSediment[0] + x, row.mSediment[2] + x };
+
+            __m256 outflow = zero;
+            __m256 inflow = zero;
+            __m256 sedimentInflow = zero;
+            __m256 slump = zero;
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                const __m256 nh = _mm256_loadu_ps(neighbourHeights[i]);
+                const __m256 nw = _mm256_loadu_ps(neighbourWater[i]);
+                const __m256 ns = _mm256_loadu_ps(neighbourSediment[i]);
+                const __m256 nLevel = _mm256_add_ps(nh, nw);
+                const __m256 in = _mm256_min_ps(nw, _mm256_max_ps(_mm256_sub_ps(nLevel, level), zero));
+                outflow = _mm256_add_ps(outflow, _mm256_min_ps(w, _mm256_max_ps(_mm256_sub_ps(level, nLevel), zero)));
+                inflow = _mm256_add_ps(inflow, in);
+                sedimentInflow = _mm256_add_ps(sedimentInflow, _mm256_mul_ps(in, _mm256_div_ps(ns, _mm256_add_ps(nw, minWater))));
+                const __m256 down = _mm256_max_ps(_mm256_sub_ps(_mm256_sub_ps(h, nh), talus), zero);
+                const __m256 up = _mm256_max_ps(_mm256_sub_ps(_mm256_sub_ps(nh, h), talus), zero);
+                slump = _mm256_add_ps(slump, _mm256_sub_ps(down, up));
+            }
+            outflow = _mm256_mul_ps(outflow, flow);
+
+            __m256 sediment = _mm256_add_ps(_mm256_sub_ps(s, _mm256_mul_ps(outflow, concentration)), _mm256_mul_ps(sedimentInflow, flow));
+            const __m256 excess = _mm256_sub_ps(sediment, _mm256_mul_ps(outflow, capacity));
+            const __m256 rate = _mm256_blendv_ps(erodeRate, depositRate, _mm256_cmp_ps(excess, zero, _CMP_GT_OQ));
+            const __m256 change = _mm256_mul_ps(excess, rate);
+            sediment = _mm256_sub_ps(sediment, change);
+
+            const __m256 water = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(w, outflow), _mm256_mul_ps(inflow, flow)), keep), rain);
+            _mm256_storeu_ps(row.mOutHeights + x, _mm256_sub_ps(_mm256_add_ps(h, change), _mm256_mul_ps(slump, thermalRate)));
+            _mm256_storeu_ps(row.mOutWater + x, water);
+            _mm256_storeu_ps(row.mOutSediment + x, sediment);
+        }
+    }
+
+    bool ErosionCpuHasAvx2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        // The OS has to save the AVX registers too
+        __cpuid(info, 1);
+        const int kOsXSave = 1 << 27;
+        const int kAvx = 1 << 28;
+        if (((info[2] & kOsXSave) == 0) || ((info[2] & kAvx) == 0) || ((_xgetbv(0) & 6) != 6))
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+}
+
+bool Erosion::IsUsingSimd() const
+{
+    static const bool hasAvx2 = ErosionCpuHasAvx2();
+    return mSimd && hasAvx2;
+}
+
+float Erosion::GetMeanIterationMS() const
+{
+    float total = 0.0f;
+    for (const float ms : mIterationMS)
+    {
+        total += ms;
+    }
+    return mIterationMS.IsEmpty() ? 0.0f : total / (float)mIterationMS.GetSize();
+}
+
+void Erosion::Run(uint32_t width, uint32_t height, Array<float>& heights, uint32_t numIterations)
+{
+    const size_t numTiles = (size_t)width * height;
+    ASSERT(heights.GetSize() == numTiles);
+
+    mHeights[0] = heights;
+    mCurrent = 0;
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        mHeights[i].SetSize(numTiles);
+        mWater[i].SetSize(numTiles);
+        mSediment[i].SetSize(numTiles);
+    }
+    ParallelFor(height, kErosionChunkRows, [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin * width; tile < end * width; ++tile)
+        {
+            mWater[0][tile] = 0.0f;
+            mSediment[0][tile] = 0.0f;
+        }
+    });
+
+    mIterationMS.Clear();
+    mIterationMS.SetCapacity(numIterations);
+    for (uint32_t i = 0; i < numIterations; ++i)
+    {
+        const Timer timer;
+        Step(width, height);
+        mIterationMS.Append(timer.GetElapsedMS());
+    }
+
+    // Sediment still carried settles where it is
+    const Array<float>& finalHeights = mHeights[mCurrent];
+    const Array<float>& finalSediment = mSediment[mCurrent];
+    ParallelFor(height, kErosionChunkRows, [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin * width; tile < end * width; ++tile)
+        {
+            heights[tile] = finalHeights[tile] + finalSediment[tile];
+        }
+    });
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        mHeights[i].Destruct();
+        mWater[i].Destruct();
+        mSediment[i].Destruct();
+    }
+}
+
+void Erosion::Step(uint32_t width, uint32_t height)
+{
+    const uint32_t from = mCurrent;
+    const uint32_t to = 1 - mCurrent;
+    const bool simd = IsUsingSimd();
+    ParallelFor(height, kErosionChunkRows, [&](size_t begin, size_t end)
+    {
+        for (uint32_t y = (uint32_t)begin; y < end; ++y)
+        {
+            const size_t rows[3] = { (size_t)width * ((y > 0) ? y - 1 : y), (size_t)width * y, (size_t)width * ((y + 1 < height) ? y + 1 : y) };
+            ErosionRow row;
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                row.mHeights[i] = mHeights[from].Begin() + rows[i];
+                row.mWater[i] = mWater[from].Begin() + rows[i];
+                row.mSediment[i] = mSediment[from].Begin() + rows[i];
+            }
+            row.mOutHeights = mHeights[to].Begin() + rows[1];
+            row.mOutWater = mWater[to].Begin() + rows[1];
+            row.mOutSediment = mSediment[to].Begin() + rows[1];
+
+            // Edge tiles are their own neighbours off the map
+            uint32_t x = 0;
+            ErosionTile(row, x, x, Math::Min(x + 1, width - 1));
+            ++x;
+            if (simd && (width > 9))
+            {
+                const uint32_t simdEnd = 1 + ((width - 2) & ~7u);
+                ErosionTilesAvx2(row, x, simdEnd);
+                x = simdEnd;
+            }
+            for (; x < width; ++x)
+            {
+                ErosionTile(row, x, x - 1, Math::Min(x + 1, width - 1));
+            }
+        }
+    });
+    mCurrent = to;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Hydraulic and thermal erosion of a heightmap, to carve valleys and soften slopes in
+// generated terrain. Rain falls on every tile, water flows to lower neighbours carrying
+// sediment it picks up from fast flowing tiles and drops on slow ones, and slopes steeper
+// than the talus angle slump towards their neighbours.
+//
+// Each iteration is a stencil over the four neighbours of every tile, reading one copy of
+// the terrain, water and sediment and writing the other, so rows can be updated in any
+// order and the result doesn't depend on the number of threads. Rows are split into chunks
+// across threads and updated eight tiles at a time with AVX2 when the CPU supports it.
+class Erosion
+{
+public:
+    // Heights has one entry per tile in units of the tile spacing, and is eroded in place
+    void Run(uint32_t width, uint32_t height, Array<float>& heights, uint32_t numIterations);
+
+    // Whether to use AVX2 on CPUs that have it, the scalar path gives identical results
+    void SetSimd(bool simd) { mSimd = simd; }
+    bool IsUsingSimd() const;
+
+    // Timings of each iteration of the last Run
+    const Array<float>& GetIterationMS() const { return mIterationMS; }
+    float GetMeanIterationMS() const;
+
+private:
+    void Step(uint32_t width, uint32_t height);
+
+    bool mSimd = true;
+
+    // Read and written alternately by each iteration
+    Array<float> mHeights[2];
+    Array<float> mWater[2];
+    Array<float> mSediment[2];
+    uint32_t mCurrent = 0;
+
+    Array<float> mIterationMS;
+};
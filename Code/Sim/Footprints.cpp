@@ -0,0 +1,247 @@
+#include "Footprints.h"
+
+#include <Mathematics/RectangleManager.h>
+
+#include <Core/Env/Assert.h>
+#include <Core/Math/Conversions.h>
+
+namespace
+{
+    const uint32_t kFootprintMinSlots = 64;
+    const uint32_t kFootprintFreeCellSize = 32;
+
+    // A parked slot is a point across but upside down vertically, top below bottom by
+    // twice this. GTE's box test can only find it overlapping a rectangle at least
+    // kMaxHeight high, and the sweep in Initialize doesn't keep it active.
+    const float kFootprintParkedExtent = FootprintOverlaps::kMaxHeight * 0.5f;
+
+    gte::AlignedBox2<float> FootprintBox(float minX, float minY, float maxX, float maxY)
+    {
+        return gte::AlignedBox2<float>(gte::Vector<2, float>{ minX, minY }, gte::Vector<2, float>{ maxX, maxY });
+    }
+}
+
+// RectangleManager keeps a reference to the rectangles, so they're declared first.
+// Turning a parked slot the right way up makes its own sides cross, and the manager
+// adds a pair of the slot with itself, which reading the overlaps skips.
+class FootprintSweep
+{
+public:
+    FootprintSweep()
+        : mManager(mBoxes)
+    {
+    }
+
+    std::vector<gte::AlignedBox2<float>> mBoxes;
+    gte::RectangleManager<float> mManager;
+};
+
+FootprintOverlaps::FootprintOverlaps() = default;
+FootprintOverlaps::~FootprintOverlaps() = default;
+
+void FootprintOverlaps::Init(uint32_t width, uint32_t height)
+{
+    mWidth = width;
+    mHeight = height;
+    mSweep = new FootprintSweep;
+    mInUse.Clear();
+    mFreeCellsX = (width + kFootprintFreeCellSize - 1) / kFootprintFreeCellSize;
+    mFreeCellsY = (height + kFootprintFreeCellSize - 1) / kFootprintFreeCellSize;
+    mFreeCells.Clear();
+    mFreeCells.SetSize((size_t)mFreeCellsX * mFreeCellsY);
+    mNumFree = 0;
+    mNumRectangles = 0;
+    mNumChanges = 0;
+    mLastChangeCount = 0;
+}
+
+FootprintOverlaps::Rectangle FootprintOverlaps::FromTiles(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    ASSERT(x0 < x1 && y0 < y1);
+    return { (float)x0, (float)y0, (float)(x1 - 1), (float)(y1 - 1) };
+}
+
+uint32_t FootprintOverlaps::Add(const Rectangle& rectangle)
+{
+    ASSERT(mSweep.Get());
+    if (mNumFree == 0)
+    {
+        Grow();
+    }
+    const uint32_t handle = TakeFreeSlot((rectangle.mMinX + rectangle.mMaxX) * 0.5f, (rectangle.mMinY + rectangle.mMaxY) * 0.5f);
+    mInUse[handle] = true;
+    ++mNumRectangles;
+    SetRectangle(handle, rectangle);
+    return handle;
+}
+
+void FootprintOverlaps::SetRectangle(uint32_t handle, const Rectangle& rectangle)
+{
+    ASSERT(mInUse[handle]);
+    ASSERT(rectangle.mMinX <= rectangle.mMaxX && rectangle.mMinY <= rectangle.mMaxY);
+    ASSERT(rectangle.mMaxY - rectangle.mMinY < kMaxHeight);
+    mSweep->mManager.SetRectangle((int32_t)handle, FootprintBox(rectangle.mMinX, rectangle.mMinY, rectangle.mMaxX, rectangle.mMaxY));
+    ++mNumChanges;
+}
+
+// The slot is parked where the rectangle was, so its sides only cross those nearby
+void FootprintOverlaps::Remove(uint32_t handle)
+{
+    const Rectangle rectangle = GetRectangle(handle);
+    mInUse[handle] = false;
+    --mNumRectangles;
+    Park(handle, (rectangle.mMinX + rectangle.mMaxX) * 0.5f, (rectangle.mMinY + rectangle.mMaxY) * 0.5f);
+    ++mNumChanges;
+}
+
+FootprintOverlaps::Rectangle FootprintOverlaps::GetRectangle(uint32_t handle) const
+{
+    ASSERT(mInUse[handle]);
+    gte::AlignedBox2<float> box;
+    mSweep->mManager.GetRectangle((int32_t)handle, box);
+    return { box.min[0], box.min[1], box.max[0], box.max[1] };
+}
+
+void FootprintOverlaps::Park(uint32_t slot, float x, float y)
+{
+    mSweep->mManager.SetRectangle((int32_t)slot, FootprintBox(x, y + kFootprintParkedExtent, x, y - kFootprintParkedExtent));
+
+    const uint32_t cellX = Math::Min((uint32_t)Math::Max(x, 0.0f) / kFootprintFreeCellSize, mFreeCellsX - 1);
+    const uint32_t cellY = Math::Min((uint32_t)Math::Max(y, 0.0f) / kFootprintFreeCellSize, mFreeCellsY - 1);
+    mFreeCells[cellX + (size_t)mFreeCellsX * cellY].Append(slot);
+    ++mNumFree;
+}
+
+// A free slot from the nearest ring of cells around the point with one
+uint32_t FootprintOverlaps::TakeFreeSlot(float x, float y)
+{
+    ASSERT(mNumFree > 0);
+    const int32_t cellX = (int32_t)Math::Min((uint32_t)Math::Max(x, 0.0f) / kFootprintFreeCellSize, mFreeCellsX - 1);
+    const int32_t cellY = (int32_t)Math::Min((uint32_t)Math::Max(y, 0.0f) / kFootprintFreeCellSize, mFreeCellsY - 1);
+    for (int32_t ring = 0;; ++ring)
+    {
+        for (int32_t dy = -ring; dy <= ring; ++dy)
+        {
+            const int32_t ny = cellY + dy;
+            if ((ny < 0) || (ny >= (int32_t)mFreeCellsY))
+            {
+                continue;
+            }
+            // Only the ends of rows inside the ring
+            const int32_t step = ((dy == -ring) || (dy == ring)) ? 1 : Math::Max(ring * 2, 1);
+            for (int32_t dx = -ring; dx <= ring; dx += step)
+            {
+                const int32_t nx = cellX + dx;
+                if ((nx < 0) || (nx >= (int32_t)mFreeCellsX))
+                {
+                    continue;
+                }
+                Array<uint32_t>& cell = mFreeCells[(size_t)nx + (size_t)mFreeCellsX * ny];
+                if (!cell.IsEmpty())
+                {
+                    const uint32_t slot = cell.Top();
+                    cell.Pop();
+                    --mNumFree;
+                    return slot;
+                }
+            }
+        }
+    }
+}
+
+// New slots are parked spread over the map, on the R2 low discrepancy sequence
+void FootprintOverlaps::Grow()
+{
+    const uint32_t numSlots = (uint32_t)mInUse.GetSize();
+    const uint32_t newNumSlots = Math::Max(numSlots * 2, kFootprintMinSlots);
+
+    mSweep->mBoxes.resize(newNumSlots);
+    for (uint32_t slot = numSlots; slot < newNumSlots; ++slot)
+    {
+        const double u = 0.5 + 0.7548776662466927 * slot;
+        const double v = 0.5 + 0.5698402909980532 * slot;
+        const float x = (float)((u - (double)(uint64_t)u) * mWidth);
+        const float y = (float)((v - (double)(uint64_t)v) * mHeight);
+        mSweep->mBoxes[slot] = FootprintBox(x, y + kFootprintParkedExtent, x, y - kFootprintParkedExtent);
+        mInUse.Append(false);
+
+        const uint32_t cellX = Math::Min((uint32_t)x / kFootprintFreeCellSize, mFreeCellsX - 1);
+        const uint32_t cellY = Math::Min((uint32_t)y / kFootprintFreeCellSize, mFreeCellsY - 1);
+        mFreeCells[cellX + (size_t)mFreeCellsX * cellY].Append(slot);
+        ++mNumFree;
+    }
+
+    // New slots mean sorting from scratch, which takes in the changes so far too
+    mSweep->mManager.Initialize();
+}
+
+void FootprintOverlaps::Update()
+{
+    if (mNumChanges > 0)
+    {
+        mSweep->mManager.Update();
+    }
+    mLastChangeCount = mNumChanges;
+    mNumChanges = 0;
+}
+
+void FootprintOverlaps::Rebuild()
+{
+    mSweep->mManager.Initialize();
+    mLastChangeCount = mNumChanges;
+    mNumChanges = 0;
+}
+
+bool FootprintOverlaps::IsOverlapping(uint32_t handle) const
+{
+    for (const gte::EdgeKey<false>& overlap : mSweep->mManager.GetOverlap())
+    {
+        if ((overlap.V[0] != overlap.V[1]) && ((overlap.V[0] == (int32_t)handle) || (overlap.V[1] == (int32_t)handle)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FootprintOverlaps::GetOverlaps(uint32_t handle, Array<uint32_t>& handles) const
+{
+    handles.Clear();
+    for (const gte::EdgeKey<false>& overlap : mSweep->mManager.GetOverlap())
+    {
+        if (overlap.V[0] == overlap.V[1])
+        {
+            continue;
+        }
+        if (overlap.V[0] == (int32_t)handle)
+        {
+            handles.Append((uint32_t)overlap.V[1]);
+        }
+        else if (overlap.V[1] == (int32_t)handle)
+        {
+            handles.Append((uint32_t)overlap.V[0]);
+        }
+    }
+}
+
+void FootprintOverlaps::GetOverlaps(Array<Pair>& pairs) const
+{
+    pairs.Clear();
+    for (const gte::EdgeKey<false>& overlap : mSweep->mManager.GetOverlap())
+    {
+        if (overlap.V[0] != overlap.V[1])
+        {
+            pairs.Append({ (uint32_t)overlap.V[0], (uint32_t)overlap.V[1] });
+        }
+    }
+}
+
+uint32_t FootprintOverlaps::GetNumOverlaps() const
+{
+    uint32_t numOverlaps = 0;
+    for (const gte::EdgeKey<false>& overlap : mSweep->mManager.GetOverlap())
+    {
+        numOverlaps += (overlap.V[0] != overlap.V[1]) ? 1 : 0;
+    }
+    return numOverlaps;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+#include <Core/Containers/UniquePtr.h>
+
+class FootprintSweep;
+
+// Rectangles such as building footprints and units, with the pairs that overlap kept up
+// to date as they're added, moved and removed. Wraps GTE's RectangleManager, which keeps
+// the rectangles' sides sorted along each axis between updates and insertion sorts them
+// after a change, adding and removing pairs as sides cross.
+//
+// Changes are batched and applied by Update. Rectangles that only move a little cross
+// few sides, so an update costs one pass over the sorted sides plus the crossings rather
+// than a full sort. Unused slots stay parked on the map as rectangles that can't overlap
+// anything, and a new rectangle takes a free slot parked near it, so adding and removing
+// cross few sides too. Moving a rectangle across the map crosses about half the others'
+// sides.
+class FootprintOverlaps
+{
+public:
+    // Closed, so rectangles that touch overlap
+    struct Rectangle
+    {
+        float mMinX;
+        float mMinY;
+        float mMaxX;
+        float mMaxY;
+    };
+
+    struct Pair
+    {
+        uint32_t mFirst;    // Lower handle
+        uint32_t mSecond;
+    };
+
+    FootprintOverlaps();
+    ~FootprintOverlaps();
+
+    // Free slots are spread over the map
+    void Init(uint32_t width, uint32_t height);
+
+    // Tiles [x0, x1) x [y0, y1), overlapping footprints that share a tile
+    static Rectangle FromTiles(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
+    // Handles are reused after removal. Rectangles must be less than kMaxHeight high.
+    // Changes take effect at the next Update.
+    uint32_t Add(const Rectangle& rectangle);
+    void SetRectangle(uint32_t handle, const Rectangle& rectangle);
+    void Remove(uint32_t handle);
+    Rectangle GetRectangle(uint32_t handle) const;
+
+    // Applies the changes since the last update
+    void Update();
+
+    // Sorts everything from scratch, cheaper than Update once most rectangles have moved
+    // a long way
+    void Rebuild();
+
+    bool HasChanges() const { return mNumChanges > 0; }
+
+    // Overlaps as of the last update. The set of overlaps is searched in full, which is
+    // cheap while few rectangles overlap, as with buildings that mustn't.
+    bool IsOverlapping(uint32_t handle) const;
+    void GetOverlaps(uint32_t handle, Array<uint32_t>& handles) const;
+    void GetOverlaps(Array<Pair>& pairs) const;
+    uint32_t GetNumOverlaps() const;
+
+    uint32_t GetNumRectangles() const { return mNumRectangles; }
+
+    // Changes applied by the last update
+    uint32_t GetLastChangeCount() const { return mLastChangeCount; }
+
+    static constexpr float kMaxHeight = 128.0f;
+
+private:
+    void Grow();
+    void Park(uint32_t slot, float x, float y);
+    uint32_t TakeFreeSlot(float x, float y);
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+
+    UniquePtr<FootprintSweep, DeleteDeletor> mSweep;
+    Array<bool> mInUse;
+
+    // Free slots by where they're parked, in square cells
+    uint32_t mFreeCellsX = 0;
+    uint32_t mFreeCellsY = 0;
+    Array<Array<uint32_t>> mFreeCells;
+    uint32_t mNumFree = 0;
+
+    uint32_t mNumRectangles = 0;
+    uint32_t mNumChanges = 0;
+    uint32_t mLastChangeCount = 0;
+};
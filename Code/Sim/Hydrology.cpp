@@ -0,0 +1,942 @@
+#include "Hydrology.h"
+
+#include <Sim/ParallelFor.h>
+
+#include <Core/Env/Assert.h>
+#include <Core/Time/Timer.h>
+
+#include <string.h>
+
+namespace
+{
+    const uint32_t kHydrologyBlockSize = 256;
+    const uint32_t kHydrologyNone = 0xFFFFFFFF;
+
+    // Direction of a tile on a flat, until it's found
+    const uint8_t kHydrologyFlat = 0xFF;
+
+    // Odd directions are diagonal
+    const int32_t kHydrologyDirectionX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+    const int32_t kHydrologyDirectionY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    // Drops to diagonal neighbours are over a longer distance, in 1/256ths
+    const int32_t kHydrologySlope = 256;
+    const int32_t kHydrologyDiagonalSlope = 181;
+
+    // Within a block, tiles are indexed with a border of one tile around the block so
+    // neighbours are a fixed offset away
+    const uint32_t kHydrologyStride = kHydrologyBlockSize + 2;
+    const uint32_t kHydrologyLocalSize = kHydrologyStride * kHydrologyStride;
+    const int32_t kHydrologyOffsets[8] =
+    {
+        1, 1 + (int32_t)kHydrologyStride, (int32_t)kHydrologyStride, (int32_t)kHydrologyStride - 1,
+        -1, -1 - (int32_t)kHydrologyStride, -(int32_t)kHydrologyStride, 1 - (int32_t)kHydrologyStride
+    };
+
+    uint32_t HydrologyGetLocal(uint32_t x, uint32_t y)
+    {
+        return (x + 1) + kHydrologyStride * (y + 1);
+    }
+
+    // Priority queue with a list of items per height, linked through the items so each item
+    // can only be queued once at a time. Flooding never pushes below the height last popped,
+    // so popping only scans upwards and the queue is linear in its items.
+    class HydrologyBucketQueue
+    {
+    public:
+        HydrologyBucketQueue()
+        {
+            mHeads.SetSize(65536);
+            memset(mHeads.Begin(), 0xFF, mHeads.GetSize() * sizeof(uint32_t));
+        }
+
+        // Buckets are all empty again once everything is popped
+        void Reset(uint32_t numItems)
+        {
+            ASSERT(mSize == 0);
+            mNext.SetSize(numItems);
+            mHeight = 0;
+        }
+
+        void Push(uint16_t height, uint32_t item)
+        {
+            ASSERT(height >= mHeight);
+            mNext[item] = mHeads[height];
+            mHeads[height] = item;
+            ++mSize;
+        }
+
+        bool Pop(uint16_t& height, uint32_t& item)
+        {
+            if (mSize == 0)
+            {
+                return false;
+            }
+            while (mHeads[mHeight] == kHydrologyNone)
+            {
+                ++mHeight;
+            }
+            item = mHeads[mHeight];
+            mHeads[mHeight] = mNext[item];
+            height = (uint16_t)mHeight;
+            --mSize;
+            return true;
+        }
+
+    private:
+        Array<uint32_t> mHeads;
+        Array<uint32_t> mNext;
+        uint32_t mHeight = 0;
+        uint32_t mSize = 0;
+    };
+
+    // Lowest height water spills over between two watersheds
+    struct HydrologySpill
+    {
+        uint32_t mA;
+        uint32_t mB;
+        uint16_t mHeight;
+    };
+
+    // Keeps the lowest spill between each pair of watersheds, open addressed by the pair
+    class HydrologySpillTable
+    {
+    public:
+        void Clear()
+        {
+            mSpills.SetSize(1024);
+            memset(mSpills.Begin(), 0xFF, mSpills.GetSize() * sizeof(HydrologySpill));
+            mSize = 0;
+            mLast = nullptr;
+        }
+
+        void Add(uint32_t a, uint32_t b, uint16_t height)
+        {
+            if (a > b)
+            {
+                const uint32_t swap = a;
+                a = b;
+                b = swap;
+            }
+            if ((mLast != nullptr) && (mLast->mA == a) && (mLast->mB == b))
+            {
+                mLast->mHeight = Math::Min(mLast->mHeight, height);
+                return;
+            }
+            HydrologySpill& spill = Find(a, b);
+            mLast = &spill;
+            if (spill.mA == kHydrologyNone)
+            {
+                spill.mA = a;
+                spill.mB = b;
+                spill.mHeight = height;
+                if (++mSize * 2 > mSpills.GetSize())
+                {
+                    Grow();
+                }
+            }
+            else if (height < spill.mHeight)
+            {
+                spill.mHeight = height;
+            }
+        }
+
+        void AppendTo(Array<HydrologySpill>& spills) const
+        {
+            spills.SetCapacity(spills.GetSize() + mSize);
+            for (const HydrologySpill& spill : mSpills)
+            {
+                if (spill.mA != kHydrologyNone)
+                {
+                    spills.Append(spill);
+                }
+            }
+        }
+
+    private:
+        HydrologySpill& Find(uint32_t a, uint32_t b)
+        {
+            const size_t mask = mSpills.GetSize() - 1;
+            size_t i = (size_t)((((uint64_t)a << 32 | b) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+            while ((mSpills[i].mA != kHydrologyNone) && ((mSpills[i].mA != a) || (mSpills[i].mB != b)))
+            {
+                i = (i + 1) & mask;
+            }
+            return mSpills[i];
+        }
+
+        void Grow()
+        {
+            mLast = nullptr;
+            Array<HydrologySpill> old;
+            old.Swap(mSpills);
+            mSpills.SetSize(old.GetSize() * 2);
+            memset(mSpills.Begin(), 0xFF, mSpills.GetSize() * sizeof(HydrologySpill));
+            for (const HydrologySpill& spill : old)
+            {
+                if (spill.mA != kHydrologyNone)
+                {
+                    Find(spill.mA, spill.mB) = spill;
+                }
+            }
+        }
+
+        Array<HydrologySpill> mSpills;
+        size_t mSize = 0;
+        HydrologySpill* mLast = nullptr;    // Spills between the same pair tend to come together
+    };
+
+    template <typename Function>
+    void HydrologyForEdgeTiles(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, Function&& function)
+    {
+        for (uint32_t x = x0; x < x1; ++x)
+        {
+            function(x, y0);
+            if (y1 - 1 > y0)
+            {
+                function(x, y1 - 1);
+            }
+        }
+        for (uint32_t y = y0 + 1; y + 1 < y1; ++y)
+        {
+            function(x0, y);
+            if (x1 - 1 > x0)
+            {
+                function(x1 - 1, y);
+            }
+        }
+    }
+}
+
+int32_t Hydrology::GetDirectionX(uint8_t direction)
+{
+    return (direction < kOffMap) ? kHydrologyDirectionX[direction] : 0;
+}
+
+int32_t Hydrology::GetDirectionY(uint8_t direction)
+{
+    return (direction < kOffMap) ? kHydrologyDirectionY[direction] : 0;
+}
+
+void Hydrology::Run(uint32_t width, uint32_t height, const Array<uint16_t>& heights)
+{
+    ASSERT(heights.GetSize() == (size_t)width * height);
+    ASSERT((size_t)width * height * 8 < kHydrologyNone);
+
+    mWidth = width;
+    mHeight = height;
+    const uint32_t numTiles = width * height;
+    mFilled.SetSize(numTiles);
+    mFlow.SetSize(numTiles);
+    mDirections.SetSize(numTiles);
+    mBasins.SetSize(numTiles);
+
+    mBlocksX = (width + kHydrologyBlockSize - 1) / kHydrologyBlockSize;
+    mBlocksY = (height + kHydrologyBlockSize - 1) / kHydrologyBlockSize;
+    const uint32_t numBlocks = mBlocksX * mBlocksY;
+    mEdgeStarts.SetSize(numBlocks + 1);
+    mEdgeStarts[0] = 0;
+    for (uint32_t block = 0; block < numBlocks; ++block)
+    {
+        uint32_t x0, y0, x1, y1;
+        GetBlockBounds(block, x0, y0, x1, y1);
+        const uint32_t numInner = ((x1 - x0 > 2) && (y1 - y0 > 2)) ? (x1 - x0 - 2) * (y1 - y0 - 2) : 0;
+        mEdgeStarts[block + 1] = mEdgeStarts[block] + (x1 - x0) * (y1 - y0) - numInner;
+    }
+
+    Timer timer;
+    Fill(heights);
+    mFillMS = timer.GetElapsedMS();
+
+    timer.Start();
+    FindDirections();
+    mDirectionMS = timer.GetElapsedMS();
+
+    timer.Start();
+    Accumulate();
+    mFlowMS = timer.GetElapsedMS();
+}
+
+void Hydrology::Fill(const Array<uint16_t>& heights)
+{
+    // Flood each block from its edge with every edge tile starting its own watershed,
+    // labelled one past its edge index. Label 0 is off the map. Labels are kept in mFlow
+    // until the blocks are raised to their watersheds' levels.
+    const uint32_t numBlocks = mBlocksX * mBlocksY;
+    Array<Array<HydrologySpill>> blockSpills;
+    blockSpills.SetSize(numBlocks);
+    ParallelFor(numBlocks, 1, [&](size_t begin, size_t end)
+    {
+        HydrologyBucketQueue queue;
+        HydrologySpillTable spills;
+        Array<uint32_t> labels;
+        Array<uint16_t> filled;
+        labels.SetSize(kHydrologyLocalSize);
+        filled.SetSize(kHydrologyLocalSize);
+        for (size_t block = begin; block < end; ++block)
+        {
+            uint32_t x0, y0, x1, y1;
+            GetBlockBounds((uint32_t)block, x0, y0, x1, y1);
+            memset(labels.Begin(), 0xFF, labels.GetSize() * sizeof(uint32_t));
+            for (uint32_t y = y0; y < y1; ++y)
+            {
+                const uint32_t local = HydrologyGetLocal(0, y - y0);
+                memset(&labels[local], 0, (x1 - x0) * sizeof(uint32_t));
+                memcpy(&filled[local], &heights[x0 + (size_t)mWidth * y], (x1 - x0) * sizeof(uint16_t));
+            }
+            queue.Reset(kHydrologyLocalSize);
+            spills.Clear();
+
+            HydrologyForEdgeTiles(x0, y0, x1, y1, [&](uint32_t x, uint32_t y)
+            {
+                const uint32_t tile = x + mWidth * y;
+                const uint32_t local = HydrologyGetLocal(x - x0, y - y0);
+                const uint32_t label = GetEdgeIndex(x, y) + 1;
+                labels[local] = label;
+                queue.Push(filled[local], local);
+                if ((x == 0) || (y == 0) || (x + 1 == mWidth) || (y + 1 == mHeight))
+                {
+                    spills.Add(0, label, 0);
+                }
+
+                // Spills into earlier blocks, so each pair of blocks adds its border once
+                for (uint32_t direction = 0; direction < 8; ++direction)
+                {
+                    const uint32_t nx = x + kHydrologyDirectionX[direction];
+                    const uint32_t ny = y + kHydrologyDirectionY[direction];
+                    if ((nx < mWidth) && (ny < mHeight) && (GetBlock(nx, ny) < block))
+                    {
+                        const uint32_t neighbour = nx + mWidth * ny;
+                        spills.Add(label, GetEdgeIndex(nx, ny) + 1, Math::Max(heights[tile], heights[neighbour]));
+                    }
+                }
+            });
+
+            uint16_t level;
+            uint32_t local;
+            while (queue.Pop(level, local))
+            {
+                const uint32_t label = labels[local];
+                for (uint32_t direction = 0; direction < 8; ++direction)
+                {
+                    const uint32_t neighbour = local + kHydrologyOffsets[direction];
+                    const uint32_t neighbourLabel = labels[neighbour];
+                    if (neighbourLabel == 0)
+                    {
+                        labels[neighbour] = label;
+                        filled[neighbour] = Math::Max(filled[neighbour], level);
+                        queue.Push(filled[neighbour], neighbour);
+                    }
+                    else if ((neighbourLabel != label) && (neighbourLabel != kHydrologyNone))
+                    {
+                        spills.Add(label, neighbourLabel, Math::Max(level, filled[neighbour]));
+                    }
+                }
+            }
+            for (uint32_t y = y0; y < y1; ++y)
+            {
+                const uint32_t rowStart = HydrologyGetLocal(0, y - y0);
+                memcpy(&mFilled[x0 + (size_t)mWidth * y], &filled[rowStart], (x1 - x0) * sizeof(uint16_t));
+                memcpy(&mFlow[x0 + (size_t)mWidth * y], &labels[rowStart], (x1 - x0) * sizeof(uint32_t));
+            }
+            spills.AppendTo(blockSpills[block]);
+        }
+    });
+
+    // A watershed fills to the lowest height it can spill over on some way off the map
+    const uint32_t numLabels = mEdgeStarts[numBlocks] + 1;
+    Array<uint32_t> spillStarts;
+    spillStarts.SetSize(numLabels + 1);
+    memset(spillStarts.Begin(), 0, spillStarts.GetSize() * sizeof(uint32_t));
+    for (const Array<HydrologySpill>& spills : blockSpills)
+    {
+        for (const HydrologySpill& spill : spills)
+        {
+            ++spillStarts[spill.mA + 1];
+            ++spillStarts[spill.mB + 1];
+        }
+    }
+    for (uint32_t label = 0; label < numLabels; ++label)
+    {
+        spillStarts[label + 1] += spillStarts[label];
+    }
+    Array<uint32_t> spillTo;
+    Array<uint16_t> spillHeights;
+    spillTo.SetSize(spillStarts[numLabels]);
+    spillHeights.SetSize(spillStarts[numLabels]);
+    {
+        Array<uint32_t> next(spillStarts);
+        for (Array<HydrologySpill>& spills : blockSpills)
+        {
+            for (const HydrologySpill& spill : spills)
+            {
+                spillTo[next[spill.mA]] = spill.mB;
+                spillHeights[next[spill.mA]++] = spill.mHeight;
+                spillTo[next[spill.mB]] = spill.mA;
+                spillHeights[next[spill.mB]++] = spill.mHeight;
+            }
+            spills.Destruct();
+        }
+    }
+
+    // Spills are queued rather than watersheds, so each is queued once and a watershed's
+    // level is found the first time one of its spills is popped
+    Array<uint32_t> levels;
+    levels.SetSize(numLabels);
+    memset(levels.Begin(), 0xFF, levels.GetSize() * sizeof(uint32_t));
+    {
+        HydrologyBucketQueue queue;
+        queue.Reset(spillStarts[numLabels]);
+        auto reach = [&](uint32_t label, uint16_t level)
+        {
+            levels[label] = level;
+            for (uint32_t spill = spillStarts[label]; spill < spillStarts[label + 1]; ++spill)
+            {
+                if (levels[spillTo[spill]] == kHydrologyNone)
+                {
+                    queue.Push(Math::Max(level, spillHeights[spill]), spill);
+                }
+            }
+        };
+        reach(0, 0);
+        uint16_t level;
+        uint32_t spill;
+        while (queue.Pop(level, spill))
+        {
+            if (levels[spillTo[spill]] == kHydrologyNone)
+            {
+                reach(spillTo[spill], level);
+            }
+        }
+    }
+
+    ParallelFor(mHeight, 64, [&](size_t begin, size_t end)
+    {
+        for (size_t tile = begin * mWidth; tile < end * mWidth; ++tile)
+        {
+            mFilled[tile] = Math::Max(mFilled[tile], (uint16_t)levels[mFlow[tile]]);
+        }
+    });
+}
+
+void Hydrology::FindDirections()
+{
+    // Steepest descent, or off the map from edge tiles with no lower neighbour. Filled lakes
+    // are flat, tiles on a flat drain towards a tile at the same height that drains, searching
+    // out from those tiles within each block.
+    const uint32_t numBlocks = mBlocksX * mBlocksY;
+    auto searchBlocks = [&](bool fromExits)
+    {
+        ParallelFor(numBlocks, 1, [&](size_t begin, size_t end)
+        {
+            Array<uint8_t> directions;
+            Array<uint16_t> filled;
+            Array<uint32_t> queue;
+            directions.SetSize(kHydrologyLocalSize);
+            filled.SetSize(kHydrologyLocalSize);
+            for (size_t block = begin; block < end; ++block)
+            {
+                uint32_t x0, y0, x1, y1;
+                GetBlockBounds((uint32_t)block, x0, y0, x1, y1);
+                memset(directions.Begin(), kOffMap, directions.GetSize());
+                if (fromExits)
+                {
+                    for (uint32_t y = y0; y < y1; ++y)
+                    {
+                        const uint32_t local = HydrologyGetLocal(0, y - y0);
+                        memcpy(&directions[local], &mDirections[x0 + (size_t)mWidth * y], x1 - x0);
+                        memcpy(&filled[local], &mFilled[x0 + (size_t)mWidth * y], (x1 - x0) * sizeof(uint16_t));
+                    }
+                }
+                else
+                {
+                    // With the border from the blocks around, and off the map never lower
+                    for (uint32_t y = y0 - 1; y != y1 + 1; ++y)
+                    {
+                        uint16_t* row = &filled[HydrologyGetLocal(0, y - y0) - 1];
+                        if (y >= mHeight)
+                        {
+                            for (uint32_t x = 0; x < x1 - x0 + 2; ++x)
+                            {
+                                row[x] = 0xFFFF;
+                            }
+                            continue;
+                        }
+                        memcpy(row + 1, &mFilled[x0 + (size_t)mWidth * y], (x1 - x0) * sizeof(uint16_t));
+                        row[0] = (x0 > 0) ? mFilled[x0 - 1 + (size_t)mWidth * y] : 0xFFFF;
+                        row[x1 - x0 + 1] = (x1 < mWidth) ? mFilled[x1 + (size_t)mWidth * y] : 0xFFFF;
+                    }
+                    for (uint32_t y = 0; y < y1 - y0; ++y)
+                    {
+                        for (uint32_t x = 0; x < x1 - x0; ++x)
+                        {
+                            const uint32_t local = HydrologyGetLocal(x, y);
+                            const int32_t height = filled[local];
+                            uint8_t best = kHydrologyFlat;
+                            int32_t bestSlope = 0;
+                            for (uint32_t direction = 0; direction < 8; ++direction)
+                            {
+                                const int32_t slope = (height - filled[local + kHydrologyOffsets[direction]]) * ((direction & 1) ? kHydrologyDiagonalSlope : kHydrologySlope);
+                                if (slope > bestSlope)
+                                {
+                                    best = (uint8_t)direction;
+                                    bestSlope = slope;
+                                }
+                            }
+                            if (best == kHydrologyFlat)
+                            {
+                                const uint32_t tileX = x0 + x;
+                                const uint32_t tileY = y0 + y;
+                                if ((tileX == 0) || (tileY == 0) || (tileX + 1 == mWidth) || (tileY + 1 == mHeight))
+                                {
+                                    best = kOffMap;
+                                }
+                            }
+                            directions[local] = best;
+                        }
+                    }
+                }
+
+                queue.Clear();
+                if (fromExits)
+                {
+                    HydrologyForEdgeTiles(x0, y0, x1, y1, [&](uint32_t x, uint32_t y)
+                    {
+                        const uint32_t group = mFlow[x + mWidth * y];
+                        if ((group != 0) && (mGroupExits[group - 1] == x + mWidth * y))
+                        {
+                            const uint32_t local = HydrologyGetLocal(x - x0, y - y0);
+                            directions[local] = mGroupExitDirections[group - 1];
+                            queue.Append(local);
+                        }
+                    });
+                }
+                else
+                {
+                    for (uint32_t y = 0; y < y1 - y0; ++y)
+                    {
+                        for (uint32_t local = HydrologyGetLocal(0, y); local < HydrologyGetLocal(x1 - x0, y); ++local)
+                        {
+                            if (directions[local] == kHydrologyFlat)
+                            {
+                                continue;
+                            }
+                            for (uint32_t direction = 0; direction < 8; ++direction)
+                            {
+                                const uint32_t neighbour = local + kHydrologyOffsets[direction];
+                                if ((directions[neighbour] == kHydrologyFlat) && (filled[neighbour] == filled[local]))
+                                {
+                                    queue.Append(local);
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+                for (size_t head = 0; head < queue.GetSize(); ++head)
+                {
+                    const uint32_t local = queue[head];
+                    for (uint32_t direction = 0; direction < 8; ++direction)
+                    {
+                        const uint32_t neighbour = local + kHydrologyOffsets[direction];
+                        if ((directions[neighbour] == kHydrologyFlat) && (filled[neighbour] == filled[local]))
+                        {
+                            directions[neighbour] = (uint8_t)((direction + 4) & 7);
+                            queue.Append(neighbour);
+                        }
+                    }
+                }
+
+                // Flats left over drain through other blocks. Each connected part is a group,
+                // numbered by edge index since each touches the block's edge, and kept in mFlow.
+                if (!fromExits)
+                {
+                    uint32_t numGroups = 0;
+                    for (uint32_t y = y0; y < y1; ++y)
+                    {
+                        memset(&mFlow[x0 + (size_t)mWidth * y], 0, (x1 - x0) * sizeof(uint32_t));
+                    }
+                    for (uint32_t y = 0; y < y1 - y0; ++y)
+                    {
+                        for (uint32_t x = 0; x < x1 - x0; ++x)
+                        {
+                            const uint32_t start = HydrologyGetLocal(x, y);
+                            if (directions[start] != kHydrologyFlat)
+                            {
+                                continue;
+                            }
+                            const uint32_t group = mEdgeStarts[block] + ++numGroups;
+                            ASSERT(numGroups <= mEdgeStarts[block + 1] - mEdgeStarts[block]);
+                            queue.Clear();
+                            queue.Append(start);
+                            directions[start] = kOffMap;    // Until all the groups are found
+                            for (size_t head = 0; head < queue.GetSize(); ++head)
+                            {
+                                const uint32_t local = queue[head];
+                                mFlow[x0 + local % kHydrologyStride - 1 + mWidth * (y0 + local / kHydrologyStride - 1)] = group;
+                                for (uint32_t direction = 0; direction < 8; ++direction)
+                                {
+                                    const uint32_t neighbour = local + kHydrologyOffsets[direction];
+                                    if ((directions[neighbour] == kHydrologyFlat) && (filled[neighbour] == filled[local]))
+                                    {
+                                        directions[neighbour] = kOffMap;
+                                        queue.Append(neighbour);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                    for (uint32_t y = 0; y < y1 - y0; ++y)
+                    {
+                        for (uint32_t x = 0; x < x1 - x0; ++x)
+                        {
+                            if (mFlow[x0 + x + mWidth * (y0 + y)] != 0)
+                            {
+                                directions[HydrologyGetLocal(x, y)] = kHydrologyFlat;
+                            }
+                        }
+                    }
+                }
+
+                for (uint32_t y = y0; y < y1; ++y)
+                {
+                    memcpy(&mDirections[x0 + (size_t)mWidth * y], &directions[HydrologyGetLocal(0, y - y0)], x1 - x0);
+                }
+            }
+        });
+    };
+    searchBlocks(false);
+
+    // Groups drain into the blocks next to them, either to a tile that drains or to another
+    // group that's been found to drain
+    const uint32_t numGroups = mEdgeStarts[numBlocks];
+    mGroupExits.SetSize(numGroups);
+    mGroupExitDirections.SetSize(numGroups);
+    memset(mGroupExits.Begin(), 0xFF, mGroupExits.GetSize() * sizeof(uint32_t));
+    Array<uint32_t> queue;
+    Array<uint32_t> linkStarts;
+    Array<uint32_t> links;      // Edge tiles of groups next to each group, with the direction to it
+    linkStarts.SetSize(numGroups + 1);
+    memset(linkStarts.Begin(), 0, linkStarts.GetSize() * sizeof(uint32_t));
+    auto forBorders = [&](auto&& function)
+    {
+        for (uint32_t block = 0; block < numBlocks; ++block)
+        {
+            uint32_t x0, y0, x1, y1;
+            GetBlockBounds(block, x0, y0, x1, y1);
+            HydrologyForEdgeTiles(x0, y0, x1, y1, [&](uint32_t x, uint32_t y)
+            {
+                const uint32_t tile = x + mWidth * y;
+                if (mFlow[tile] == 0)
+                {
+                    return;
+                }
+                for (uint32_t direction = 0; direction < 8; ++direction)
+                {
+                    const uint32_t nx = x + kHydrologyDirectionX[direction];
+                    const uint32_t ny = y + kHydrologyDirectionY[direction];
+                    const uint32_t neighbour = nx + mWidth * ny;
+                    if ((nx < mWidth) && (ny < mHeight) && (GetBlock(nx, ny) != block) && (mFilled[neighbour] == mFilled[tile]))
+                    {
+                        function(tile, direction, neighbour);
+                    }
+                }
+            });
+        }
+    };
+    forBorders([&](uint32_t tile, uint32_t direction, uint32_t neighbour)
+    {
+        const uint32_t group = mFlow[tile] - 1;
+        if (mDirections[neighbour] != kHydrologyFlat)
+        {
+            if (mGroupExits[group] == kHydrologyNone)
+            {
+                mGroupExits[group] = tile;
+                mGroupExitDirections[group] = (uint8_t)direction;
+                queue.Append(group);
+            }
+        }
+        else
+        {
+            ++linkStarts[mFlow[neighbour]];
+        }
+    });
+    for (uint32_t group = 0; group < numGroups; ++group)
+    {
+        linkStarts[group + 1] += linkStarts[group];
+    }
+    links.SetSize(linkStarts[numGroups]);
+    {
+        Array<uint32_t> next(linkStarts);
+        forBorders([&](uint32_t tile, uint32_t direction, uint32_t neighbour)
+        {
+            if (mDirections[neighbour] == kHydrologyFlat)
+            {
+                links[next[mFlow[neighbour] - 1]++] = tile * 8 + direction;
+            }
+        });
+    }
+    for (size_t head = 0; head < queue.GetSize(); ++head)
+    {
+        const uint32_t group = queue[head];
+        for (uint32_t link = linkStarts[group]; link < linkStarts[group + 1]; ++link)
+        {
+            const uint32_t tile = links[link] / 8;
+            const uint32_t linked = mFlow[tile] - 1;
+            if (mGroupExits[linked] == kHydrologyNone)
+            {
+                mGroupExits[linked] = tile;
+                mGroupExitDirections[linked] = (uint8_t)(links[link] % 8);
+                queue.Append(linked);
+            }
+        }
+    }
+
+    // Then each group drains to where it leaves its block
+    searchBlocks(true);
+    ASSERT(memchr(mDirections.Begin(), kHydrologyFlat, mDirections.GetSize()) == nullptr);
+}
+
+void Hydrology::Accumulate()
+{
+    const uint32_t numBlocks = mBlocksX * mBlocksY;
+    const uint32_t numEdges = mEdgeStarts[numBlocks];
+    mEdgeExits.SetSize(numEdges);
+    mEdgeBasins.SetSize(numEdges);
+    Array<uint32_t> inflows;
+    inflows.SetSize(numEdges);
+    memset(inflows.Begin(), 0, inflows.GetSize() * sizeof(uint32_t));
+
+    // Flow from within each block, and where water arriving at each edge tile leaves it
+    auto accumulateBlocks = [&](bool findExits)
+    {
+        ParallelFor(numBlocks, 1, [&](size_t begin, size_t end)
+        {
+            BlockScratch scratch;
+            for (size_t block = begin; block < end; ++block)
+            {
+                AccumulateBlock((uint32_t)block, inflows, findExits, scratch);
+            }
+        });
+    };
+    accumulateBlocks(true);
+
+    // Water leaving a block arrives at the edge of another, so edge tiles pass their flow on
+    // upstream first
+    Array<uint32_t> edgeTiles;
+    edgeTiles.SetSize(numEdges);
+    for (uint32_t block = 0; block < numBlocks; ++block)
+    {
+        uint32_t x0, y0, x1, y1;
+        GetBlockBounds(block, x0, y0, x1, y1);
+        HydrologyForEdgeTiles(x0, y0, x1, y1, [&](uint32_t x, uint32_t y)
+        {
+            edgeTiles[GetEdgeIndex(x, y)] = x + mWidth * y;
+        });
+    }
+    Array<uint32_t> nexts;
+    Array<uint32_t> numUpstream;
+    nexts.SetSize(numEdges);
+    numUpstream.SetSize(numEdges);
+    memset(numUpstream.Begin(), 0, numUpstream.GetSize() * sizeof(uint32_t));
+    for (uint32_t edge = 0; edge < numEdges; ++edge)
+    {
+        const uint32_t downstream = GetDownstream(edgeTiles[mEdgeExits[edge]]);
+        nexts[edge] = kHydrologyNone;
+        if (downstream != kHydrologyNone)
+        {
+            nexts[edge] = GetEdgeIndex(downstream % mWidth, downstream / mWidth);
+            ++numUpstream[nexts[edge]];
+            if (mEdgeExits[edge] == edge)
+            {
+                inflows[nexts[edge]] += mFlow[edgeTiles[edge]];
+            }
+        }
+    }
+    Array<uint32_t> order;
+    order.SetCapacity(numEdges);
+    for (uint32_t edge = 0; edge < numEdges; ++edge)
+    {
+        if (numUpstream[edge] == 0)
+        {
+            order.Append(edge);
+        }
+    }
+    for (size_t i = 0; i < order.GetSize(); ++i)
+    {
+        const uint32_t next = nexts[order[i]];
+        if (next != kHydrologyNone)
+        {
+            inflows[next] += inflows[order[i]];
+            if (--numUpstream[next] == 0)
+            {
+                order.Append(next);
+            }
+        }
+    }
+    ASSERT(order.GetSize() == numEdges);
+    for (size_t i = order.GetSize(); i-- > 0; )
+    {
+        const uint32_t edge = order[i];
+        mEdgeBasins[edge] = (nexts[edge] == kHydrologyNone) ? edgeTiles[mEdgeExits[edge]] : mEdgeBasins[nexts[edge]];
+    }
+
+    // Again with the flow arriving from other blocks
+    accumulateBlocks(false);
+}
+
+void Hydrology::AccumulateBlock(uint32_t block, const Array<uint32_t>& inflows, bool findExits, BlockScratch& scratch)
+{
+    uint32_t x0, y0, x1, y1;
+    GetBlockBounds(block, x0, y0, x1, y1);
+    const uint32_t blockWidth = x1 - x0;
+    const uint32_t blockHeight = y1 - y0;
+    Array<uint32_t>& downstreams = scratch.mDownstreams;
+    Array<uint32_t>& flows = scratch.mFlows;
+    Array<uint32_t>& order = scratch.mOrder;
+    Array<uint32_t>& results = scratch.mResults;
+    Array<uint8_t>& donors = scratch.mDonors;
+    downstreams.SetSize(kHydrologyLocalSize);
+    flows.SetSize(kHydrologyLocalSize);
+    results.SetSize(kHydrologyLocalSize);
+    donors.SetSize(kHydrologyLocalSize);
+    memset(donors.Begin(), 0, donors.GetSize());
+    order.Clear();
+    order.SetCapacity(blockWidth * blockHeight);
+
+    // Downstream within the block, if it is
+    for (uint32_t y = 0; y < blockHeight; ++y)
+    {
+        for (uint32_t x = 0; x < blockWidth; ++x)
+        {
+            const uint32_t local = HydrologyGetLocal(x, y);
+            const uint8_t direction = mDirections[x0 + x + (size_t)mWidth * (y0 + y)];
+            const uint32_t nx = x + GetDirectionX(direction);
+            const uint32_t ny = y + GetDirectionY(direction);
+            if ((direction != kOffMap) && (nx < blockWidth) && (ny < blockHeight))
+            {
+                downstreams[local] = local + kHydrologyOffsets[direction];
+                ++donors[downstreams[local]];
+            }
+            else
+            {
+                downstreams[local] = kHydrologyNone;
+            }
+            const bool isEdge = (x == 0) || (y == 0) || (x + 1 == blockWidth) || (y + 1 == blockHeight);
+            flows[local] = 1 + (isEdge ? inflows[GetEdgeIndex(x0 + x, y0 + y)] : 0);
+        }
+    }
+    for (uint32_t y = 0; y < blockHeight; ++y)
+    {
+        for (uint32_t local = HydrologyGetLocal(0, y); local < HydrologyGetLocal(blockWidth, y); ++local)
+        {
+            if (donors[local] == 0)
+            {
+                order.Append(local);
+            }
+        }
+    }
+
+    // Tiles in order from upstream
+    for (size_t i = 0; i < order.GetSize(); ++i)
+    {
+        const uint32_t downstream = downstreams[order[i]];
+        if (downstream != kHydrologyNone)
+        {
+            flows[downstream] += flows[order[i]];
+            if (--donors[downstream] == 0)
+            {
+                order.Append(downstream);
+            }
+        }
+    }
+    ASSERT(order.GetSize() == blockWidth * blockHeight);
+
+    // Then from downstream, the first time round for where water leaves the block and the
+    // second for the basins
+    auto getTile = [&](uint32_t local)
+    {
+        return x0 + local % kHydrologyStride - 1 + mWidth * (y0 + local / kHydrologyStride - 1);
+    };
+    for (size_t i = order.GetSize(); i-- > 0; )
+    {
+        const uint32_t local = order[i];
+        if (downstreams[local] != kHydrologyNone)
+        {
+            results[local] = results[downstreams[local]];
+        }
+        else if (findExits)
+        {
+            results[local] = local;
+        }
+        else
+        {
+            const uint32_t downstream = GetDownstream(getTile(local));
+            results[local] = (downstream == kHydrologyNone) ? getTile(local) : mEdgeBasins[GetEdgeIndex(downstream % mWidth, downstream / mWidth)];
+        }
+    }
+
+    if (findExits)
+    {
+        HydrologyForEdgeTiles(0, 0, blockWidth, blockHeight, [&](uint32_t x, uint32_t y)
+        {
+            const uint32_t exit = getTile(results[HydrologyGetLocal(x, y)]);
+            mEdgeExits[GetEdgeIndex(x0 + x, y0 + y)] = GetEdgeIndex(exit % mWidth, exit / mWidth);
+        });
+    }
+    for (uint32_t y = 0; y < blockHeight; ++y)
+    {
+        const uint32_t local = HydrologyGetLocal(0, y);
+        memcpy(&mFlow[x0 + (size_t)mWidth * (y0 + y)], &flows[local], blockWidth * sizeof(uint32_t));
+        if (!findExits)
+        {
+            memcpy(&mBasins[x0 + (size_t)mWidth * (y0 + y)], &results[local], blockWidth * sizeof(uint32_t));
+        }
+    }
+}
+
+void Hydrology::GetBlockBounds(uint32_t block, uint32_t& x0, uint32_t& y0, uint32_t& x1, uint32_t& y1) const
+{
+    x0 = (block % mBlocksX) * kHydrologyBlockSize;
+    y0 = (block / mBlocksX) * kHydrologyBlockSize;
+    x1 = Math::Min(x0 + kHydrologyBlockSize, mWidth);
+    y1 = Math::Min(y0 + kHydrologyBlockSize, mHeight);
+}
+
+uint32_t Hydrology::GetBlock(uint32_t x, uint32_t y) const
+{
+    return x / kHydrologyBlockSize + mBlocksX * (y / kHydrologyBlockSize);
+}
+
+uint32_t Hydrology::GetEdgeIndex(uint32_t x, uint32_t y) const
+{
+    // Top row, bottom row, then the left and right tiles of the rows between
+    const uint32_t block = GetBlock(x, y);
+    uint32_t x0, y0, x1, y1;
+    GetBlockBounds(block, x0, y0, x1, y1);
+    const uint32_t width = x1 - x0;
+    uint32_t index;
+    if (y == y0)
+    {
+        index = x - x0;
+    }
+    else if (y + 1 == y1)
+    {
+        index = width + x - x0;
+    }
+    else
+    {
+        ASSERT((x == x0) || (x + 1 == x1));
+        index = 2 * width + (y - y0 - 1) * ((width > 1) ? 2 : 1) + ((x == x0) ? 0 : 1);
+    }
+    return mEdgeStarts[block] + index;
+}
+
+uint32_t Hydrology::GetDownstream(uint32_t tile) const
+{
+    const uint8_t direction = mDirections[tile];
+    if (direction == kOffMap)
+    {
+        return kHydrologyNone;
+    }
+    return tile + kHydrologyDirectionX[direction] + mWidth * kHydrologyDirectionY[direction];
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Where water runs on a heightmap, for rivers, lakes and drainage basins. Depressions are
+// filled up to their spill height, so every tile drains to one of its eight neighbours or
+// off the edge of the map. Flow through a tile counts the tiles upstream of it, so rivers
+// are tiles with a large flow and lakes are tiles filled above the land.
+//
+// The map is split into square blocks of tiles that are processed in parallel. Filling
+// floods each block from its own edge with priority-flood, then floods the graph of spill
+// heights between the blocks' edge watersheds from the map edge, and raises each block to
+// its watersheds' levels. Flow is accumulated within each block, passed between blocks
+// along their edges, then accumulated within each block again.
+class Hydrology
+{
+public:
+    // Heights has one entry per tile
+    void Run(uint32_t width, uint32_t height, const Array<uint16_t>& heights);
+
+    // Height of the water surface, above the land's height in lakes
+    uint16_t GetFilled(uint32_t x, uint32_t y) const { return mFilled[x + (size_t)mWidth * y]; }
+
+    // Tiles draining through the tile, including itself
+    uint32_t GetFlow(uint32_t x, uint32_t y) const { return mFlow[x + (size_t)mWidth * y]; }
+
+    // Neighbour the tile drains to, kOffMap for tiles draining off the edge of the map
+    uint8_t GetDirection(uint32_t x, uint32_t y) const { return mDirections[x + (size_t)mWidth * y]; }
+    static int32_t GetDirectionX(uint8_t direction);
+    static int32_t GetDirectionY(uint8_t direction);
+
+    // Index of the tile on the map edge the tile's water leaves from
+    uint32_t GetBasin(uint32_t x, uint32_t y) const { return mBasins[x + (size_t)mWidth * y]; }
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+
+    // Stage timings of the last Run
+    float GetFillMS() const { return mFillMS; }
+    float GetDirectionMS() const { return mDirectionMS; }
+    float GetFlowMS() const { return mFlowMS; }
+
+    static const uint8_t kOffMap = 8;
+
+private:
+    void Fill(const Array<uint16_t>& heights);
+    void FindDirections();
+    void Accumulate();
+    // Per thread, indexed by tile within a block with a border of one tile around it
+    struct BlockScratch
+    {
+        Array<uint32_t> mDownstreams;
+        Array<uint32_t> mFlows;
+        Array<uint32_t> mOrder;
+        Array<uint32_t> mResults;
+        Array<uint8_t> mDonors;
+    };
+
+    void AccumulateBlock(uint32_t block, const Array<uint32_t>& inflows, bool findExits, BlockScratch& scratch);
+
+    void GetBlockBounds(uint32_t block, uint32_t& x0, uint32_t& y0, uint32_t& x1, uint32_t& y1) const;
+    uint32_t GetBlock(uint32_t x, uint32_t y) const;
+    uint32_t GetEdgeIndex(uint32_t x, uint32_t y) const;
+    uint32_t GetDownstream(uint32_t tile) const;
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    Array<uint16_t> mFilled;
+    Array<uint32_t> mFlow;
+    Array<uint8_t> mDirections;
+    Array<uint32_t> mBasins;
+
+    // Blocks of tiles processed in parallel, edge tiles are numbered block by block
+    uint32_t mBlocksX = 0;
+    uint32_t mBlocksY = 0;
+    Array<uint32_t> mEdgeStarts;
+
+    // Per group of flat tiles draining through other blocks, numbered by edge index
+    Array<uint32_t> mGroupExits;
+    Array<uint8_t> mGroupExitDirections;
+
+    // Per edge tile while accumulating
+    Array<uint32_t> mEdgeExits;     // Edge index of the tile where its water leaves the block
+    Array<uint32_t> mEdgeBasins;
+
+    float mFillMS = 0.0f;
+    float mDirectionMS = 0.0f;
+    float mFlowMS = 0.0f;
+};
@@ -0,0 +1,513 @@
+#include "JobAssigner.h"
+
+#include <Sim/ParallelFor.h>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    const uint32_t kJobNone = 0xFFFFFFFF;
+    const float kJobsPerCell = 4.0f;
+    const uint32_t kJobMaxCells = 1 << 20;
+    const uint32_t kJobMaxRounds = 32;
+    const size_t kJobChunkSize = 1024;
+
+    // The auction is quadratic in the pairs of a cell, larger cells keep their greedy matches
+    const uint32_t kAuctionMaxPairs = 64;
+    const uint32_t kAuctionMaxBidsPerPair = 32;
+    const float kAuctionEpsilon = 1e-2f;    // Relative to the cell size
+
+    // Orders proposals by distance then worker, so results don't depend on thread timing
+    uint64_t JobProposalKey(float distanceSq, uint32_t worker)
+    {
+        uint32_t bits;
+        memcpy(&bits, &distanceSq, sizeof(bits)); // Non-negative floats order like their bits
+        return ((uint64_t)bits << 32) | worker;
+    }
+
+    void JobHeapSiftDown(uint64_t* heap, uint32_t size, uint32_t i)
+    {
+        for (;;)
+        {
+            uint32_t largest = i;
+            const uint32_t left = i * 2 + 1;
+            const uint32_t right = left + 1;
+            if ((left < size) && (heap[left] > heap[largest]))
+            {
+                largest = left;
+            }
+            if ((right < size) && (heap[right] > heap[largest]))
+            {
+                largest = right;
+            }
+            if (largest == i)
+            {
+                return;
+            }
+            const uint64_t temp = heap[i];
+            heap[i] = heap[largest];
+            heap[largest] = temp;
+            i = largest;
+        }
+    }
+}
+
+void JobAssigner::Clear()
+{
+    mWorkerIds.Clear();
+    mWorkerX.Clear();
+    mWorkerY.Clear();
+    mWorkerSkills.Clear();
+    mJobIds.Clear();
+    mJobX.Clear();
+    mJobY.Clear();
+    mJobSlots.Clear();
+    mJobRequiredSkills.Clear();
+}
+
+void JobAssigner::AddWorker(uint32_t id, float x, float y, uint32_t skills)
+{
+    mWorkerIds.Append(id);
+    mWorkerX.Append(x);
+    mWorkerY.Append(y);
+    mWorkerSkills.Append(skills);
+}
+
+void JobAssigner::AddJob(uint32_t id, float x, float y, uint32_t slots, uint32_t requiredSkills)
+{
+    mJobIds.Append(id);
+    mJobX.Append(x);
+    mJobY.Append(y);
+    mJobSlots.Append(slots);
+    mJobRequiredSkills.Append(requiredSkills);
+}
+
+void JobAssigner::Solve()
+{
+    mAssignedWorkers.Clear();
+    mAssignedJobs.Clear();
+    mRounds = 0;
+    mGreedyDistance = 0.0f;
+    mDistance = 0.0f;
+
+    const uint32_t numWorkers = (uint32_t)mWorkerIds.GetSize();
+    const uint32_t numJobs = (uint32_t)mJobIds.GetSize();
+    if ((numWorkers == 0) || (numJobs == 0))
+    {
+        return;
+    }
+
+    // Size cells so each holds a few jobs on average
+    float minX = FLT_MAX;
+    float minY = FLT_MAX;
+    float maxX = -FLT_MAX;
+    float maxY = -FLT_MAX;
+    for (uint32_t job = 0; job < numJobs; ++job)
+    {
+        minX = Math::Min(minX, mJobX[job]);
+        minY = Math::Min(minY, mJobY[job]);
+        maxX = Math::Max(maxX, mJobX[job]);
+        maxY = Math::Max(maxY, mJobY[job]);
+    }
+    const float width = maxX - minX + 1.0f;
+    const float height = maxY - minY + 1.0f;
+    mCellSize = Math::Max(sqrtf(width * height * kJobsPerCell / (float)numJobs), sqrtf(width * height / (float)kJobMaxCells));
+    mMinX = minX;
+    mMinY = minY;
+    mGridWidth = (uint32_t)(width / mCellSize) + 1;
+    mGridHeight = (uint32_t)(height / mCellSize) + 1;
+
+    mJobCell.SetSize(numJobs);
+    mJobFree.SetSize(numJobs);
+    for (uint32_t job = 0; job < numJobs; ++job)
+    {
+        const uint32_t cx = (uint32_t)((mJobX[job] - mMinX) / mCellSize);
+        const uint32_t cy = (uint32_t)((mJobY[job] - mMinY) / mCellSize);
+        mJobCell[job] = cx + cy * mGridWidth;
+        mJobFree[job] = mJobSlots[job];
+    }
+
+    mWorkerJob.SetSize(numWorkers);
+    mProposal.SetSize(numWorkers);
+    mProposalDistanceSq.SetSize(numWorkers);
+    mPending.SetSize(numWorkers);
+    for (uint32_t worker = 0; worker < numWorkers; ++worker)
+    {
+        mWorkerJob[worker] = kJobNone;
+        mPending[worker] = worker;
+    }
+
+    // Greedy rounds. A worker that finds nothing gives up, as jobs only ever fill up.
+    mProposerStart.SetSize(numJobs + 1);
+    while (!mPending.IsEmpty() && (mRounds < kJobMaxRounds))
+    {
+        ++mRounds;
+        BuildGrid();
+
+        ParallelFor(mPending.GetSize(), kJobChunkSize, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                Propose(mPending[i]);
+            }
+        });
+
+        // Group proposals by job
+        memset(mProposerStart.Begin(), 0, mProposerStart.GetSize() * sizeof(uint32_t));
+        for (uint32_t worker : mPending)
+        {
+            if (mProposal[worker] != kJobNone)
+            {
+                mProposerStart[mProposal[worker] + 1]++;
+            }
+        }
+        mProposedJobs.Clear();
+        for (uint32_t job = 0; job < numJobs; ++job)
+        {
+            if (mProposerStart[job + 1])
+            {
+                mProposedJobs.Append(job);
+            }
+            mProposerStart[job + 1] += mProposerStart[job];
+        }
+        mProposers.SetSize(mProposerStart[numJobs]);
+        for (uint32_t worker : mPending)
+        {
+            const uint32_t job = mProposal[worker];
+            if (job != kJobNone)
+            {
+                mProposers[mProposerStart[job]++] = worker;
+            }
+        }
+        for (uint32_t job = numJobs; job > 0; --job)
+        {
+            mProposerStart[job] = mProposerStart[job - 1];
+        }
+        mProposerStart[0] = 0;
+
+        ParallelFor(mProposedJobs.GetSize(), kJobChunkSize / 8, [this](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                Accept(mProposedJobs[i]);
+            }
+        });
+
+        // Rejected workers try again
+        size_t numPending = 0;
+        for (uint32_t worker : mPending)
+        {
+            if ((mProposal[worker] != kJobNone) && (mWorkerJob[worker] == kJobNone))
+            {
+                mPending[numPending++] = worker;
+            }
+        }
+        mPending.SetSize(numPending);
+    }
+
+    // Group matches by the job's cell and let an auction improve each cell
+    const uint32_t numCells = mGridWidth * mGridHeight;
+    mPairStart.SetSize(numCells + 1);
+    memset(mPairStart.Begin(), 0, mPairStart.GetSize() * sizeof(uint32_t));
+    for (uint32_t worker = 0; worker < numWorkers; ++worker)
+    {
+        const uint32_t job = mWorkerJob[worker];
+        if (job != kJobNone)
+        {
+            mPairStart[mJobCell[job] + 1]++;
+            mGreedyDistance += sqrtf(GetDistanceSq(worker, job));
+        }
+    }
+    for (uint32_t cell = 0; cell < numCells; ++cell)
+    {
+        mPairStart[cell + 1] += mPairStart[cell];
+    }
+    mPairs.SetSize(mPairStart[numCells]);
+    for (uint32_t worker = 0; worker < numWorkers; ++worker)
+    {
+        const uint32_t job = mWorkerJob[worker];
+        if (job != kJobNone)
+        {
+            mPairs[mPairStart[mJobCell[job]]++] = worker;
+        }
+    }
+    for (uint32_t cell = numCells; cell > 0; --cell)
+    {
+        mPairStart[cell] = mPairStart[cell - 1];
+    }
+    mPairStart[0] = 0;
+
+    ParallelFor(numCells, kJobChunkSize, [this](size_t begin, size_t end)
+    {
+        for (size_t cell = begin; cell < end; ++cell)
+        {
+            Refine((uint32_t)cell);
+        }
+    });
+
+    mAssignedWorkers.SetCapacity(mPairs.GetSize());
+    mAssignedJobs.SetCapacity(mPairs.GetSize());
+    for (uint32_t worker = 0; worker < numWorkers; ++worker)
+    {
+        const uint32_t job = mWorkerJob[worker];
+        if (job != kJobNone)
+        {
+            mAssignedWorkers.Append(mWorkerIds[worker]);
+            mAssignedJobs.Append(mJobIds[job]);
+            mDistance += sqrtf(GetDistanceSq(worker, job));
+        }
+    }
+}
+
+void JobAssigner::BuildGrid()
+{
+    const uint32_t numCells = mGridWidth * mGridHeight;
+    const uint32_t numJobs = (uint32_t)mJobIds.GetSize();
+    mCellStart.SetSize(numCells + 1);
+    memset(mCellStart.Begin(), 0, mCellStart.GetSize() * sizeof(uint32_t));
+    for (uint32_t job = 0; job < numJobs; ++job)
+    {
+        if (mJobFree[job])
+        {
+            mCellStart[mJobCell[job] + 1]++;
+        }
+    }
+    for (uint32_t cell = 0; cell < numCells; ++cell)
+    {
+        mCellStart[cell + 1] += mCellStart[cell];
+    }
+    mCellJobs.SetSize(mCellStart[numCells]);
+    for (uint32_t job = 0; job < numJobs; ++job)
+    {
+        if (mJobFree[job])
+        {
+            mCellJobs[mCellStart[mJobCell[job]]++] = job;
+        }
+    }
+    for (uint32_t cell = numCells; cell > 0; --cell)
+    {
+        mCellStart[cell] = mCellStart[cell - 1];
+    }
+    mCellStart[0] = 0;
+}
+
+void JobAssigner::Propose(uint32_t worker)
+{
+    const float x = mWorkerX[worker];
+    const float y = mWorkerY[worker];
+    const int32_t cx = (int32_t)floorf((x - mMinX) / mCellSize);
+    const int32_t cy = (int32_t)floorf((y - mMinY) / mCellSize);
+    const int32_t gridWidth = (int32_t)mGridWidth;
+    const int32_t gridHeight = (int32_t)mGridHeight;
+
+    // Search rings of cells outwards until they can't hold anything nearer
+    float bestDistanceSq = mMaxDistance * mMaxDistance;
+    uint32_t bestJob = kJobNone;
+    for (int32_t ring = 0; ; ++ring)
+    {
+        const float ringDistance = (float)(ring - 1) * mCellSize;
+        if ((ring > 0) && (ringDistance * ringDistance > bestDistanceSq))
+        {
+            break;
+        }
+        if ((cx - ring < 0) && (cy - ring < 0) && (cx + ring >= gridWidth) && (cy + ring >= gridHeight))
+        {
+            break;
+        }
+
+        const int32_t minY = Math::Max(cy - ring, 0);
+        const int32_t maxY = Math::Min(cy + ring, gridHeight - 1);
+        for (int32_t gy = minY; gy <= maxY; ++gy)
+        {
+            const bool edgeRow = (gy == cy - ring) || (gy == cy + ring);
+            const int32_t step = edgeRow ? 1 : Math::Max(ring * 2, 1);
+            for (int32_t gx = cx - ring; gx <= cx + ring; gx += step)
+            {
+                if ((gx < 0) || (gx >= gridWidth))
+                {
+                    continue;
+                }
+                const uint32_t cell = (uint32_t)(gx + gy * gridWidth);
+                for (uint32_t i = mCellStart[cell]; i < mCellStart[cell + 1]; ++i)
+                {
+                    const uint32_t job = mCellJobs[i];
+                    if (!IsFeasible(worker, job))
+                    {
+                        continue;
+                    }
+                    const float distanceSq = GetDistanceSq(worker, job);
+                    if ((distanceSq < bestDistanceSq) || ((distanceSq == bestDistanceSq) && (job < bestJob)))
+                    {
+                        bestDistanceSq = distanceSq;
+                        bestJob = job;
+                    }
+                }
+            }
+        }
+    }
+
+    mProposal[worker] = bestJob;
+    mProposalDistanceSq[worker] = bestDistanceSq;
+}
+
+void JobAssigner::Accept(uint32_t job)
+{
+    const uint32_t begin = mProposerStart[job];
+    const uint32_t count = mProposerStart[job + 1] - begin;
+    const uint32_t free = mJobFree[job];
+    if (count <= free)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            mWorkerJob[mProposers[begin + i]] = job;
+        }
+        mJobFree[job] = free - count;
+        return;
+    }
+
+    // Keep the nearest proposers in a max-heap the size of the free slots
+    StackArray<uint64_t> heap;
+    heap.SetSize(free);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t worker = mProposers[begin + i];
+        const uint64_t key = JobProposalKey(mProposalDistanceSq[worker], worker);
+        if (i < free)
+        {
+            heap[i] = key;
+            if (i + 1 == free)
+            {
+                for (uint32_t j = free / 2; j-- > 0; )
+                {
+                    JobHeapSiftDown(heap.Begin(), free, j);
+                }
+            }
+        }
+        else if (key < heap[0])
+        {
+            heap[0] = key;
+            JobHeapSiftDown(heap.Begin(), free, 0);
+        }
+    }
+    for (uint64_t key : heap)
+    {
+        mWorkerJob[(uint32_t)key] = job;
+    }
+    mJobFree[job] = 0;
+}
+
+void JobAssigner::Refine(uint32_t cell)
+{
+    const uint32_t begin = mPairStart[cell];
+    const uint32_t numPairs = mPairStart[cell + 1] - begin;
+    if ((numPairs < 2) || (numPairs > kAuctionMaxPairs))
+    {
+        return;
+    }
+
+    // Forward auction of this cell's filled slots among the workers holding them. Each
+    // unassigned worker bids for its best slot by the margin over its second best.
+    uint32_t workers[kAuctionMaxPairs];
+    uint32_t slotJobs[kAuctionMaxPairs];
+    uint32_t slotOwners[kAuctionMaxPairs];
+    uint32_t workerSlots[kAuctionMaxPairs];
+    float prices[kAuctionMaxPairs];
+    uint32_t unassigned[kAuctionMaxPairs];
+    for (uint32_t i = 0; i < numPairs; ++i)
+    {
+        workers[i] = mPairs[begin + i];
+        slotJobs[i] = mWorkerJob[workers[i]];
+        slotOwners[i] = kJobNone;
+        workerSlots[i] = kJobNone;
+        prices[i] = 0.0f;
+        unassigned[i] = numPairs - 1 - i;
+    }
+
+    // Distance from each worker to each slot, infeasible slots cost FLT_MAX
+    float costs[kAuctionMaxPairs * kAuctionMaxPairs];
+    const float maxDistanceSq = mMaxDistance * mMaxDistance;
+    float greedy = 0.0f;
+    for (uint32_t i = 0; i < numPairs; ++i)
+    {
+        float* workerCosts = costs + i * numPairs;
+        for (uint32_t slot = 0; slot < numPairs; ++slot)
+        {
+            const float distanceSq = GetDistanceSq(workers[i], slotJobs[slot]);
+            const bool feasible = (distanceSq <= maxDistanceSq) && IsFeasible(workers[i], slotJobs[slot]);
+            workerCosts[slot] = feasible ? sqrtf(distanceSq) : FLT_MAX;
+        }
+        greedy += workerCosts[i];
+    }
+
+    const float epsilon = kAuctionEpsilon * mCellSize;
+    uint32_t numUnassigned = numPairs;
+    uint32_t bidsLeft = numPairs * kAuctionMaxBidsPerPair;
+    while (numUnassigned && bidsLeft--)
+    {
+        const uint32_t bidder = unassigned[--numUnassigned];
+        const float* workerCosts = costs + bidder * numPairs;
+        float best = -FLT_MAX;
+        float second = -FLT_MAX;
+        uint32_t bestSlot = kJobNone;
+        for (uint32_t slot = 0; slot < numPairs; ++slot)
+        {
+            if (workerCosts[slot] == FLT_MAX)
+            {
+                continue;
+            }
+            const float value = -workerCosts[slot] - prices[slot];
+            if (value > best)
+            {
+                second = best;
+                best = value;
+                bestSlot = slot;
+            }
+            else if (value > second)
+            {
+                second = value;
+            }
+        }
+        ASSERT(bestSlot != kJobNone); // The greedy slot is always feasible
+
+        prices[bestSlot] += ((second == -FLT_MAX) ? 0.0f : (best - second)) + epsilon;
+        const uint32_t outbid = slotOwners[bestSlot];
+        if (outbid != kJobNone)
+        {
+            workerSlots[outbid] = kJobNone;
+            unassigned[numUnassigned++] = outbid;
+        }
+        slotOwners[bestSlot] = bidder;
+        workerSlots[bidder] = bestSlot;
+    }
+    if (numUnassigned)
+    {
+        return;
+    }
+
+    float refined = 0.0f;
+    for (uint32_t i = 0; i < numPairs; ++i)
+    {
+        refined += costs[i * numPairs + workerSlots[i]];
+    }
+    if (refined < greedy)
+    {
+        for (uint32_t i = 0; i < numPairs; ++i)
+        {
+            mWorkerJob[workers[i]] = slotJobs[workerSlots[i]];
+        }
+    }
+}
+
+float JobAssigner::GetDistanceSq(uint32_t worker, uint32_t job) const
+{
+    const float dx = mJobX[job] - mWorkerX[worker];
+    const float dy = mJobY[job] - mWorkerY[worker];
+    return dx * dx + dy * dy;
+}
+
+bool JobAssigner::IsFeasible(uint32_t worker, uint32_t job) const
+{
+    return (mJobRequiredSkills[job] & ~mWorkerSkills[worker]) == 0;
+}
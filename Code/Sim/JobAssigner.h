@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Matches idle workers to open job slots once per tick. Jobs are bucketed in a grid sized
+// to their density. Unmatched workers propose to their nearest feasible job in parallel,
+// and each job accepts its nearest proposers, until nobody is left to propose. Each grid
+// cell's matches are then improved with an auction. Work grows roughly linearly with the
+// number of workers and jobs.
+class JobAssigner
+{
+public:
+    // Fill in the workers and jobs for this tick, then Solve
+    void Clear();
+    void AddWorker(uint32_t id, float x, float y, uint32_t skills);
+    void AddJob(uint32_t id, float x, float y, uint32_t slots, uint32_t requiredSkills);
+
+    // Workers never walk further than this to a job
+    void SetMaxDistance(float distance) { mMaxDistance = distance; }
+
+    void Solve();
+
+    // One entry per filled slot, workers and jobs by id
+    const Array<uint32_t>& GetAssignedWorkers() const { return mAssignedWorkers; }
+    const Array<uint32_t>& GetAssignedJobs() const { return mAssignedJobs; }
+
+    // Stats for the last Solve
+    uint32_t GetRounds() const { return mRounds; }
+    float GetGreedyDistance() const { return mGreedyDistance; }    // Total before the auction
+    float GetDistance() const { return mDistance; }                 // Total after
+
+private:
+    void BuildGrid();
+    void Propose(uint32_t worker);
+    void Accept(uint32_t job);
+    void Refine(uint32_t cell);
+    float GetDistanceSq(uint32_t worker, uint32_t job) const;
+    bool IsFeasible(uint32_t worker, uint32_t job) const;
+
+    float mMaxDistance = 256.0f;
+
+    Array<uint32_t> mWorkerIds;
+    Array<float> mWorkerX;
+    Array<float> mWorkerY;
+    Array<uint32_t> mWorkerSkills;
+
+    Array<uint32_t> mJobIds;
+    Array<float> mJobX;
+    Array<float> mJobY;
+    Array<uint32_t> mJobSlots;
+    Array<uint32_t> mJobRequiredSkills;
+
+    // Grid of jobs that still have free slots
+    float mMinX = 0.0f;
+    float mMinY = 0.0f;
+    float mCellSize = 1.0f;
+    uint32_t mGridWidth = 0;
+    uint32_t mGridHeight = 0;
+    Array<uint32_t> mJobCell;
+    Array<uint32_t> mCellStart;
+    Array<uint32_t> mCellJobs;
+
+    // Solve state
+    Array<uint32_t> mJobFree;
+    Array<uint32_t> mWorkerJob;
+    Array<uint32_t> mPending;
+    Array<uint32_t> mProposal;
+    Array<float> mProposalDistanceSq;
+    Array<uint32_t> mProposedJobs;
+    Array<uint32_t> mProposerStart;
+    Array<uint32_t> mProposers;
+    Array<uint32_t> mPairStart;
+    Array<uint32_t> mPairs;
+
+    Array<uint32_t> mAssignedWorkers;
+    Array<uint32_t> mAssignedJobs;
+    uint32_t mRounds = 0;
+    float mGreedyDistance = 0.0f;
+    float mDistance = 0.0f;
+};
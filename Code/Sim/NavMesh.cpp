@@ -0,0 +1,614 @@
+#include "NavMesh.h"
+
+#include <Mathematics/ConstrainedDelaunay2.h>
+
+#include <Core/Env/Assert.h>
+#include <Core/Mem/FrameArena.h>
+
+#include <math.h>
+
+namespace
+{
+    const uint32_t kNavMeshSectorSize = 64;
+    const uint32_t kNavMeshNone = 0xFFFFFFFF;
+    // Neighbour across a sector's side, found from the neighbouring sector's side edges
+    const uint32_t kNavMeshSide = 0xFFFFFFFE;
+
+    struct NavMeshHeapItem
+    {
+        float mCost;
+        uint32_t mNode;
+    };
+
+    void NavMeshHeapPush(Array<NavMeshHeapItem>& heap, float cost, uint32_t node)
+    {
+        size_t i = heap.GetSize();
+        heap.Append({ cost, node });
+        while (i > 0)
+        {
+            const size_t parent = (i - 1) / 2;
+            if (heap[parent].mCost <= cost)
+            {
+                break;
+            }
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = { cost, node };
+    }
+
+    NavMeshHeapItem NavMeshHeapPop(Array<NavMeshHeapItem>& heap)
+    {
+        const NavMeshHeapItem top = heap[0];
+        const NavMeshHeapItem last = heap.Top();
+        heap.Pop();
+        const size_t size = heap.GetSize();
+        if (size)
+        {
+            size_t i = 0;
+            for (;;)
+            {
+                size_t child = i * 2 + 1;
+                if (child >= size)
+                {
+                    break;
+                }
+                if ((child + 1 < size) && (heap[child + 1].mCost < heap[child].mCost))
+                {
+                    ++child;
+                }
+                if (last.mCost <= heap[child].mCost)
+                {
+                    break;
+                }
+                heap[i] = heap[child];
+                i = child;
+            }
+            heap[i] = last;
+        }
+        return top;
+    }
+
+    // Positive when c is counterclockwise from b around a
+    float NavMeshCross(const NavMesh::Point& a, const NavMesh::Point& b, const NavMesh::Point& c)
+    {
+        return (b.mX - a.mX) * (c.mY - a.mY) - (b.mY - a.mY) * (c.mX - a.mX);
+    }
+
+    float NavMeshDistance(const NavMesh::Point& a, const NavMesh::Point& b)
+    {
+        const float dx = b.mX - a.mX;
+        const float dy = b.mY - a.mY;
+        return sqrtf(dx * dx + dy * dy);
+    }
+
+    bool NavMeshEqual(const NavMesh::Point& a, const NavMesh::Point& b)
+    {
+        return (a.mX == b.mX) && (a.mY == b.mY);
+    }
+}
+
+void NavMesh::Init(uint32_t width, uint32_t height, const Array<float>& speeds)
+{
+    ASSERT(speeds.GetSize() == (size_t)width * height);
+
+    mWidth = width;
+    mHeight = height;
+    mBlocked.SetSize(speeds.GetSize());
+    for (size_t i = 0; i < speeds.GetSize(); ++i)
+    {
+        mBlocked[i] = (speeds[i] > 0.0f) ? 0 : 1;
+    }
+
+    mSectorsX = (width + kNavMeshSectorSize - 1) / kNavMeshSectorSize;
+    mSectorsY = (height + kNavMeshSectorSize - 1) / kNavMeshSectorSize;
+    mSectors.Clear();
+    mSectors.SetSize((size_t)mSectorsX * mSectorsY);
+    Update();
+}
+
+void NavMesh::AddObstacle(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    ASSERT(x0 < x1 && x1 <= mWidth && y0 < y1 && y1 <= mHeight);
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        for (uint32_t x = x0; x < x1; ++x)
+        {
+            ++mBlocked[x + (size_t)mWidth * y];
+        }
+    }
+    MarkDirty(x0, y0, x1, y1);
+}
+
+void NavMesh::RemoveObstacle(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    ASSERT(x0 < x1 && x1 <= mWidth && y0 < y1 && y1 <= mHeight);
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        for (uint32_t x = x0; x < x1; ++x)
+        {
+            ASSERT(mBlocked[x + (size_t)mWidth * y] > 0);
+            --mBlocked[x + (size_t)mWidth * y];
+        }
+    }
+    MarkDirty(x0, y0, x1, y1);
+}
+
+// Tiles next to a sector decide where it puts vertices along its sides, so sectors
+// within a tile of the change are retriangulated too
+void NavMesh::MarkDirty(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    const uint32_t sx0 = ((x0 > 0) ? x0 - 1 : 0) / kNavMeshSectorSize;
+    const uint32_t sy0 = ((y0 > 0) ? y0 - 1 : 0) / kNavMeshSectorSize;
+    const uint32_t sx1 = Math::Min(x1 / kNavMeshSectorSize, mSectorsX - 1);
+    const uint32_t sy1 = Math::Min(y1 / kNavMeshSectorSize, mSectorsY - 1);
+    for (uint32_t sy = sy0; sy <= sy1; ++sy)
+    {
+        for (uint32_t sx = sx0; sx <= sx1; ++sx)
+        {
+            mSectors[sx + mSectorsX * sy].mDirty = true;
+        }
+    }
+}
+
+void NavMesh::Update()
+{
+    mLastRebuildCount = 0;
+    for (uint32_t sector = 0; sector < mSectors.GetSize(); ++sector)
+    {
+        if (mSectors[sector].mDirty)
+        {
+            BuildSector(sector);
+            mSectors[sector].mDirty = false;
+            ++mLastRebuildCount;
+        }
+    }
+}
+
+uint32_t NavMesh::GetNumTriangles() const
+{
+    uint32_t count = 0;
+    for (const Sector& sector : mSectors)
+    {
+        count += (uint32_t)sector.mTriangles.GetSize();
+    }
+    return count;
+}
+
+// Vertices go at tile corners where the walkable area's boundary turns, and along the
+// sector's sides wherever any tile touching the corner differs, which is the same on both
+// sides of the side. Straight runs of the boundary between them are constrained edges.
+void NavMesh::BuildSector(uint32_t sectorIndex)
+{
+    Sector& sector = mSectors[sectorIndex];
+    const uint32_t x0 = (sectorIndex % mSectorsX) * kNavMeshSectorSize;
+    const uint32_t y0 = (sectorIndex / mSectorsX) * kNavMeshSectorSize;
+    const uint32_t x1 = Math::Min(x0 + kNavMeshSectorSize, mWidth);
+    const uint32_t y1 = Math::Min(y0 + kNavMeshSectorSize, mHeight);
+    const uint32_t cornersX = x1 - x0 + 1;
+    const uint32_t cornersY = y1 - y0 + 1;
+
+    // -1 for tiles off the map
+    auto getTile = [&](int32_t x, int32_t y) -> int32_t
+    {
+        if ((x < 0) || (y < 0) || (x >= (int32_t)mWidth) || (y >= (int32_t)mHeight))
+        {
+            return -1;
+        }
+        return (mBlocked[(size_t)x + (size_t)mWidth * (size_t)y] == 0) ? 1 : 0;
+    };
+
+    std::vector<gte::Vector2<float>> points;
+    std::vector<int32_t> pointIndices((size_t)cornersX * cornersY, -1);
+    for (uint32_t cy = 0; cy < cornersY; ++cy)
+    {
+        for (uint32_t cx = 0; cx < cornersX; ++cx)
+        {
+            const int32_t x = (int32_t)(x0 + cx);
+            const int32_t y = (int32_t)(y0 + cy);
+            const bool onSide = (cx == 0) || (cy == 0) || (cx == cornersX - 1) || (cy == cornersY - 1);
+            const bool corner = ((cx == 0) || (cx == cornersX - 1)) && ((cy == 0) || (cy == cornersY - 1));
+            bool vertex = corner;
+            if (!vertex && onSide)
+            {
+                const int32_t tiles[4] = { getTile(x - 1, y - 1), getTile(x, y - 1), getTile(x - 1, y), getTile(x, y) };
+                int32_t previous = -1;
+                for (const int32_t tile : tiles)
+                {
+                    if (tile >= 0)
+                    {
+                        vertex |= (previous >= 0) && (tile != previous);
+                        previous = tile;
+                    }
+                }
+            }
+            else if (!vertex)
+            {
+                const int32_t topLeft = getTile(x - 1, y - 1);
+                const int32_t topRight = getTile(x, y - 1);
+                const int32_t bottomLeft = getTile(x - 1, y);
+                const int32_t bottomRight = getTile(x, y);
+                const bool horizontal = (topLeft == topRight) && (bottomLeft == bottomRight);
+                const bool vertical = (topLeft == bottomLeft) && (topRight == bottomRight);
+                vertex = !horizontal && !vertical;
+            }
+            if (vertex)
+            {
+                pointIndices[cx + (size_t)cornersX * cy] = (int32_t)points.size();
+                points.push_back({ (float)x, (float)y });
+            }
+        }
+    }
+
+    // Boundary edges between walkable and blocked tiles inside the sector, joined into
+    // runs between vertices
+    std::vector<std::array<int32_t, 2>> edges;
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        // Horizontal lines between rows, then vertical lines between columns
+        const uint32_t numLines = (pass == 0) ? cornersY : cornersX;
+        const uint32_t lineLength = (pass == 0) ? cornersX : cornersY;
+        for (uint32_t line = 1; line + 1 < numLines; ++line)
+        {
+            int32_t start = -1;
+            for (uint32_t along = 0; along + 1 < lineLength; ++along)
+            {
+                const int32_t x = (int32_t)(x0 + ((pass == 0) ? along : line));
+                const int32_t y = (int32_t)(y0 + ((pass == 0) ? line : along));
+                const bool boundary = (pass == 0) ? (getTile(x, y - 1) != getTile(x, y)) : (getTile(x - 1, y) != getTile(x, y));
+                const uint32_t cx = (pass == 0) ? along : line;
+                const uint32_t cy = (pass == 0) ? line : along;
+                const int32_t here = pointIndices[cx + (size_t)cornersX * cy];
+                if ((start >= 0) && (here >= 0))
+                {
+                    edges.push_back({ start, here });
+                    start = -1;
+                }
+                if (boundary && (start < 0))
+                {
+                    start = here;
+                    ASSERT(start >= 0);
+                }
+            }
+            if (start >= 0)
+            {
+                const uint32_t cx = (pass == 0) ? lineLength - 1 : line;
+                const uint32_t cy = (pass == 0) ? line : lineLength - 1;
+                const int32_t here = pointIndices[cx + (size_t)cornersX * cy];
+                ASSERT(here >= 0);
+                edges.push_back({ start, here });
+            }
+        }
+    }
+
+    gte::ConstrainedDelaunay2<float> delaunay;
+    delaunay(points);
+    std::vector<int32_t> partitioned;
+    for (const std::array<int32_t, 2>& edge : edges)
+    {
+        delaunay.Insert(edge, partitioned);
+    }
+    delaunay.UpdateIndicesAdjacencies();
+    const std::vector<int32_t>& indices = delaunay.GetIndices();
+    const std::vector<int32_t>& adjacencies = delaunay.GetAdjacencies();
+    const size_t numTriangles = indices.size() / 3;
+
+    sector.mPoints.SetSize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        sector.mPoints[i] = { points[i][0], points[i][1] };
+    }
+
+    // Keep the walkable triangles. Every triangle is wholly walkable or blocked, so the
+    // tile under its centroid says which.
+    std::vector<uint32_t> remap(numTriangles, kNavMeshNone);
+    sector.mTriangles.Clear();
+    for (size_t t = 0; t < numTriangles; ++t)
+    {
+        const Point& a = sector.mPoints[indices[t * 3]];
+        const Point& b = sector.mPoints[indices[t * 3 + 1]];
+        const Point& c = sector.mPoints[indices[t * 3 + 2]];
+        const uint32_t x = (uint32_t)((a.mX + b.mX + c.mX) / 3.0f);
+        const uint32_t y = (uint32_t)((a.mY + b.mY + c.mY) / 3.0f);
+        if (IsWalkable(x, y))
+        {
+            remap[t] = (uint32_t)sector.mTriangles.GetSize();
+            sector.mTriangles.EmplaceBack();
+        }
+    }
+    ASSERT(sector.mTriangles.GetSize() <= 0xFFFF);
+
+    sector.mSides.Clear();
+    for (size_t t = 0; t < numTriangles; ++t)
+    {
+        if (remap[t] == kNavMeshNone)
+        {
+            continue;
+        }
+        Triangle& triangle = sector.mTriangles[remap[t]];
+        uint32_t order[3] = { 0, 1, 2 };
+        if (NavMeshCross(sector.mPoints[indices[t * 3]], sector.mPoints[indices[t * 3 + 1]], sector.mPoints[indices[t * 3 + 2]]) < 0.0f)
+        {
+            // Reversing the vertices reverses the edges, edge i runs from vertex i to i + 1
+            triangle.mVertices[0] = (uint32_t)indices[t * 3];
+            triangle.mVertices[1] = (uint32_t)indices[t * 3 + 2];
+            triangle.mVertices[2] = (uint32_t)indices[t * 3 + 1];
+            order[0] = 2;
+            order[2] = 0;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                triangle.mVertices[i] = (uint32_t)indices[t * 3 + i];
+            }
+        }
+
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const int32_t adjacent = adjacencies[t * 3 + order[i]];
+            if (adjacent >= 0)
+            {
+                triangle.mNeighbours[i] = remap[adjacent];
+                continue;
+            }
+
+            // On the sector's hull, which is its rectangle
+            triangle.mNeighbours[i] = kNavMeshNone;
+            const Point& a = sector.mPoints[triangle.mVertices[i]];
+            const Point& b = sector.mPoints[triangle.mVertices[(i + 1) % 3]];
+            uint32_t side;
+            if ((a.mX == (float)x0) && (b.mX == (float)x0))
+            {
+                side = 0;
+            }
+            else if ((a.mX == (float)x1) && (b.mX == (float)x1))
+            {
+                side = 1;
+            }
+            else if ((a.mY == (float)y0) && (b.mY == (float)y0))
+            {
+                side = 2;
+            }
+            else
+            {
+                ASSERT((a.mY == (float)y1) && (b.mY == (float)y1));
+                side = 3;
+            }
+            const bool mapEdge = ((side == 0) && (x0 == 0)) || ((side == 1) && (x1 == mWidth)) || ((side == 2) && (y0 == 0)) || ((side == 3) && (y1 == mHeight));
+            if (!mapEdge)
+            {
+                triangle.mNeighbours[i] = kNavMeshSide;
+                const uint32_t start = (uint32_t)((side < 2) ? Math::Min(a.mY, b.mY) : Math::Min(a.mX, b.mX));
+                sector.mSides.Append({ side, start, remap[t] });
+            }
+        }
+    }
+    sector.mSides.Sort([](const SideEdge& a, const SideEdge& b) { return (a.mSide < b.mSide) || ((a.mSide == b.mSide) && (a.mStart < b.mStart)); });
+}
+
+const NavMesh::Point& NavMesh::GetVertex(uint32_t node, uint32_t vertex) const
+{
+    const Sector& sector = mSectors[node >> 16];
+    return sector.mPoints[sector.mTriangles[node & 0xFFFF].mVertices[vertex]];
+}
+
+uint32_t NavMesh::GetNeighbour(uint32_t node, uint32_t edge) const
+{
+    const uint32_t sectorIndex = node >> 16;
+    const Sector& sector = mSectors[sectorIndex];
+    const uint32_t neighbour = sector.mTriangles[node & 0xFFFF].mNeighbours[edge];
+    if (neighbour == kNavMeshNone)
+    {
+        return kNavMeshNone;
+    }
+    if (neighbour != kNavMeshSide)
+    {
+        return (sectorIndex << 16) | neighbour;
+    }
+
+    // Find the same edge on the facing side of the neighbouring sector
+    const Point& a = GetVertex(node, edge);
+    const Point& b = GetVertex(node, (edge + 1) % 3);
+    uint32_t side;
+    uint32_t other;
+    uint32_t start;
+    const uint32_t x0 = (sectorIndex % mSectorsX) * kNavMeshSectorSize;
+    const uint32_t y0 = (sectorIndex / mSectorsX) * kNavMeshSectorSize;
+    if (a.mX == b.mX)
+    {
+        side = (a.mX == (float)x0) ? 1 : 0;
+        other = (side == 1) ? sectorIndex - 1 : sectorIndex + 1;
+        start = (uint32_t)Math::Min(a.mY, b.mY);
+    }
+    else
+    {
+        ASSERT(a.mY == b.mY);
+        side = (a.mY == (float)y0) ? 3 : 2;
+        other = (side == 3) ? sectorIndex - mSectorsX : sectorIndex + mSectorsX;
+        start = (uint32_t)Math::Min(a.mX, b.mX);
+    }
+
+    const Array<SideEdge>& sideEdges = mSectors[other].mSides;
+    size_t low = 0;
+    size_t high = sideEdges.GetSize();
+    while (low < high)
+    {
+        const size_t middle = (low + high) / 2;
+        if ((sideEdges[middle].mSide < side) || ((sideEdges[middle].mSide == side) && (sideEdges[middle].mStart < start)))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    if ((low < sideEdges.GetSize()) && (sideEdges[low].mSide == side) && (sideEdges[low].mStart == start))
+    {
+        return (other << 16) | sideEdges[low].mTriangle;
+    }
+    return kNavMeshNone;    // Blocked on the other side
+}
+
+uint32_t NavMesh::FindTriangle(const Point& point) const
+{
+    if ((point.mX < 0.0f) || (point.mY < 0.0f) || (point.mX >= (float)mWidth) || (point.mY >= (float)mHeight))
+    {
+        return kNavMeshNone;
+    }
+    const uint32_t sectorIndex = ((uint32_t)point.mX / kNavMeshSectorSize) + mSectorsX * ((uint32_t)point.mY / kNavMeshSectorSize);
+    const Sector& sector = mSectors[sectorIndex];
+    for (uint32_t t = 0; t < sector.mTriangles.GetSize(); ++t)
+    {
+        const Triangle& triangle = sector.mTriangles[t];
+        const Point& a = sector.mPoints[triangle.mVertices[0]];
+        const Point& b = sector.mPoints[triangle.mVertices[1]];
+        const Point& c = sector.mPoints[triangle.mVertices[2]];
+        if ((NavMeshCross(a, b, point) >= 0.0f) && (NavMeshCross(b, c, point) >= 0.0f) && (NavMeshCross(c, a, point) >= 0.0f))
+        {
+            return (sectorIndex << 16) | t;
+        }
+    }
+    return kNavMeshNone;
+}
+
+bool NavMesh::FindPath(const Point& start, const Point& end, Array<Point>& path)
+{
+    Update();
+    path.Clear();
+    const uint32_t from = FindTriangle(start);
+    const uint32_t to = FindTriangle(end);
+    if ((from == kNavMeshNone) || (to == kNavMeshNone))
+    {
+        return false;
+    }
+
+    // A* between triangles, entering each at the middle of the edge crossed
+    FrameArenaScope scratch;
+    ++mSearch;
+    FrameArray<NavMeshHeapItem> heap;
+    Triangle& first = GetTriangle(from);
+    first.mSearch = mSearch;
+    first.mParent = kNavMeshNone;
+    first.mCost = 0.0f;
+    first.mEntry = start;
+    NavMeshHeapPush(heap, NavMeshDistance(start, end), from);
+    bool found = (from == to);
+    while (!found && !heap.IsEmpty())
+    {
+        const NavMeshHeapItem item = NavMeshHeapPop(heap);
+        Triangle& triangle = GetTriangle(item.mNode);
+        if (item.mCost > triangle.mCost + NavMeshDistance(triangle.mEntry, end))
+        {
+            continue;   // Stale
+        }
+        if (item.mNode == to)
+        {
+            found = true;
+            break;
+        }
+        for (uint32_t edge = 0; edge < 3; ++edge)
+        {
+            const uint32_t next = GetNeighbour(item.mNode, edge);
+            if (next == kNavMeshNone)
+            {
+                continue;
+            }
+            const Point& a = GetVertex(item.mNode, edge);
+            const Point& b = GetVertex(item.mNode, (edge + 1) % 3);
+            const Point entry = { (a.mX + b.mX) * 0.5f, (a.mY + b.mY) * 0.5f };
+            const float cost = triangle.mCost + NavMeshDistance(triangle.mEntry, entry);
+            Triangle& nextTriangle = GetTriangle(next);
+            if ((nextTriangle.mSearch == mSearch) && (nextTriangle.mCost <= cost))
+            {
+                continue;
+            }
+            nextTriangle.mSearch = mSearch;
+            nextTriangle.mParent = item.mNode;
+            nextTriangle.mCost = cost;
+            nextTriangle.mEntry = entry;
+            NavMeshHeapPush(heap, cost + NavMeshDistance(entry, end), next);
+        }
+    }
+    if (!found)
+    {
+        return false;
+    }
+
+    // Portals from the end back to the start, as the left and right ends of each edge
+    // crossed when walking from the start
+    FrameArray<Point> lefts;
+    FrameArray<Point> rights;
+    lefts.Append(end);
+    rights.Append(end);
+    for (uint32_t node = to; GetTriangle(node).mParent != kNavMeshNone; node = GetTriangle(node).mParent)
+    {
+        const uint32_t parent = GetTriangle(node).mParent;
+        uint32_t edge = 0;
+        while (GetNeighbour(parent, edge) != node)
+        {
+            ++edge;
+        }
+        lefts.Append(GetVertex(parent, (edge + 1) % 3));
+        rights.Append(GetVertex(parent, edge));
+    }
+    lefts.Append(start);
+    rights.Append(start);
+
+    // Funnel: narrow the wedge from the apex through each portal, and when one side
+    // crosses the other, its corner becomes the next apex of the path
+    path.Append(start);
+    const uint32_t numPortals = (uint32_t)lefts.GetSize();
+    Point apex = start;
+    Point left = start;
+    Point right = start;
+    uint32_t leftIndex = 0;
+    uint32_t rightIndex = 0;
+    for (uint32_t i = 1; i < numPortals; ++i)
+    {
+        const Point& portalLeft = lefts[numPortals - 1 - i];
+        const Point& portalRight = rights[numPortals - 1 - i];
+
+        if (NavMeshCross(apex, right, portalRight) >= 0.0f)
+        {
+            if (NavMeshEqual(apex, right) || (NavMeshCross(apex, left, portalRight) < 0.0f))
+            {
+                right = portalRight;
+                rightIndex = i;
+            }
+            else
+            {
+                apex = left;
+                path.Append(apex);
+                right = apex;
+                rightIndex = leftIndex;
+                i = leftIndex;
+                continue;
+            }
+        }
+
+        if (NavMeshCross(apex, left, portalLeft) <= 0.0f)
+        {
+            if (NavMeshEqual(apex, left) || (NavMeshCross(apex, right, portalLeft) > 0.0f))
+            {
+                left = portalLeft;
+                leftIndex = i;
+            }
+            else
+            {
+                apex = right;
+                path.Append(apex);
+                left = apex;
+                leftIndex = rightIndex;
+                i = rightIndex;
+                continue;
+            }
+        }
+    }
+    if (!NavMeshEqual(path.Top(), end))
+    {
+        path.Append(end);
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Triangles covering the walkable part of the map, so paths across open ground are a
+// handful of straight lines rather than a search over every tile. Impassable tiles and
+// building footprints are holes in the mesh.
+//
+// The map is split into square sectors, each triangulated with a constrained Delaunay
+// triangulation of the corners of its holes, with the holes' edges as constraints.
+// Neighbouring sectors put vertices at the same points along their shared side, so
+// their edges there match exactly and paths cross between them. Adding or removing a
+// footprint only retriangulates the sectors it touches.
+//
+// Paths are found with A* over triangles, then pulled taut through the edges they cross
+// with the funnel algorithm.
+class NavMesh
+{
+public:
+    struct Point
+    {
+        float mX;
+        float mY;
+    };
+
+    // speeds has one entry per tile, zero for impassable tiles
+    void Init(uint32_t width, uint32_t height, const Array<float>& speeds);
+
+    // Footprints cover tiles [x0, x1) x [y0, y1) and may overlap. Removing must match an
+    // earlier add. Changed sectors are retriangulated by the next Update or FindPath.
+    void AddObstacle(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    void RemoveObstacle(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    void Update();
+
+    // Path in tile units from start to end, including both. Returns false if either end is
+    // blocked or there's no way between them.
+    bool FindPath(const Point& start, const Point& end, Array<Point>& path);
+
+    bool IsWalkable(uint32_t x, uint32_t y) const { return mBlocked[x + (size_t)mWidth * y] == 0; }
+    uint32_t GetNumTriangles() const;
+
+    // Sectors retriangulated by the last Update
+    uint32_t GetLastRebuildCount() const { return mLastRebuildCount; }
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+
+private:
+    struct Triangle
+    {
+        uint32_t mVertices[3];      // Counterclockwise
+        uint32_t mNeighbours[3];    // Across the edge from each vertex to the next
+
+        // Search state, valid when mSearch is the current search
+        uint32_t mSearch = 0;
+        uint32_t mParent = 0;
+        float mCost = 0.0f;
+        Point mEntry = {};
+    };
+
+    // An edge along a side of a sector, with coordinates along the side
+    struct SideEdge
+    {
+        uint32_t mSide;             // Left, right, top or bottom
+        uint32_t mStart;
+        uint32_t mTriangle;
+    };
+
+    struct Sector
+    {
+        Array<Point> mPoints;
+        Array<Triangle> mTriangles;
+        Array<SideEdge> mSides;     // Sorted by side then start
+        bool mDirty = true;
+    };
+
+    void MarkDirty(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    void BuildSector(uint32_t sector);
+    uint32_t FindTriangle(const Point& point) const;
+    uint32_t GetNeighbour(uint32_t node, uint32_t edge) const;
+    Triangle& GetTriangle(uint32_t node) { return mSectors[node >> 16].mTriangles[node & 0xFFFF]; }
+    const Point& GetVertex(uint32_t node, uint32_t vertex) const;
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    Array<uint16_t> mBlocked;   // Count of obstacles on each tile, impassable terrain is one
+    uint32_t mSectorsX = 0;
+    uint32_t mSectorsY = 0;
+    Array<Sector> mSectors;
+    uint32_t mLastRebuildCount = 0;
+    uint32_t mSearch = 0;
+};
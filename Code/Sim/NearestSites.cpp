@@ -0,0 +1,416 @@
+#include "NearestSites.h"
+
+#include <Sim/ParallelFor.h>
+
+#include <Core/Env/Assert.h>
+#include <Core/Mem/MemStats.h>
+#include <Core/Process/Atomic.h>
+#include <Core/Process/Thread.h>
+#include <Core/Time/Timer.h>
+
+#include <emmintrin.h>
+#include <float.h>
+
+namespace
+{
+    const uint32_t kNearestNoSite = 0xFFFFFFFF;
+
+    // Sites per leaf, unused slots are far away so they never match
+    const uint32_t kNearestLeafSize = 8;
+    const uint32_t kNearestMaxDepth = 28;
+
+    const uint32_t kNearestQueryChunk = 512;
+    const uint32_t kNearestBuildStackSize = 64 * 1024;
+}
+
+// Split planes for 2^mDepth - 1 nodes, node n's children are 2n + 1 and 2n + 2, and the
+// sites of the 2^mDepth leaves below them
+class NearestTree
+{
+public:
+    void Build(const Array<uint64_t>& ids, const Array<float>& xs, const Array<float>& ys);
+
+    // Results sorted nearest first, with k entries
+    void Find(float x, float y, uint32_t k, uint64_t* ids, float* distancesSq) const;
+
+    uint32_t mNumSites = 0;
+    float mBuildMS = 0.0f;
+
+private:
+    void BuildNode(uint32_t node, uint32_t level, uint32_t begin, uint32_t end, const Array<float>& xs, const Array<float>& ys);
+    void Select(uint32_t begin, uint32_t nth, uint32_t end, const float* coordinates);
+
+    uint32_t mDepth = 0;
+    Array<float> mSplits;
+    Array<uint8_t> mAxes;
+
+    // Per leaf slot
+    Array<float> mX;
+    Array<float> mY;
+    Array<uint64_t> mIds;
+
+    // While building, sites in tree order
+    Array<uint32_t> mOrder;
+    const Array<uint64_t>* mBuildIds = nullptr;
+};
+
+void NearestTree::Build(const Array<uint64_t>& ids, const Array<float>& xs, const Array<float>& ys)
+{
+    const Timer timer;
+    mNumSites = (uint32_t)ids.GetSize();
+    mDepth = 0;
+    while ((mDepth < kNearestMaxDepth) && (((size_t)kNearestLeafSize << mDepth) < mNumSites))
+    {
+        ++mDepth;
+    }
+    const uint32_t numLeaves = 1u << mDepth;
+    mSplits.SetSize(numLeaves - 1);
+    mAxes.SetSize(numLeaves - 1);
+    mX.SetSize((size_t)numLeaves * kNearestLeafSize);
+    mY.SetSize((size_t)numLeaves * kNearestLeafSize);
+    mIds.SetSize((size_t)numLeaves * kNearestLeafSize);
+    for (size_t i = 0; i < mX.GetSize(); ++i)
+    {
+        mX[i] = FLT_MAX;
+        mY[i] = FLT_MAX;
+        mIds[i] = 0;
+    }
+
+    mOrder.SetSize(mNumSites);
+    for (uint32_t i = 0; i < mNumSites; ++i)
+    {
+        mOrder[i] = i;
+    }
+    mBuildIds = &ids;
+    BuildNode(0, 0, 0, mNumSites, xs, ys);
+    mBuildIds = nullptr;
+    mOrder.Destruct();
+    mBuildMS = timer.GetElapsedMS();
+}
+
+// Splits the sites at their median along the axis they're most spread out on
+void NearestTree::BuildNode(uint32_t node, uint32_t level, uint32_t begin, uint32_t end, const Array<float>& xs, const Array<float>& ys)
+{
+    if (level == mDepth)
+    {
+        const size_t slot = (size_t)(node - ((1u << mDepth) - 1)) * kNearestLeafSize;
+        ASSERT(end - begin <= kNearestLeafSize);
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const uint32_t site = mOrder[i];
+            mX[slot + i - begin] = xs[site];
+            mY[slot + i - begin] = ys[site];
+            mIds[slot + i - begin] = (*mBuildIds)[site];
+        }
+        return;
+    }
+
+    float minX = FLT_MAX;
+    float minY = FLT_MAX;
+    float maxX = -FLT_MAX;
+    float maxY = -FLT_MAX;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const uint32_t site = mOrder[i];
+        minX = Math::Min(minX, xs[site]);
+        maxX = Math::Max(maxX, xs[site]);
+        minY = Math::Min(minY, ys[site]);
+        maxY = Math::Max(maxY, ys[site]);
+    }
+    const uint8_t axis = ((maxY - minY) > (maxX - minX)) ? 1 : 0;
+    const float* coordinates = (axis == 0) ? xs.Begin() : ys.Begin();
+    const uint32_t middle = begin + (end - begin) / 2;
+    if (middle < end)
+    {
+        Select(begin, middle, end, coordinates);
+        mSplits[node] = coordinates[mOrder[middle]];
+    }
+    else
+    {
+        mSplits[node] = FLT_MAX;    // No sites below
+    }
+    mAxes[node] = axis;
+    BuildNode(node * 2 + 1, level + 1, begin, middle, xs, ys);
+    BuildNode(node * 2 + 2, level + 1, middle, end, xs, ys);
+}
+
+// Partially sorts mOrder[begin, end) so the nth site is in place, with no greater sites
+// before it and no lesser ones after
+void NearestTree::Select(uint32_t begin, uint32_t nth, uint32_t end, const float* coordinates)
+{
+    uint32_t* order = mOrder.Begin();
+    while (end - begin > 1)
+    {
+        // Rounding the pivot down means j stops short of end - 1, so the range always shrinks
+        const float pivot = coordinates[order[begin + (end - begin - 1) / 2]];
+        uint32_t i = begin;
+        uint32_t j = end - 1;
+        for (;;)
+        {
+            while (coordinates[order[i]] < pivot)
+            {
+                ++i;
+            }
+            while (coordinates[order[j]] > pivot)
+            {
+                --j;
+            }
+            if (i >= j)
+            {
+                break;
+            }
+            const uint32_t swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+            ++i;
+            --j;
+        }
+        // [begin, j] holds no sites above the pivot and (j, end) none below it
+        if (nth <= j)
+        {
+            end = j + 1;
+        }
+        else
+        {
+            begin = j + 1;
+        }
+    }
+}
+
+void NearestTree::Find(float x, float y, uint32_t k, uint64_t* ids, float* distancesSq) const
+{
+    for (uint32_t i = 0; i < k; ++i)
+    {
+        ids[i] = 0;
+        distancesSq[i] = FLT_MAX;
+    }
+    float worst = FLT_MAX;
+
+    // Far sides still to visit, with the squared distance to their split plane
+    struct Pending
+    {
+        uint32_t mNode;
+        uint32_t mLevel;
+        float mDistanceSq;
+    };
+    Pending stack[kNearestMaxDepth + 1];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = { 0, 0, 0.0f };
+
+    const __m128 qx = _mm_set1_ps(x);
+    const __m128 qy = _mm_set1_ps(y);
+    while (stackSize > 0)
+    {
+        Pending pending = stack[--stackSize];
+        if (pending.mDistanceSq >= worst)
+        {
+            continue;
+        }
+        uint32_t node = pending.mNode;
+        for (uint32_t level = pending.mLevel; level < mDepth; ++level)
+        {
+            const float offset = ((mAxes[node] == 0) ? x : y) - mSplits[node];
+            const uint32_t near = node * 2 + ((offset < 0.0f) ? 1 : 2);
+            const uint32_t far = node * 2 + ((offset < 0.0f) ? 2 : 1);
+            stack[stackSize++] = { far, level + 1, offset * offset };
+            node = near;
+        }
+
+        const size_t slot = (size_t)(node - ((1u << mDepth) - 1)) * kNearestLeafSize;
+        for (uint32_t group = 0; group < kNearestLeafSize; group += 4)
+        {
+            const __m128 dx = _mm_sub_ps(_mm_loadu_ps(mX.Begin() + slot + group), qx);
+            const __m128 dy = _mm_sub_ps(_mm_loadu_ps(mY.Begin() + slot + group), qy);
+            const __m128 distanceSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            if (_mm_movemask_ps(_mm_cmplt_ps(distanceSq, _mm_set1_ps(worst))) == 0)
+            {
+                continue;
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, distanceSq);
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                if (lanes[lane] >= worst)
+                {
+                    continue;
+                }
+                uint32_t i = k - 1;
+                for (; (i > 0) && (distancesSq[i - 1] > lanes[lane]); --i)
+                {
+                    distancesSq[i] = distancesSq[i - 1];
+                    ids[i] = ids[i - 1];
+                }
+                distancesSq[i] = lanes[lane];
+                ids[i] = mIds[slot + group + lane];
+                worst = distancesSq[k - 1];
+            }
+        }
+    }
+}
+
+// Builds a tree from a snapshot of the sites on its own thread
+class NearestBuild
+{
+public:
+    static uint32_t ThreadMain(void* param)
+    {
+        NearestBuild* build = static_cast<NearestBuild*>(param);
+        {
+            const MemCategoryScope scope(build->mCategory);
+            build->mResult = new NearestTree;
+            build->mResult->Build(build->mIds, build->mX, build->mY);
+        }
+        AtomicStoreRelease(&build->mDone, true);
+        return 0;
+    }
+
+    bool IsDone() const { return AtomicLoadAcquire(&mDone); }
+
+    Array<uint64_t> mIds;
+    Array<float> mX;
+    Array<float> mY;
+
+    uint8_t mCategory = 0;  // The starting thread's, so the tree is counted there
+    Thread::ThreadHandle mThread = INVALID_THREAD_HANDLE;
+    UniquePtr<NearestTree, DeleteDeletor> mResult;
+
+private:
+    volatile bool mDone = false;
+};
+
+NearestSites::NearestSites() = default;
+NearestSites::~NearestSites()
+{
+    if (mBuild.Get())
+    {
+        FinishBuild();
+    }
+}
+
+void NearestSites::AddSite(uint64_t id, float x, float y)
+{
+    ASSERT(id != 0);
+    ASSERT(FindSite(id) == kNearestNoSite);
+    mSites.Append({ id, x, y });
+    mChanged = true;
+}
+
+void NearestSites::MoveSite(uint64_t id, float x, float y)
+{
+    const uint32_t site = FindSite(id);
+    ASSERT(site != kNearestNoSite);
+    mSites[site].mX = x;
+    mSites[site].mY = y;
+    mChanged = true;
+}
+
+void NearestSites::RemoveSite(uint64_t id)
+{
+    const uint32_t site = FindSite(id);
+    if (site != kNearestNoSite)
+    {
+        mSites[site] = mSites.Top();
+        mSites.Pop();
+        mChanged = true;
+    }
+}
+
+uint32_t NearestSites::FindSite(uint64_t id) const
+{
+    for (size_t i = 0; i < mSites.GetSize(); ++i)
+    {
+        if (mSites[i].mId == id)
+        {
+            return (uint32_t)i;
+        }
+    }
+    return kNearestNoSite;
+}
+
+void NearestSites::Update()
+{
+    if (mBuild.Get() && mBuild->IsDone())
+    {
+        FinishBuild();
+    }
+    if (!mBuild.Get() && mChanged)
+    {
+        StartBuild();
+    }
+}
+
+void NearestSites::Flush()
+{
+    if (mBuild.Get())
+    {
+        FinishBuild();
+    }
+    if (mChanged)
+    {
+        StartBuild();
+        FinishBuild();
+    }
+}
+
+void NearestSites::StartBuild()
+{
+    NearestBuild* build = new NearestBuild;
+    build->mIds.SetCapacity(mSites.GetSize());
+    build->mX.SetCapacity(mSites.GetSize());
+    build->mY.SetCapacity(mSites.GetSize());
+    for (const Site& site : mSites)
+    {
+        build->mIds.Append(site.mId);
+        build->mX.Append(site.mX);
+        build->mY.Append(site.mY);
+    }
+    mChanged = false;
+
+    build->mCategory = MemStats::GetCurrentCategory();
+    build->mThread = Thread::CreateThread(NearestBuild::ThreadMain, "NearestBuild", kNearestBuildStackSize, build);
+    mBuild = build;
+}
+
+void NearestSites::FinishBuild()
+{
+    Thread::WaitForThread(mBuild->mThread);
+    Thread::CloseHandle(mBuild->mThread);
+    mTree = mBuild->mResult.Release();
+    mBuild.Destroy();
+}
+
+uint32_t NearestSites::GetNumSites() const
+{
+    return mTree.Get() ? mTree->mNumSites : 0;
+}
+
+float NearestSites::GetBuildMS() const
+{
+    return mTree.Get() ? mTree->mBuildMS : 0.0f;
+}
+
+void NearestSites::FindNearest(const float* xs, const float* ys, uint32_t count, uint32_t k, uint64_t* ids, float* distancesSq) const
+{
+    ASSERT((k > 0) && (k <= kMaxNeighbours));
+    const NearestTree* tree = mTree.Get();
+    ParallelFor(count, kNearestQueryChunk, [&](size_t begin, size_t end)
+    {
+        float scratch[kMaxNeighbours];
+        for (size_t i = begin; i < end; ++i)
+        {
+            float* distances = distancesSq ? distancesSq + i * k : scratch;
+            if (tree)
+            {
+                tree->Find(xs[i], ys[i], k, ids + i * k, distances);
+            }
+            else
+            {
+                for (uint32_t j = 0; j < k; ++j)
+                {
+                    ids[i * k + j] = 0;
+                    distances[j] = FLT_MAX;
+                }
+            }
+        }
+    });
+}
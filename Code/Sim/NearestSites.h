@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+#include <Core/Containers/UniquePtr.h>
+
+class NearestTree;
+class NearestBuild;
+
+// Finds the sites nearest to many points at once, such as the closest settlement or
+// resource to every agent each tick. Sites are kept in a kd-tree stored as flat arrays:
+// split planes in breadth first order, and the sites of each leaf packed together so a
+// leaf is tested against a query point four sites at a time.
+//
+// Adding, moving or removing sites doesn't touch the tree in use. Update rebuilds the
+// tree on a background thread and swaps it in once it's done, so queries carry on
+// against the previous sites until then.
+class NearestSites
+{
+public:
+    NearestSites();
+    ~NearestSites();
+
+    // ids must be non-zero, zero is used for missing results
+    void AddSite(uint64_t id, float x, float y);
+    void MoveSite(uint64_t id, float x, float y);
+    void RemoveSite(uint64_t id);
+
+    // Call once per frame
+    void Update();
+
+    // Wait for any pending rebuild and swap it in
+    void Flush();
+
+    bool IsRebuilding() const { return mBuild.Get() != nullptr; }
+    bool HasChanges() const { return mChanged; }
+
+    // Sites in the tree in use
+    uint32_t GetNumSites() const;
+    float GetBuildMS() const;
+
+    // For each of count points, the ids of the k nearest sites nearest first, written to
+    // ids[point * k + i], with their squared distances if given. Missing results have id
+    // zero and distance FLT_MAX. Points are split between threads.
+    void FindNearest(const float* xs, const float* ys, uint32_t count, uint32_t k, uint64_t* ids, float* distancesSq = nullptr) const;
+
+    static const uint32_t kMaxNeighbours = 16;
+
+private:
+    struct Site
+    {
+        uint64_t mId;
+        float mX;
+        float mY;
+    };
+
+    uint32_t FindSite(uint64_t id) const;
+    void StartBuild();
+    void FinishBuild();
+
+    Array<Site> mSites;
+    bool mChanged = false;
+
+    UniquePtr<NearestTree, DeleteDeletor> mTree;
+    UniquePtr<NearestBuild, DeleteDeletor> mBuild;
+};
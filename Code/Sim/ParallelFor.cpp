@@ -0,0 +1,159 @@
+#include "ParallelFor.h"
+
+#include <Core/Containers/Array.h>
+#include <Core/Env/Env.h>
+#include <Core/Mem/MemStats.h>
+#include <Core/Process/Atomic.h>
+#include <Core/Process/Mutex.h>
+#include <Core/Process/Semaphore.h>
+#include <Core/Process/Thread.h>
+
+namespace
+{
+    const uint32_t kParallelForMaxWorkers = 63;
+    const uint32_t kParallelForStackSize = 256 * 1024;
+
+    class ParallelForPool
+    {
+    public:
+        ParallelForPool()
+        {
+            const uint32_t numWorkers = Math::Min(Env::GetNumProcessors(), kParallelForMaxWorkers + 1) - 1;
+            for (uint32_t i = 0; i < numWorkers; ++i)
+            {
+                mThreads.Append(Thread::CreateThread(WorkerMain, "ParallelFor", kParallelForStackSize, this));
+            }
+        }
+
+        ~ParallelForPool()
+        {
+            if (mThreads.IsEmpty())
+            {
+                return;
+            }
+            mQuit = true;
+            mWake.Signal((uint32_t)mThreads.GetSize());
+            for (Thread::ThreadHandle thread : mThreads)
+            {
+                Thread::WaitForThread(thread);
+                Thread::CloseHandle(thread);
+            }
+        }
+
+        uint32_t GetNumThreads() const { return (uint32_t)mThreads.GetSize() + 1; }
+
+        void Run(size_t count, size_t chunkSize, ParallelForFunction function, const void* body)
+        {
+            const uint64_t numChunks = (count + chunkSize - 1) / chunkSize;
+            const uint32_t numWorkers = (uint32_t)Math::Min<uint64_t>(mThreads.GetSize(), numChunks - 1);
+
+            bool serial = (numWorkers == 0);
+            if (!serial)
+            {
+                MutexHolder lock(mMutex);
+                serial = mRunning;
+                mRunning = true;
+            }
+            if (serial)
+            {
+                for (size_t begin = 0; begin < count; begin += chunkSize)
+                {
+                    function(body, begin, Math::Min(begin + chunkSize, count));
+                }
+                return;
+            }
+
+            mFunction = function;
+            mBody = body;
+            mCount = count;
+            mChunkSize = chunkSize;
+            mNumChunks = numChunks;
+            mNextChunk = 0;
+            mCategory = MemStats::GetCurrentCategory();
+
+            // Every woken worker signals once it runs out of chunks, after which none of
+            // them touch this job again
+            mWake.Signal(numWorkers);
+            Work();
+            for (uint32_t i = 0; i < numWorkers; ++i)
+            {
+                mDone.Wait();
+            }
+
+            MutexHolder lock(mMutex);
+            mRunning = false;
+        }
+
+    private:
+        static uint32_t WorkerMain(void* param)
+        {
+            ParallelForPool* pool = static_cast<ParallelForPool*>(param);
+            for (;;)
+            {
+                pool->mWake.Wait();
+                if (pool->mQuit)
+                {
+                    return 0;
+                }
+                {
+                    // Counted in the caller's category
+                    const MemCategoryScope scope(pool->mCategory);
+                    pool->Work();
+                }
+                pool->mDone.Signal();
+            }
+        }
+
+        void Work()
+        {
+            for (;;)
+            {
+                const uint64_t chunk = AtomicInc(&mNextChunk) - 1;
+                if (chunk >= mNumChunks)
+                {
+                    return;
+                }
+                const size_t begin = (size_t)chunk * mChunkSize;
+                mFunction(mBody, begin, Math::Min(begin + mChunkSize, mCount));
+            }
+        }
+
+        Array<Thread::ThreadHandle> mThreads;
+        Semaphore mWake;
+        Semaphore mDone;
+        volatile bool mQuit = false;
+
+        Mutex mMutex;
+        bool mRunning = false;
+
+        // The job being run
+        ParallelForFunction mFunction = nullptr;
+        const void* mBody = nullptr;
+        size_t mCount = 0;
+        size_t mChunkSize = 0;
+        uint64_t mNumChunks = 0;
+        volatile uint64_t mNextChunk = 0;
+        uint8_t mCategory = 0;
+    };
+
+    ParallelForPool& ParallelForGetPool()
+    {
+        static ParallelForPool pool;
+        return pool;
+    }
+}
+
+void ParallelForRun(size_t count, size_t chunkSize, ParallelForFunction function, const void* body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    ASSERT(chunkSize > 0);
+    ParallelForGetPool().Run(count, chunkSize, function, body);
+}
+
+uint32_t ParallelForGetNumThreads()
+{
+    return ParallelForGetPool().GetNumThreads();
+}
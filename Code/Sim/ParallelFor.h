@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Core/Env/Types.h>
+
+using ParallelForFunction = void (*)(const void* body, size_t begin, size_t end);
+
+// Splits [0, count) into chunks and calls body(begin, end) for each of them on a pool of
+// worker threads and the calling thread, returning once all chunks are done. Chunks
+// should be large enough to amortise a few atomic operations. A ParallelFor started
+// while another is running, including from inside a body, runs on the calling thread.
+template <class Body>
+void ParallelFor(size_t count, size_t chunkSize, const Body& body)
+{
+    ParallelForRun(count, chunkSize, [](const void* b, size_t begin, size_t end) { (*static_cast<const Body*>(b))(begin, end); }, &body);
+}
+
+void ParallelForRun(size_t count, size_t chunkSize, ParallelForFunction function, const void* body);
+
+// Threads that run chunks, including the calling thread
+uint32_t ParallelForGetNumThreads();
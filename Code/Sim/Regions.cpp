@@ -0,0 +1,425 @@
+#include "Regions.h"
+
+#include <Sim/ParallelFor.h>
+
+#include <Core/Env/Assert.h>
+
+#include <string.h>
+
+namespace
+{
+    // Rows labelled together by one thread
+    const uint32_t kRegionBandRows = 64;
+
+    // Labels of tiles visited while checking for a split, plus the search
+    const uint32_t kRegionSearchLabel = 0xFFFFFFF0;
+
+    // Roots are always the lowest tile of their set, so every parent is below its child
+    uint32_t RegionFind(Array<uint32_t>& parents, uint32_t tile)
+    {
+        while (parents[tile] != tile)
+        {
+            parents[tile] = parents[parents[tile]];
+            tile = parents[tile];
+        }
+        return tile;
+    }
+
+    uint32_t RegionFindConst(const Array<uint32_t>& parents, uint32_t tile)
+    {
+        while (parents[tile] != tile)
+        {
+            tile = parents[tile];
+        }
+        return tile;
+    }
+
+    void RegionUnion(Array<uint32_t>& parents, uint32_t a, uint32_t b)
+    {
+        a = RegionFind(parents, a);
+        b = RegionFind(parents, b);
+        if (a < b)
+        {
+            parents[b] = a;
+        }
+        else if (b < a)
+        {
+            parents[a] = b;
+        }
+    }
+
+    uint32_t RegionGetNeighbours(uint32_t tile, uint32_t width, uint32_t height, uint32_t neighbours[4])
+    {
+        const uint32_t x = tile % width;
+        const uint32_t y = tile / width;
+        uint32_t numNeighbours = 0;
+        if (x > 0)
+        {
+            neighbours[numNeighbours++] = tile - 1;
+        }
+        if (x + 1 < width)
+        {
+            neighbours[numNeighbours++] = tile + 1;
+        }
+        if (y > 0)
+        {
+            neighbours[numNeighbours++] = tile - width;
+        }
+        if (y + 1 < height)
+        {
+            neighbours[numNeighbours++] = tile + width;
+        }
+        return numNeighbours;
+    }
+}
+
+void RegionMap::Init(uint32_t width, uint32_t height, const Array<float>& speeds)
+{
+    ASSERT(speeds.GetSize() == (size_t)width * height);
+    ASSERT((size_t)width * height < kRegionSearchLabel);
+
+    mWidth = width;
+    mHeight = height;
+    const uint32_t numTiles = width * height;
+    mLabels.SetSize(numTiles);
+    mRegionSizes.Clear();
+    mFreeRegions.Clear();
+
+    // Each band only touches its own tiles' parents, so bands label in parallel
+    const uint32_t numBands = (height + kRegionBandRows - 1) / kRegionBandRows;
+    auto getBandTiles = [&](size_t band, uint32_t& begin, uint32_t& end)
+    {
+        begin = (uint32_t)band * kRegionBandRows * width;
+        end = Math::Min(begin + kRegionBandRows * width, numTiles);
+    };
+    Array<uint32_t> parents;
+    parents.SetSize(numTiles);
+    ParallelFor(numBands, 1, [&](size_t first, size_t last)
+    {
+        for (size_t band = first; band < last; ++band)
+        {
+            uint32_t begin, end;
+            getBandTiles(band, begin, end);
+            for (uint32_t tile = begin; tile < end; ++tile)
+            {
+                parents[tile] = tile;
+                if (speeds[tile] <= 0.0f)
+                {
+                    continue;
+                }
+                if (((tile % width) != 0) && (speeds[tile - 1] > 0.0f))
+                {
+                    parents[tile] = parents[tile - 1];
+                }
+                if ((tile >= begin + width) && (speeds[tile - width] > 0.0f))
+                {
+                    RegionUnion(parents, tile, tile - width);
+                }
+            }
+        }
+    });
+
+    // Borders are a thin strip of the map, so they're merged on this thread
+    for (uint32_t band = 1; band < numBands; ++band)
+    {
+        uint32_t begin, end;
+        getBandTiles(band, begin, end);
+        for (uint32_t tile = begin; tile < begin + width; ++tile)
+        {
+            if ((speeds[tile] > 0.0f) && (speeds[tile - width] > 0.0f))
+            {
+                RegionUnion(parents, tile, tile - width);
+            }
+        }
+    }
+
+    // Find every tile's root without writing to the shared parents. Parents are always
+    // earlier tiles, so a parent in the same band already has its root.
+    Array<uint32_t> bandRegions;
+    bandRegions.SetSize(numBands);
+    ParallelFor(numBands, 1, [&](size_t first, size_t last)
+    {
+        for (size_t band = first; band < last; ++band)
+        {
+            uint32_t begin, end;
+            getBandTiles(band, begin, end);
+            uint32_t numRoots = 0;
+            for (uint32_t tile = begin; tile < end; ++tile)
+            {
+                const uint32_t parent = parents[tile];
+                if (speeds[tile] <= 0.0f)
+                {
+                    mLabels[tile] = kRegionSearchLabel;
+                }
+                else if (parent == tile)
+                {
+                    mLabels[tile] = tile;
+                    ++numRoots;
+                }
+                else
+                {
+                    mLabels[tile] = (parent >= begin) ? mLabels[parent] : RegionFindConst(parents, parent);
+                }
+            }
+            bandRegions[band] = numRoots;
+        }
+    });
+
+    // Number the roots in tile order
+    uint32_t numRegions = 0;
+    for (uint32_t& regions : bandRegions)
+    {
+        const uint32_t firstRegion = numRegions + 1;
+        numRegions += regions;
+        regions = firstRegion;
+    }
+    ParallelFor(numBands, 1, [&](size_t first, size_t last)
+    {
+        for (size_t band = first; band < last; ++band)
+        {
+            uint32_t begin, end;
+            getBandTiles(band, begin, end);
+            uint32_t region = bandRegions[band];
+            for (uint32_t tile = begin; tile < end; ++tile)
+            {
+                if (mLabels[tile] == tile)
+                {
+                    parents[tile] = region++;
+                }
+            }
+        }
+    });
+    ParallelFor(numBands, 1, [&](size_t first, size_t last)
+    {
+        for (size_t band = first; band < last; ++band)
+        {
+            uint32_t begin, end;
+            getBandTiles(band, begin, end);
+            for (uint32_t tile = begin; tile < end; ++tile)
+            {
+                const uint32_t root = mLabels[tile];
+                mLabels[tile] = (root == kRegionSearchLabel) ? 0 : parents[root];
+            }
+        }
+    });
+
+    mRegionSizes.SetSize(numRegions + 1);
+    memset(mRegionSizes.Begin(), 0, mRegionSizes.GetSize() * sizeof(uint32_t));
+    for (uint32_t label : mLabels)
+    {
+        ++mRegionSizes[label];
+    }
+    mRegionSizes[0] = 0;
+}
+
+void RegionMap::SetPassable(uint32_t x, uint32_t y, bool passable)
+{
+    ASSERT(x < mWidth && y < mHeight);
+    const uint32_t tile = x + mWidth * y;
+    const uint32_t region = mLabels[tile];
+    if ((region != 0) == passable)
+    {
+        return;
+    }
+
+    uint32_t neighbours[4];
+    const uint32_t numNeighbours = RegionGetNeighbours(tile, mWidth, mHeight, neighbours);
+    if (passable)
+    {
+        // Join the neighbouring regions into the largest of them
+        uint32_t largest = 0;
+        for (uint32_t i = 0; i < numNeighbours; ++i)
+        {
+            const uint32_t label = mLabels[neighbours[i]];
+            if ((label != 0) && ((largest == 0) || (mRegionSizes[label] > mRegionSizes[largest])))
+            {
+                largest = label;
+            }
+        }
+        if (largest == 0)
+        {
+            mLabels[tile] = AddRegion(1);
+            return;
+        }
+        mLabels[tile] = largest;
+        ++mRegionSizes[largest];
+        for (uint32_t i = 0; i < numNeighbours; ++i)
+        {
+            const uint32_t label = mLabels[neighbours[i]];
+            if ((label != 0) && (label != largest))
+            {
+                Relabel(neighbours[i], label, largest);
+            }
+        }
+        return;
+    }
+
+    mLabels[tile] = 0;
+    if (--mRegionSizes[region] == 0)
+    {
+        mFreeRegions.Append(region);
+        return;
+    }
+    uint32_t starts[4];
+    uint32_t numStarts = 0;
+    for (uint32_t i = 0; i < numNeighbours; ++i)
+    {
+        if (mLabels[neighbours[i]] == region)
+        {
+            starts[numStarts++] = neighbours[i];
+        }
+    }
+    if (numStarts > 1)
+    {
+        Split(region, starts, numStarts);
+    }
+}
+
+uint32_t RegionMap::AddRegion(uint32_t size)
+{
+    if (!mFreeRegions.IsEmpty())
+    {
+        const uint32_t region = mFreeRegions.Top();
+        mFreeRegions.Pop();
+        mRegionSizes[region] = size;
+        return region;
+    }
+    mRegionSizes.Append(size);
+    return (uint32_t)mRegionSizes.GetSize() - 1;
+}
+
+void RegionMap::Relabel(uint32_t tile, uint32_t from, uint32_t to)
+{
+    mRegionSizes[to] += mRegionSizes[from];
+    mRegionSizes[from] = 0;
+    mFreeRegions.Append(from);
+
+    mQueue.Clear();
+    mQueue.Append(tile);
+    mLabels[tile] = to;
+    for (size_t head = 0; head < mQueue.GetSize(); ++head)
+    {
+        uint32_t neighbours[4];
+        const uint32_t numNeighbours = RegionGetNeighbours(mQueue[head], mWidth, mHeight, neighbours);
+        for (uint32_t i = 0; i < numNeighbours; ++i)
+        {
+            if (mLabels[neighbours[i]] == from)
+            {
+                mLabels[neighbours[i]] = to;
+                mQueue.Append(neighbours[i]);
+            }
+        }
+    }
+}
+
+void RegionMap::Split(uint32_t region, const uint32_t* starts, uint32_t numStarts)
+{
+    // Search from each neighbour of the removed tile a tile at a time in turn. Searches
+    // that meet are still connected. Once at most one group of them is still searching,
+    // the others have visited all of their parts of the region and become new regions.
+    for (uint32_t i = 0; i < numStarts; ++i)
+    {
+        Search& search = mSearches[i];
+        search.mTiles.Clear();
+        search.mTiles.Append(starts[i]);
+        search.mHead = 0;
+        search.mGroup = i;
+        mLabels[starts[i]] = kRegionSearchLabel + i;
+    }
+    auto isGroupSearching = [&](uint32_t group)
+    {
+        for (uint32_t i = 0; i < numStarts; ++i)
+        {
+            if ((mSearches[i].mGroup == group) && (mSearches[i].mHead < mSearches[i].mTiles.GetSize()))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (;;)
+    {
+        uint32_t numSearching = 0;
+        for (uint32_t group = 0; group < numStarts; ++group)
+        {
+            numSearching += isGroupSearching(group) ? 1 : 0;
+        }
+        if (numSearching <= 1)
+        {
+            break;
+        }
+
+        for (uint32_t i = 0; i < numStarts; ++i)
+        {
+            Search& search = mSearches[i];
+            if (search.mHead == search.mTiles.GetSize())
+            {
+                continue;
+            }
+            uint32_t neighbours[4];
+            const uint32_t numNeighbours = RegionGetNeighbours(search.mTiles[search.mHead++], mWidth, mHeight, neighbours);
+            for (uint32_t n = 0; n < numNeighbours; ++n)
+            {
+                const uint32_t label = mLabels[neighbours[n]];
+                if (label == region)
+                {
+                    mLabels[neighbours[n]] = kRegionSearchLabel + i;
+                    search.mTiles.Append(neighbours[n]);
+                }
+                else if ((label >= kRegionSearchLabel) && (mSearches[label - kRegionSearchLabel].mGroup != search.mGroup))
+                {
+                    const uint32_t a = search.mGroup;
+                    const uint32_t b = mSearches[label - kRegionSearchLabel].mGroup;
+                    const uint32_t merged = Math::Min(a, b);
+                    for (uint32_t j = 0; j < numStarts; ++j)
+                    {
+                        if ((mSearches[j].mGroup == a) || (mSearches[j].mGroup == b))
+                        {
+                            mSearches[j].mGroup = merged;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // The group still searching keeps the region, or the largest if they all finished
+    uint32_t groupSizes[4] = { 0, 0, 0, 0 };
+    for (uint32_t i = 0; i < numStarts; ++i)
+    {
+        groupSizes[mSearches[i].mGroup] += (uint32_t)mSearches[i].mTiles.GetSize();
+    }
+    uint32_t keep = mSearches[0].mGroup;
+    for (uint32_t group = 0; group < numStarts; ++group)
+    {
+        if (isGroupSearching(group))
+        {
+            keep = group;
+            break;
+        }
+        if (groupSizes[group] > groupSizes[keep])
+        {
+            keep = group;
+        }
+    }
+
+    uint32_t groupRegions[4];
+    for (uint32_t group = 0; group < numStarts; ++group)
+    {
+        groupRegions[group] = region;
+        if ((group != keep) && (groupSizes[group] != 0))
+        {
+            groupRegions[group] = AddRegion(groupSizes[group]);
+            mRegionSizes[region] -= groupSizes[group];
+        }
+    }
+    for (uint32_t i = 0; i < numStarts; ++i)
+    {
+        const uint32_t label = groupRegions[mSearches[i].mGroup];
+        for (uint32_t tile : mSearches[i].mTiles)
+        {
+            mLabels[tile] = label;
+        }
+    }
+}
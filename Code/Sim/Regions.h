@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Connected regions of passable land, so islands, enclosed valleys and whether two tiles
+// are reachable by land are label lookups rather than searches. Tiles are 4-connected.
+//
+// Init labels bands of rows in parallel with union-find, then merges the labels across
+// band borders. Changing a tile's passability only relabels the region it
+// touches: joining regions relabels the smaller ones, and a possible split is checked
+// by searching out from the tile's neighbours in lockstep, so the work is bounded by
+// the smaller side of the split.
+class RegionMap
+{
+public:
+    // speeds has one entry per tile, zero for impassable tiles
+    void Init(uint32_t width, uint32_t height, const Array<float>& speeds);
+
+    void SetPassable(uint32_t x, uint32_t y, bool passable);
+
+    // Zero for impassable tiles
+    uint32_t GetRegion(uint32_t x, uint32_t y) const { return mLabels[x + (size_t)mWidth * y]; }
+    bool IsConnected(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const
+    {
+        const uint32_t region = GetRegion(x0, y0);
+        return (region != 0) && (region == GetRegion(x1, y1));
+    }
+
+    uint32_t GetRegionSize(uint32_t region) const { return mRegionSizes[region]; }
+    uint32_t GetNumRegions() const { return (uint32_t)(mRegionSizes.GetSize() - 1 - mFreeRegions.GetSize()); }
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+
+private:
+    struct Search
+    {
+        Array<uint32_t> mTiles;     // Visited, in order, from mHead on still to expand
+        uint32_t mHead = 0;
+        uint32_t mGroup = 0;        // Searches that met share the lowest group
+    };
+
+    uint32_t AddRegion(uint32_t size);
+    void Relabel(uint32_t tile, uint32_t from, uint32_t to);
+    void Split(uint32_t region, const uint32_t* starts, uint32_t numStarts);
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    Array<uint32_t> mLabels;
+    Array<uint32_t> mRegionSizes;   // Zero for unused regions, entry 0 is unused
+    Array<uint32_t> mFreeRegions;
+
+    Search mSearches[4];
+    Array<uint32_t> mQueue;
+};
@@ -0,0 +1,996 @@
+#include "RoadNetwork.h"
+
+#include <Core/Env/Assert.h>
+#include <Core/Mem/FrameArena.h>
+#include <Core/Mem/MemStats.h>
+#include <Core/Process/Atomic.h>
+#include <Core/Process/Thread.h>
+#include <Core/Time/Timer.h>
+
+#include <float.h>
+
+namespace
+{
+    const uint32_t kRoadMinTableSize = 1024;
+    const uint32_t kRoadNoMiddle = 0xFFFFFFFF;
+
+    // Witness searches give up after settling this many junctions and add the shortcut
+    // anyway, which costs a little query time but is never wrong. Estimating priorities
+    // only needs rough shortcut counts.
+    const uint32_t kRoadWitnessSettleLimit = 128;
+    const uint32_t kRoadPrioritySettleLimit = 32;
+
+    // Past this many changed junctions, re-contraction redoes every remaining witness search
+    const uint32_t kRoadMaxDirty = 2048;
+
+    // The order is rebuilt once more than this fraction of junctions have changed since
+    // it was made
+    const uint32_t kRoadReorderDivisor = 8;
+
+    const uint32_t kRoadContractionStackSize = 256 * 1024;
+
+    // Ties are broken by node so searches settle in the same order whatever order their
+    // arcs are stored in, which re-contraction relies on
+    template<class Item>
+    bool RoadHeapLess(const Item& a, const Item& b)
+    {
+        return (a.mCost < b.mCost) || ((a.mCost == b.mCost) && (a.mNode < b.mNode));
+    }
+
+    template<class Item>
+    void RoadHeapPush(Array<Item>& heap, float cost, uint32_t node)
+    {
+        const Item item = { cost, node };
+        size_t i = heap.GetSize();
+        heap.Append(item);
+        while (i > 0)
+        {
+            const size_t parent = (i - 1) / 2;
+            if (!RoadHeapLess(item, heap[parent]))
+            {
+                break;
+            }
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = item;
+    }
+
+    template<class Item>
+    Item RoadHeapPop(Array<Item>& heap)
+    {
+        const Item top = heap[0];
+        const Item last = heap.Top();
+        heap.Pop();
+        const size_t size = heap.GetSize();
+        if (size)
+        {
+            size_t i = 0;
+            for (;;)
+            {
+                size_t child = i * 2 + 1;
+                if (child >= size)
+                {
+                    break;
+                }
+                if ((child + 1 < size) && RoadHeapLess(heap[child + 1], heap[child]))
+                {
+                    ++child;
+                }
+                if (!RoadHeapLess(heap[child], last))
+                {
+                    break;
+                }
+                heap[i] = heap[child];
+                i = child;
+            }
+            heap[i] = last;
+        }
+        return top;
+    }
+
+    uint32_t RoadHashTile(uint32_t x, uint32_t y)
+    {
+        const uint64_t key = ((uint64_t)y << 32) | x;
+        return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+}
+
+// The result of a contraction. Queries only need the upward arcs, the rest is kept so the
+// next contraction can reuse the work done for junctions away from any change.
+class RoadHierarchy
+{
+public:
+    struct Arc
+    {
+        uint32_t mTo;
+        float mCost;
+        uint32_t mMiddle;   // Junction the shortcut was made around, kRoadNoMiddle for roads
+    };
+
+    struct Shortcut
+    {
+        uint32_t mFrom;
+        uint32_t mTo;
+        float mCost;
+    };
+
+    // Covers every junction a junction's witness searches settled
+    struct Box
+    {
+        uint32_t mMinX;
+        uint32_t mMinY;
+        uint32_t mMaxX;
+        uint32_t mMaxY;
+
+        void Set(uint32_t x, uint32_t y)
+        {
+            mMinX = mMaxX = x;
+            mMinY = mMaxY = y;
+        }
+        void Add(uint32_t x, uint32_t y)
+        {
+            mMinX = Math::Min(mMinX, x);
+            mMinY = Math::Min(mMinY, y);
+            mMaxX = Math::Max(mMaxX, x);
+            mMaxY = Math::Max(mMaxY, y);
+        }
+        bool Contains(uint32_t x, uint32_t y) const
+        {
+            return (x >= mMinX) && (x <= mMaxX) && (y >= mMinY) && (y <= mMaxY);
+        }
+    };
+
+    uint32_t GetNumNodes() const { return (uint32_t)mRanks.GetSize(); }
+
+    // Arcs are by rank and only lead up to higher ranks
+    const Arc* BeginArcs(uint32_t rank) const { return mArcs.Begin() + mArcStart[rank]; }
+    const Arc* EndArcs(uint32_t rank) const { return mArcs.Begin() + mArcStart[rank + 1]; }
+
+    uint32_t GetMiddle(uint32_t lower, uint32_t upper) const
+    {
+        for (const Arc* arc = BeginArcs(lower); arc != EndArcs(lower); ++arc)
+        {
+            if (arc->mTo == upper)
+            {
+                return arc->mMiddle;
+            }
+        }
+        ASSERT(false);
+        return kRoadNoMiddle;
+    }
+
+    // Junctions are numbered by rank for searching, so the top of the hierarchy that
+    // every query visits is packed together
+    Array<uint32_t> mArcStart;
+    Array<Arc> mArcs;
+
+    // Junctions in contraction order, and the rank of each junction
+    Array<uint32_t> mOrder;
+    Array<uint32_t> mRanks;
+
+    // Per junction, what its contraction found
+    Array<Box> mBoxes;
+    Array<uint32_t> mShortcutStart;
+    Array<uint32_t> mNumShortcuts;
+    Array<Shortcut> mShortcuts;
+
+    uint32_t mNumRecontracted = 0;
+    float mContractionMS = 0.0f;
+};
+
+// Builds a hierarchy from a snapshot of the roads on its own thread
+class RoadContraction
+{
+public:
+    static uint32_t ThreadMain(void* param)
+    {
+        RoadContraction* contraction = static_cast<RoadContraction*>(param);
+        {
+            const MemCategoryScope scope(contraction->mCategory);
+            contraction->Run();
+        }
+        AtomicStoreRelease(&contraction->mDone, true);
+        return 0;
+    }
+
+    bool IsDone() const { return AtomicLoadAcquire(&mDone); }
+
+    // Snapshot, roads as one list per junction
+    Array<uint32_t> mX;
+    Array<uint32_t> mY;
+    Array<uint32_t> mRoadStart;
+    Array<uint32_t> mRoadTo;
+    Array<float> mRoadCost;
+    Array<uint32_t> mChanged;
+    const RoadHierarchy* mPrevious = nullptr;  // Order from scratch when null
+
+    uint8_t mCategory = 0;  // The starting thread's, so the hierarchy is counted there
+    Thread::ThreadHandle mThread = INVALID_THREAD_HANDLE;
+    UniquePtr<RoadHierarchy, DeleteDeletor> mResult;
+
+private:
+    typedef RoadHierarchy::Arc Arc;
+    typedef RoadHierarchy::Shortcut Shortcut;
+    typedef RoadHierarchy::Box Box;
+
+    struct HeapItem
+    {
+        float mCost;
+        uint32_t mNode;
+    };
+
+    void Run();
+    void Order();
+    void Reorder();
+    void FindShortcuts(uint32_t node, uint32_t settleLimit, Array<Shortcut>& shortcuts, Box& box);
+    void WitnessSearch(uint32_t from, uint32_t skip, float limit, uint32_t settleLimit, uint32_t numTargets, Box& box);
+    void Contract(uint32_t node, const Shortcut* shortcuts, uint32_t numShortcuts, const Box& box);
+    void AddArc(uint32_t from, uint32_t to, float cost, uint32_t middle);
+    void MarkDirty(uint32_t node);
+    bool IsDirty(const Box& box) const;
+    void MarkChangedShortcuts(const Shortcut* previous, uint32_t numPrevious, const Array<Shortcut>& shortcuts);
+    void Renumber();
+
+    volatile bool mDone = false;
+
+    // Roads and shortcuts between junctions not yet contracted
+    Array<Array<Arc>> mGraph;
+    Array<uint32_t> mContractedNeighbours;
+    Array<uint32_t> mLevels;    // Longest chain of contracted junctions below
+
+    // Upward arcs by junction
+    Array<uint32_t> mArcStart;
+    Array<uint32_t> mArcEnd;
+    Array<Arc> mArcs;
+
+    // Junctions whose arcs differ from the previous contraction
+    Array<bool> mDirtyNodes;
+    Array<uint32_t> mDirtyList;
+
+    Array<float> mWitnessCosts;
+    Array<bool> mWitnessTargets;
+    Array<uint32_t> mWitnessTouched;
+    Array<HeapItem> mWitnessHeap;
+};
+
+void RoadContraction::Run()
+{
+    Timer timer;
+    const uint32_t numNodes = (uint32_t)mX.GetSize();
+    mGraph.SetSize(numNodes);
+    for (uint32_t node = 0; node < numNodes; ++node)
+    {
+        for (uint32_t road = mRoadStart[node]; road < mRoadStart[node + 1]; ++road)
+        {
+            mGraph[node].Append({ mRoadTo[road], mRoadCost[road], kRoadNoMiddle });
+        }
+    }
+    mContractedNeighbours.SetSize(numNodes);
+    mLevels.SetSize(numNodes);
+    mWitnessCosts.SetSize(numNodes);
+    mWitnessTargets.SetSize(numNodes);
+    for (uint32_t node = 0; node < numNodes; ++node)
+    {
+        mContractedNeighbours[node] = 0;
+        mLevels[node] = 0;
+        mWitnessCosts[node] = FLT_MAX;
+        mWitnessTargets[node] = false;
+    }
+
+    mResult = new RoadHierarchy;
+    RoadHierarchy& result = *mResult.Get();
+    mArcStart.SetSize(numNodes);
+    mArcEnd.SetSize(numNodes);
+    result.mBoxes.SetSize(numNodes);
+    result.mShortcutStart.SetSize(numNodes);
+    result.mNumShortcuts.SetSize(numNodes);
+    result.mOrder.SetCapacity(numNodes);
+
+    if (mPrevious)
+    {
+        Reorder();
+    }
+    else
+    {
+        Order();
+    }
+    Renumber();
+    result.mContractionMS = timer.GetElapsedMS();
+}
+
+void RoadContraction::Order()
+{
+    // Contract the junction that adds the fewest shortcuts for the arcs it removes, with
+    // penalties for contracted neighbours and depth to spread contraction evenly and keep
+    // the hierarchy shallow. Priorities only grow stale as neighbours are contracted, so
+    // they are recomputed when popped.
+    RoadHierarchy& result = *mResult.Get();
+    const uint32_t numNodes = (uint32_t)mGraph.GetSize();
+    Array<Shortcut> shortcuts;
+    Box box;
+    auto getPriority = [&](uint32_t node)
+    {
+        FindShortcuts(node, kRoadPrioritySettleLimit, shortcuts, box);
+        return 2.0f * ((float)shortcuts.GetSize() - (float)mGraph[node].GetSize()) + (float)mContractedNeighbours[node] + (float)mLevels[node];
+    };
+
+    Array<HeapItem> heap;
+    heap.SetCapacity(numNodes);
+    for (uint32_t node = 0; node < numNodes; ++node)
+    {
+        RoadHeapPush(heap, getPriority(node), node);
+    }
+    while (!heap.IsEmpty())
+    {
+        const uint32_t node = RoadHeapPop(heap).mNode;
+        const float priority = getPriority(node);
+        if (!heap.IsEmpty() && (priority > heap[0].mCost))
+        {
+            RoadHeapPush(heap, priority, node);
+            continue;
+        }
+        FindShortcuts(node, kRoadWitnessSettleLimit, shortcuts, box);
+        Contract(node, shortcuts.Begin(), (uint32_t)shortcuts.GetSize(), box);
+    }
+    result.mNumRecontracted = numNodes;
+}
+
+void RoadContraction::Reorder()
+{
+    // Contract in the previous order, with new junctions first. A junction's witness
+    // searches only need redoing if they could have reached a junction whose arcs changed,
+    // otherwise it adds the same shortcuts as last time.
+    RoadHierarchy& result = *mResult.Get();
+    const RoadHierarchy& previous = *mPrevious;
+    const uint32_t numNodes = (uint32_t)mGraph.GetSize();
+    const uint32_t numPrevious = previous.GetNumNodes();
+    mDirtyNodes.SetSize(numNodes);
+    for (uint32_t node = 0; node < numNodes; ++node)
+    {
+        mDirtyNodes[node] = false;
+    }
+    for (uint32_t node : mChanged)
+    {
+        MarkDirty(node);
+    }
+
+    Array<Shortcut> shortcuts;
+    Box box;
+    uint32_t numRecontracted = 0;
+    auto contract = [&](uint32_t node)
+    {
+        if ((node < numPrevious) && !mDirtyNodes[node] && (mDirtyList.GetSize() <= kRoadMaxDirty) && !IsDirty(previous.mBoxes[node]))
+        {
+            Contract(node, previous.mShortcuts.Begin() + previous.mShortcutStart[node], previous.mNumShortcuts[node], previous.mBoxes[node]);
+            return;
+        }
+        FindShortcuts(node, kRoadWitnessSettleLimit, shortcuts, box);
+        if (node < numPrevious)
+        {
+            MarkChangedShortcuts(previous.mShortcuts.Begin() + previous.mShortcutStart[node], previous.mNumShortcuts[node], shortcuts);
+        }
+        else
+        {
+            MarkChangedShortcuts(nullptr, 0, shortcuts);
+        }
+        Contract(node, shortcuts.Begin(), (uint32_t)shortcuts.GetSize(), box);
+        ++numRecontracted;
+    };
+    for (uint32_t node = numPrevious; node < numNodes; ++node)
+    {
+        contract(node);
+    }
+    for (uint32_t node : previous.mOrder)
+    {
+        contract(node);
+    }
+    result.mNumRecontracted = numRecontracted;
+}
+
+void RoadContraction::FindShortcuts(uint32_t node, uint32_t settleLimit, Array<Shortcut>& shortcuts, Box& box)
+{
+    // A pair of neighbours needs a shortcut unless there's a route between them that
+    // avoids the junction and is no dearer than going through it
+    shortcuts.Clear();
+    const Array<Arc>& arcs = mGraph[node];
+    box.Set(mX[node], mY[node]);
+    for (const Arc& arc : arcs)
+    {
+        box.Add(mX[arc.mTo], mY[arc.mTo]);
+    }
+    for (size_t i = 0; (i + 1) < arcs.GetSize(); ++i)
+    {
+        const uint32_t from = arcs[i].mTo;
+        float limit = 0.0f;
+        for (size_t j = i + 1; j < arcs.GetSize(); ++j)
+        {
+            limit = Math::Max(limit, arcs[i].mCost + arcs[j].mCost);
+        }
+        for (size_t j = i + 1; j < arcs.GetSize(); ++j)
+        {
+            mWitnessTargets[arcs[j].mTo] = true;
+        }
+        WitnessSearch(from, node, limit, settleLimit, (uint32_t)(arcs.GetSize() - i - 1), box);
+        for (size_t j = i + 1; j < arcs.GetSize(); ++j)
+        {
+            mWitnessTargets[arcs[j].mTo] = false;
+            const float cost = arcs[i].mCost + arcs[j].mCost;
+            if (mWitnessCosts[arcs[j].mTo] > cost)
+            {
+                shortcuts.Append({ from, arcs[j].mTo, cost });
+            }
+        }
+        for (uint32_t touched : mWitnessTouched)
+        {
+            mWitnessCosts[touched] = FLT_MAX;
+        }
+        mWitnessTouched.Clear();
+    }
+}
+
+void RoadContraction::WitnessSearch(uint32_t from, uint32_t skip, float limit, uint32_t settleLimit, uint32_t numTargets, Box& box)
+{
+    mWitnessCosts[from] = 0.0f;
+    mWitnessTouched.Append(from);
+    RoadHeapPush(mWitnessHeap, 0.0f, from);
+    uint32_t numSettled = 0;
+    while (!mWitnessHeap.IsEmpty())
+    {
+        const HeapItem item = RoadHeapPop(mWitnessHeap);
+        if (item.mCost > mWitnessCosts[item.mNode])
+        {
+            continue;
+        }
+        if ((item.mCost > limit) || (numSettled == settleLimit))
+        {
+            break;
+        }
+        ++numSettled;
+        box.Add(mX[item.mNode], mY[item.mNode]);
+        if (mWitnessTargets[item.mNode] && (--numTargets == 0))
+        {
+            break;
+        }
+        for (const Arc& arc : mGraph[item.mNode])
+        {
+            const float cost = item.mCost + arc.mCost;
+            if ((arc.mTo != skip) && (cost < mWitnessCosts[arc.mTo]))
+            {
+                if (mWitnessCosts[arc.mTo] == FLT_MAX)
+                {
+                    mWitnessTouched.Append(arc.mTo);
+                }
+                mWitnessCosts[arc.mTo] = cost;
+                RoadHeapPush(mWitnessHeap, cost, arc.mTo);
+            }
+        }
+    }
+    mWitnessHeap.Clear();
+}
+
+void RoadContraction::Contract(uint32_t node, const Shortcut* shortcuts, uint32_t numShortcuts, const Box& box)
+{
+    RoadHierarchy& result = *mResult.Get();
+    result.mOrder.Append(node);
+    result.mBoxes[node] = box;
+    result.mShortcutStart[node] = (uint32_t)result.mShortcuts.GetSize();
+    result.mNumShortcuts[node] = numShortcuts;
+    for (uint32_t i = 0; i < numShortcuts; ++i)
+    {
+        result.mShortcuts.Append(shortcuts[i]);
+    }
+
+    // Every remaining neighbour is contracted later, so these are the upward arcs
+    mArcStart[node] = (uint32_t)mArcs.GetSize();
+    for (const Arc& arc : mGraph[node])
+    {
+        mArcs.Append(arc);
+        Array<Arc>& reverseArcs = mGraph[arc.mTo];
+        for (Arc& reverse : reverseArcs)
+        {
+            if (reverse.mTo == node)
+            {
+                reverseArcs.Erase(&reverse);
+                break;
+            }
+        }
+        ++mContractedNeighbours[arc.mTo];
+        mLevels[arc.mTo] = Math::Max(mLevels[arc.mTo], mLevels[node] + 1);
+    }
+    mArcEnd[node] = (uint32_t)mArcs.GetSize();
+    mGraph[node].Destruct();
+
+    for (uint32_t i = 0; i < numShortcuts; ++i)
+    {
+        AddArc(shortcuts[i].mFrom, shortcuts[i].mTo, shortcuts[i].mCost, node);
+        AddArc(shortcuts[i].mTo, shortcuts[i].mFrom, shortcuts[i].mCost, node);
+    }
+}
+
+void RoadContraction::AddArc(uint32_t from, uint32_t to, float cost, uint32_t middle)
+{
+    for (Arc& arc : mGraph[from])
+    {
+        if (arc.mTo == to)
+        {
+            if (cost < arc.mCost)
+            {
+                arc.mCost = cost;
+                arc.mMiddle = middle;
+            }
+            return;
+        }
+    }
+    mGraph[from].Append({ to, cost, middle });
+}
+
+void RoadContraction::MarkDirty(uint32_t node)
+{
+    if (!mDirtyNodes[node])
+    {
+        mDirtyNodes[node] = true;
+        mDirtyList.Append(node);
+    }
+}
+
+bool RoadContraction::IsDirty(const Box& box) const
+{
+    for (uint32_t node : mDirtyList)
+    {
+        if (box.Contains(mX[node], mY[node]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RoadContraction::MarkChangedShortcuts(const Shortcut* previous, uint32_t numPrevious, const Array<Shortcut>& shortcuts)
+{
+    // Shortcuts are compared as unordered pairs, as neighbours may be listed in a new order
+    auto matches = [](const Shortcut& a, const Shortcut& b)
+    {
+        return (a.mCost == b.mCost) && (((a.mFrom == b.mFrom) && (a.mTo == b.mTo)) || ((a.mFrom == b.mTo) && (a.mTo == b.mFrom)));
+    };
+    for (const Shortcut& shortcut : shortcuts)
+    {
+        bool found = false;
+        for (uint32_t i = 0; (i < numPrevious) && !found; ++i)
+        {
+            found = matches(shortcut, previous[i]);
+        }
+        if (!found)
+        {
+            MarkDirty(shortcut.mFrom);
+            MarkDirty(shortcut.mTo);
+        }
+    }
+    for (uint32_t i = 0; i < numPrevious; ++i)
+    {
+        bool found = false;
+        for (size_t j = 0; (j < shortcuts.GetSize()) && !found; ++j)
+        {
+            found = matches(previous[i], shortcuts[j]);
+        }
+        if (!found)
+        {
+            MarkDirty(previous[i].mFrom);
+            MarkDirty(previous[i].mTo);
+        }
+    }
+}
+
+void RoadContraction::Renumber()
+{
+    RoadHierarchy& result = *mResult.Get();
+    const uint32_t numNodes = (uint32_t)result.mOrder.GetSize();
+    result.mRanks.SetSize(numNodes);
+    for (uint32_t rank = 0; rank < numNodes; ++rank)
+    {
+        result.mRanks[result.mOrder[rank]] = rank;
+    }
+    result.mArcStart.SetCapacity(numNodes + 1);
+    result.mArcs.SetCapacity(mArcs.GetSize());
+    for (uint32_t node : result.mOrder)
+    {
+        result.mArcStart.Append((uint32_t)result.mArcs.GetSize());
+        for (uint32_t arc = mArcStart[node]; arc < mArcEnd[node]; ++arc)
+        {
+            const uint32_t middle = mArcs[arc].mMiddle;
+            result.mArcs.Append({ result.mRanks[mArcs[arc].mTo], mArcs[arc].mCost, (middle == kRoadNoMiddle) ? kRoadNoMiddle : result.mRanks[middle] });
+        }
+    }
+    result.mArcStart.Append((uint32_t)result.mArcs.GetSize());
+}
+
+RoadNetwork::RoadNetwork()
+{
+    mJunctionTable.SetSize(kRoadMinTableSize);
+    for (uint32_t& entry : mJunctionTable)
+    {
+        entry = kInvalidJunction;
+    }
+}
+
+RoadNetwork::~RoadNetwork()
+{
+    if (mContraction.Get())
+    {
+        FinishContraction();
+    }
+}
+
+uint32_t RoadNetwork::AddJunction(uint32_t x, uint32_t y)
+{
+    const uint32_t existing = FindJunction(x, y);
+    if (existing != kInvalidJunction)
+    {
+        return existing;
+    }
+    if ((mJunctions.GetSize() + 1) * 2 > mJunctionTable.GetSize())
+    {
+        GrowTable();
+    }
+
+    const uint32_t junction = (uint32_t)mJunctions.GetSize();
+    Junction& added = mJunctions.EmplaceBack();
+    added.mX = x;
+    added.mY = y;
+    const uint32_t mask = (uint32_t)mJunctionTable.GetSize() - 1;
+    uint32_t slot = RoadHashTile(x, y) & mask;
+    while (mJunctionTable[slot] != kInvalidJunction)
+    {
+        slot = (slot + 1) & mask;
+    }
+    mJunctionTable[slot] = junction;
+    return junction;
+}
+
+uint32_t RoadNetwork::FindJunction(uint32_t x, uint32_t y) const
+{
+    const uint32_t mask = (uint32_t)mJunctionTable.GetSize() - 1;
+    for (uint32_t slot = RoadHashTile(x, y) & mask;; slot = (slot + 1) & mask)
+    {
+        const uint32_t junction = mJunctionTable[slot];
+        if ((junction == kInvalidJunction) || ((mJunctions[junction].mX == x) && (mJunctions[junction].mY == y)))
+        {
+            return junction;
+        }
+    }
+}
+
+void RoadNetwork::GrowTable()
+{
+    mJunctionTable.SetSize(mJunctionTable.GetSize() * 2);
+    for (uint32_t& entry : mJunctionTable)
+    {
+        entry = kInvalidJunction;
+    }
+    const uint32_t mask = (uint32_t)mJunctionTable.GetSize() - 1;
+    for (uint32_t junction = 0; junction < mJunctions.GetSize(); ++junction)
+    {
+        uint32_t slot = RoadHashTile(mJunctions[junction].mX, mJunctions[junction].mY) & mask;
+        while (mJunctionTable[slot] != kInvalidJunction)
+        {
+            slot = (slot + 1) & mask;
+        }
+        mJunctionTable[slot] = junction;
+    }
+}
+
+void RoadNetwork::BuildRoad(uint32_t a, uint32_t b, float cost)
+{
+    ASSERT((a != b) && (cost > 0.0f));
+    for (Road& road : mJunctions[a].mRoads)
+    {
+        if (road.mTo == b)
+        {
+            if (road.mCost == cost)
+            {
+                return;
+            }
+            road.mCost = cost;
+            for (Road& reverse : mJunctions[b].mRoads)
+            {
+                if (reverse.mTo == a)
+                {
+                    reverse.mCost = cost;
+                }
+            }
+            MarkChanged(a);
+            MarkChanged(b);
+            return;
+        }
+    }
+    mJunctions[a].mRoads.Append({ b, cost });
+    mJunctions[b].mRoads.Append({ a, cost });
+    MarkChanged(a);
+    MarkChanged(b);
+}
+
+void RoadNetwork::DestroyRoad(uint32_t a, uint32_t b)
+{
+    bool destroyed = false;
+    Array<Road>& roadsA = mJunctions[a].mRoads;
+    for (Road& road : roadsA)
+    {
+        if (road.mTo == b)
+        {
+            roadsA.Erase(&road);
+            destroyed = true;
+            break;
+        }
+    }
+    Array<Road>& roadsB = mJunctions[b].mRoads;
+    for (Road& road : roadsB)
+    {
+        if (road.mTo == a)
+        {
+            roadsB.Erase(&road);
+            break;
+        }
+    }
+    if (destroyed)
+    {
+        MarkChanged(a);
+        MarkChanged(b);
+    }
+}
+
+void RoadNetwork::MarkChanged(uint32_t junction)
+{
+    if (!mJunctions[junction].mChanged)
+    {
+        mJunctions[junction].mChanged = true;
+        mChangedJunctions.Append(junction);
+    }
+}
+
+void RoadNetwork::Update()
+{
+    if (mContraction.Get() && mContraction->IsDone())
+    {
+        FinishContraction();
+    }
+    if (!mContraction.Get() && HasChanges())
+    {
+        StartContraction();
+    }
+}
+
+void RoadNetwork::Flush()
+{
+    if (mContraction.Get())
+    {
+        FinishContraction();
+    }
+    if (HasChanges())
+    {
+        StartContraction();
+        FinishContraction();
+    }
+}
+
+void RoadNetwork::StartContraction()
+{
+    RoadContraction* contraction = new RoadContraction;
+    const uint32_t numJunctions = (uint32_t)mJunctions.GetSize();
+    contraction->mX.SetCapacity(numJunctions);
+    contraction->mY.SetCapacity(numJunctions);
+    contraction->mRoadStart.SetCapacity(numJunctions + 1);
+    for (Junction& junction : mJunctions)
+    {
+        contraction->mX.Append(junction.mX);
+        contraction->mY.Append(junction.mY);
+        contraction->mRoadStart.Append((uint32_t)contraction->mRoadTo.GetSize());
+        for (const Road& road : junction.mRoads)
+        {
+            contraction->mRoadTo.Append(road.mTo);
+            contraction->mRoadCost.Append(road.mCost);
+        }
+        junction.mChanged = false;
+    }
+    contraction->mRoadStart.Append((uint32_t)contraction->mRoadTo.GetSize());
+
+    // The hierarchy in use stays alive until the contraction finishes
+    mChangesSinceOrdered += (uint32_t)mChangedJunctions.GetSize();
+    if (mHierarchy.Get() && (mChangesSinceOrdered * kRoadReorderDivisor < numJunctions))
+    {
+        contraction->mPrevious = mHierarchy.Get();
+        contraction->mChanged = Move(mChangedJunctions);
+    }
+    else
+    {
+        mChangesSinceOrdered = 0;
+    }
+    mChangedJunctions.Clear();
+
+    contraction->mCategory = MemStats::GetCurrentCategory();
+    contraction->mThread = Thread::CreateThread(RoadContraction::ThreadMain, "RoadContraction", kRoadContractionStackSize, contraction);
+    mContraction = contraction;
+}
+
+void RoadNetwork::FinishContraction()
+{
+    Thread::WaitForThread(mContraction->mThread);
+    Thread::CloseHandle(mContraction->mThread);
+    mHierarchy = mContraction->mResult.Release();
+    mContraction.Destroy();
+}
+
+uint32_t RoadNetwork::GetNumShortcuts() const
+{
+    return mHierarchy.Get() ? (uint32_t)mHierarchy->mShortcuts.GetSize() : 0;
+}
+
+uint32_t RoadNetwork::GetNumRecontracted() const
+{
+    return mHierarchy.Get() ? mHierarchy->mNumRecontracted : 0;
+}
+
+float RoadNetwork::GetContractionMS() const
+{
+    return mHierarchy.Get() ? mHierarchy->mContractionMS : 0.0f;
+}
+
+float RoadQuery::Find(const RoadNetwork& network, uint32_t from, uint32_t to, Array<uint32_t>* junctions)
+{
+    if (junctions)
+    {
+        junctions->Clear();
+    }
+    mNumVisited = 0;
+    const RoadHierarchy* hierarchy = network.mHierarchy.Get();
+    if (!hierarchy || (from >= hierarchy->GetNumNodes()) || (to >= hierarchy->GetNumNodes()))
+    {
+        return FLT_MAX;
+    }
+    if (from == to)
+    {
+        if (junctions)
+        {
+            junctions->Append(from);
+        }
+        return 0.0f;
+    }
+
+    const uint32_t numNodes = hierarchy->GetNumNodes();
+    for (Side& side : mSides)
+    {
+        const uint32_t oldSize = (uint32_t)side.mCosts.GetSize();
+        if (oldSize < numNodes)
+        {
+            side.mCosts.SetSize(numNodes);
+            side.mParents.SetSize(numNodes);
+            side.mParentMiddles.SetSize(numNodes);
+            for (uint32_t node = oldSize; node < numNodes; ++node)
+            {
+                side.mCosts[node] = FLT_MAX;
+            }
+        }
+    }
+    const uint32_t ends[2] = { hierarchy->mRanks[from], hierarchy->mRanks[to] };
+    for (uint32_t s = 0; s < 2; ++s)
+    {
+        Side& side = mSides[s];
+        side.mCosts[ends[s]] = 0.0f;
+        side.mParents[ends[s]] = RoadNetwork::kInvalidJunction;
+        side.mTouched.Append(ends[s]);
+        RoadHeapPush(side.mHeap, 0.0f, ends[s]);
+    }
+
+    // Both sides only search upwards and meet at the route's highest junction. Either
+    // side can stop once its next junction is dearer than the best route so far.
+    float best = FLT_MAX;
+    uint32_t meet = RoadNetwork::kInvalidJunction;
+    for (;;)
+    {
+        uint32_t s = 0;
+        if (mSides[0].mHeap.IsEmpty() || (!mSides[1].mHeap.IsEmpty() && (mSides[1].mHeap[0].mCost < mSides[0].mHeap[0].mCost)))
+        {
+            s = 1;
+        }
+        Side& side = mSides[s];
+        if (side.mHeap.IsEmpty() || (side.mHeap[0].mCost >= best))
+        {
+            break;
+        }
+        const HeapItem item = RoadHeapPop(side.mHeap);
+
+        if (item.mCost > side.mCosts[item.mNode])
+        {
+            continue;
+        }
+        ++mNumVisited;
+
+        const float otherCost = mSides[1 - s].mCosts[item.mNode];
+        if ((otherCost != FLT_MAX) && (item.mCost + otherCost < best))
+        {
+            best = item.mCost + otherCost;
+            meet = item.mNode;
+        }
+
+        // A junction reached more cheaply down from a higher one can't be on the route
+        bool stalled = false;
+        const RoadHierarchy::Arc* end = hierarchy->EndArcs(item.mNode);
+        for (const RoadHierarchy::Arc* arc = hierarchy->BeginArcs(item.mNode); arc != end; ++arc)
+        {
+            const float upperCost = side.mCosts[arc->mTo];
+            if ((upperCost != FLT_MAX) && (upperCost + arc->mCost < item.mCost))
+            {
+                stalled = true;
+                break;
+            }
+        }
+        if (stalled)
+        {
+            continue;
+        }
+
+        for (const RoadHierarchy::Arc* arc = hierarchy->BeginArcs(item.mNode); arc != end; ++arc)
+        {
+            const float cost = item.mCost + arc->mCost;
+            if (cost < side.mCosts[arc->mTo])
+            {
+                if (side.mCosts[arc->mTo] == FLT_MAX)
+                {
+                    side.mTouched.Append(arc->mTo);
+                }
+                side.mCosts[arc->mTo] = cost;
+                side.mParents[arc->mTo] = item.mNode;
+                side.mParentMiddles[arc->mTo] = arc->mMiddle;
+                RoadHeapPush(side.mHeap, cost, arc->mTo);
+            }
+        }
+    }
+
+    if (junctions && (best != FLT_MAX))
+    {
+        // Up from the start to the meeting junction, then down to the end
+        FrameArenaScope scratch;
+        FrameArray<uint32_t> up;
+        for (uint32_t node = meet; node != ends[0]; node = mSides[0].mParents[node])
+        {
+            up.Append(node);
+        }
+        junctions->Append(ends[0]);
+        uint32_t previous = ends[0];
+        for (size_t i = up.GetSize(); i-- > 0;)
+        {
+            Unpack(*hierarchy, previous, up[i], mSides[0].mParentMiddles[up[i]], *junctions);
+            previous = up[i];
+        }
+        for (uint32_t node = meet; node != ends[1]; node = mSides[1].mParents[node])
+        {
+            Unpack(*hierarchy, node, mSides[1].mParents[node], mSides[1].mParentMiddles[node], *junctions);
+        }
+        for (uint32_t& junction : *junctions)
+        {
+            junction = hierarchy->mOrder[junction];
+        }
+    }
+
+    for (Side& side : mSides)
+    {
+        for (uint32_t node : side.mTouched)
+        {
+            side.mCosts[node] = FLT_MAX;
+        }
+        side.mTouched.Clear();
+        side.mHeap.Clear();
+    }
+    return best;
+}
+
+void RoadQuery::Unpack(const RoadHierarchy& hierarchy, uint32_t from, uint32_t to, uint32_t middle, Array<uint32_t>& junctions) const
+{
+    // A shortcut stands for the two arcs up from the junction it was made around
+    if (middle == kRoadNoMiddle)
+    {
+        junctions.Append(to);
+        return;
+    }
+    Unpack(hierarchy, from, middle, hierarchy.GetMiddle(middle, from), junctions);
+    Unpack(hierarchy, middle, to, hierarchy.GetMiddle(middle, to), junctions);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+#include <Core/Containers/UniquePtr.h>
+
+class RoadContraction;
+class RoadHierarchy;
+
+// Roads as edges between junction tiles, for long distance routing without searching the
+// whole map. Routes are found over a contraction hierarchy, so a query only visits a
+// few hundred junctions however far apart its ends are.
+//
+// Building or destroying roads doesn't touch the hierarchy in use. Update re-contracts on
+// a background thread and swaps the result in once it's done, so queries carry on against
+// the previous roads until then. Re-contraction keeps the previous junction order and only
+// redoes the witness searches of junctions near a change; every so often the order is
+// rebuilt from scratch to keep the hierarchy shallow.
+class RoadNetwork
+{
+public:
+    RoadNetwork();
+    ~RoadNetwork();
+
+    // Adds a junction at the tile if there isn't one already
+    uint32_t AddJunction(uint32_t x, uint32_t y);
+    uint32_t FindJunction(uint32_t x, uint32_t y) const;
+
+    // Builds the road, or changes its cost if it already exists. Costs must be positive.
+    void BuildRoad(uint32_t a, uint32_t b, float cost);
+    void DestroyRoad(uint32_t a, uint32_t b);
+
+    // Call once per frame
+    void Update();
+
+    // Wait for any pending re-contraction and swap it in
+    void Flush();
+
+    bool IsContracting() const { return mContraction.Get() != nullptr; }
+    bool HasChanges() const { return !mChangedJunctions.IsEmpty(); }
+
+    uint32_t GetNumJunctions() const { return (uint32_t)mJunctions.GetSize(); }
+    uint32_t GetJunctionX(uint32_t junction) const { return mJunctions[junction].mX; }
+    uint32_t GetJunctionY(uint32_t junction) const { return mJunctions[junction].mY; }
+
+    // Stats for the hierarchy in use
+    uint32_t GetNumShortcuts() const;
+    uint32_t GetNumRecontracted() const;  // Junctions whose witness searches were redone
+    float GetContractionMS() const;
+
+    static const uint32_t kInvalidJunction = 0xFFFFFFFF;
+
+private:
+    friend class RoadQuery;
+
+    struct Road
+    {
+        uint32_t mTo;
+        float mCost;
+    };
+
+    struct Junction
+    {
+        uint32_t mX = 0;
+        uint32_t mY = 0;
+        bool mChanged = false;
+        Array<Road> mRoads;
+    };
+
+    void MarkChanged(uint32_t junction);
+    void GrowTable();
+    void StartContraction();
+    void FinishContraction();
+
+    Array<Junction> mJunctions;
+    Array<uint32_t> mJunctionTable;     // Open addressed by tile
+    Array<uint32_t> mChangedJunctions;  // Since the last contraction started
+    uint32_t mChangesSinceOrdered = 0;
+
+    UniquePtr<RoadHierarchy, DeleteDeletor> mHierarchy;
+    UniquePtr<RoadContraction, DeleteDeletor> mContraction;
+};
+
+// Finds routes over a network's current hierarchy. Keeps its search state between queries,
+// so use one per thread. Safe to run alongside other queries while the network isn't updating.
+class RoadQuery
+{
+public:
+    // Returns the route's cost, FLT_MAX when there is no route. Junctions added since the
+    // hierarchy was built have no route yet. The junctions along the route, including
+    // both ends, are written to junctions when given.
+    float Find(const RoadNetwork& network, uint32_t from, uint32_t to, Array<uint32_t>* junctions = nullptr);
+
+    // Junctions visited by the last Find
+    uint32_t GetNumVisited() const { return mNumVisited; }
+
+private:
+    struct HeapItem
+    {
+        float mCost;
+        uint32_t mNode;
+    };
+
+    // Search upwards from one end of the route
+    struct Side
+    {
+        Array<float> mCosts;
+        Array<uint32_t> mParents;
+        Array<uint32_t> mParentMiddles;
+        Array<uint32_t> mTouched;
+        Array<HeapItem> mHeap;
+    };
+
+    void Unpack(const RoadHierarchy& hierarchy, uint32_t from, uint32_t to, uint32_t middle, Array<uint32_t>& junctions) const;
+
+    Side mSides[2];
+    uint32_t mNumVisited = 0;
+};
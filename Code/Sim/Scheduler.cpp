@@ -0,0 +1,122 @@
+#include "Scheduler.h"
+
+#include <Core/Mem/FrameArena.h>
+#include <Core/Profile/Profile.h>
+#include <Core/Time/Timer.h>
+
+namespace
+{
+    uint32_t SchedulerTicksToUs(int64_t ticks)
+    {
+        return (uint32_t)((ticks * 1000000) / Timer::GetFrequency());
+    }
+
+    class SchedulerOrder
+    {
+    public:
+        // Stale systems first, then by priority
+        template <class T>
+        bool operator () (const T& a, const T& b) const
+        {
+            if (a->mStats.mStale != b->mStats.mStale)
+            {
+                return a->mStats.mStale;
+            }
+            return a->mPriority > b->mPriority;
+        }
+    };
+}
+
+void Scheduler::Register(TimeSlicedSystem* system, uint32_t priority, uint32_t budgetUs, uint32_t maxStalenessFrames)
+{
+    Entry& entry = mEntries.EmplaceBack();
+    entry.mSystem = system;
+    entry.mPriority = priority;
+    entry.mMaxStalenessFrames = maxStalenessFrames;
+    entry.mStats.mName = system->GetName();
+    entry.mStats.mBudgetUs = budgetUs;
+}
+
+void Scheduler::Unregister(TimeSlicedSystem* system)
+{
+    for (Entry& entry : mEntries)
+    {
+        if (entry.mSystem == system)
+        {
+            mEntries.Erase(&entry);
+            return;
+        }
+    }
+}
+
+void Scheduler::Update(uint32_t frameBudgetUs)
+{
+    FrameArenaScope scratch;
+    FrameArray<Entry*> order(mEntries.GetSize());
+    for (Entry& entry : mEntries)
+    {
+        Stats& stats = entry.mStats;
+        stats.mUsedUs = 0;
+        stats.mStepsRun = 0;
+        stats.mFramesSincePass++;
+        stats.mStale = (entry.mMaxStalenessFrames != 0) && (stats.mFramesSincePass > entry.mMaxStalenessFrames);
+        order.Append(&entry);
+    }
+    order.Sort(SchedulerOrder());
+
+    uint32_t usedUs = 0;
+    for (Entry* entry : order)
+    {
+        const Stats& stats = entry->mStats;
+        if (stats.mStale)
+        {
+            usedUs += Run(*entry, stats.mBudgetUs);
+            continue;
+        }
+        if (usedUs >= frameBudgetUs)
+        {
+            break;
+        }
+        // Others only get what's left of the frame
+        usedUs += Run(*entry, Math::Min(stats.mBudgetUs, frameBudgetUs - usedUs));
+    }
+    mLastFrameUsedUs = usedUs;
+}
+
+uint32_t Scheduler::Run(Entry& entry, uint32_t budgetUs)
+{
+    Stats& stats = entry.mStats;
+    if (!entry.mInPass)
+    {
+        if (!entry.mSystem->HasWork())
+        {
+            stats.mFramesSincePass = 0; // Nothing to do is as good as up to date
+            return 0;
+        }
+        entry.mInPass = true;
+        entry.mCursor = 0;
+    }
+
+    PROFILE_SECTION(stats.mName);
+
+    const int64_t start = Timer::GetNow();
+    uint32_t usedUs = 0;
+    do
+    {
+        stats.mStepsRun++;
+        const bool more = entry.mSystem->Step(entry.mCursor);
+        usedUs = SchedulerTicksToUs(Timer::GetNow() - start);
+        if (!more)
+        {
+            entry.mInPass = false;
+            stats.mFramesSincePass = 0;
+            stats.mPassesCompleted++;
+            break;
+        }
+    }
+    while (usedUs < budgetUs);
+
+    stats.mUsedUs = usedUs;
+    stats.mPeakUsedUs = Math::Max(stats.mPeakUsedUs, usedUs);
+    return usedUs;
+}
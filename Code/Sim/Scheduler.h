@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Expensive but non-urgent work that can be spread over several frames
+class TimeSlicedSystem
+{
+public:
+    virtual ~TimeSlicedSystem() = default;
+
+    // Must be valid for the lifetime of the application, it is used as the profile section id
+    virtual const char* GetName() const = 0;
+
+    // Whether a new pass should be started, a pass in progress always continues
+    virtual bool HasWork() const { return true; }
+
+    // Do one small unit of work starting at cursor (for example the next chunk index)
+    // and advance it. Returns false once the pass is complete.
+    virtual bool Step(uint32_t& cursor) = 0;
+};
+
+// Gives each registered system a microsecond budget per frame. Systems run in priority
+// order, each within the lesser of its budget and what's left of the frame budget,
+// except that a system which hasn't completed a pass within its maximum staleness goes
+// first and always gets its own budget.
+class Scheduler
+{
+public:
+    struct Stats
+    {
+        const char* mName = nullptr;
+        uint32_t mBudgetUs = 0;
+        uint32_t mUsedUs = 0;           // Last frame
+        uint32_t mPeakUsedUs = 0;
+        uint32_t mStepsRun = 0;         // Last frame
+        uint32_t mFramesSincePass = 0;  // Frames since the last completed pass
+        uint32_t mPassesCompleted = 0;
+        bool mStale = false;
+    };
+
+    // Higher priority systems run first. maxStalenessFrames of zero means never stale.
+    void Register(TimeSlicedSystem* system, uint32_t priority, uint32_t budgetUs, uint32_t maxStalenessFrames);
+    void Unregister(TimeSlicedSystem* system);
+
+    // Call once per frame
+    void Update(uint32_t frameBudgetUs);
+
+    uint32_t GetLastFrameUsedUs() const { return mLastFrameUsedUs; }
+    size_t GetNumSystems() const { return mEntries.GetSize(); }
+    const Stats& GetStats(size_t index) const { return mEntries[index].mStats; }
+
+private:
+    struct Entry
+    {
+        TimeSlicedSystem* mSystem = nullptr;
+        uint32_t mPriority = 0;
+        uint32_t mMaxStalenessFrames = 0;
+        uint32_t mCursor = 0;
+        bool mInPass = false;
+        Stats mStats;
+    };
+
+    uint32_t Run(Entry& entry, uint32_t budgetUs);
+
+    Array<Entry> mEntries;
+    uint32_t mLastFrameUsedUs = 0;
+};
@@ -0,0 +1,172 @@
+#include "SettlementSim.h"
+
+#include <Sim/World.h>
+
+#include <float.h>
+#include <math.h>
+
+namespace
+{
+    const float kFoodPerPersonPerTick = 0.01f;
+    const float kGrowthPerTick = 0.0001f;
+    const float kStarvedPerFood = 50.0f; // People lost per unit of food that couldn't be eaten
+
+    void SettlementIntegrate(Settlement& settlement, uint32_t ticks)
+    {
+        const float n = (float)ticks;
+        settlement.mWood += settlement.mWoodRate * n;
+        settlement.mFood += (settlement.mFoodRate - settlement.mPopulation * kFoodPerPersonPerTick) * n;
+        if (settlement.mFood < 0.0f)
+        {
+            const float starved = -settlement.mFood * kStarvedPerFood;
+            settlement.mPopulation = Math::Max(settlement.mPopulation - starved, 0.0f);
+            settlement.mFood = 0.0f;
+        }
+        else
+        {
+            settlement.mPopulation *= (ticks == 1) ? (1.0f + kGrowthPerTick) : powf(1.0f + kGrowthPerTick, n);
+        }
+    }
+}
+
+SettlementSim::SettlementSim()
+{
+    Array<Tier> tiers;
+    tiers.Append({ 96.0f, 1, false });
+    tiers.Append({ 384.0f, 8, true });
+    tiers.Append({ FLT_MAX, 64, true });
+    SetTiers(tiers);
+}
+
+void SettlementSim::SetTiers(const Array<Tier>& tiers)
+{
+    ASSERT(!tiers.IsEmpty() && tiers.GetSize() < 256);
+    mTiers = tiers;
+    mTierCounts.SetSize(tiers.GetSize());
+    mTierDistancesSq.Clear();
+    for (const Tier& tier : tiers)
+    {
+        ASSERT(Math::IsPowerOf2(tier.mTickInterval));
+        mTierDistancesSq.Append(tier.mMaxDistance * tier.mMaxDistance);
+    }
+    mTierDistancesSq.Top() = FLT_MAX;
+}
+
+void SettlementSim::Tick(Array<Settlement>& settlements)
+{
+    if (mSettlementsChanged || (mSettlementX.GetSize() != settlements.GetSize()))
+    {
+        Rebuild(settlements);
+    }
+
+    ++mTick;
+    mUpdatedCount = 0;
+    for (uint32_t& count : mTierCounts)
+    {
+        count = 0;
+    }
+
+    const size_t numSettlements = settlements.GetSize();
+    for (size_t i = 0; i < numSettlements; ++i)
+    {
+        const float dx = mSettlementX[i] - mFocusX;
+        const float dy = mSettlementY[i] - mFocusY;
+        const float distanceSq = dx * dx + dy * dy;
+        uint8_t tierIndex = 0;
+        while (distanceSq > mTierDistancesSq[tierIndex])
+        {
+            ++tierIndex;
+        }
+        mTierCounts[tierIndex]++;
+
+        // Promoted settlements update straight away so they catch up before being
+        // seen in detail, otherwise updates are staggered across the tier's interval
+        const Tier& tier = mTiers[tierIndex];
+        const uint8_t oldTierIndex = mSettlementTier[i];
+        if (tierIndex != oldTierIndex)
+        {
+            mSettlementTier[i] = tierIndex;
+            settlements[i].mLodTier = tierIndex;
+            if (tierIndex < oldTierIndex)
+            {
+                Update(settlements[i], tier);
+                continue;
+            }
+        }
+        if (((mTick + mSettlementPhase[i]) & (tier.mTickInterval - 1)) == 0)
+        {
+            Update(settlements[i], tier);
+        }
+    }
+}
+
+void SettlementSim::Update(Settlement& settlement, const Tier& tier)
+{
+    const uint32_t elapsed = mTick - settlement.mLastTick;
+    settlement.mLastTick = mTick;
+    ++mUpdatedCount;
+    if (tier.mAggregated)
+    {
+        TickAggregated(settlement, elapsed);
+        return;
+    }
+
+    // Catch up on the ticks missed at a lower level of detail before ticking fully
+    if (elapsed > 1)
+    {
+        TickAggregated(settlement, elapsed - 1);
+    }
+    TickFull(settlement);
+}
+
+void SettlementSim::Rebuild(const Array<Settlement>& settlements)
+{
+    const size_t numSettlements = settlements.GetSize();
+    mSettlementX.SetSize(numSettlements);
+    mSettlementY.SetSize(numSettlements);
+    mSettlementPhase.SetSize(numSettlements);
+    mSettlementTier.SetSize(numSettlements);
+    for (size_t i = 0; i < numSettlements; ++i)
+    {
+        const Settlement& settlement = settlements[i];
+        mSettlementX[i] = (float)settlement.mX;
+        mSettlementY[i] = (float)settlement.mY;
+        mSettlementPhase[i] = (uint32_t)settlement.mId;
+        mSettlementTier[i] = settlement.mLodTier;
+    }
+    mSettlementsChanged = false;
+}
+
+/*static*/ void SettlementSim::TickFull(Settlement& settlement)
+{
+    RefreshRates(settlement);
+    SettlementIntegrate(settlement, 1);
+}
+
+/*static*/ void SettlementSim::TickAggregated(Settlement& settlement, uint32_t ticks)
+{
+    if (settlement.mRatesDirty)
+    {
+        RefreshRates(settlement);
+    }
+    if (ticks)
+    {
+        SettlementIntegrate(settlement, ticks);
+    }
+}
+
+/*static*/ void SettlementSim::RefreshRates(Settlement& settlement)
+{
+    // Sum the per building production the aggregated model runs on
+    float food = 0.0f;
+    float wood = 0.0f;
+    for (const Building& building : settlement.mBuildings)
+    {
+        const float workers = (float)building.mWorkers;
+        food += workers * building.mFoodPerWorker;
+        wood += workers * building.mWoodPerWorker;
+    }
+    settlement.mFoodRate = food;
+    settlement.mWoodRate = wood;
+    settlement.mRatesDirty = false;
+}
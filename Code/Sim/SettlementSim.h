@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+class Settlement;
+
+// Ticks settlement economies at a level of detail that depends on distance from the
+// focus (the player or camera). Near settlements tick every tick at full fidelity, distant
+// ones tick less often with an aggregated model. When a settlement moves to a more
+// detailed tier its missed ticks are integrated first so no time is lost.
+class SettlementSim
+{
+public:
+    struct Tier
+    {
+        float mMaxDistance;         // Settlements further than this fall into the next tier
+        uint32_t mTickInterval;     // Ticks between updates, a power of two
+        bool mAggregated;           // Use the settlement-level model instead of per building
+    };
+
+    SettlementSim();
+
+    // Tiers are ordered nearest first, the last tier takes every remaining settlement
+    void SetTiers(const Array<Tier>& tiers);
+    const Array<Tier>& GetTiers() const { return mTiers; }
+
+    void SetFocus(float x, float y) { mFocusX = x; mFocusY = y; }
+
+    // Must be called when settlements are added, removed or moved
+    void SetSettlementsChanged() { mSettlementsChanged = true; }
+
+    void Tick(Array<Settlement>& settlements);
+
+    uint32_t GetTick() const { return mTick; }
+
+    // Settlements in each tier and how many were updated, during the last Tick
+    uint32_t GetTierCount(size_t tier) const { return mTierCounts[tier]; }
+    uint32_t GetUpdatedCount() const { return mUpdatedCount; }
+
+    static void TickFull(Settlement& settlement);
+    static void TickAggregated(Settlement& settlement, uint32_t ticks);
+    static void RefreshRates(Settlement& settlement);
+
+private:
+    void Rebuild(const Array<Settlement>& settlements);
+    void Update(Settlement& settlement, const Tier& tier);
+
+    Array<Tier> mTiers;
+    Array<float> mTierDistancesSq;
+    Array<uint32_t> mTierCounts;
+    float mFocusX = 0.0f;
+    float mFocusY = 0.0f;
+    uint32_t mTick = 0;
+    uint32_t mUpdatedCount = 0;
+
+    // Compact copy of what's needed to decide which settlements are due each tick, so
+    // that settlements which aren't due are never touched
+    bool mSettlementsChanged = true;
+    Array<float> mSettlementX;
+    Array<float> mSettlementY;
+    Array<uint32_t> mSettlementPhase;
+    Array<uint8_t> mSettlementTier;
+};
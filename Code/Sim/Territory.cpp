@@ -0,0 +1,314 @@
+#include "Territory.h"
+
+#include <Mathematics/FastMarch2.h>
+
+#include <Core/Env/Assert.h>
+
+namespace
+{
+    const uint32_t kTerritoryNoSource = 0xFFFFFFFF;
+
+    // Ignore re-marching a tile for improvements smaller than this, the eikonal update
+    // is not exactly symmetric so tiny changes would otherwise ripple across the map.
+    const float kTerritoryMarchTolerance = 1e-3f;
+
+    const uint32_t kTerritoryTilesPerStep = 1024;
+}
+
+// FastMarch2 over a grid padded by one tile on each side (FastMarch2 marks its border as
+// impassable). Iterate() is replaced to carry the owning source along with the front and
+// to re-open accepted tiles that a new source reaches sooner, which is what lets the
+// same march run either over the whole map or only the region around a changed source.
+class TerritoryMarch : public gte::FastMarch2<float>
+{
+public:
+    TerritoryMarch(TerritoryMap& map, size_t xBound, size_t yBound, std::vector<float> const& speeds)
+        : gte::FastMarch2<float>(xBound, yBound, 1.0f, 1.0f, std::vector<size_t>(), speeds)
+        , mMap(map)
+        , mOwners(xBound * yBound, kTerritoryNoSource)
+    {
+    }
+
+    uint32_t GetOwner(size_t i) const { return mOwners[i]; }
+    bool IsEmpty() const { return mHeap.GetNumElements() == 0; }
+
+    void Seed(size_t i, uint32_t source)
+    {
+        ASSERT(!IsZeroSpeed(i));
+        mTimes[i] = 0.0f;
+        SetOwner(i, source);
+        Open(i);
+    }
+
+    // Forget a tile so that it can be reached again by the remaining sources
+    void Clear(size_t i)
+    {
+        mTimes[i] = std::numeric_limits<float>::max();
+        mOwners[i] = kTerritoryNoSource;
+    }
+
+    // Push an accepted tile back on to the front with its current time
+    void Open(size_t i)
+    {
+        if (IsTrial(i))
+        {
+            mHeap.Update(mTrials[i], mTimes[i]);
+        }
+        else
+        {
+            mTrials[i] = mHeap.Insert(i, mTimes[i]);
+        }
+    }
+
+    virtual void Iterate() override
+    {
+        size_t i = 0;
+        float value = 0.0f;
+        mHeap.Remove(i, value);
+        mTrials[i] = nullptr;
+
+        Relax(i - 1);
+        Relax(i + 1);
+        Relax(i - mXBound);
+        Relax(i + mXBound);
+    }
+
+private:
+    void Relax(size_t i)
+    {
+        if (IsZeroSpeed(i))
+        {
+            return;
+        }
+
+        const float time = UpwindTime(i);
+        if (time + kTerritoryMarchTolerance >= mTimes[i])
+        {
+            return;
+        }
+
+        mTimes[i] = time;
+        SetOwner(i, UpwindOwner(i));
+        Open(i);
+    }
+
+    // Same eikonal update as FastMarch2::ComputeTime(), except that when the quadratic
+    // has no solution the front arrives from the nearer neighbour. ComputeTime() takes the
+    // further one, which is harmless for a single front but lets an old, distant time win
+    // over a new nearby source.
+    float UpwindTime(size_t i) const
+    {
+        const float maxTime = std::numeric_limits<float>::max();
+        const float x = Math::Min(IsValid(i - 1) ? mTimes[i - 1] : maxTime, IsValid(i + 1) ? mTimes[i + 1] : maxTime);
+        const float y = Math::Min(IsValid(i - mXBound) ? mTimes[i - mXBound] : maxTime, IsValid(i + mXBound) ? mTimes[i + mXBound] : maxTime);
+        const float invSpeed = mInvSpeeds[i];
+        if (x == maxTime || y == maxTime)
+        {
+            const float nearest = Math::Min(x, y);
+            return (nearest == maxTime) ? maxTime : nearest + invSpeed;
+        }
+
+        const float diff = x - y;
+        const float discr = 2.0f * invSpeed * invSpeed - diff * diff;
+        if (discr < 0.0f)
+        {
+            return Math::Min(x, y) + invSpeed;
+        }
+        return 0.5f * (x + y + std::sqrt(discr));
+    }
+
+    uint32_t UpwindOwner(size_t i) const
+    {
+        const size_t neighbors[4] = { i - 1, i + 1, i - mXBound, i + mXBound };
+        uint32_t owner = kTerritoryNoSource;
+        float best = std::numeric_limits<float>::max();
+        for (size_t n : neighbors)
+        {
+            if (IsValid(n) && mTimes[n] < best && mOwners[n] != kTerritoryNoSource)
+            {
+                best = mTimes[n];
+                owner = mOwners[n];
+            }
+        }
+        return owner;
+    }
+
+    void SetOwner(size_t i, uint32_t source)
+    {
+        mOwners[i] = source;
+        if (source == kTerritoryNoSource)
+        {
+            return;
+        }
+
+        TerritoryMap::Source& s = mMap.mSources[source];
+        const uint32_t x = (uint32_t)(i % mXBound);
+        const uint32_t y = (uint32_t)(i / mXBound);
+        s.mMinX = Math::Min(s.mMinX, x);
+        s.mMinY = Math::Min(s.mMinY, y);
+        s.mMaxX = Math::Max(s.mMaxX, x);
+        s.mMaxY = Math::Max(s.mMaxY, y);
+    }
+
+    TerritoryMap& mMap;
+    std::vector<uint32_t> mOwners;
+};
+
+TerritoryMap::TerritoryMap() = default;
+TerritoryMap::~TerritoryMap() = default;
+
+void TerritoryMap::Init(uint32_t width, uint32_t height, const Array<float>& speeds)
+{
+    ASSERT(speeds.GetSize() == (size_t)width * height);
+
+    mWidth = width;
+    mHeight = height;
+    mSources.Clear();
+
+    const size_t xBound = (size_t)width + 2;
+    const size_t yBound = (size_t)height + 2;
+    std::vector<float> paddedSpeeds(xBound * yBound, 0.0f);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            paddedSpeeds[(x + 1) + xBound * (y + 1)] = speeds[x + (size_t)width * y];
+        }
+    }
+    mMarch = new TerritoryMarch(*this, xBound, yBound, paddedSpeeds);
+}
+
+void TerritoryMap::AddSource(uint64_t ownerId, uint32_t x, uint32_t y)
+{
+    ASSERT(ownerId != 0);
+    ASSERT(x < mWidth && y < mHeight);
+    ASSERT(FindSource(ownerId) == kTerritoryNoSource);
+
+    const size_t cell = mMarch->Index(x + 1, y + 1);
+    if (mMarch->IsZeroSpeed(cell))
+    {
+        return; // Can't claim anything from an impassable tile
+    }
+
+    // Reuse a free slot so the per-tile owner stays small
+    uint32_t slot = FindSource(0);
+    if (slot == kTerritoryNoSource)
+    {
+        slot = (uint32_t)mSources.GetSize();
+        mSources.EmplaceBack();
+    }
+    Source& source = mSources[slot];
+    source.mOwnerId = ownerId;
+    source.mCell = (uint32_t)cell;
+    source.mMinX = source.mMaxX = x + 1;
+    source.mMinY = source.mMaxY = y + 1;
+
+    // The new front only advances while it beats the existing times, so the march
+    // stops at the new border rather than visiting the whole map
+    mMarch->Seed(cell, slot);
+}
+
+void TerritoryMap::RemoveSource(uint64_t ownerId)
+{
+    const uint32_t slot = FindSource(ownerId);
+    if (slot == kTerritoryNoSource)
+    {
+        return;
+    }
+
+    // Release every tile the source owns. Only tiles within its bounds can be affected,
+    // every other tile's nearest source is unchanged. This is safe while a march is in
+    // progress, released tiles still on the front are re-timed when they are reached.
+    const Source& source = mSources[slot];
+    const size_t xBound = mMarch->GetXBound();
+    const uint32_t minX = source.mMinX;
+    const uint32_t minY = source.mMinY;
+    const uint32_t maxX = source.mMaxX;
+    const uint32_t maxY = source.mMaxY;
+    for (uint32_t y = minY; y <= maxY; ++y)
+    {
+        for (uint32_t x = minX; x <= maxX; ++x)
+        {
+            const size_t i = mMarch->Index(x, y);
+            if (mMarch->GetOwner(i) == slot)
+            {
+                mMarch->Clear(i);
+            }
+        }
+    }
+
+    // Re-open the neighbouring territory along the released region's edge, one tile
+    // outside the bounds covers every tile that can border it
+    const uint32_t edgeMinX = Math::Max(minX, 2u) - 1;
+    const uint32_t edgeMinY = Math::Max(minY, 2u) - 1;
+    const uint32_t edgeMaxX = Math::Min(maxX + 1, mWidth);
+    const uint32_t edgeMaxY = Math::Min(maxY + 1, mHeight);
+    for (uint32_t y = edgeMinY; y <= edgeMaxY; ++y)
+    {
+        for (uint32_t x = edgeMinX; x <= edgeMaxX; ++x)
+        {
+            const size_t i = mMarch->Index(x, y);
+            if (mMarch->IsValid(i) &&
+                (mMarch->IsFar(i - 1) || mMarch->IsFar(i + 1) || mMarch->IsFar(i - xBound) || mMarch->IsFar(i + xBound)))
+            {
+                mMarch->Open(i);
+            }
+        }
+    }
+
+    mSources[slot] = Source();
+}
+
+uint64_t TerritoryMap::GetOwner(uint32_t x, uint32_t y) const
+{
+    ASSERT(x < mWidth && y < mHeight);
+    const uint32_t slot = mMarch->GetOwner(mMarch->Index(x + 1, y + 1));
+    return (slot == kTerritoryNoSource) ? 0 : mSources[slot].mOwnerId;
+}
+
+float TerritoryMap::GetDistance(uint32_t x, uint32_t y) const
+{
+    ASSERT(x < mWidth && y < mHeight);
+    return mMarch->GetTime(mMarch->Index(x + 1, y + 1));
+}
+
+uint32_t TerritoryMap::FindSource(uint64_t ownerId) const
+{
+    for (size_t i = 0; i < mSources.GetSize(); ++i)
+    {
+        if (mSources[i].mOwnerId == ownerId)
+        {
+            return (uint32_t)i;
+        }
+    }
+    return kTerritoryNoSource;
+}
+
+bool TerritoryMap::HasWork() const
+{
+    return mMarch.Get() && !mMarch->IsEmpty();
+}
+
+bool TerritoryMap::Step(uint32_t& cursor)
+{
+    if (cursor == 0)
+    {
+        mLastMarchCount = 0;
+    }
+
+    for (uint32_t i = 0; (i < kTerritoryTilesPerStep) && !mMarch->IsEmpty(); ++i)
+    {
+        mMarch->Iterate();
+        ++mLastMarchCount;
+    }
+    ++cursor;
+    return !mMarch->IsEmpty();
+}
+
+void TerritoryMap::Flush()
+{
+    uint32_t cursor = 0;
+    while (HasWork() && Step(cursor))
+    {
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Sim/Scheduler.h>
+
+#include <Core/Containers/Array.h>
+#include <Core/Containers/UniquePtr.h>
+
+class TerritoryMarch;
+
+// Which settlement controls each tile, found by a multi-source fast march over
+// terrain-weighted travel time. Founding or destroying a settlement only re-marches
+// the tiles whose nearest settlement changes. The march runs as a time-sliced system,
+// so ownership near a changed settlement settles over a few frames.
+class TerritoryMap : public TimeSlicedSystem
+{
+public:
+    TerritoryMap();
+    virtual ~TerritoryMap() override;
+
+    // speeds has one entry per tile, zero for impassable tiles
+    void Init(uint32_t width, uint32_t height, const Array<float>& speeds);
+
+    // ownerId must be non-zero, zero is used for unowned tiles
+    void AddSource(uint64_t ownerId, uint32_t x, uint32_t y);
+    void RemoveSource(uint64_t ownerId);
+
+    // TimeSlicedSystem
+    virtual const char* GetName() const override { return "Territory"; }
+    virtual bool HasWork() const override;
+    virtual bool Step(uint32_t& cursor) override;
+
+    // Finish any pending march immediately
+    void Flush();
+
+    uint64_t GetOwner(uint32_t x, uint32_t y) const;
+    float GetDistance(uint32_t x, uint32_t y) const;
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+
+    // Number of tiles accepted by the current or last march
+    uint32_t GetLastMarchCount() const { return mLastMarchCount; }
+
+private:
+    friend class TerritoryMarch;
+
+    struct Source
+    {
+        uint64_t mOwnerId = 0;
+        uint32_t mCell = 0;
+
+        // Bounds of every cell this source has ever owned, in padded grid coordinates
+        uint32_t mMinX = 0;
+        uint32_t mMinY = 0;
+        uint32_t mMaxX = 0;
+        uint32_t mMaxY = 0;
+    };
+
+    uint32_t FindSource(uint64_t ownerId) const;
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    uint32_t mLastMarchCount = 0;
+    Array<Source> mSources;
+    UniquePtr<TerritoryMarch, DeleteDeletor> mMarch;
+};
@@ -0,0 +1,212 @@
+#include "TerritoryCells.h"
+
+#include <Mathematics/IncrementalDelaunay2.h>
+
+#include <Core/Env/Assert.h>
+
+namespace
+{
+    const uint32_t kTerritoryCellsNoSite = 0xFFFFFFFF;
+
+    // IncrementalDelaunay2 starts with three vertices of a supertriangle and the four
+    // corners of the map, sites are numbered after them
+    const uint32_t kTerritoryCellsFirstSite = 7;
+}
+
+// The triangulation's vertices are the sites, the map's corners and a supertriangle
+// around them. Before FinalizeTriangulation() the corners are ordinary vertices, so two
+// sites can be neighbours in the sites' own triangulation but separated by a corner here.
+class TerritoryTriangulation : public gte::IncrementalDelaunay2<double>
+{
+public:
+    TerritoryTriangulation(uint32_t width, uint32_t height)
+        : gte::IncrementalDelaunay2<double>(0.0, 0.0, (double)width, (double)height)
+    {
+    }
+
+    const std::unordered_set<int32_t>& GetAdjacent(uint32_t vertex) const
+    {
+        const auto& vertices = GetGraph().GetVertices();
+        const auto it = vertices.find((int32_t)vertex);
+        ASSERT(it != vertices.end());
+        return it->second->VAdjacent;
+    }
+};
+
+TerritoryCells::TerritoryCells() = default;
+TerritoryCells::~TerritoryCells() = default;
+
+void TerritoryCells::Init(uint32_t width, uint32_t height)
+{
+    mWidth = width;
+    mHeight = height;
+    mSites.Clear();
+    mCells.Clear();
+    mTriangulation = new TerritoryTriangulation(width, height);
+}
+
+void TerritoryCells::AddSite(uint64_t ownerId, uint32_t x, uint32_t y)
+{
+    ASSERT(ownerId != 0);
+    ASSERT(x < mWidth && y < mHeight);
+    ASSERT(FindSite(ownerId) == kTerritoryCellsNoSite);
+
+    // Sites are at the tile's centre, strictly inside the map
+    const uint32_t vertex = (uint32_t)mTriangulation->Insert(gte::Vector2<double>{ (double)x + 0.5, (double)y + 0.5 });
+    if (vertex >= mCells.GetSize())
+    {
+        // Cells hold their corners, so grow geometrically rather than moving them all each time
+        if (vertex >= mCells.GetCapacity())
+        {
+            mCells.SetCapacity(Math::Max(vertex + 1, (uint32_t)mCells.GetCapacity() * 2));
+        }
+        mCells.SetSize(vertex + 1);
+    }
+    Site& site = mSites.EmplaceBack();
+    site.mOwnerId = ownerId;
+    site.mVertex = vertex;
+
+    mLastRebuildCount = 0;
+    if (mCells[vertex].mNumSites++ > 0)
+    {
+        return; // Already a site on this tile
+    }
+
+    RebuildCell(vertex);
+    GetNeighbours(vertex, mNeighbours);
+    for (const uint32_t neighbour : mNeighbours)
+    {
+        RebuildCell(neighbour);
+    }
+}
+
+void TerritoryCells::RemoveSite(uint64_t ownerId)
+{
+    const uint32_t slot = FindSite(ownerId);
+    if (slot == kTerritoryCellsNoSite)
+    {
+        return;
+    }
+    const uint32_t vertex = mSites[slot].mVertex;
+    mSites.EraseIndex(slot);
+
+    mLastRebuildCount = 0;
+    Cell& cell = mCells[vertex];
+    if (--cell.mNumSites > 0)
+    {
+        return;
+    }
+    cell.mPoints.Destruct();
+
+    // Neighbours gain the removed cell's area between them
+    GetNeighbours(vertex, mNeighbours);
+    const gte::Vector2<double> position = mTriangulation->GetVertices()[vertex];
+    mTriangulation->Remove(position);
+    for (const uint32_t neighbour : mNeighbours)
+    {
+        RebuildCell(neighbour);
+    }
+}
+
+const Array<TerritoryCells::Point>& TerritoryCells::GetCell(uint64_t ownerId) const
+{
+    const uint32_t slot = FindSite(ownerId);
+    ASSERT(slot != kTerritoryCellsNoSite);
+    return mCells[mSites[slot].mVertex].mPoints;
+}
+
+uint32_t TerritoryCells::FindSite(uint64_t ownerId) const
+{
+    for (size_t i = 0; i < mSites.GetSize(); ++i)
+    {
+        if (mSites[i].mOwnerId == ownerId)
+        {
+            return (uint32_t)i;
+        }
+    }
+    return kTerritoryCellsNoSite;
+}
+
+// Sites adjacent to the vertex, or reached through the map corners and supertriangle.
+// Without those extra vertices the sites reached through them could be adjacent to it,
+// so their bisectors may bound its cell too.
+void TerritoryCells::GetNeighbours(uint32_t vertex, Array<uint32_t>& neighbours) const
+{
+    neighbours.Clear();
+    uint32_t visited = 0;
+    uint32_t pending[kTerritoryCellsFirstSite];
+    uint32_t numPending = 0;
+    uint32_t current = vertex;
+    for (;;)
+    {
+        for (const int32_t adjacent : mTriangulation->GetAdjacent(current))
+        {
+            const uint32_t other = (uint32_t)adjacent;
+            if (other < kTerritoryCellsFirstSite)
+            {
+                if ((visited & (1u << other)) == 0)
+                {
+                    visited |= 1u << other;
+                    pending[numPending++] = other;
+                }
+            }
+            else if ((other != vertex) && (neighbours.Find(other) == nullptr))
+            {
+                neighbours.Append(other);
+            }
+        }
+        if (numPending == 0)
+        {
+            break;
+        }
+        current = pending[--numPending];
+    }
+}
+
+// Sutherland-Hodgman clip of the map by the half-plane closer to the site than to each
+// neighbour. The cell is convex throughout, so each clip is linear in its points.
+void TerritoryCells::RebuildCell(uint32_t vertex)
+{
+    ++mLastRebuildCount;
+    const auto& positions = mTriangulation->GetVertices();
+    const double sx = positions[vertex][0];
+    const double sy = positions[vertex][1];
+
+    // Clipped in scratch arrays, then copied to the cell
+    Array<Point>& points = mCellPoints;
+    points.SetSize(4);
+    points[0] = { 0.0f, 0.0f };
+    points[1] = { (float)mWidth, 0.0f };
+    points[2] = { (float)mWidth, (float)mHeight };
+    points[3] = { 0.0f, (float)mHeight };
+
+    GetNeighbours(vertex, mSearch);
+    for (const uint32_t neighbour : mSearch)
+    {
+        // Points p with (p - midpoint) . (neighbour - site) <= 0 are kept
+        const double dx = positions[neighbour][0] - sx;
+        const double dy = positions[neighbour][1] - sy;
+        const double offset = dx * (sx + dx * 0.5) + dy * (sy + dy * 0.5);
+
+        mClipped.Clear();
+        const size_t numPoints = points.GetSize();
+        for (size_t i = 0; i < numPoints; ++i)
+        {
+            const Point& a = points[i];
+            const Point& b = points[(i + 1) % numPoints];
+            const double da = dx * a.mX + dy * a.mY - offset;
+            const double db = dx * b.mX + dy * b.mY - offset;
+            if (da <= 0.0)
+            {
+                mClipped.Append(a);
+            }
+            if ((da < 0.0) != (db < 0.0) && (da != 0.0) && (db != 0.0))
+            {
+                const double t = da / (da - db);
+                mClipped.Append({ (float)(a.mX + (b.mX - a.mX) * t), (float)(a.mY + (b.mY - a.mY) * t) });
+            }
+        }
+        points.Swap(mClipped);
+    }
+    mCells[vertex].mPoints = points;
+}
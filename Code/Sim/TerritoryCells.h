@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+#include <Core/Containers/UniquePtr.h>
+
+class TerritoryTriangulation;
+
+// Polygons of the area closer to each settlement than to any other, clipped to the map,
+// for drawing borders and placing labels without scanning tiles. The Delaunay
+// triangulation of the sites is kept up to date as they're added and removed, and a
+// site's cell is the map clipped by the bisectors with its Delaunay neighbours, so a
+// change only rebuilds the cells of the changed site's neighbours.
+//
+// Sites on the same tile share a cell.
+class TerritoryCells
+{
+public:
+    struct Point
+    {
+        float mX;
+        float mY;
+    };
+
+    TerritoryCells();
+    ~TerritoryCells();
+
+    void Init(uint32_t width, uint32_t height);
+
+    // ownerId must be non-zero and not already added
+    void AddSite(uint64_t ownerId, uint32_t x, uint32_t y);
+    void RemoveSite(uint64_t ownerId);
+
+    // Counterclockwise, in tile units with tile (x, y) covering [x, x + 1) x [y, y + 1)
+    const Array<Point>& GetCell(uint64_t ownerId) const;
+
+    uint32_t GetNumSites() const { return (uint32_t)mSites.GetSize(); }
+
+    // Cells rebuilt by the last AddSite or RemoveSite
+    uint32_t GetLastRebuildCount() const { return mLastRebuildCount; }
+
+private:
+    struct Site
+    {
+        uint64_t mOwnerId = 0;
+        uint32_t mVertex = 0;
+    };
+
+    // Indexed by triangulation vertex
+    struct Cell
+    {
+        InlineArray<Point, 8> mPoints;  // Most cells have fewer corners, so need no allocation
+        uint32_t mNumSites = 0;
+    };
+
+    uint32_t FindSite(uint64_t ownerId) const;
+    void GetNeighbours(uint32_t vertex, Array<uint32_t>& neighbours) const;
+    void RebuildCell(uint32_t vertex);
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    Array<Site> mSites;
+    Array<Cell> mCells;
+    uint32_t mLastRebuildCount = 0;
+    UniquePtr<TerritoryTriangulation, DeleteDeletor> mTriangulation;
+
+    Array<uint32_t> mNeighbours;
+    Array<uint32_t> mSearch;
+    Array<Point> mCellPoints;
+    Array<Point> mClipped;
+};
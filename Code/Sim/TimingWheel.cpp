@@ -0,0 +1,160 @@
+#include "TimingWheel.h"
+
+namespace
+{
+    const uint32_t kTimingWheelNone = 0xFFFFFFFF;
+}
+
+TimingWheel::TimingWheel()
+    : mFreeTimer(kTimingWheelNone)
+{
+}
+
+void TimingWheel::SetHandler(uint16_t type, TimerHandler* handler)
+{
+    while (mHandlers.GetSize() <= type)
+    {
+        mHandlers.Append(nullptr);
+    }
+    mHandlers[type] = handler;
+    mBatches.SetSize(mHandlers.GetSize());
+}
+
+TimingWheel::Handle TimingWheel::Schedule(uint16_t type, uint32_t delayTicks, uint64_t payload)
+{
+    ASSERT((type < mHandlers.GetSize()) && mHandlers[type]);
+
+    uint32_t index = mFreeTimer;
+    if (index != kTimingWheelNone)
+    {
+        mFreeTimer = mTimers[index].mPosition;
+    }
+    else
+    {
+        index = (uint32_t)mTimers.GetSize();
+        Timer& timer = mTimers.EmplaceBack();
+        timer.mGeneration = 1;
+    }
+
+    Entry entry;
+    entry.mDue = mTick + Math::Max(delayTicks, 1u);
+    entry.mPayload = payload;
+    entry.mTimer = index;
+    entry.mType = type;
+    Insert(entry);
+    ++mNumPending;
+
+    return ((uint64_t)mTimers[index].mGeneration << 32) | index;
+}
+
+bool TimingWheel::Cancel(Handle handle)
+{
+    if (!IsPending(handle))
+    {
+        return false;
+    }
+
+    // Swap the last entry of the slot into the cancelled one's place
+    const uint32_t index = (uint32_t)handle;
+    const Timer& timer = mTimers[index];
+    Array<Entry>& slot = mSlots[timer.mSlot];
+    const Entry& last = slot.Top();
+    mTimers[last.mTimer].mPosition = timer.mPosition;
+    slot[timer.mPosition] = last;
+    slot.Pop();
+
+    Release(index);
+    --mNumPending;
+    return true;
+}
+
+bool TimingWheel::IsPending(Handle handle) const
+{
+    const uint32_t index = (uint32_t)handle;
+    return (index < mTimers.GetSize()) && (mTimers[index].mGeneration == (uint32_t)(handle >> 32));
+}
+
+void TimingWheel::Advance()
+{
+    ++mTick;
+
+    // Coarser levels first, so a timer can cascade all the way down in one tick
+    for (uint32_t level = kLevels - 1; level > 0; --level)
+    {
+        const uint64_t mask = ((uint64_t)1 << (level * kSlotBits)) - 1;
+        if ((mTick & mask) == 0)
+        {
+            Cascade(level);
+        }
+    }
+
+    // Everything in the current finest slot is due now
+    Array<Entry>& slot = mSlots[mTick & (kSlotsPerLevel - 1)];
+    for (const Entry& entry : slot)
+    {
+        Array<uint64_t>& batch = mBatches[entry.mType];
+        if (batch.IsEmpty())
+        {
+            mDueTypes.Append(entry.mType);
+        }
+        batch.Append(entry.mPayload);
+        Release(entry.mTimer);
+    }
+    mNumPending -= slot.GetSize();
+    slot.Clear();
+
+    for (uint16_t type : mDueTypes)
+    {
+        mHandlers[type]->OnTimers(mTick, mBatches[type]);
+        mBatches[type].Clear();
+    }
+    mDueTypes.Clear();
+}
+
+void TimingWheel::Reserve(size_t numTimers)
+{
+    mTimers.SetCapacity(numTimers);
+}
+
+void TimingWheel::Insert(const Entry& entry)
+{
+    // The level is chosen by how far away the timer is, the slot by its due tick, so
+    // it's reached exactly when the level's slot cascades or fires
+    const uint64_t delta = entry.mDue - mTick;
+    ASSERT(delta >> (kLevels * kSlotBits) == 0);
+    uint32_t level = 0;
+    while ((delta >> ((level + 1) * kSlotBits)) != 0)
+    {
+        ++level;
+    }
+    const uint32_t slotIndex = level * kSlotsPerLevel + (uint32_t)((entry.mDue >> (level * kSlotBits)) & (kSlotsPerLevel - 1));
+
+    Array<Entry>& slot = mSlots[slotIndex];
+    Timer& timer = mTimers[entry.mTimer];
+    timer.mSlot = slotIndex;
+    timer.mPosition = (uint32_t)slot.GetSize();
+    slot.Append(entry);
+}
+
+void TimingWheel::Cascade(uint32_t level)
+{
+    // Everything here is due within the span of one slot of this level, so it always
+    // lands in a finer level
+    Array<Entry>& slot = mSlots[level * kSlotsPerLevel + (uint32_t)((mTick >> (level * kSlotBits)) & (kSlotsPerLevel - 1))];
+    for (const Entry& entry : slot)
+    {
+        Insert(entry);
+    }
+    slot.Clear();
+}
+
+void TimingWheel::Release(uint32_t index)
+{
+    Timer& timer = mTimers[index];
+    if (++timer.mGeneration == 0)
+    {
+        timer.mGeneration = 1;
+    }
+    timer.mPosition = mFreeTimer;
+    mFreeTimer = index;
+}
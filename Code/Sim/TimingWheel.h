@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Receives every timer of one type that fires in a tick as a single batch
+class TimerHandler
+{
+public:
+    virtual ~TimerHandler() = default;
+
+    virtual void OnTimers(uint64_t tick, const Array<uint64_t>& payloads) = 0;
+};
+
+// Hierarchical timing wheel for "fire at tick T" world events such as building
+// completion or harvests. Schedule and Cancel are O(1), and Advance only touches the
+// timers that are due or are cascading down to a finer level.
+class TimingWheel
+{
+public:
+    // Identifies a pending timer, stale handles are safely rejected. 0 is never valid.
+    using Handle = uint64_t;
+
+    TimingWheel();
+
+    // Types are small integers chosen by the caller, each with one handler
+    void SetHandler(uint16_t type, TimerHandler* handler);
+
+    // Fires at GetTick() + delayTicks, a delay of 0 fires on the next Advance
+    Handle Schedule(uint16_t type, uint32_t delayTicks, uint64_t payload);
+    bool Cancel(Handle handle);
+    bool IsPending(Handle handle) const;
+
+    // Move to the next tick and deliver everything due in it, batched per type.
+    // Handlers may schedule and cancel timers.
+    void Advance();
+
+    uint64_t GetTick() const { return mTick; }
+    size_t GetNumPending() const { return mNumPending; }
+    void Reserve(size_t numTimers);
+
+private:
+    static const uint32_t kLevels = 4;
+    static const uint32_t kSlotBits = 8;
+    static const uint32_t kSlotsPerLevel = 1 << kSlotBits;
+
+    // Slots hold their timers by value so delivering and cascading walk memory in order
+    struct Entry
+    {
+        uint64_t mDue;
+        uint64_t mPayload;
+        uint32_t mTimer;
+        uint16_t mType;
+    };
+
+    // Where a timer's entry currently lives, or the next free timer when unused
+    struct Timer
+    {
+        uint32_t mGeneration;
+        uint32_t mSlot;
+        uint32_t mPosition;
+    };
+
+    void Insert(const Entry& entry);
+    void Cascade(uint32_t level);
+    void Release(uint32_t timer);
+
+    uint64_t mTick = 0;
+    size_t mNumPending = 0;
+
+    Array<Entry> mSlots[kLevels * kSlotsPerLevel];
+    Array<Timer> mTimers;
+    uint32_t mFreeTimer;
+
+    Array<TimerHandler*> mHandlers;
+    Array<Array<uint64_t>> mBatches;
+    Array<uint16_t> mDueTypes;
+};
@@ -0,0 +1,638 @@
+#include "TradeNetwork.h"
+
+#include <Sim/ParallelFor.h>
+
+#include <Core/Mem/FrameArena.h>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    const uint32_t kTradeMinCapacity = 64;
+
+    // Cached costs are sums of floats, so comparisons against them allow some rounding
+    const float kTradeTolerance = 1e-4f;
+
+    // Per node state while re-running a source
+    const uint8_t kTradeCandidate = 1;  // May have lost its route
+    const uint8_t kTradeLost = 2;       // Did lose its route
+    const uint8_t kTradeChanged = 4;
+
+    struct TradeHeapItem
+    {
+        float mCost;
+        uint32_t mNode;
+    };
+
+    void TradeHeapPush(Array<TradeHeapItem>& heap, float cost, uint32_t node)
+    {
+        size_t i = heap.GetSize();
+        heap.Append({ cost, node });
+        while (i > 0)
+        {
+            const size_t parent = (i - 1) / 2;
+            if (heap[parent].mCost <= cost)
+            {
+                break;
+            }
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = { cost, node };
+    }
+
+    TradeHeapItem TradeHeapPop(Array<TradeHeapItem>& heap)
+    {
+        const TradeHeapItem top = heap[0];
+        const TradeHeapItem last = heap.Top();
+        heap.Pop();
+        const size_t size = heap.GetSize();
+        if (size)
+        {
+            size_t i = 0;
+            for (;;)
+            {
+                size_t child = i * 2 + 1;
+                if (child >= size)
+                {
+                    break;
+                }
+                if ((child + 1 < size) && (heap[child + 1].mCost < heap[child].mCost))
+                {
+                    ++child;
+                }
+                if (last.mCost <= heap[child].mCost)
+                {
+                    break;
+                }
+                heap[i] = heap[child];
+                i = child;
+            }
+            heap[i] = last;
+        }
+        return top;
+    }
+}
+
+TradeNetwork::TradeNetwork()
+{
+    Grow(kTradeMinCapacity);
+}
+
+uint32_t TradeNetwork::AddNode(uint64_t settlementId)
+{
+    uint32_t node;
+    if (!mFreeNodes.IsEmpty())
+    {
+        node = mFreeNodes.Top();
+        mFreeNodes.Pop();
+    }
+    else
+    {
+        node = (uint32_t)mNodes.GetSize();
+        if (node == mCapacity)
+        {
+            Grow(mCapacity + mCapacity / 2);
+        }
+        mNodes.EmplaceBack();
+    }
+
+    Node& n = mNodes[node];
+    n.mSettlementId = settlementId;
+    n.mUsed = true;
+    n.mFresh = true;
+    MarkDirty(node);
+    return node;
+}
+
+void TradeNetwork::RemoveNode(uint32_t node)
+{
+    // Routes to the node itself go with it, so only sources that went through it to
+    // reach its neighbours need re-running
+    Node& n = mNodes[node];
+    ASSERT(n.mUsed);
+    for (const Edge& edge : n.mEdges)
+    {
+        if (!n.mFresh && !mNodes[edge.mTo].mFresh)
+        {
+            MarkUsers(node, edge.mTo, edge.mCost);
+        }
+        RecordChange(node, edge.mTo, edge.mCost, FLT_MAX);
+        Array<Edge>& reverseEdges = mNodes[edge.mTo].mEdges;
+        for (Edge& reverse : reverseEdges)
+        {
+            if (reverse.mTo == node)
+            {
+                reverseEdges.Erase(&reverse);
+                break;
+            }
+        }
+    }
+    n.mEdges.Clear();
+    n.mUsed = false;
+    n.mFresh = false;
+    n.mSettlementId = 0;
+    mRemovedNodes.Append(node);
+}
+
+uint32_t TradeNetwork::FindNode(uint64_t settlementId) const
+{
+    for (uint32_t node = 0; node < mNodes.GetSize(); ++node)
+    {
+        if (mNodes[node].mUsed && (mNodes[node].mSettlementId == settlementId))
+        {
+            return node;
+        }
+    }
+    return kInvalidNode;
+}
+
+void TradeNetwork::Reserve(uint32_t numNodes)
+{
+    if (numNodes > mCapacity)
+    {
+        Grow(numNodes);
+    }
+    mNodes.SetCapacity(numNodes);
+}
+
+void TradeNetwork::SetEdge(uint32_t a, uint32_t b, float cost)
+{
+    ASSERT((a != b) && mNodes[a].mUsed && mNodes[b].mUsed && (cost > 0.0f));
+
+    // Fresh nodes are checked for shortcuts in Update, once all their edges are known
+    const bool freshA = mNodes[a].mFresh;
+    const bool freshB = mNodes[b].mFresh;
+
+    for (Edge& edge : mNodes[a].mEdges)
+    {
+        if (edge.mTo == b)
+        {
+            const float oldCost = edge.mCost;
+            if (!freshA && !freshB)
+            {
+                if (cost < oldCost)
+                {
+                    MarkShortcuts(a, b, cost);
+                }
+                else if (cost > oldCost)
+                {
+                    MarkUsers(a, b, oldCost);
+                    MarkUsers(b, a, oldCost);
+                }
+            }
+            RecordChange(a, b, oldCost, cost);
+            edge.mCost = cost;
+            for (Edge& reverse : mNodes[b].mEdges)
+            {
+                if (reverse.mTo == a)
+                {
+                    reverse.mCost = cost;
+                }
+            }
+            return;
+        }
+    }
+
+    if (!freshA && !freshB)
+    {
+        MarkShortcuts(a, b, cost);
+    }
+    RecordChange(a, b, FLT_MAX, cost);
+    mNodes[a].mEdges.Append({ b, cost });
+    mNodes[b].mEdges.Append({ a, cost });
+}
+
+void TradeNetwork::RemoveEdge(uint32_t a, uint32_t b)
+{
+    Array<Edge>& edgesA = mNodes[a].mEdges;
+    for (Edge& edge : edgesA)
+    {
+        if (edge.mTo == b)
+        {
+            if (!mNodes[a].mFresh && !mNodes[b].mFresh)
+            {
+                MarkUsers(a, b, edge.mCost);
+                MarkUsers(b, a, edge.mCost);
+            }
+            RecordChange(a, b, edge.mCost, FLT_MAX);
+            edgesA.Erase(&edge);
+            break;
+        }
+    }
+    Array<Edge>& edgesB = mNodes[b].mEdges;
+    for (Edge& edge : edgesB)
+    {
+        if (edge.mTo == a)
+        {
+            edgesB.Erase(&edge);
+            break;
+        }
+    }
+}
+
+uint32_t TradeNetwork::Update()
+{
+    const uint32_t numNodes = (uint32_t)mNodes.GetSize();
+
+    // Flatten the edges for the searches
+    mEdgeStart.SetSize(numNodes + 1);
+    mEdgeTo.Clear();
+    mEdgeCost.Clear();
+    for (uint32_t node = 0; node < numNodes; ++node)
+    {
+        mEdgeStart[node] = (uint32_t)mEdgeTo.GetSize();
+        for (const Edge& edge : mNodes[node].mEdges)
+        {
+            mEdgeTo.Append(edge.mTo);
+            mEdgeCost.Append(edge.mCost);
+        }
+    }
+    mEdgeStart[numNodes] = (uint32_t)mEdgeTo.GetSize();
+
+    // Fresh nodes have nothing cached to re-run from, so they get full runs. These come
+    // first so each fresh node's shortcuts are checked against its final costs, even
+    // when its neighbours are fresh too.
+    Array<uint32_t> fullRuns;
+    for (uint32_t node : mDirty)
+    {
+        if (mNodes[node].mUsed && mNodes[node].mFresh)
+        {
+            fullRuns.Append(node);
+        }
+    }
+    Array<Array<float>> fullCosts;
+    fullCosts.SetSize(fullRuns.GetSize());
+    ParallelFor(fullRuns.GetSize(), 1, [this, &fullRuns, &fullCosts](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            RunAll(fullRuns[i], fullCosts[i]);
+        }
+    });
+    for (size_t i = 0; i < fullRuns.GetSize(); ++i)
+    {
+        MarkFreshShortcuts(fullRuns[i], fullCosts[i]);
+    }
+
+    // Re-runs start from the cached costs, so nothing is written until they have all
+    // finished
+    Array<Rerun> reruns;
+    for (uint32_t node : mDirty)
+    {
+        if (mNodes[node].mUsed && !mNodes[node].mFresh)
+        {
+            reruns.EmplaceBack();
+            reruns.Top().mSource = node;
+        }
+    }
+    ParallelFor(reruns.GetSize(), 1, [this, &reruns](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            RunChanges(reruns[i]);
+        }
+    });
+    for (const Rerun& rerun : reruns)
+    {
+        for (size_t i = 0; i < rerun.mNodes.GetSize(); ++i)
+        {
+            WriteCost(rerun.mSource, rerun.mNodes[i], rerun.mCosts[i]);
+        }
+    }
+    for (size_t i = 0; i < fullRuns.GetSize(); ++i)
+    {
+        for (uint32_t node = 0; node < numNodes; ++node)
+        {
+            WriteCost(fullRuns[i], node, fullCosts[i][node]);
+        }
+    }
+
+    // Removed nodes can be reused now their old costs aren't needed
+    for (uint32_t node : mRemovedNodes)
+    {
+        for (uint32_t other = 0; other < numNodes; ++other)
+        {
+            if (other != node)
+            {
+                SetCost(node, other, FLT_MAX);
+            }
+        }
+        mFreeNodes.Append(node);
+    }
+    mRemovedNodes.Clear();
+
+    const uint32_t numRun = (uint32_t)mDirty.GetSize();
+    for (uint32_t node : mDirty)
+    {
+        mNodes[node].mDirty = false;
+        mNodes[node].mFresh = false;
+    }
+    mDirty.Clear();
+    mChanges.Clear();
+    return numRun;
+}
+
+void TradeNetwork::Grow(uint32_t capacity)
+{
+    // Rows of the triangle keep their order, so each row copies across in one go
+    Array<float> costs;
+    costs.SetSize((size_t)capacity * (capacity - 1) / 2);
+    for (float& cost : costs)
+    {
+        cost = FLT_MAX;
+    }
+    const uint32_t oldCapacity = mCapacity;
+    for (uint32_t row = 0; (row + 1) < oldCapacity; ++row)
+    {
+        const size_t oldStart = (size_t)row * (2 * (size_t)oldCapacity - row - 1) / 2;
+        const size_t newStart = (size_t)row * (2 * (size_t)capacity - row - 1) / 2;
+        memcpy(&costs[newStart], &mCosts[oldStart], (oldCapacity - row - 1) * sizeof(float));
+    }
+    mCosts = Move(costs);
+    mCapacity = capacity;
+}
+
+void TradeNetwork::MarkDirty(uint32_t node)
+{
+    if (!mNodes[node].mDirty)
+    {
+        mNodes[node].mDirty = true;
+        mDirty.Append(node);
+    }
+}
+
+void TradeNetwork::MarkShortcuts(uint32_t a, uint32_t b, float cost)
+{
+    // A source only gets cheaper routes if the edge is cheaper than its current route
+    // between the edge's ends
+    for (uint32_t source = 0; source < mNodes.GetSize(); ++source)
+    {
+        const Node& node = mNodes[source];
+        if (!node.mUsed || node.mDirty)
+        {
+            continue;
+        }
+        const float costA = GetCost(source, a);
+        const float costB = GetCost(source, b);
+        if ((costA + cost < costB * (1.0f - kTradeTolerance)) || (costB + cost < costA * (1.0f - kTradeTolerance)))
+        {
+            MarkDirty(source);
+        }
+    }
+}
+
+void TradeNetwork::MarkUsers(uint32_t from, uint32_t to, float oldCost)
+{
+    // A source's routes only get dearer if it reached the far end of the edge through
+    // it, in which case the costs to the two ends differ by exactly the edge's cost
+    for (uint32_t source = 0; source < mNodes.GetSize(); ++source)
+    {
+        const Node& node = mNodes[source];
+        if (!node.mUsed || node.mDirty)
+        {
+            continue;
+        }
+        const float costFrom = GetCost(source, from);
+        const float costTo = GetCost(source, to);
+        if ((costTo != FLT_MAX) && (costFrom + oldCost <= costTo + kTradeTolerance * costTo))
+        {
+            MarkDirty(source);
+        }
+    }
+}
+
+void TradeNetwork::MarkFreshShortcuts(uint32_t fresh, const Array<float>& costs)
+{
+    // A new node only changes another source's routes if going through it is cheaper
+    // than the cached route to one of its settled neighbours. Routes through a chain of
+    // new nodes are caught at the last one, whose costs already include the chain.
+    const Array<Edge>& edges = mNodes[fresh].mEdges;
+    if (edges.GetSize() < 2)
+    {
+        return;
+    }
+    for (uint32_t source = 0; source < mNodes.GetSize(); ++source)
+    {
+        const Node& node = mNodes[source];
+        if (!node.mUsed || node.mDirty || (costs[source] == FLT_MAX))
+        {
+            continue;
+        }
+        for (const Edge& edge : edges)
+        {
+            if (mNodes[edge.mTo].mFresh)
+            {
+                continue;
+            }
+            if (costs[source] + edge.mCost < GetCost(source, edge.mTo) * (1.0f - kTradeTolerance))
+            {
+                MarkDirty(source);
+                break;
+            }
+        }
+    }
+}
+
+void TradeNetwork::RecordChange(uint32_t a, uint32_t b, float oldCost, float newCost)
+{
+    // Keep the cost from before the first change, as that's what the cache holds
+    if (a > b)
+    {
+        const uint32_t temp = a;
+        a = b;
+        b = temp;
+    }
+    for (Change& change : mChanges)
+    {
+        if ((change.mA == a) && (change.mB == b))
+        {
+            change.mNewCost = newCost;
+            return;
+        }
+    }
+    mChanges.Append({ a, b, oldCost, newCost });
+}
+
+void TradeNetwork::WriteCost(uint32_t source, uint32_t node, float cost)
+{
+    // When both ends of a pair are being re-run the lower numbered source writes it, so
+    // every pair is written by exactly one source
+    if ((node == source) || !mNodes[node].mUsed || (mNodes[node].mDirty && (node < source)))
+    {
+        return;
+    }
+    SetCost(source, node, cost);
+}
+
+void TradeNetwork::RunAll(uint32_t source, Array<float>& costs) const
+{
+    FrameArenaScope scratch;
+    const uint32_t numNodes = (uint32_t)mNodes.GetSize();
+    costs.SetSize(numNodes);
+    for (float& cost : costs)
+    {
+        cost = FLT_MAX;
+    }
+    FrameArray<TradeHeapItem> heap(numNodes);
+
+    costs[source] = 0.0f;
+    TradeHeapPush(heap, 0.0f, source);
+    while (!heap.IsEmpty())
+    {
+        const TradeHeapItem item = TradeHeapPop(heap);
+        if (item.mCost > costs[item.mNode])
+        {
+            continue;
+        }
+        for (uint32_t edge = mEdgeStart[item.mNode]; edge < mEdgeStart[item.mNode + 1]; ++edge)
+        {
+            const uint32_t to = mEdgeTo[edge];
+            const float cost = item.mCost + mEdgeCost[edge];
+            if (cost < costs[to])
+            {
+                costs[to] = cost;
+                TradeHeapPush(heap, cost, to);
+            }
+        }
+    }
+}
+
+void TradeNetwork::RunChanges(Rerun& rerun) const
+{
+    const uint32_t source = rerun.mSource;
+    Array<uint32_t>& changed = rerun.mNodes;
+
+    // Start from the cached costs, which are for the graph before the changes
+    FrameArenaScope scratch;
+    const uint32_t numNodes = (uint32_t)mNodes.GetSize();
+    FrameArray<float> costs(numNodes);
+    costs.SetSize(numNodes);
+    for (uint32_t node = 0; node < numNodes; ++node)
+    {
+        costs[node] = GetCost(source, node);
+    }
+    FrameArray<uint8_t> states(numNodes);
+    states.SetSize(numNodes);
+    memset(states.Begin(), 0, numNodes);
+    FrameArray<TradeHeapItem> heap;
+
+    // Nodes reached through an edge that got dearer or went away may have lost their route
+    auto addCandidate = [&](uint32_t from, uint32_t to, float oldCost)
+    {
+        if ((states[to] & kTradeCandidate) || !mNodes[to].mUsed || (to == source) || (costs[from] == FLT_MAX) || (costs[to] == FLT_MAX))
+        {
+            return;
+        }
+        if (costs[from] + oldCost <= costs[to] + kTradeTolerance * costs[to])
+        {
+            states[to] |= kTradeCandidate;
+            TradeHeapPush(heap, costs[to], to);
+        }
+    };
+    for (const Change& change : mChanges)
+    {
+        if (change.mNewCost > change.mOldCost)
+        {
+            addCandidate(change.mA, change.mB, change.mOldCost);
+            addCandidate(change.mB, change.mA, change.mOldCost);
+        }
+    }
+
+    // In order of old cost, a candidate keeps its route if a neighbour that kept its own
+    // still reaches it as cheaply, otherwise its dependents become candidates too
+    FrameArray<uint32_t> lost;
+    while (!heap.IsEmpty())
+    {
+        const uint32_t node = TradeHeapPop(heap).mNode;
+        const float cost = costs[node];
+        bool supported = false;
+        for (uint32_t edge = mEdgeStart[node]; edge < mEdgeStart[node + 1]; ++edge)
+        {
+            const uint32_t from = mEdgeTo[edge];
+            if (!(states[from] & kTradeLost) && (costs[from] != FLT_MAX) && (costs[from] + mEdgeCost[edge] <= cost + kTradeTolerance * cost))
+            {
+                supported = true;
+                break;
+            }
+        }
+        if (supported)
+        {
+            continue;
+        }
+        states[node] |= kTradeLost;
+        lost.Append(node);
+        for (uint32_t edge = mEdgeStart[node]; edge < mEdgeStart[node + 1]; ++edge)
+        {
+            addCandidate(node, mEdgeTo[edge], mEdgeCost[edge]);
+        }
+    }
+
+    // Lost nodes restart from their best neighbour that kept its route
+    for (uint32_t node : lost)
+    {
+        costs[node] = FLT_MAX;
+        states[node] |= kTradeChanged;
+        changed.Append(node);
+    }
+    for (uint32_t node : lost)
+    {
+        float best = FLT_MAX;
+        for (uint32_t edge = mEdgeStart[node]; edge < mEdgeStart[node + 1]; ++edge)
+        {
+            const uint32_t from = mEdgeTo[edge];
+            if (costs[from] != FLT_MAX)
+            {
+                best = Math::Min(best, costs[from] + mEdgeCost[edge]);
+            }
+        }
+        if (best != FLT_MAX)
+        {
+            costs[node] = best;
+            TradeHeapPush(heap, best, node);
+        }
+    }
+
+    // Cheaper and new edges, then spread every improvement
+    auto relax = [&](uint32_t from, uint32_t to, float cost)
+    {
+        if (mNodes[to].mUsed && (costs[from] != FLT_MAX) && (costs[from] + cost < costs[to]))
+        {
+            costs[to] = costs[from] + cost;
+            TradeHeapPush(heap, costs[to], to);
+            if (!(states[to] & kTradeChanged))
+            {
+                states[to] |= kTradeChanged;
+                changed.Append(to);
+            }
+        }
+    };
+    for (const Change& change : mChanges)
+    {
+        if (change.mNewCost < change.mOldCost)
+        {
+            relax(change.mA, change.mB, change.mNewCost);
+            relax(change.mB, change.mA, change.mNewCost);
+        }
+    }
+    while (!heap.IsEmpty())
+    {
+        const TradeHeapItem item = TradeHeapPop(heap);
+        if (item.mCost > costs[item.mNode])
+        {
+            continue;
+        }
+        for (uint32_t edge = mEdgeStart[item.mNode]; edge < mEdgeStart[item.mNode + 1]; ++edge)
+        {
+            relax(item.mNode, mEdgeTo[edge], mEdgeCost[edge]);
+        }
+    }
+
+    rerun.mCosts.SetCapacity(changed.GetSize());
+    for (uint32_t node : changed)
+    {
+        rerun.mCosts.Append(costs[node]);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Core/Containers/Array.h>
+
+// Trade routes between settlements with the cheapest route cost between every pair
+// cached. Costs are symmetric, so only the upper triangle of the matrix is stored.
+//
+// Changes are applied to the graph immediately but costs are only brought up to date by
+// Update. Each change is checked against the cached costs to find which sources it can
+// affect: a cheaper edge only affects sources it gives a shortcut to, and a dearer one
+// only those whose cheapest routes use it. Just those sources are re-run, in parallel,
+// and each re-run only revisits the settlements whose cost from the source changed.
+class TradeNetwork
+{
+public:
+    TradeNetwork();
+
+    uint32_t AddNode(uint64_t settlementId);
+    void RemoveNode(uint32_t node);
+    uint32_t FindNode(uint64_t settlementId) const;
+    void Reserve(uint32_t numNodes);
+
+    // Adds the edge, or changes its cost if it already exists. Costs must be positive.
+    void SetEdge(uint32_t a, uint32_t b, float cost);
+    void RemoveEdge(uint32_t a, uint32_t b);
+
+    // Returns the number of sources that were re-run
+    uint32_t Update();
+
+    // FLT_MAX when unreachable. Safe to call from any thread while not updating.
+    float GetCost(uint32_t a, uint32_t b) const
+    {
+        if (a == b)
+        {
+            return 0.0f;
+        }
+        return (a < b) ? mCosts[GetIndex(a, b)] : mCosts[GetIndex(b, a)];
+    }
+
+    uint32_t GetNumNodes() const { return (uint32_t)mNodes.GetSize(); }
+    bool IsNodeUsed(uint32_t node) const { return mNodes[node].mUsed; }
+    uint64_t GetSettlementId(uint32_t node) const { return mNodes[node].mSettlementId; }
+    size_t GetMemoryUsed() const { return mCosts.GetSize() * sizeof(float); }
+
+    static const uint32_t kInvalidNode = 0xFFFFFFFF;
+
+private:
+    struct Edge
+    {
+        uint32_t mTo;
+        float mCost;
+    };
+
+    // An edge changed since the last Update, FLT_MAX costs for edges that didn't exist
+    struct Change
+    {
+        uint32_t mA;
+        uint32_t mB;
+        float mOldCost;
+        float mNewCost;
+    };
+
+    // What a re-run found, for the settlements whose cost from the source changed
+    struct Rerun
+    {
+        uint32_t mSource;
+        Array<uint32_t> mNodes;
+        Array<float> mCosts;
+    };
+
+    struct Node
+    {
+        uint64_t mSettlementId = 0;
+        bool mUsed = false;
+        bool mFresh = false;    // Added since the last Update, so it has no cached costs yet
+        bool mDirty = false;
+        Array<Edge> mEdges;
+    };
+
+    size_t GetIndex(uint32_t a, uint32_t b) const
+    {
+        return (size_t)a * (2 * (size_t)mCapacity - a - 1) / 2 + (b - a - 1);
+    }
+    void SetCost(uint32_t a, uint32_t b, float cost) { mCosts[(a < b) ? GetIndex(a, b) : GetIndex(b, a)] = cost; }
+
+    void Grow(uint32_t capacity);
+    void MarkDirty(uint32_t node);
+    void MarkShortcuts(uint32_t a, uint32_t b, float cost);
+    void MarkUsers(uint32_t from, uint32_t to, float oldCost);
+    void MarkFreshShortcuts(uint32_t fresh, const Array<float>& costs);
+    void RecordChange(uint32_t a, uint32_t b, float oldCost, float newCost);
+    void WriteCost(uint32_t source, uint32_t node, float cost);
+    void RunAll(uint32_t source, Array<float>& costs) const;
+    void RunChanges(Rerun& rerun) const;
+
+    Array<Node> mNodes;
+    Array<uint32_t> mEdgeStart;
+    Array<uint32_t> mEdgeTo;
+    Array<float> mEdgeCost;
+    Array<uint32_t> mFreeNodes;
+    Array<uint32_t> mRemovedNodes;  // Freed once Update no longer needs their old costs
+    Array<uint32_t> mDirty;
+    Array<Change> mChanges;
+
+    uint32_t mCapacity = 0;
+    Array<float> mCosts;
+};
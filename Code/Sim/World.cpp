@@ -1,3 +1,331 @@
 #include "World.h"
 
+#include <Sim/Erosion.h>
+#include <Sim/Hydrology.h>
 
+#include <Core/Mem/MemStats.h>
+#include <Core/Tracing/Tracing.h>
+
+#include <math.h>
+
+namespace
+{
+    // Time given to low priority systems each frame
+    const uint32_t kSchedulerFrameBudgetUs = 2000;
+    const uint32_t kTerritoryBudgetUs = 1000;
+    const uint32_t kTerritoryMaxStalenessFrames = 30;
+
+    const float kSettlementFoundingPopulation = 10.0f;
+
+    // After a long frame the simulation falls behind rather than spending ever longer
+    // catching up
+    const uint32_t kMaxTicksPerUpdate = 4;
+
+    // Travel along a road is this much faster than across the land under it
+    const float kRoadSpeedup = 4.0f;
+
+    // Terrain is octaves of value noise, from hills this many tiles apart down to bumps
+    // between neighbouring tiles
+    const uint32_t kTerrainLargestSpacing = 128;
+    const float kTerrainRelief = 64.0f;
+    const uint32_t kTerrainSeed = 1;
+
+    // Tiles with this many tiles draining through them are rivers, reaching full size at
+    // kRiverFullFlowFactor times that
+    const uint32_t kRiverMinFlow = 256;
+    const float kRiverFullFlowFactor = 64.0f;
+    // Silt left by rivers deepens the soil along them
+    const float kRiverSoil = 0.5f;
+
+    // Memory is counted by the system that allocated it, to tell which of them is growing
+    const uint8_t kLandMemory = MemStats::GetCategory("Land");
+    const uint8_t kAgentMemory = MemStats::GetCategory("Agents");
+    const uint8_t kSettlementMemory = MemStats::GetCategory("Settlements");
+    const uint8_t kTerritoryMemory = MemStats::GetCategory("Territory");
+    const uint8_t kPathfindingMemory = MemStats::GetCategory("Pathfinding");
+    const uint8_t kFootprintMemory = MemStats::GetCategory("Footprints");
+
+    // Value noise with random heights in [0, 1) at lattice points spacing tiles apart
+    float WorldValueNoise(uint32_t x, uint32_t y, uint32_t spacing, uint32_t seed)
+    {
+        float corners[4];
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const uint32_t lx = x / spacing + (i & 1);
+            const uint32_t ly = y / spacing + (i >> 1);
+            uint32_t h = (lx * 0x8da6b343u) ^ (ly * 0xd8163841u) ^ (seed * 0xcb1ab31fu);
+            h ^= h >> 15;
+            h *= 0x2c1b3c6du;
+            h ^= h >> 12;
+            corners[i] = (float)(h & 0xFFFF) / 65536.0f;
+        }
+        const float fx = (float)(x % spacing) / (float)spacing;
+        const float fy = (float)(y % spacing) / (float)spacing;
+        const float top = corners[0] + (corners[1] - corners[0]) * fx;
+        const float bottom = corners[2] + (corners[3] - corners[2]) * fx;
+        return top + (bottom - top) * fy;
+    }
+}
+
+float Land::GetMoveSpeed() const
+{
+    // Rivers are forded and lakes waded or gone around
+    const float water = Math::Min(mWater, 1.0f) + mRiver;
+    return 1.0f / (1.0f + 2.0f * mForested + 2.0f * water);
+}
+
+World::World(uint32_t width, uint32_t height, uint32_t erosionIterations)
+    : mWidth(width)
+    , mHeight(height)
+{
+    Array<float> speeds;
+    {
+        const MemCategoryScope scope(kLandMemory);
+        mLand.SetSize((size_t)width * height);
+        GenerateTerrain(erosionIterations);
+
+        speeds.SetCapacity(mLand.GetSize());
+        for (const Land& land : mLand)
+        {
+            speeds.Append(land.GetMoveSpeed());
+        }
+    }
+    {
+        const MemCategoryScope scope(kTerritoryMemory);
+        mTerritory.Init(width, height, speeds);
+        mTerritoryCells.Init(width, height);
+    }
+    {
+        const MemCategoryScope scope(kPathfindingMemory);
+        mRegions.Init(width, height, speeds);
+        mNavMesh.Init(width, height, speeds);
+    }
+    {
+        const MemCategoryScope scope(kFootprintMemory);
+        mFootprints.Init(width, height);
+    }
+
+    mScheduler.Register(&mTerritory, 1, kTerritoryBudgetUs, kTerritoryMaxStalenessFrames);
+}
+
+World::~World()
+{
+    mScheduler.Unregister(&mTerritory);
+}
+
+void World::GenerateTerrain(uint32_t erosionIterations)
+{
+    LargePageArray<float> heights;
+    heights.SetSize(mLand.GetSize());
+    for (uint32_t y = 0; y < mHeight; ++y)
+    {
+        for (uint32_t x = 0; x < mWidth; ++x)
+        {
+            float height = 0.0f;
+            float amplitude = 0.5f * kTerrainRelief;
+            for (uint32_t spacing = kTerrainLargestSpacing; spacing >= 2; spacing /= 2)
+            {
+                height += WorldValueNoise(x, y, spacing, kTerrainSeed + spacing) * amplitude;
+                amplitude *= 0.5f;
+            }
+            heights[x + (size_t)mWidth * y] = height;
+            GetLand(x, y).mElevation = height;
+        }
+    }
+
+    Erosion erosion;
+    erosion.Run(mWidth, mHeight, heights, erosionIterations);
+    if (erosionIterations > 0)
+    {
+        OUTPUT("Erosion: %u iterations over %ux%u tiles, %.2f ms per iteration%s\n", erosionIterations, mWidth, mHeight,
+               (double)erosion.GetMeanIterationMS(), erosion.IsUsingSimd() ? " (AVX2)" : "");
+    }
+
+    // Soil is deeper where sediment settled and thinner where it was washed away
+    for (size_t i = 0; i < mLand.GetSize(); ++i)
+    {
+        Land& land = mLand[i];
+        land.mSoil = Math::Clamp(0.5f + (heights[i] - land.mElevation), 0.0f, 1.0f);
+        land.mElevation = heights[i];
+    }
+
+    GenerateWater(heights);
+}
+
+void World::GenerateWater(const Array<float>& heights)
+{
+    // Hydrology works on whole numbers, so heights are spread over the range of a uint16
+    float lowest = heights[0];
+    float highest = heights[0];
+    for (float height : heights)
+    {
+        lowest = Math::Min(lowest, height);
+        highest = Math::Max(highest, height);
+    }
+    const float scale = (highest > lowest) ? (65535.0f / (highest - lowest)) : 0.0f;
+    Array<uint16_t> levels;
+    levels.SetSize(heights.GetSize());
+    for (size_t i = 0; i < heights.GetSize(); ++i)
+    {
+        levels[i] = (uint16_t)((heights[i] - lowest) * scale + 0.5f);
+    }
+
+    Hydrology hydrology;
+    hydrology.Run(mWidth, mHeight, levels);
+
+    const float riverScale = 1.0f / log2f(kRiverFullFlowFactor);
+    uint32_t lakeTiles = 0;
+    uint32_t riverTiles = 0;
+    for (uint32_t y = 0; y < mHeight; ++y)
+    {
+        for (uint32_t x = 0; x < mWidth; ++x)
+        {
+            const size_t i = x + (size_t)mWidth * y;
+            Land& land = mLand[i];
+            const uint16_t filled = hydrology.GetFilled(x, y);
+            const uint32_t flow = hydrology.GetFlow(x, y);
+            if (filled > levels[i])
+            {
+                land.mWater = (float)(filled - levels[i]) / scale;
+                ++lakeTiles;
+            }
+            else if (flow >= kRiverMinFlow)
+            {
+                land.mRiver = Math::Min(log2f((float)flow / (float)kRiverMinFlow) * riverScale, 1.0f);
+                land.mSoil = Math::Min(land.mSoil + kRiverSoil * land.mRiver, 1.0f);
+                ++riverTiles;
+            }
+            land.mBasin = hydrology.GetBasin(x, y);
+        }
+    }
+    OUTPUT("Hydrology: %u lake tiles, %u river tiles, %.2f ms\n", lakeTiles, riverTiles,
+           (double)(hydrology.GetFillMS() + hydrology.GetDirectionMS() + hydrology.GetFlowMS()));
+}
+
+void World::Update(float seconds)
+{
+    mUntickedSeconds += seconds;
+    uint32_t ticks = (uint32_t)(mUntickedSeconds / kTickSeconds);
+    if (ticks > kMaxTicksPerUpdate)
+    {
+        ticks = kMaxTicksPerUpdate;
+        mUntickedSeconds = 0.0f;
+    }
+    else
+    {
+        mUntickedSeconds -= (float)ticks * kTickSeconds;
+    }
+    for (uint32_t i = 0; i < ticks; ++i)
+    {
+        Tick();
+    }
+
+    {
+        const MemCategoryScope scope(kPathfindingMemory);
+        mRoads.Update();
+    }
+    {
+        const MemCategoryScope scope(kTerritoryMemory);
+        mNearestSettlements.Update();
+    }
+    {
+        const MemCategoryScope scope(kFootprintMemory);
+        mFootprints.Update();
+    }
+
+    // Only territory is scheduled so far
+    const MemCategoryScope scope(kTerritoryMemory);
+    mScheduler.Update(kSchedulerFrameBudgetUs);
+}
+
+void World::Tick()
+{
+    mEvents.Advance();
+    {
+        const MemCategoryScope scope(kAgentMemory);
+        mAgents.Tick(kTickSeconds);
+    }
+    const MemCategoryScope scope(kSettlementMemory);
+    mSettlementSim.Tick(mSettlements);
+}
+
+Settlement& World::FoundSettlement(const AString& name, uint32_t x, uint32_t y)
+{
+    const MemCategoryScope scope(kSettlementMemory);
+    Settlement& settlement = mSettlements.EmplaceBack();
+    settlement.mId = mNextSettlementId++;
+    settlement.mName = name;
+    settlement.mX = x;
+    settlement.mY = y;
+    settlement.mPopulation = kSettlementFoundingPopulation;
+    settlement.mLastTick = mSettlementSim.GetTick();
+    mSettlementSim.SetSettlementsChanged();
+
+    {
+        const MemCategoryScope territoryScope(kTerritoryMemory);
+        mTerritory.AddSource(settlement.mId, x, y);
+        mTerritoryCells.AddSite(settlement.mId, x, y);
+        mNearestSettlements.AddSite(settlement.mId, (float)x + 0.5f, (float)y + 0.5f);
+    }
+    return settlement;
+}
+
+void World::DestroySettlement(uint64_t id)
+{
+    Settlement* settlement = FindSettlement(id);
+    if (settlement)
+    {
+        mTerritory.RemoveSource(id);
+        mTerritoryCells.RemoveSite(id);
+        mNearestSettlements.RemoveSite(id);
+        mSettlements.Erase(settlement);
+        mSettlementSim.SetSettlementsChanged();
+    }
+}
+
+Settlement* World::FindSettlement(uint64_t id)
+{
+    for (Settlement& settlement : mSettlements)
+    {
+        if (settlement.mId == id)
+        {
+            return &settlement;
+        }
+    }
+    return nullptr;
+}
+
+void World::BuildRoad(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    if ((x0 == x1) && (y0 == y1))
+    {
+        return;
+    }
+
+    // Time to walk the straight line between the junctions, sampled once per tile
+    const float dx = (float)x1 - (float)x0;
+    const float dy = (float)y1 - (float)y0;
+    const float length = sqrtf(dx * dx + dy * dy);
+    const uint32_t numSamples = Math::Max(1u, (uint32_t)length);
+    float time = 0.0f;
+    for (uint32_t i = 0; i < numSamples; ++i)
+    {
+        const float t = ((float)i + 0.5f) / (float)numSamples;
+        const uint32_t x = (uint32_t)((float)x0 + dx * t + 0.5f);
+        const uint32_t y = (uint32_t)((float)y0 + dy * t + 0.5f);
+        time += 1.0f / GetLand(x, y).GetMoveSpeed();
+    }
+    const float cost = Math::Max(time * length / ((float)numSamples * kRoadSpeedup), 1e-3f);
+    const MemCategoryScope scope(kPathfindingMemory);
+    mRoads.BuildRoad(mRoads.AddJunction(x0, y0), mRoads.AddJunction(x1, y1), cost);
+}
+
+void World::DestroyRoad(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    const uint32_t a = mRoads.FindJunction(x0, y0);
+    const uint32_t b = mRoads.FindJunction(x1, y1);
+    if ((a != RoadNetwork::kInvalidJunction) && (b != RoadNetwork::kInvalidJunction))
+    {
+        mRoads.DestroyRoad(a, b);
+    }
+}
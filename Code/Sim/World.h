@@ -1,5 +1,17 @@
 #pragma once
 
+#include <Sim/Agents.h>
+#include <Sim/Footprints.h>
+#include <Sim/NavMesh.h>
+#include <Sim/NearestSites.h>
+#include <Sim/Regions.h>
+#include <Sim/RoadNetwork.h>
+#include <Sim/Scheduler.h>
+#include <Sim/SettlementSim.h>
+#include <Sim/Territory.h>
+#include <Sim/TerritoryCells.h>
+#include <Sim/TimingWheel.h>
+
 #include <Core/Containers/Array.h>
 #include <Core/Strings/AString.h>
 
@@ -11,25 +23,56 @@ class BuildingType
 
 class Building
 {
-
+public:
+    uint32_t mWorkers = 0;
+    float mFoodPerWorker = 0;
+    float mWoodPerWorker = 0;
 };
 
 class Settlement
 {
+public:
     uint64_t mId;
     AString mName;
+    uint32_t mX = 0;
+    uint32_t mY = 0;
+
+    float mPopulation = 0;
+    float mFood = 0;
+    float mWood = 0;
 
+    // Per tick production summed over buildings, set mRatesDirty when buildings change
+    float mFoodRate = 0;
+    float mWoodRate = 0;
+    bool mRatesDirty = true;
+
+    // Owned by SettlementSim
+    uint8_t mLodTier = 0;
+    uint32_t mLastTick = 0;
 
     Array<Building> mBuildings;
 };
 
 class Land
 {
+public:
+    // Relative speed of travel across the tile, used to weight distances
+    float GetMoveSpeed() const;
+
+    // Height of the ground in units of the tile spacing
+    float mElevation = 0;
     float mForested = 0;
     float mSoil = 0;
     float mGold = 0;
     float mIron = 0;
     float mFarmed = 0;
+
+    // Depth of lake water over the ground, in units of the tile spacing
+    float mWater = 0;
+    // How much of a river runs through the tile, from 0 for none to 1 for the largest
+    float mRiver = 0;
+    // Index of the tile on the map edge the tile's water drains off from
+    uint32_t mBasin = 0;
 };
 
 
@@ -37,8 +80,84 @@ class Land
 
 class World
 {
+public:
+    // Terrain is generated and eroded for the given number of iterations
+    World(uint32_t width, uint32_t height, uint32_t erosionIterations);
+    ~World();
+
+    // Call once per frame with the seconds since the last. Ticks once for each tick interval
+    // the time adds up to, so the simulation runs at the same rate whatever the frame rate.
+    // Once warmed up it doesn't allocate from the heap, except for the footprint overlaps,
+    // whose sweep allocates set nodes as rectangles start and stop overlapping.
+    void Update(float seconds);
+
+    // Advance the simulation by one tick, kTickSeconds of game time
+    void Tick();
+    static constexpr float kTickSeconds = 1.0f / 20.0f;
+
+    // Where the player is looking, settlements near it are simulated in full detail
+    void SetFocus(float x, float y) { mSettlementSim.SetFocus(x, y); }
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+    Land& GetLand(uint32_t x, uint32_t y) { return mLand[x + (size_t)mWidth * y]; }
+    const Land& GetLand(uint32_t x, uint32_t y) const { return mLand[x + (size_t)mWidth * y]; }
+
+    Settlement& FoundSettlement(const AString& name, uint32_t x, uint32_t y);
+    void DestroySettlement(uint64_t id);
+    Settlement* FindSettlement(uint64_t id);
+    const Array<Settlement>& GetSettlements() const { return mSettlements; }
 
+    AgentStore& GetAgents() { return mAgents; }
 
+    // Roads between junction tiles, costed by the land they cross
+    void BuildRoad(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    void DestroyRoad(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    const RoadNetwork& GetRoads() const { return mRoads; }
 
+    // Events fire during Tick, delays are in ticks
+    TimingWheel& GetEvents() { return mEvents; }
+
+    // Which tiles are reachable from each other by land
+    RegionMap& GetRegions() { return mRegions; }
+
+    // Walkable area for paths on foot, building footprints are added as obstacles
+    NavMesh& GetNavMesh() { return mNavMesh; }
+
+    // Overlapping building footprints and units, updated once per frame
+    FootprintOverlaps& GetFootprints() { return mFootprints; }
+
+    const TerritoryMap& GetTerritory() const { return mTerritory; }
+
+    // Polygons of the area nearest each settlement, ignoring terrain, for drawing borders
+    const TerritoryCells& GetTerritoryCells() const { return mTerritoryCells; }
+
+    // Settlements at their tile's centre, for finding the closest ones to many agents
+    const NearestSites& GetNearestSettlements() const { return mNearestSettlements; }
+    const Scheduler& GetScheduler() const { return mScheduler; }
+    SettlementSim& GetSettlementSim() { return mSettlementSim; }
+
+private:
+    void GenerateTerrain(uint32_t erosionIterations);
+    void GenerateWater(const Array<float>& heights);
+
+    uint32_t mWidth;
+    uint32_t mHeight;
+    float mUntickedSeconds = 0.0f;
+    LargePageArray<Land> mLand;
+
+    uint64_t mNextSettlementId = 1;
     Array<Settlement> mSettlements;
-};
\ No newline at end of file
+    SettlementSim mSettlementSim;
+    TerritoryMap mTerritory;
+    TerritoryCells mTerritoryCells;
+    NearestSites mNearestSettlements;
+    TimingWheel mEvents;
+    AgentStore mAgents;
+    RoadNetwork mRoads;
+    RegionMap mRegions;
+    NavMesh mNavMesh;
+    FootprintOverlaps mFootprints;
+
+    Scheduler mScheduler;
+};
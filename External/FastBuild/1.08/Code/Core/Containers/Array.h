@@ -7,11 +7,16 @@
 #include "Core/Containers/Forward.h"
 #include "Core/Containers/Move.h"
 #include "Core/Containers/Sort.h"
+#include "Core/Containers/TypeTraits.h"
 #include "Core/Env/Assert.h"
 #include "Core/Env/Types.h"
 #include "Core/Math/Conversions.h"
+#include "Core/Mem/FrameArena.h"
+#include "Core/Mem/LargePages.h"
 #include "Core/Mem/Mem.h"
 
+#include <string.h>
+
 // Array
 //------------------------------------------------------------------------------
 template < class T >
@@ -52,10 +57,15 @@ public:
     void                        Swap( Array< T > & other );
 
     // sorting
-    void                        Sort() { ShellSort( m_Begin, m_Begin + m_Size, AscendingCompare() ); }
-    void                        SortDeref() { ShellSort( m_Begin, m_Begin + m_Size, AscendingCompareDeref() ); }
+    void                        Sort() { IntroSort( m_Begin, m_Begin + m_Size, AscendingCompare() ); }
+    void                        SortDeref() { IntroSort( m_Begin, m_Begin + m_Size, AscendingCompareDeref() ); }
+    template < class COMPARER >
+    void                        Sort( const COMPARER & comp ) { IntroSort( m_Begin, m_Begin + m_Size, comp ); }
+    template < class GET_KEY >
+    void                        SortByKey( const GET_KEY & getKey ); // stable radix sort on an integer or float key
+    void                        SortParallel() { ParallelSort( m_Begin, m_Begin + m_Size, AscendingCompare() ); }
     template < class COMPARER >
-    void                        Sort( const COMPARER & comp ) { ShellSort( m_Begin, m_Begin + m_Size, comp ); }
+    void                        SortParallel( const COMPARER & comp, uint32_t numThreads = 0 ) { ParallelSort( m_Begin, m_Begin + m_Size, comp, numThreads ); }
 
     // find
     template < class U >
@@ -94,15 +104,22 @@ public:
 
 protected:
     void Grow();
+    void                        Relocate( size_t capacity );
     [[nodiscard]] T *           Allocate( size_t numElements ) const;
     void                        Deallocate( T * ptr ) const;
+    [[nodiscard]] uint32_t      GetReallocatedFlags() const;
 
     // High bit of Capacity is set when memory should not be freed
     // (allocated on the stack for example)
+    // Next bit is set when memory comes from the FrameArena
+    // Next bit is set when memory comes from LargePages
+    // Which leaves 29 bits, so capacity is less than 2^29 elements
     enum : uint32_t
     {
         DO_NOT_FREE_MEMORY_FLAG = 0x80000000,
-        CAPACITY_MASK = 0x7FFFFFFF,
+        FRAME_MEMORY_FLAG = 0x40000000,
+        LARGE_PAGE_MEMORY_FLAG = 0x20000000,
+        CAPACITY_MASK = 0x1FFFFFFF,
     };
 
     T *         m_Begin;
@@ -191,6 +208,7 @@ Array< T >::Array( size_t initialCapacity, bool resizeable )
         #if defined( ASSERTS_ENABLED )
             m_Resizeable = true; // allow initial allocation
         #endif
+        m_CapacityAndFlags = 0; // heap memory
         m_Begin = Allocate( initialCapacity );
         m_Size = 0;
         m_CapacityAndFlags = (uint32_t)initialCapacity;
@@ -238,7 +256,7 @@ void Array< T >::Destruct()
     Deallocate( m_Begin );
     m_Begin = nullptr;
     m_Size = 0;
-    m_CapacityAndFlags = 0;
+    m_CapacityAndFlags = GetReallocatedFlags();
 }
 
 // SetCapacity
@@ -246,33 +264,41 @@ void Array< T >::Destruct()
 template < class T >
 void Array< T >::SetCapacity( size_t capacity )
 {
+    ASSERT( capacity <= CAPACITY_MASK ); // Would overflow into the flags
     if ( capacity <= GetCapacity() )
     {
         return;
     }
 
-    T * newMem = Allocate( capacity );
-
-    // transfer and items across and destroy all the originals
-    T * src = m_Begin;
-    T * endIter = src + m_Size;
-    T * dst = newMem;
-    while ( src < endIter )
+    if constexpr ( IsTriviallyRelocatable< T >::value )
     {
-        INPLACE_NEW ( dst ) T( Move( *src ) );
-        PRAGMA_DISABLE_PUSH_MSVC(26800) // Use of a moved from object here is deliberate/necessary
-        src->~T();
-        PRAGMA_DISABLE_POP_MSVC
-        src++;
-        dst++;
+        Relocate( capacity );
     }
+    else
+    {
+        T * newMem = Allocate( capacity );
 
-    // free old memory
-    Deallocate( m_Begin );
+        // transfer and items across and destroy all the originals
+        T * src = m_Begin;
+        T * endIter = src + m_Size;
+        T * dst = newMem;
+        while ( src < endIter )
+        {
+            INPLACE_NEW ( dst ) T( Move( *src ) );
+            PRAGMA_DISABLE_PUSH_MSVC(26800) // Use of a moved from object here is deliberate/necessary
+            src->~T();
+            PRAGMA_DISABLE_POP_MSVC
+            src++;
+            dst++;
+        }
 
-    // hook up to new memory
-    m_Begin = newMem;
-    m_CapacityAndFlags = (uint32_t)capacity;
+        // free old memory
+        Deallocate( m_Begin );
+
+        // hook up to new memory
+        m_Begin = newMem;
+        m_CapacityAndFlags = ( (uint32_t)capacity | GetReallocatedFlags() );
+    }
 }
 
 // SetSize
@@ -369,6 +395,22 @@ void Array< T >::Swap( Array< T > & other )
     #endif
 }
 
+// SortByKey
+//------------------------------------------------------------------------------
+template < class T >
+template < class GET_KEY >
+void Array< T >::SortByKey( const GET_KEY & getKey )
+{
+    if ( m_Size < 2 )
+    {
+        return;
+    }
+    constexpr size_t align = __alignof( T ) > sizeof( void * ) ? __alignof( T ) : sizeof( void * );
+    T * scratch = static_cast< T * >( ALLOC( sizeof( T ) * m_Size, align ) );
+    RadixSort( m_Begin, m_Begin + m_Size, scratch, getKey );
+    FREE( scratch );
+}
+
 // Find
 //------------------------------------------------------------------------------
 template < class T >
@@ -471,11 +513,7 @@ template < class T >
 template < class U >
 void Array< T >::Append( const Array< U > & other )
 {
-    U* endPos = other.End();
-    for ( U* it = other.Begin(); it != endPos; ++it )
-    {
-        Append( *it );
-    }
+    Append( other.Begin(), other.End() );
 }
 
 // Append
@@ -484,10 +522,33 @@ template < class T >
 template < class U >
 void Array< T >::Append( const U * otherBegin, const U * otherEnd )
 {
-    for ( const U* it = otherBegin; it != otherEnd; ++it )
+    // Make space for everything at once, growing as Append of each would have
+    const size_t numItems = (size_t)( otherEnd - otherBegin );
+    const size_t currentCapacity = GetCapacity();
+    if ( ( m_Size + numItems ) > currentCapacity )
     {
-        Append( *it );
+        ASSERT( m_Resizeable );
+        const size_t grownCapacity = ( currentCapacity + ( currentCapacity >> 1 ) + 1 );
+        SetCapacity( Math::Max( m_Size + numItems, grownCapacity ) );
     }
+
+    T * dst = ( m_Begin + m_Size );
+    if constexpr ( IsSame< T, U >::value && IsTriviallyCopyable< T >::value )
+    {
+        if ( numItems )
+        {
+            memcpy( (void *)dst, (const void *)otherBegin, sizeof( T ) * numItems );
+        }
+    }
+    else
+    {
+        for ( const U * it = otherBegin; it != otherEnd; ++it )
+        {
+            INPLACE_NEW ( dst ) T( *it );
+            ++dst;
+        }
+    }
+    m_Size += (uint32_t)numItems;
 }
 
 // Pop
@@ -577,7 +638,7 @@ Array< T > & Array< T >::operator = ( const Array< T > & other )
     {
         Deallocate( m_Begin );
         m_Begin = Allocate( otherSize );
-        m_CapacityAndFlags = (uint32_t)otherSize;
+        m_CapacityAndFlags = ( (uint32_t)otherSize | GetReallocatedFlags() );
     }
 
     m_Size = (uint32_t)otherSize;
@@ -615,7 +676,7 @@ Array< T > & Array< T >::operator = ( Array< T > && other )
         {
             Deallocate( m_Begin );
             m_Begin = Allocate( otherSize );
-            m_CapacityAndFlags = (uint32_t)otherSize;
+            m_CapacityAndFlags = ( otherSize | GetReallocatedFlags() );
         }
 
         // Move elements
@@ -663,24 +724,35 @@ void Array< T >::Grow()
 
     // grow by 1.5 times (but at least by one)
     const size_t currentCapacity = GetCapacity();
-    const size_t size = GetSize();
-    const size_t newCapacity = ( currentCapacity + ( currentCapacity >> 1 ) + 1 );
-    T * newMem = Allocate( newCapacity );
+    SetCapacity( currentCapacity + ( currentCapacity >> 1 ) + 1 );
+}
 
-    T * src = m_Begin;
-    T * dst = newMem;
-    T * endIter = m_Begin + m_Size;
-    while ( src < endIter )
+// Relocate
+//------------------------------------------------------------------------------
+// Move trivially relocatable elements to memory of the given capacity, by resizing a
+// heap allocation (in place or by remapping its pages where the system allows) or
+// with a single memcpy
+template < class T >
+void Array< T >::Relocate( size_t capacity )
+{
+    ASSERT( capacity <= CAPACITY_MASK ); // Would overflow into the flags
+    if ( m_Begin && ( ( m_CapacityAndFlags & ( DO_NOT_FREE_MEMORY_FLAG | LARGE_PAGE_MEMORY_FLAG ) ) == 0 ) )
     {
-        INPLACE_NEW ( dst ) T( Move( *src ) );
-        src->~T();
-        dst++;
-        src++;
+        ASSERT( m_Resizeable );
+        constexpr size_t align = __alignof( T ) > sizeof( void * ) ? __alignof( T ) : sizeof( void * );
+        m_Begin = static_cast< T * >( REALLOC( m_Begin, sizeof( T ) * GetCapacity(), sizeof( T ) * capacity, align ) );
     }
-    Deallocate( m_Begin );
-    m_Begin = newMem;
-    m_Size = (uint32_t)size;
-    m_CapacityAndFlags = (uint32_t)newCapacity;
+    else
+    {
+        T * newMem = Allocate( capacity );
+        if ( m_Size )
+        {
+            memcpy( (void *)newMem, (const void *)m_Begin, sizeof( T ) * m_Size );
+        }
+        Deallocate( m_Begin );
+        m_Begin = newMem;
+    }
+    m_CapacityAndFlags = ( (uint32_t)capacity | GetReallocatedFlags() );
 }
 
 // Allocate
@@ -689,7 +761,16 @@ template < class T >
 T * Array< T >::Allocate( size_t numElements ) const
 {
     ASSERT( m_Resizeable );
+    ASSERT( numElements <= CAPACITY_MASK ); // Would overflow into the flags
     constexpr size_t align = __alignof( T ) > sizeof( void * ) ? __alignof( T ) : sizeof( void * );
+    if ( m_CapacityAndFlags & FRAME_MEMORY_FLAG )
+    {
+        return static_cast< T * >( FrameArena::Alloc( sizeof( T ) * numElements, align ) );
+    }
+    if ( m_CapacityAndFlags & LARGE_PAGE_MEMORY_FLAG )
+    {
+        return static_cast< T * >( LargePages::Alloc( sizeof( T ) * numElements, align ) );
+    }
     return static_cast< T * >( ALLOC( sizeof( T ) * numElements, align ) );
 }
 
@@ -698,12 +779,36 @@ T * Array< T >::Allocate( size_t numElements ) const
 template < class T >
 void Array< T >::Deallocate( T * ptr ) const
 {
-    if ( ( m_CapacityAndFlags & DO_NOT_FREE_MEMORY_FLAG ) == 0 )
+    if ( m_CapacityAndFlags & DO_NOT_FREE_MEMORY_FLAG )
+    {
+        return;
+    }
+    if ( m_CapacityAndFlags & LARGE_PAGE_MEMORY_FLAG )
+    {
+        LargePages::Free( ptr );
+        return;
+    }
+    FREE( ptr );
+}
+
+// GetReallocatedFlags
+//------------------------------------------------------------------------------
+// Flags kept when the memory is replaced. Stack memory is replaced by heap memory,
+// but frame memory is replaced by more frame memory, and large page memory by more
+// large page memory.
+template < class T >
+uint32_t Array< T >::GetReallocatedFlags() const
+{
+    if ( m_CapacityAndFlags & FRAME_MEMORY_FLAG )
     {
-        FREE( ptr );
+        return ( FRAME_MEMORY_FLAG | DO_NOT_FREE_MEMORY_FLAG );
     }
+    return ( m_CapacityAndFlags & LARGE_PAGE_MEMORY_FLAG );
 }
 
+// Arrays hold no pointers into themselves, so arrays of arrays relocate them with memcpy
+template < class T > struct IsTriviallyRelocatable< Array< T > > { static constexpr bool value = true; };
+
 // StackArray
 //------------------------------------------------------------------------------
 template<class T, uint32_t RESERVED = 32>
@@ -747,4 +852,100 @@ private:
     PRAGMA_DISABLE_POP_MSVC // 4324
 };
 
+// InlineArray
+//------------------------------------------------------------------------------
+// An Array that keeps up to N elements in itself, and moves them to the heap if it
+// grows past that. Unlike StackArray it can be held by other objects: copies and
+// moves keep their own storage, and a moved-from InlineArray goes back to its own.
+template<class T, uint32_t N>
+class InlineArray : public Array<T>
+{
+public:
+    InlineArray() { UseInlineStorage(); }
+    InlineArray( const InlineArray & other ) : Array<T>() { UseInlineStorage(); Array<T>::operator = ( other ); }
+    InlineArray( InlineArray && other ) { UseInlineStorage(); MoveFrom( other ); }
+    explicit InlineArray( const Array<T> & other ) { UseInlineStorage(); Array<T>::operator = ( other ); }
+    InlineArray( Array<T> && other ) { UseInlineStorage(); Array<T>::operator = ( Move( other ) ); }
+
+    InlineArray &               operator = ( const Array<T> & other )       { Array<T>::operator = ( other ); return *this; }
+    InlineArray &               operator = ( const InlineArray & other )    { Array<T>::operator = ( other ); return *this; }
+    InlineArray &               operator = ( Array<T> && other )            { Array<T>::operator = ( Move( other ) ); return *this; }
+    InlineArray &               operator = ( InlineArray && other )         { MoveFrom( other ); return *this; }
+
+    // Free any heap memory, going back to the array's own storage
+    void                        Destruct() { Array<T>::Destruct(); UseInlineStorage(); }
+
+    // Whether the elements are still held in the array itself
+    [[nodiscard]] bool          IsInline() const { return ( (const void *)Array<T>::m_Begin == (const void *)&m_Storage ); }
+
+private:
+    void UseInlineStorage()
+    {
+        Array<T>::m_Begin = (T *)&m_Storage;
+        Array<T>::m_CapacityAndFlags = ( N | Array<T>::DO_NOT_FREE_MEMORY_FLAG );
+    }
+    void MoveFrom( InlineArray & other )
+    {
+        Array<T>::operator = ( Move( other ) );
+        if ( other.m_Begin == nullptr )
+        {
+            other.UseInlineStorage();
+        }
+    }
+
+    PRAGMA_DISABLE_PUSH_MSVC( 4324 ) // structure was padded due to alignment specifier
+    alignas(__alignof(T)) uint8_t m_Storage[ N * sizeof( T ) ];
+    PRAGMA_DISABLE_POP_MSVC // 4324
+};
+
+// FrameArray
+//------------------------------------------------------------------------------
+// An Array whose memory comes from the thread's FrameArena, so it must not outlive
+// the frame (or the FrameArenaScope it was made in). Growing it never frees memory,
+// and moving it into another Array copies the elements out of frame memory.
+template<class T>
+class FrameArray : public Array<T>
+{
+public:
+    explicit FrameArray( size_t initialCapacity = 0 )
+    {
+        Array<T>::m_CapacityAndFlags = ( Array<T>::FRAME_MEMORY_FLAG | Array<T>::DO_NOT_FREE_MEMORY_FLAG );
+        Array<T>::SetCapacity( initialCapacity );
+    }
+    FrameArray( const FrameArray<T> & other )
+        : Array<T>()
+    {
+        Array<T>::m_CapacityAndFlags = ( Array<T>::FRAME_MEMORY_FLAG | Array<T>::DO_NOT_FREE_MEMORY_FLAG );
+        Array<T>::operator = ( other );
+    }
+
+    void                        operator = ( const Array<T> & other )       { Array<T>::operator = ( other ); }
+    void                        operator = ( const FrameArray<T> & other )  { Array<T>::operator = ( other ); }
+};
+
+// LargePageArray
+//------------------------------------------------------------------------------
+// An Array whose memory comes from LargePages, for big arrays walked often such as
+// per tile data, so the system can back them with large pages. While it's smaller
+// than a large page its memory comes from the heap as usual.
+template<class T>
+class LargePageArray : public Array<T>
+{
+public:
+    explicit LargePageArray( size_t initialCapacity = 0 )
+    {
+        Array<T>::m_CapacityAndFlags = Array<T>::LARGE_PAGE_MEMORY_FLAG;
+        Array<T>::SetCapacity( initialCapacity );
+    }
+    LargePageArray( const LargePageArray<T> & other )
+        : Array<T>()
+    {
+        Array<T>::m_CapacityAndFlags = Array<T>::LARGE_PAGE_MEMORY_FLAG;
+        Array<T>::operator = ( other );
+    }
+
+    void                        operator = ( const Array<T> & other )           { Array<T>::operator = ( other ); }
+    void                        operator = ( const LargePageArray<T> & other )  { Array<T>::operator = ( other ); }
+};
+
 //------------------------------------------------------------------------------
@@ -0,0 +1,446 @@
+// FlatHashMap.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Move.h"
+#include "Core/Env/Assert.h"
+#include "Core/Env/Types.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Strings/AString.h"
+
+#if defined( __X64__ )
+    #include <emmintrin.h>
+#endif
+#if defined( __WINDOWS__ )
+    #include <intrin.h>
+#endif
+
+#include <string.h>
+
+// Hashing Functions
+//------------------------------------------------------------------------------
+// Keys that compare equal must hash the same, so strings hash the same whether
+// they're held as an AString or a const char *
+namespace FlatHashMapKeyHashingFunctions
+{
+    inline uint64_t Hash( const AString & key )
+    {
+        return xxHash::Calc64( key );
+    }
+    inline uint64_t Hash( const char * key )
+    {
+        return xxHash::Calc64( key, AString::StrLen( key ) );
+    }
+    inline uint64_t Hash( uint64_t key )
+    {
+        // MurmurHash3 finalizer
+        key ^= ( key >> 33 );
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= ( key >> 33 );
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= ( key >> 33 );
+        return key;
+    }
+    inline uint64_t Hash( uint32_t key )
+    {
+        return Hash( static_cast< uint64_t >( key ) );
+    }
+}
+
+// FlatHashMap
+//------------------------------------------------------------------------------
+// Open addressing in the style of SwissTable. Entries are stored inline in one
+// allocation, in groups of 16 slots with a control byte per slot holding either
+// 7 bits of the key's hash or "empty". A lookup compares all 16 control bytes of
+// a group at once and only compares keys whose bits match, moving on to the next
+// group while the current one is full.
+//
+// Erase shifts later entries back into the freed slot instead of leaving a
+// tombstone, so lookups never slow down as entries come and go. The table
+// doubles when it's 7/8 full.
+template< class KEY, class VALUE >
+class FlatHashMap
+{
+public:
+    FlatHashMap();
+    FlatHashMap( FlatHashMap< KEY, VALUE > && other ) = delete;
+    ~FlatHashMap();
+
+    void Destruct();
+    void Clear(); // Remove all entries, keeping the memory
+    void Reserve( size_t count );
+
+    [[nodiscard]] bool          IsEmpty() const { return ( m_Count == 0 ); }
+    [[nodiscard]] size_t        GetSize() const { return m_Count; }
+    [[nodiscard]] size_t        GetCapacity() const { return m_Capacity; }
+    [[nodiscard]] size_t        GetMemoryUsage() const;
+
+    FlatHashMap< KEY, VALUE > & operator = ( const FlatHashMap< KEY, VALUE > & other ) = delete;
+    FlatHashMap< KEY, VALUE > & operator = ( FlatHashMap< KEY, VALUE > && other ) = delete;
+
+    class KeyValue
+    {
+    public:
+        KeyValue( const KEY & key, const VALUE & value )
+            : m_Key( key )
+            , m_Value( value )
+        {}
+
+        KeyValue & operator = ( const KeyValue & other ) = delete;
+
+        const KEY   m_Key;
+        VALUE       m_Value;
+
+    protected:
+        friend class FlatHashMap< KEY, VALUE >;
+
+        // Entries are only moved by the map, which destroys the source straight after
+        KeyValue( KeyValue && other )
+            : m_Key( Move( const_cast< KEY & >( other.m_Key ) ) )
+            , m_Value( Move( other.m_Value ) )
+        {}
+    };
+
+    // Check if an item exists in the map. The key can be any type comparable to KEY
+    // that hashes the same, such as a const char * for an AString key.
+    template < class U >
+    [[nodiscard]] KeyValue *    Find( const U & key ) const;
+
+    // Add items to the map
+    KeyValue &                  Insert( const KEY & key, const VALUE & value );
+
+    // Remove items from the map, returning false if not found
+    template < class U >
+    bool                        Erase( const U & key );
+
+protected:
+    enum : uint32_t { kGroupSize = 16 };
+    enum : uint8_t { kEmpty = 0x80 };
+
+    [[nodiscard]] static uint8_t    GetControl( uint64_t hash ) { return static_cast< uint8_t >( hash & 0x7F ); }
+    [[nodiscard]] uint32_t          GetHomeGroup( uint64_t hash ) const { return static_cast< uint32_t >( hash >> 7 ) & m_GroupMask; }
+
+    // Bit i of the result is set for each slot i in the group that matches
+    [[nodiscard]] static uint32_t   MatchControl( const uint8_t * group, uint8_t control );
+    [[nodiscard]] static uint32_t   MatchEmpty( const uint8_t * group );
+    [[nodiscard]] static uint32_t   CountTrailingZeros( uint32_t mask );
+
+    template < class U >
+    [[nodiscard]] uint32_t      FindSlot( const U & key ) const;
+    [[nodiscard]] uint32_t      FindEmptySlot( uint64_t hash ) const;
+    void                        Rehash( uint32_t numGroups );
+
+    uint8_t *   m_Control = nullptr;    // One byte per slot, followed by the slots
+    KeyValue *  m_Slots = nullptr;
+    uint32_t    m_Count = 0;
+    uint32_t    m_Capacity = 0;
+    uint32_t    m_GroupMask = 0;
+};
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+FlatHashMap< KEY, VALUE >::FlatHashMap() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+FlatHashMap< KEY, VALUE >::~FlatHashMap()
+{
+    Destruct();
+}
+
+// Destruct
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+void FlatHashMap< KEY, VALUE >::Destruct()
+{
+    if ( m_Control )
+    {
+        Clear();
+        FREE( m_Control );
+        m_Control = nullptr;
+        m_Slots = nullptr;
+        m_Capacity = 0;
+        m_GroupMask = 0;
+    }
+}
+
+// Clear
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+void FlatHashMap< KEY, VALUE >::Clear()
+{
+    for ( uint32_t i = 0; ( i < m_Capacity ) && ( m_Count > 0 ); ++i )
+    {
+        if ( m_Control[ i ] != kEmpty )
+        {
+            m_Slots[ i ].~KeyValue();
+            m_Control[ i ] = kEmpty;
+            --m_Count;
+        }
+    }
+    ASSERT( m_Count == 0 );
+}
+
+// Reserve
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+void FlatHashMap< KEY, VALUE >::Reserve( size_t count )
+{
+    uint32_t numGroups = ( m_Capacity / kGroupSize );
+    if ( numGroups == 0 )
+    {
+        numGroups = 1;
+    }
+    while ( ( static_cast< size_t >( numGroups ) * kGroupSize * 7 / 8 ) < count )
+    {
+        numGroups *= 2;
+    }
+    if ( ( numGroups * kGroupSize ) != m_Capacity )
+    {
+        Rehash( numGroups );
+    }
+}
+
+// GetMemoryUsage
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+size_t FlatHashMap< KEY, VALUE >::GetMemoryUsage() const
+{
+    return static_cast< size_t >( m_Capacity ) * ( 1 + sizeof( KeyValue ) );
+}
+
+// Find
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+template < class U >
+typename FlatHashMap< KEY, VALUE >::KeyValue * FlatHashMap< KEY, VALUE >::Find( const U & key ) const
+{
+    const uint32_t slot = FindSlot( key );
+    return ( slot < m_Capacity ) ? &m_Slots[ slot ] : nullptr;
+}
+
+// Insert
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+typename FlatHashMap< KEY, VALUE >::KeyValue & FlatHashMap< KEY, VALUE >::Insert( const KEY & key, const VALUE & value )
+{
+    // Debug check item doesn't already exist
+    ASSERT( Find( key ) == nullptr );
+
+    // Grow when the new item would make the table more than 7/8 full
+    if ( ( static_cast< uint64_t >( m_Count ) + 1 ) * 8 > static_cast< uint64_t >( m_Capacity ) * 7 )
+    {
+        Rehash( ( m_Capacity == 0 ) ? 1 : ( m_Capacity / kGroupSize ) * 2 );
+    }
+
+    const uint64_t hash = FlatHashMapKeyHashingFunctions::Hash( key );
+    const uint32_t slot = FindEmptySlot( hash );
+    m_Control[ slot ] = GetControl( hash );
+    KeyValue * keyValue = INPLACE_NEW ( &m_Slots[ slot ] ) KeyValue( key, value );
+    m_Count++;
+    return *keyValue;
+}
+
+// Erase
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+template < class U >
+bool FlatHashMap< KEY, VALUE >::Erase( const U & key )
+{
+    uint32_t hole = FindSlot( key );
+    if ( hole >= m_Capacity )
+    {
+        return false;
+    }
+    m_Slots[ hole ].~KeyValue();
+    m_Control[ hole ] = kEmpty;
+    m_Count--;
+
+    // Lookups stop at the first group with an empty slot. If the hole's group was
+    // full, entries further on may have been placed past it, so the first of those
+    // whose lookup passes through the hole's group is moved into the hole, leaving
+    // a new hole to fill in turn.
+    for ( ;; )
+    {
+        const uint32_t holeGroup = ( hole / kGroupSize );
+        if ( MatchEmpty( m_Control + holeGroup * kGroupSize ) & ~( 1u << ( hole % kGroupSize ) ) )
+        {
+            return true; // The group wasn't full
+        }
+
+        uint32_t moved = m_Capacity;
+        uint32_t group = holeGroup;
+        do
+        {
+            group = ( ( group + 1 ) & m_GroupMask );
+            const uint8_t * control = m_Control + group * kGroupSize;
+            uint32_t full = ( ~MatchEmpty( control ) & 0xFFFF );
+            while ( full )
+            {
+                const uint32_t slot = group * kGroupSize + CountTrailingZeros( full );
+                full &= ( full - 1 );
+                const uint32_t home = GetHomeGroup( FlatHashMapKeyHashingFunctions::Hash( m_Slots[ slot ].m_Key ) );
+                if ( ( ( holeGroup - home ) & m_GroupMask ) < ( ( group - home ) & m_GroupMask ) )
+                {
+                    moved = slot;
+                    break;
+                }
+            }
+
+            // Nothing beyond a group with an empty slot was placed past it
+            if ( ( moved == m_Capacity ) && MatchEmpty( control ) )
+            {
+                return true;
+            }
+        } while ( moved == m_Capacity );
+
+        INPLACE_NEW ( &m_Slots[ hole ] ) KeyValue( Move( m_Slots[ moved ] ) );
+        m_Slots[ moved ].~KeyValue();
+        m_Control[ hole ] = m_Control[ moved ];
+        m_Control[ moved ] = kEmpty;
+        hole = moved;
+    }
+}
+
+// MatchControl
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+/*static*/ uint32_t FlatHashMap< KEY, VALUE >::MatchControl( const uint8_t * group, uint8_t control )
+{
+    #if defined( __X64__ )
+        const __m128i bytes = _mm_load_si128( reinterpret_cast< const __m128i * >( group ) );
+        return static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( bytes, _mm_set1_epi8( static_cast< char >( control ) ) ) ) );
+    #else
+        uint32_t mask = 0;
+        for ( uint32_t i = 0; i < kGroupSize; ++i )
+        {
+            mask |= ( ( group[ i ] == control ) ? ( 1u << i ) : 0 );
+        }
+        return mask;
+    #endif
+}
+
+// MatchEmpty
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+/*static*/ uint32_t FlatHashMap< KEY, VALUE >::MatchEmpty( const uint8_t * group )
+{
+    #if defined( __X64__ )
+        // Only empty slots have the high bit set
+        return static_cast< uint32_t >( _mm_movemask_epi8( _mm_load_si128( reinterpret_cast< const __m128i * >( group ) ) ) );
+    #else
+        return MatchControl( group, kEmpty );
+    #endif
+}
+
+// CountTrailingZeros
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+/*static*/ uint32_t FlatHashMap< KEY, VALUE >::CountTrailingZeros( uint32_t mask )
+{
+    ASSERT( mask != 0 );
+    #if defined( __WINDOWS__ )
+        unsigned long index;
+        _BitScanForward( &index, mask );
+        return static_cast< uint32_t >( index );
+    #else
+        return static_cast< uint32_t >( __builtin_ctz( mask ) );
+    #endif
+}
+
+// FindSlot
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+template < class U >
+uint32_t FlatHashMap< KEY, VALUE >::FindSlot( const U & key ) const
+{
+    // Handle empty
+    if ( m_Count == 0 )
+    {
+        return m_Capacity;
+    }
+
+    const uint64_t hash = FlatHashMapKeyHashingFunctions::Hash( key );
+    const uint8_t control = GetControl( hash );
+    uint32_t group = GetHomeGroup( hash );
+    for ( ;; )
+    {
+        const uint8_t * groupControl = m_Control + group * kGroupSize;
+        uint32_t matches = MatchControl( groupControl, control );
+        while ( matches )
+        {
+            const uint32_t slot = group * kGroupSize + CountTrailingZeros( matches );
+            if ( m_Slots[ slot ].m_Key == key )
+            {
+                return slot;
+            }
+            matches &= ( matches - 1 );
+        }
+
+        // Not found if the key would have gone in this group
+        if ( MatchEmpty( groupControl ) )
+        {
+            return m_Capacity;
+        }
+        group = ( ( group + 1 ) & m_GroupMask );
+    }
+}
+
+// FindEmptySlot
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+uint32_t FlatHashMap< KEY, VALUE >::FindEmptySlot( uint64_t hash ) const
+{
+    uint32_t group = GetHomeGroup( hash );
+    for ( ;; )
+    {
+        const uint32_t empty = MatchEmpty( m_Control + group * kGroupSize );
+        if ( empty )
+        {
+            return group * kGroupSize + CountTrailingZeros( empty );
+        }
+        group = ( ( group + 1 ) & m_GroupMask );
+    }
+}
+
+// Rehash
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+void FlatHashMap< KEY, VALUE >::Rehash( uint32_t numGroups )
+{
+    ASSERT( ( numGroups & ( numGroups - 1 ) ) == 0 );
+    const uint32_t capacity = numGroups * kGroupSize;
+    ASSERT( ( static_cast< uint64_t >( capacity ) * 7 / 8 ) >= m_Count );
+
+    // Control bytes first, a multiple of 16 so the slots after them stay aligned
+    const size_t alignment = ( alignof( KeyValue ) > kGroupSize ) ? alignof( KeyValue ) : static_cast< size_t >( kGroupSize );
+    const size_t controlSize = ( ( capacity + alignment - 1 ) / alignment ) * alignment;
+    uint8_t * oldControl = m_Control;
+    KeyValue * oldSlots = m_Slots;
+    const uint32_t oldCapacity = m_Capacity;
+
+    m_Control = static_cast< uint8_t * >( ALLOC( controlSize + capacity * sizeof( KeyValue ), alignment ) );
+    m_Slots = reinterpret_cast< KeyValue * >( m_Control + controlSize );
+    m_Capacity = capacity;
+    m_GroupMask = ( numGroups - 1 );
+    memset( m_Control, kEmpty, capacity );
+
+    for ( uint32_t i = 0; i < oldCapacity; ++i )
+    {
+        if ( oldControl[ i ] != kEmpty )
+        {
+            const uint32_t slot = FindEmptySlot( FlatHashMapKeyHashingFunctions::Hash( oldSlots[ i ].m_Key ) );
+            m_Control[ slot ] = oldControl[ i ];
+            INPLACE_NEW ( &m_Slots[ slot ] ) KeyValue( Move( oldSlots[ i ] ) );
+            oldSlots[ i ].~KeyValue();
+        }
+    }
+    FREE( oldControl );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,142 @@
+// IntrusiveMPSCQueue.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+#include "Core/Process/Atomic.h"
+
+// IntrusiveMPSCQueueNode
+//------------------------------------------------------------------------------
+// Base for objects that are put in an IntrusiveMPSCQueue. An object can only be in one
+// queue at a time.
+class IntrusiveMPSCQueueNode
+{
+public:
+    IntrusiveMPSCQueueNode() : m_Next( nullptr ) {}
+
+private:
+    template < class T > friend class IntrusiveMPSCQueue;
+
+    IntrusiveMPSCQueueNode * volatile m_Next;
+};
+
+// IntrusiveMPSCQueue
+//------------------------------------------------------------------------------
+// An unbounded queue of objects from any number of producer threads to one consumer
+// thread, without locks. Objects link themselves through their IntrusiveMPSCQueueNode,
+// so pushing never allocates and never fails. The queue doesn't own the objects: they
+// must outlive their time in it, and whoever pops one owns it again.
+//
+// Objects are linked from the oldest to the newest. A producer exchanges itself in as
+// the newest, then links the one it replaced to it with release, so the consumer can
+// follow the links with acquire. Pop returns nullptr for the moment between a producer's
+// exchange and its link, even though objects before it may be in the queue.
+template < class T >
+class IntrusiveMPSCQueue
+{
+public:
+    IntrusiveMPSCQueue();
+    ~IntrusiveMPSCQueue() = default;
+
+    IntrusiveMPSCQueue( const IntrusiveMPSCQueue & other ) = delete;
+    IntrusiveMPSCQueue & operator = ( const IntrusiveMPSCQueue & other ) = delete;
+
+    // Producers
+    void                Push( T * object );
+
+    // Consumer
+    [[nodiscard]] T *   Pop();
+
+private:
+    using Node = IntrusiveMPSCQueueNode;
+
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    void    PushNode( Node * node );
+
+    PRAGMA_DISABLE_PUSH_MSVC( 4324 ) // structure was padded due to alignment specifier
+    // The newest node, exchanged by the producers
+    alignas( CACHE_LINE_SIZE ) Node * volatile m_Head;
+
+    // The oldest node, owned by the consumer. The stub is kept in the queue so it's never
+    // empty of nodes, and producers always have one to link to.
+    alignas( CACHE_LINE_SIZE ) Node * m_Tail;
+    Node                m_Stub;
+    PRAGMA_DISABLE_POP_MSVC // 4324
+};
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+IntrusiveMPSCQueue< T >::IntrusiveMPSCQueue()
+    : m_Head( &m_Stub )
+    , m_Tail( &m_Stub )
+{
+}
+
+// Push
+//------------------------------------------------------------------------------
+template < class T >
+void IntrusiveMPSCQueue< T >::Push( T * object )
+{
+    PushNode( object );
+}
+
+// PushNode
+//------------------------------------------------------------------------------
+template < class T >
+void IntrusiveMPSCQueue< T >::PushNode( Node * node )
+{
+    AtomicStoreRelaxed( &node->m_Next, static_cast< Node * >( nullptr ) );
+    Node * previous = AtomicExchange( &m_Head, node );
+
+    // Release, so the node's object is written before the consumer reaches it
+    AtomicStoreRelease( &previous->m_Next, node );
+}
+
+// Pop
+//------------------------------------------------------------------------------
+template < class T >
+T * IntrusiveMPSCQueue< T >::Pop()
+{
+    Node * tail = m_Tail;
+    Node * next = AtomicLoadAcquire( &tail->m_Next );
+    if ( tail == &m_Stub )
+    {
+        // Step over the stub
+        if ( next == nullptr )
+        {
+            return nullptr;
+        }
+        m_Tail = next;
+        tail = next;
+        next = AtomicLoadAcquire( &next->m_Next );
+    }
+
+    if ( next )
+    {
+        m_Tail = next;
+        return static_cast< T * >( tail );
+    }
+
+    // The tail is the last node linked. If it's not the newest, a producer has exchanged
+    // itself in but not yet linked it.
+    if ( tail != AtomicLoadAcquire( &m_Head ) )
+    {
+        return nullptr;
+    }
+
+    // Put the stub back behind the tail, so the tail can be taken out
+    PushNode( &m_Stub );
+    next = AtomicLoadAcquire( &tail->m_Next );
+    if ( next )
+    {
+        m_Tail = next;
+        return static_cast< T * >( tail );
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
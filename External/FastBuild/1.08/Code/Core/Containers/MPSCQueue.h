@@ -0,0 +1,188 @@
+// MPSCQueue.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Move.h"
+#include "Core/Env/Assert.h"
+#include "Core/Env/Types.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+
+// MPSCQueue
+//------------------------------------------------------------------------------
+// A bounded queue from any number of producer threads to one consumer thread, without
+// locks. The capacity is rounded up to a power of 2. Push fails when the queue is full and
+// Pop when it's empty, rather than waiting.
+//
+// Each slot has a sequence number saying whose turn it is. A slot at position p is free
+// for the producer of p when its sequence is p, holds that producer's element once it's
+// p + 1, and is free again for position p + capacity once the consumer is done with it.
+// Producers claim positions by compare exchange on the tail, so each only waits on the
+// others when they claim the same position. Elements are popped in the order their
+// positions were claimed, so Pop can fail while a producer that claimed a position before
+// others is still writing its element, even though theirs are ready.
+template < class T >
+class MPSCQueue
+{
+public:
+    explicit MPSCQueue( size_t capacity );
+    ~MPSCQueue();
+
+    MPSCQueue( const MPSCQueue & other ) = delete;
+    MPSCQueue & operator = ( const MPSCQueue & other ) = delete;
+
+    // Producers
+    [[nodiscard]] bool      Push( const T & value );
+    [[nodiscard]] bool      Push( T && value );
+
+    // Consumer
+    [[nodiscard]] bool      Pop( T & value );
+
+    [[nodiscard]] size_t    GetCapacity() const { return (size_t)( m_Mask + 1 ); }
+
+private:
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    struct Slot
+    {
+        volatile uint64_t m_Sequence;
+        PRAGMA_DISABLE_PUSH_MSVC( 4324 ) // structure was padded due to alignment specifier
+        alignas( __alignof( T ) ) uint8_t m_Storage[ sizeof( T ) ];
+        PRAGMA_DISABLE_POP_MSVC // 4324
+
+        T * GetElement() { return reinterpret_cast< T * >( m_Storage ); }
+    };
+
+    template < class U >
+    bool PushInternal( U && value );
+
+    // Read only after construction
+    Slot *              m_Slots;
+    uint64_t            m_Mask;
+
+    PRAGMA_DISABLE_PUSH_MSVC( 4324 ) // structure was padded due to alignment specifier
+    // Claimed by the producers
+    alignas( CACHE_LINE_SIZE ) volatile uint64_t m_Tail;
+
+    // Owned by the consumer
+    alignas( CACHE_LINE_SIZE ) uint64_t m_Head;
+    PRAGMA_DISABLE_POP_MSVC // 4324
+};
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+MPSCQueue< T >::MPSCQueue( size_t capacity )
+    : m_Tail( 0 )
+    , m_Head( 0 )
+{
+    ASSERT( capacity > 0 );
+    size_t roundedCapacity = 1;
+    while ( roundedCapacity < capacity )
+    {
+        roundedCapacity *= 2;
+    }
+    m_Slots = static_cast< Slot * >( ALLOC( sizeof( Slot ) * roundedCapacity, __alignof( Slot ) ) );
+    m_Mask = ( roundedCapacity - 1 );
+    for ( size_t i = 0; i < roundedCapacity; ++i )
+    {
+        m_Slots[ i ].m_Sequence = i;
+    }
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+MPSCQueue< T >::~MPSCQueue()
+{
+    for ( ;; )
+    {
+        Slot & slot = m_Slots[ m_Head & m_Mask ];
+        if ( slot.m_Sequence != ( m_Head + 1 ) )
+        {
+            break;
+        }
+        slot.GetElement()->~T();
+        ++m_Head;
+    }
+    FREE( m_Slots );
+}
+
+// Push
+//------------------------------------------------------------------------------
+template < class T >
+bool MPSCQueue< T >::Push( const T & value )
+{
+    return PushInternal( value );
+}
+
+// Push
+//------------------------------------------------------------------------------
+template < class T >
+bool MPSCQueue< T >::Push( T && value )
+{
+    return PushInternal( Move( value ) );
+}
+
+// PushInternal
+//------------------------------------------------------------------------------
+template < class T >
+template < class U >
+bool MPSCQueue< T >::PushInternal( U && value )
+{
+    uint64_t tail = AtomicLoadRelaxed( &m_Tail );
+    Slot * slot;
+    for ( ;; )
+    {
+        slot = &m_Slots[ tail & m_Mask ];
+
+        // Acquire, so the consumer is finished with the slot before it's written
+        const uint64_t sequence = AtomicLoadAcquire( &slot->m_Sequence );
+        const int64_t turn = (int64_t)( sequence - tail );
+        if ( turn == 0 )
+        {
+            // Free for this position, if no other producer claims it first
+            if ( AtomicCompareExchange( &m_Tail, tail + 1, tail ) )
+            {
+                break;
+            }
+        }
+        else if ( turn < 0 )
+        {
+            // Still holds the element from a lap ago
+            return false;
+        }
+        tail = AtomicLoadRelaxed( &m_Tail );
+    }
+
+    INPLACE_NEW ( slot->GetElement() ) T( static_cast< U && >( value ) );
+
+    // Release, so the element is written before the consumer sees it
+    AtomicStoreRelease( &slot->m_Sequence, tail + 1 );
+    return true;
+}
+
+// Pop
+//------------------------------------------------------------------------------
+template < class T >
+bool MPSCQueue< T >::Pop( T & value )
+{
+    Slot & slot = m_Slots[ m_Head & m_Mask ];
+    if ( AtomicLoadAcquire( &slot.m_Sequence ) != ( m_Head + 1 ) )
+    {
+        return false;
+    }
+
+    T * element = slot.GetElement();
+    value = Move( *element );
+    element->~T();
+
+    // Release, so the element is finished with before a producer reuses the slot
+    AtomicStoreRelease( &slot.m_Sequence, m_Head + m_Mask + 1 );
+    ++m_Head;
+    return true;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,162 @@
+// SPSCQueue.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Move.h"
+#include "Core/Env/Assert.h"
+#include "Core/Env/Types.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+
+// SPSCQueue
+//------------------------------------------------------------------------------
+// A bounded queue from one producer thread to one consumer thread, without locks. The
+// capacity is rounded up to a power of 2. Push fails when the queue is full and Pop when
+// it's empty, rather than waiting.
+//
+// The producer publishes an element by storing the tail with release, and the consumer
+// gives its slot back by storing the head with release, each loading the other's index
+// with acquire. Each keeps the last index it saw of the other's, so they only touch the
+// other's cache line when the queue looks full or empty.
+template < class T >
+class SPSCQueue
+{
+public:
+    explicit SPSCQueue( size_t capacity );
+    ~SPSCQueue();
+
+    SPSCQueue( const SPSCQueue & other ) = delete;
+    SPSCQueue & operator = ( const SPSCQueue & other ) = delete;
+
+    // Producer
+    [[nodiscard]] bool      Push( const T & value );
+    [[nodiscard]] bool      Push( T && value );
+
+    // Consumer
+    [[nodiscard]] bool      Pop( T & value );
+
+    // Exact on the consumer's thread with respect to its own pops, otherwise a snapshot
+    [[nodiscard]] bool      IsEmpty() const     { return ( AtomicLoadAcquire( &m_Head ) == AtomicLoadAcquire( &m_Tail ) ); }
+    [[nodiscard]] size_t    GetCapacity() const { return (size_t)( m_Mask + 1 ); }
+
+private:
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    template < class U >
+    bool PushInternal( U && value );
+
+    // Read only after construction
+    T *                 m_Elements;
+    uint64_t            m_Mask;
+
+    PRAGMA_DISABLE_PUSH_MSVC( 4324 ) // structure was padded due to alignment specifier
+    // Written by the producer
+    alignas( CACHE_LINE_SIZE ) volatile uint64_t m_Tail;
+    uint64_t            m_CachedHead;
+
+    // Written by the consumer
+    alignas( CACHE_LINE_SIZE ) volatile uint64_t m_Head;
+    uint64_t            m_CachedTail;
+    PRAGMA_DISABLE_POP_MSVC // 4324
+};
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+SPSCQueue< T >::SPSCQueue( size_t capacity )
+    : m_Tail( 0 )
+    , m_CachedHead( 0 )
+    , m_Head( 0 )
+    , m_CachedTail( 0 )
+{
+    ASSERT( capacity > 0 );
+    size_t roundedCapacity = 1;
+    while ( roundedCapacity < capacity )
+    {
+        roundedCapacity *= 2;
+    }
+    m_Elements = static_cast< T * >( ALLOC( sizeof( T ) * roundedCapacity, __alignof( T ) ) );
+    m_Mask = ( roundedCapacity - 1 );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+SPSCQueue< T >::~SPSCQueue()
+{
+    for ( uint64_t i = m_Head; i != m_Tail; ++i )
+    {
+        m_Elements[ i & m_Mask ].~T();
+    }
+    FREE( m_Elements );
+}
+
+// Push
+//------------------------------------------------------------------------------
+template < class T >
+bool SPSCQueue< T >::Push( const T & value )
+{
+    return PushInternal( value );
+}
+
+// Push
+//------------------------------------------------------------------------------
+template < class T >
+bool SPSCQueue< T >::Push( T && value )
+{
+    return PushInternal( Move( value ) );
+}
+
+// PushInternal
+//------------------------------------------------------------------------------
+template < class T >
+template < class U >
+bool SPSCQueue< T >::PushInternal( U && value )
+{
+    const uint64_t tail = AtomicLoadRelaxed( &m_Tail );
+    if ( ( tail - m_CachedHead ) > m_Mask )
+    {
+        // Looks full, so see how far the consumer has got. Acquire, so its last pop is
+        // finished with the slot before it's written.
+        m_CachedHead = AtomicLoadAcquire( &m_Head );
+        if ( ( tail - m_CachedHead ) > m_Mask )
+        {
+            return false;
+        }
+    }
+
+    INPLACE_NEW ( &m_Elements[ tail & m_Mask ] ) T( static_cast< U && >( value ) );
+
+    // Release, so the element is written before the consumer sees it
+    AtomicStoreRelease( &m_Tail, tail + 1 );
+    return true;
+}
+
+// Pop
+//------------------------------------------------------------------------------
+template < class T >
+bool SPSCQueue< T >::Pop( T & value )
+{
+    const uint64_t head = AtomicLoadRelaxed( &m_Head );
+    if ( head == m_CachedTail )
+    {
+        // Looks empty, so see what the producer has published since
+        m_CachedTail = AtomicLoadAcquire( &m_Tail );
+        if ( head == m_CachedTail )
+        {
+            return false;
+        }
+    }
+
+    T & element = m_Elements[ head & m_Mask ];
+    value = Move( element );
+    element.~T();
+
+    // Release, so the element is finished with before the producer reuses its slot
+    AtomicStoreRelease( &m_Head, head + 1 );
+    return true;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,129 @@
+// Sort.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Sort.h"
+
+// Core
+#include "Core/Env/Env.h"
+#include "Core/Mem/MemStats.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
+
+// SortJobsState
+//------------------------------------------------------------------------------
+struct SortJobsState
+{
+    static const uint32_t kMaxWorkers = 64;
+
+    Thread::ThreadHandle    m_Workers[ kMaxWorkers ];
+    uint32_t                m_NumWorkers;
+    Semaphore               m_Wake;
+    Semaphore               m_Done;
+    volatile bool           m_Quit;
+    uint8_t                 m_Category;
+
+    // The phase being run
+    SortJobs::JobFunction   m_Function;
+    void *                  m_UserData;
+    uint32_t                m_NumJobs;
+    volatile uint32_t       m_NextJob;
+};
+
+// SortJobsWork
+//------------------------------------------------------------------------------
+static void SortJobsWork( SortJobsState & state )
+{
+    for ( ;; )
+    {
+        const uint32_t job = ( AtomicInc( &state.m_NextJob ) - 1 );
+        if ( job >= state.m_NumJobs )
+        {
+            return;
+        }
+        state.m_Function( state.m_UserData, job );
+    }
+}
+
+// SortJobsThreadFunction
+//------------------------------------------------------------------------------
+static uint32_t SortJobsThreadFunction( void * userData )
+{
+    SortJobsState & state = *static_cast< SortJobsState * >( userData );
+
+    // Counted in the sorting thread's category
+    MemStats::SetCurrentCategory( state.m_Category );
+    for ( ;; )
+    {
+        state.m_Wake.Wait();
+        if ( state.m_Quit )
+        {
+            return 0;
+        }
+        SortJobsWork( state );
+        state.m_Done.Signal();
+    }
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+SortJobs::SortJobs( uint32_t numThreads )
+    : m_State( FNEW( SortJobsState ) )
+{
+    SortJobsState & state = *m_State;
+    state.m_NumWorkers = Math::Min( Math::Max( numThreads, 1u ) - 1, SortJobsState::kMaxWorkers );
+    state.m_Quit = false;
+    state.m_Category = MemStats::GetCurrentCategory();
+    for ( uint32_t i = 0; i < state.m_NumWorkers; ++i )
+    {
+        state.m_Workers[ i ] = Thread::CreateThread( SortJobsThreadFunction, "SortJobs", Thread::kDefaultStackSize, &state );
+        ASSERT( state.m_Workers[ i ] != INVALID_THREAD_HANDLE );
+    }
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+SortJobs::~SortJobs()
+{
+    SortJobsState & state = *m_State;
+    state.m_Quit = true;
+    state.m_Wake.Signal( state.m_NumWorkers );
+    for ( uint32_t i = 0; i < state.m_NumWorkers; ++i )
+    {
+        Thread::WaitForThread( state.m_Workers[ i ] );
+        Thread::CloseHandle( state.m_Workers[ i ] );
+    }
+    FDELETE m_State;
+}
+
+// Run
+//------------------------------------------------------------------------------
+void SortJobs::Run( JobFunction func, void * userData, uint32_t numJobs )
+{
+    SortJobsState & state = *m_State;
+    state.m_Function = func;
+    state.m_UserData = userData;
+    state.m_NumJobs = numJobs;
+    state.m_NextJob = 0;
+
+    // Workers take jobs alongside the calling thread. Each woken worker signals once it
+    // runs out of jobs, after which none of them touch this phase again.
+    const uint32_t numWoken = ( numJobs > 0 ) ? Math::Min( state.m_NumWorkers, numJobs - 1 ) : 0;
+    state.m_Wake.Signal( numWoken );
+    SortJobsWork( state );
+    for ( uint32_t i = 0; i < numWoken; ++i )
+    {
+        state.m_Done.Wait();
+    }
+}
+
+// GetDefaultNumThreads
+//------------------------------------------------------------------------------
+/*static*/ uint32_t SortJobs::GetDefaultNumThreads()
+{
+    return Env::GetNumProcessors();
+}
+
+//------------------------------------------------------------------------------
@@ -4,7 +4,13 @@
 
 // Includes
 //------------------------------------------------------------------------------
+#include "Core/Containers/Move.h"
+#include "Core/Env/Assert.h"
 #include "Core/Env/Types.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/Mem.h"
+
+#include <string.h>
 
 // AscendingCompare
 //------------------------------------------------------------------------------
@@ -65,4 +71,437 @@ void ShellSort( T * begin, T * end, const COMPARE & compare )
     }
 }
 
+// SortHelpers
+//------------------------------------------------------------------------------
+namespace SortHelpers
+{
+    // Ranges this small are finished with an insertion sort
+    static const size_t kInsertionSortThreshold = 16;
+
+    template < class T >
+    inline void SwapItems( T & a, T & b )
+    {
+        T temp( Move( a ) );
+        a = Move( b );
+        b = Move( temp );
+    }
+
+    template < class T, class COMPARE >
+    void InsertionSort( T * begin, T * end, const COMPARE & compare )
+    {
+        const size_t numItems = (size_t)( end - begin );
+        for ( size_t i = 1; i < numItems; ++i )
+        {
+            if ( compare( begin[ i ], begin[ i - 1 ] ) )
+            {
+                T temp( Move( begin[ i ] ) );
+                size_t j = i;
+                do
+                {
+                    begin[ j ] = Move( begin[ j - 1 ] );
+                    --j;
+                } while ( ( j > 0 ) && compare( temp, begin[ j - 1 ] ) );
+                begin[ j ] = Move( temp );
+            }
+        }
+    }
+
+    template < class T, class COMPARE >
+    void SiftDown( T * heap, size_t index, size_t size, const COMPARE & compare )
+    {
+        T temp( Move( heap[ index ] ) );
+        for ( ;; )
+        {
+            size_t child = ( index * 2 ) + 1;
+            if ( child >= size )
+            {
+                break;
+            }
+            if ( ( child + 1 < size ) && compare( heap[ child ], heap[ child + 1 ] ) )
+            {
+                ++child;
+            }
+            if ( !compare( temp, heap[ child ] ) )
+            {
+                break;
+            }
+            heap[ index ] = Move( heap[ child ] );
+            index = child;
+        }
+        heap[ index ] = Move( temp );
+    }
+
+    template < class T, class COMPARE >
+    void HeapSort( T * begin, T * end, const COMPARE & compare )
+    {
+        const size_t numItems = (size_t)( end - begin );
+        for ( size_t i = numItems / 2; i-- > 0; )
+        {
+            SiftDown( begin, i, numItems, compare );
+        }
+        for ( size_t i = numItems - 1; i > 0; --i )
+        {
+            SwapItems( begin[ 0 ], begin[ i ] );
+            SiftDown( begin, 0, i, compare );
+        }
+    }
+
+    // Swap the median of a, b and c into first
+    template < class T, class COMPARE >
+    void MoveMedianToFirst( T * first, T * a, T * b, T * c, const COMPARE & compare )
+    {
+        T * median;
+        if ( compare( *a, *b ) )
+        {
+            median = compare( *b, *c ) ? b : ( compare( *a, *c ) ? c : a );
+        }
+        else
+        {
+            median = compare( *a, *c ) ? a : ( compare( *b, *c ) ? c : b );
+        }
+        SwapItems( *first, *median );
+    }
+
+    template < class T, class COMPARE >
+    void IntroSortLoop( T * begin, T * end, uint32_t depthLimit, const COMPARE & compare )
+    {
+        while ( (size_t)( end - begin ) > kInsertionSortThreshold )
+        {
+            if ( depthLimit == 0 )
+            {
+                HeapSort( begin, end, compare );
+                return;
+            }
+            --depthLimit;
+
+            // Partition around the median of three, which leaves an item on each side
+            // to stop the scans without bounds checks. Items equal to the pivot stop
+            // both scans, so they're spread over both sides.
+            MoveMedianToFirst( begin, begin + 1, begin + ( end - begin ) / 2, end - 1, compare );
+            T * left = begin + 1;
+            T * right = end;
+            for ( ;; )
+            {
+                while ( compare( *left, *begin ) )
+                {
+                    ++left;
+                }
+                --right;
+                while ( compare( *begin, *right ) )
+                {
+                    --right;
+                }
+                if ( !( left < right ) )
+                {
+                    break;
+                }
+                SwapItems( *left, *right );
+                ++left;
+            }
+
+            // Recurse into one side and loop on the other
+            IntroSortLoop( left, end, depthLimit, compare );
+            end = left;
+        }
+        InsertionSort( begin, end, compare );
+    }
+
+    // Keys mapped to unsigned integers that sort in the same order
+    inline uint32_t RadixKey( uint32_t key ) { return key; }
+    inline uint32_t RadixKey( int32_t key ) { return ( (uint32_t)key ^ 0x80000000u ); }
+    inline uint64_t RadixKey( uint64_t key ) { return key; }
+    inline uint64_t RadixKey( int64_t key ) { return ( (uint64_t)key ^ 0x8000000000000000ull ); }
+    inline uint32_t RadixKey( float key )
+    {
+        uint32_t bits;
+        memcpy( &bits, &key, sizeof( bits ) );
+        return ( bits & 0x80000000u ) ? ~bits : ( bits | 0x80000000u );
+    }
+    inline uint64_t RadixKey( double key )
+    {
+        uint64_t bits;
+        memcpy( &bits, &key, sizeof( bits ) );
+        return ( bits & 0x8000000000000000ull ) ? ~bits : ( bits | 0x8000000000000000ull );
+    }
+
+    // Move an item to uninitialized memory, leaving its old memory uninitialized
+    template < class T >
+    inline void RelocateItem( T * to, T * from )
+    {
+        INPLACE_NEW ( to ) T( Move( *from ) );
+        from->~T();
+    }
+}
+
+// IntroSort
+//------------------------------------------------------------------------------
+// Quicksort with a median of three pivot, falling back to a heap sort for ranges
+// that keep partitioning badly so the worst case stays O(n log n). Not stable.
+template < class T, class COMPARE >
+void IntroSort( T * begin, T * end, const COMPARE & compare )
+{
+    const size_t numItems = (size_t)( end - begin );
+    uint32_t depthLimit = 0;
+    for ( size_t n = numItems; n > 1; n >>= 1 )
+    {
+        depthLimit += 2;
+    }
+    SortHelpers::IntroSortLoop( begin, end, depthLimit, compare );
+}
+
+// RadixSort
+//------------------------------------------------------------------------------
+// A stable LSD radix sort, a byte at a time, on the integer or floating point key
+// getKey returns for each item. Items are moved between the range and scratch,
+// which must be uninitialized memory with room for them all. Bytes that are the
+// same in every key are skipped.
+template < class T, class GET_KEY >
+void RadixSort( T * begin, T * end, T * scratch, const GET_KEY & getKey )
+{
+    const size_t numItems = (size_t)( end - begin );
+    if ( numItems < 2 )
+    {
+        return;
+    }
+
+    using KEY = decltype( SortHelpers::RadixKey( getKey( *begin ) ) );
+    const uint32_t numDigits = sizeof( KEY );
+
+    // Count every byte of the keys in one pass
+    size_t counts[ sizeof( KEY ) ][ 256 ];
+    memset( counts, 0, sizeof( counts ) );
+    for ( const T * item = begin; item != end; ++item )
+    {
+        const KEY key = SortHelpers::RadixKey( getKey( *item ) );
+        for ( uint32_t digit = 0; digit < numDigits; ++digit )
+        {
+            ++counts[ digit ][ ( key >> ( digit * 8 ) ) & 0xFF ];
+        }
+    }
+
+    const KEY firstKey = SortHelpers::RadixKey( getKey( *begin ) );
+    T * src = begin;
+    T * dst = scratch;
+    for ( uint32_t digit = 0; digit < numDigits; ++digit )
+    {
+        const uint32_t shift = ( digit * 8 );
+        if ( counts[ digit ][ ( firstKey >> shift ) & 0xFF ] == numItems )
+        {
+            continue; // every key has this byte
+        }
+
+        size_t offsets[ 256 ];
+        size_t offset = 0;
+        for ( uint32_t bucket = 0; bucket < 256; ++bucket )
+        {
+            offsets[ bucket ] = offset;
+            offset += counts[ digit ][ bucket ];
+        }
+        for ( T * item = src; item != src + numItems; ++item )
+        {
+            const size_t bucket = (size_t)( ( SortHelpers::RadixKey( getKey( *item ) ) >> shift ) & 0xFF );
+            SortHelpers::RelocateItem( dst + offsets[ bucket ]++, item );
+        }
+
+        T * temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    // Finish in the range
+    if ( src != begin )
+    {
+        for ( size_t i = 0; i < numItems; ++i )
+        {
+            SortHelpers::RelocateItem( begin + i, src + i );
+        }
+    }
+}
+
+// SortJobs
+//------------------------------------------------------------------------------
+// Runs the jobs of a ParallelSort on Thread workers, started once for all its phases
+struct SortJobsState;
+class SortJobs
+{
+public:
+    typedef void (*JobFunction)( void * userData, uint32_t jobIndex );
+
+    // Start workers so up to numThreads threads, including the calling one, take jobs.
+    // Workers count their allocations in the calling thread's memory category.
+    explicit SortJobs( uint32_t numThreads );
+    ~SortJobs();
+
+    SortJobs( const SortJobs & other ) = delete;
+    SortJobs & operator = ( const SortJobs & other ) = delete;
+
+    // Call func for each job in [0, numJobs) and return once all have finished
+    void Run( JobFunction func, void * userData, uint32_t numJobs );
+
+    // Threads to use when the caller doesn't say
+    [[nodiscard]] static uint32_t GetDefaultNumThreads();
+
+private:
+    SortJobsState * m_State;
+};
+
+// SortHelpers (ParallelSort)
+//------------------------------------------------------------------------------
+namespace SortHelpers
+{
+    // Ranges smaller than this are sorted on the calling thread
+    static const size_t kParallelSortThreshold = ( 64 * 1024 );
+    static const uint32_t kParallelSortSamplesPerBucket = 32;
+
+    template < class T, class COMPARE >
+    struct ParallelSortState
+    {
+        T *                 m_Begin;
+        T *                 m_Scratch;
+        const COMPARE *     m_Compare;
+        const T **          m_Splitters;    // m_NumBuckets - 1, pointing into the range
+        uint8_t *           m_ItemBuckets;  // bucket of each item
+        size_t *            m_Offsets;      // per block and bucket
+        size_t *            m_BucketStarts; // m_NumBuckets + 1
+        size_t              m_NumItems;
+        uint32_t            m_NumBuckets;
+
+        T * GetBlockBegin( uint32_t block ) const { return m_Begin + ( m_NumItems * block ) / m_NumBuckets; }
+        T * GetBlockEnd( uint32_t block ) const { return m_Begin + ( m_NumItems * ( block + 1 ) ) / m_NumBuckets; }
+
+        // Count the items of a block in each bucket
+        static void ClassifyJob( void * userData, uint32_t block )
+        {
+            const ParallelSortState & state = *static_cast< ParallelSortState * >( userData );
+            const COMPARE & compare = *state.m_Compare;
+            size_t * counts = state.m_Offsets + ( block * state.m_NumBuckets );
+            T * const blockEnd = state.GetBlockEnd( block );
+            for ( T * item = state.GetBlockBegin( block ); item != blockEnd; ++item )
+            {
+                uint32_t low = 0;
+                uint32_t high = ( state.m_NumBuckets - 1 );
+                while ( low < high )
+                {
+                    const uint32_t mid = ( low + high ) / 2;
+                    if ( compare( *item, *state.m_Splitters[ mid ] ) )
+                    {
+                        high = mid;
+                    }
+                    else
+                    {
+                        low = mid + 1;
+                    }
+                }
+                state.m_ItemBuckets[ item - state.m_Begin ] = (uint8_t)low;
+                ++counts[ low ];
+            }
+        }
+
+        // Move the items of a block to their buckets in scratch
+        static void ScatterJob( void * userData, uint32_t block )
+        {
+            const ParallelSortState & state = *static_cast< ParallelSortState * >( userData );
+            size_t * offsets = state.m_Offsets + ( block * state.m_NumBuckets );
+            T * const blockEnd = state.GetBlockEnd( block );
+            for ( T * item = state.GetBlockBegin( block ); item != blockEnd; ++item )
+            {
+                const uint8_t bucket = state.m_ItemBuckets[ item - state.m_Begin ];
+                RelocateItem( state.m_Scratch + offsets[ bucket ]++, item );
+            }
+        }
+
+        // Sort a bucket and move it back to the range
+        static void SortBucketJob( void * userData, uint32_t bucket )
+        {
+            const ParallelSortState & state = *static_cast< ParallelSortState * >( userData );
+            const size_t start = state.m_BucketStarts[ bucket ];
+            const size_t end = state.m_BucketStarts[ bucket + 1 ];
+            IntroSort( state.m_Scratch + start, state.m_Scratch + end, *state.m_Compare );
+            for ( size_t i = start; i < end; ++i )
+            {
+                RelocateItem( state.m_Begin + i, state.m_Scratch + i );
+            }
+        }
+    };
+}
+
+// ParallelSort
+//------------------------------------------------------------------------------
+// A sample sort on Thread workers: splitters picked from a sample of the items
+// divide them into buckets, blocks of items are moved to their buckets in parallel
+// and the buckets are then sorted in parallel with IntroSort. Small ranges are
+// sorted on the calling thread. Not stable, and keys with few distinct values make
+// uneven buckets, which sort with less parallelism.
+template < class T, class COMPARE >
+void ParallelSort( T * begin, T * end, const COMPARE & compare, uint32_t numThreads = 0 )
+{
+    const size_t numItems = (size_t)( end - begin );
+    if ( numThreads == 0 )
+    {
+        numThreads = SortJobs::GetDefaultNumThreads();
+    }
+    if ( ( numThreads < 2 ) || ( numItems < SortHelpers::kParallelSortThreshold ) )
+    {
+        IntroSort( begin, end, compare );
+        return;
+    }
+
+    // A few buckets per thread to even out their sizes
+    const uint32_t numBuckets = Math::Min( numThreads * 4, 256u );
+    const uint32_t numSamples = ( numBuckets * SortHelpers::kParallelSortSamplesPerBucket );
+
+    SortHelpers::ParallelSortState< T, COMPARE > state;
+    state.m_Begin = begin;
+    state.m_Scratch = static_cast< T * >( ALLOC( numItems * sizeof( T ), Math::Max( __alignof( T ), sizeof( void * ) ) ) );
+    state.m_Compare = &compare;
+    state.m_Splitters = static_cast< const T ** >( ALLOC( numSamples * sizeof( const T * ) ) );
+    state.m_ItemBuckets = static_cast< uint8_t * >( ALLOC( numItems ) );
+    state.m_Offsets = static_cast< size_t * >( ALLOC( numBuckets * numBuckets * sizeof( size_t ) ) );
+    state.m_BucketStarts = static_cast< size_t * >( ALLOC( ( numBuckets + 1 ) * sizeof( size_t ) ) );
+    state.m_NumItems = numItems;
+    state.m_NumBuckets = numBuckets;
+
+    // Pick splitters from a sample spread over the range
+    const T ** samples = state.m_Splitters;
+    for ( uint32_t i = 0; i < numSamples; ++i )
+    {
+        samples[ i ] = begin + ( ( numItems * i ) / numSamples ) + ( ( i * 7919 ) % ( numItems / numSamples ) );
+    }
+    IntroSort( samples, samples + numSamples, [ &compare ]( const T * a, const T * b ) { return compare( *a, *b ); } );
+    for ( uint32_t bucket = 0; bucket < ( numBuckets - 1 ); ++bucket )
+    {
+        samples[ bucket ] = samples[ ( bucket + 1 ) * SortHelpers::kParallelSortSamplesPerBucket ];
+    }
+
+    // Count the items for each bucket in each block
+    SortJobs jobs( numThreads );
+    memset( state.m_Offsets, 0, numBuckets * numBuckets * sizeof( size_t ) );
+    jobs.Run( SortHelpers::ParallelSortState< T, COMPARE >::ClassifyJob, &state, numBuckets );
+
+    // Where each block's items go in each bucket
+    size_t offset = 0;
+    for ( uint32_t bucket = 0; bucket < numBuckets; ++bucket )
+    {
+        state.m_BucketStarts[ bucket ] = offset;
+        for ( uint32_t block = 0; block < numBuckets; ++block )
+        {
+            size_t & count = state.m_Offsets[ ( block * numBuckets ) + bucket ];
+            const size_t blockCount = count;
+            count = offset;
+            offset += blockCount;
+        }
+    }
+    state.m_BucketStarts[ numBuckets ] = offset;
+    ASSERT( offset == numItems );
+
+    jobs.Run( SortHelpers::ParallelSortState< T, COMPARE >::ScatterJob, &state, numBuckets );
+    jobs.Run( SortHelpers::ParallelSortState< T, COMPARE >::SortBucketJob, &state, numBuckets );
+
+    FREE( state.m_BucketStarts );
+    FREE( state.m_Offsets );
+    FREE( state.m_ItemBuckets );
+    FREE( state.m_Splitters );
+    FREE( state.m_Scratch );
+}
+
 //------------------------------------------------------------------------------
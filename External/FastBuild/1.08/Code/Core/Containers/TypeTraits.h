@@ -0,0 +1,18 @@
+// TypeTraits.h
+//------------------------------------------------------------------------------
+#pragma once
+
+template<class T, class U> struct IsSame    { static constexpr bool value = false; };
+template<class T> struct IsSame<T, T>       { static constexpr bool value = true; };
+
+template<class T> struct IsTriviallyCopyable { static constexpr bool value = __is_trivially_copyable( T ); };
+
+// Objects that can be moved to new memory with memcpy, with the originals then forgotten
+// rather than destroyed. Trivially copyable types are, and other types that hold no
+// pointers into themselves can say so with DECLARE_TRIVIALLY_RELOCATABLE.
+template<class T> struct IsTriviallyRelocatable { static constexpr bool value = IsTriviallyCopyable<T>::value; };
+
+#define DECLARE_TRIVIALLY_RELOCATABLE( T ) \
+    template<> struct IsTriviallyRelocatable<T> { static constexpr bool value = true; }
+
+//------------------------------------------------------------------------------
@@ -16,15 +16,22 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestEnv )
     REGISTER_TESTGROUP( TestFileIO )
     REGISTER_TESTGROUP( TestFileStream )
+    REGISTER_TESTGROUP( TestFlatHashMap )
+    REGISTER_TESTGROUP( TestFrameArena )
     REGISTER_TESTGROUP( TestHash )
+    REGISTER_TESTGROUP( TestLargePages )
     REGISTER_TESTGROUP( TestLevenshteinDistance )
     REGISTER_TESTGROUP( TestMemPoolBlock )
+    REGISTER_TESTGROUP( TestMemStats )
     REGISTER_TESTGROUP( TestMutex )
+    REGISTER_TESTGROUP( TestObjectPool )
     REGISTER_TESTGROUP( TestPathUtils )
+    REGISTER_TESTGROUP( TestQueues )
     REGISTER_TESTGROUP( TestReflection )
     REGISTER_TESTGROUP( TestSemaphore )
     REGISTER_TESTGROUP( TestSharedMemory )
     REGISTER_TESTGROUP( TestSmallBlockAllocator )
+    REGISTER_TESTGROUP( TestSort )
     REGISTER_TESTGROUP( TestSystemMutex )
     REGISTER_TESTGROUP( TestTestTCPConnectionPool )
     REGISTER_TESTGROUP( TestTimer )
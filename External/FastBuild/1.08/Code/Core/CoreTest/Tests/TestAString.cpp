@@ -46,6 +46,7 @@ private:
     void TrimEnd() const;
     void MoveConstructor() const;
     void MoveAssignment() const;
+    void SmallString() const;
 
     // Helpers
     template <class SRC, class DST, uint32_t EXPECTED_ALLOCS, class SRC_CAST = SRC>
@@ -84,6 +85,7 @@ REGISTER_TESTS_BEGIN( TestAString )
     REGISTER_TEST( TrimEnd )
     REGISTER_TEST( MoveConstructor )
     REGISTER_TEST( MoveAssignment )
+    REGISTER_TEST( SmallString )
 REGISTER_TESTS_END
 
 // AStringConstructors
@@ -94,7 +96,7 @@ void TestAString::AStringConstructors() const
         // AString with no arguments
         AString empty;
         TEST_ASSERT( empty.GetLength() == 0 );
-        TEST_ASSERT( empty.GetReserved() == 0 );
+        TEST_ASSERT( empty.GetReserved() > 0 ); // held in the string itself
         TEST_ASSERT( empty.IsEmpty() == true );
         TEST_ASSERT( empty.MemoryMustBeFreed() == false );
     }
@@ -112,13 +114,26 @@ void TestAString::AStringConstructors() const
         TEST_ASSERT( fromCharStar.GetLength() == 5 );
         TEST_ASSERT( fromCharStar.GetReserved() >= 5 );
         TEST_ASSERT( fromCharStar.IsEmpty() == false );
-        TEST_ASSERT( fromCharStar.MemoryMustBeFreed() == true );
+        TEST_ASSERT( fromCharStar.MemoryMustBeFreed() == false ); // short enough to be held in the string
 
         // AString from AString
         AString fromAString( fromCharStar );
         TEST_ASSERT( fromAString.GetLength() == 5 );
         TEST_ASSERT( fromAString.GetReserved() >= 5 );
         TEST_ASSERT( fromAString.IsEmpty() == false );
+        TEST_ASSERT( fromAString.MemoryMustBeFreed() == false );
+    }
+    {
+        // AString from char * too long to be held in the string
+        AString fromCharStar( "hellohellohello" );
+        TEST_ASSERT( fromCharStar.GetLength() == 15 );
+        TEST_ASSERT( fromCharStar.GetReserved() >= 15 );
+        TEST_ASSERT( fromCharStar.MemoryMustBeFreed() == true );
+
+        // AString from AString
+        AString fromAString( fromCharStar );
+        TEST_ASSERT( fromAString.GetLength() == 15 );
+        TEST_ASSERT( fromAString == "hellohellohello" );
         TEST_ASSERT( fromAString.MemoryMustBeFreed() == true );
     }
     {
@@ -127,7 +142,11 @@ void TestAString::AStringConstructors() const
         TEST_ASSERT( fromCharStarPair.GetLength() == 5 );
         TEST_ASSERT( fromCharStarPair.GetReserved() >= 5 );
         TEST_ASSERT( fromCharStarPair.IsEmpty() == false );
-        TEST_ASSERT( fromCharStarPair.MemoryMustBeFreed() == true );
+        TEST_ASSERT( fromCharStarPair.MemoryMustBeFreed() == false );
+
+        AString longCharStarPair( hello, hello + 15 );
+        TEST_ASSERT( longCharStarPair.GetLength() == 15 );
+        TEST_ASSERT( longCharStarPair.MemoryMustBeFreed() == true );
     }
 }
 
@@ -140,23 +159,32 @@ void TestAString::AStringAssignment() const
     TEST_ASSERT( str.GetLength() == 4 );
     TEST_ASSERT( str.GetReserved() >= 4 );
     TEST_ASSERT( str.IsEmpty() == false );
-    TEST_ASSERT( str.MemoryMustBeFreed() == true );
+    TEST_ASSERT( str.MemoryMustBeFreed() == false ); // short enough to be held in the string
 
     AString str2;
     str2 = str;
     TEST_ASSERT( str2.GetLength() == 4 );
     TEST_ASSERT( str2.GetReserved() >= 4 );
     TEST_ASSERT( str2.IsEmpty() == false );
-    TEST_ASSERT( str2.MemoryMustBeFreed() == true );
+    TEST_ASSERT( str2.MemoryMustBeFreed() == false );
 
-    const char * testData = "hellozzzzzzzzz";
+    const char * testData = "hellozzzzzzzzzzzzzzz";
     AString str3;
     str3.Assign( testData, testData + 5 );
     TEST_ASSERT( str3.GetLength() == 5 );
     TEST_ASSERT( str3.GetReserved() >= 5 );
     TEST_ASSERT( str3.IsEmpty() == false );
+    TEST_ASSERT( str3.MemoryMustBeFreed() == false );
+
+    str3.Assign( testData, testData + 20 );
+    TEST_ASSERT( str3.GetLength() == 20 );
+    TEST_ASSERT( str3.GetReserved() >= 20 );
     TEST_ASSERT( str3.MemoryMustBeFreed() == true );
 
+    str2 = str3;
+    TEST_ASSERT( str2 == testData );
+    TEST_ASSERT( str2.MemoryMustBeFreed() == true );
+
     // assign empty
     {
         AString dst;
@@ -325,12 +353,12 @@ void TestAString::ClearAndFreeMemory() const
         // Take note of memory state before
         TEST_MEMORY_SNAPSHOT( s1 );
 
-        AString str( "String" );
+        AString str( "String allocated on the heap" );
         str.ClearAndFreeMemory();
         TEST_ASSERT( str.IsEmpty() );
         TEST_ASSERT( str.GetLength() == 0 );
         TEST_ASSERT( AString::StrLen( str.Get() ) == 0 );
-        TEST_ASSERT( str.GetReserved() == 0 );
+        TEST_ASSERT( str.MemoryMustBeFreed() == false );
 
         // Check 1 alloc occurred but is no longer active
         TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 )
@@ -344,7 +372,7 @@ void TestAString::ClearAndFreeMemory() const
         TEST_ASSERT( str.IsEmpty() );
         TEST_ASSERT( str.GetLength() == 0 );
         TEST_ASSERT( AString::StrLen( str.Get() ) == 0 );
-        TEST_ASSERT( str.GetReserved() == 0 );
+        TEST_ASSERT( str.MemoryMustBeFreed() == false );
     }
     // AStackString
     {
@@ -383,7 +411,7 @@ void TestAString::ClearAndFreeMemory() const
         TEST_ASSERT( str.IsEmpty() );
         TEST_ASSERT( str.GetLength() == 0 );
         TEST_ASSERT( AString::StrLen( str.Get() ) == 0 );
-        TEST_ASSERT( str.GetReserved() == 0 ); // Stack reservation can't be retained
+        TEST_ASSERT( str.MemoryMustBeFreed() == false ); // Stack reservation can't be retained
 
         // Check 1 alloc occurred but is no longer active
         TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 )
@@ -1004,7 +1032,7 @@ template <class SRC, class DST, uint32_t EXPECTED_ALLOCS, class SRC_CAST>
 void TestAString::MoveConstructorHelper() const
 {
     // Create the source string
-    SRC stringA( "string" );
+    SRC stringA( "string too long to be small" );
 
     // Take note of memory state before
     TEST_MEMORY_SNAPSHOT( s1 );
@@ -1049,7 +1077,7 @@ void TestAString::MoveAssignmentHelper() const
     // Empty destination
     {
         // Create the source string
-        SRC stringA( "string" );
+        SRC stringA( "string too long to be small" );
 
         // Create the destination
         DST stringB;
@@ -1076,7 +1104,7 @@ void TestAString::MoveAssignmentHelper() const
 
         {
             // Create the source string
-            SRC stringA( "string" );
+            SRC stringA( "string too long to be small" );
 
             // Create the destination
             DST stringB;
@@ -1115,4 +1143,65 @@ void TestAString::MoveAssignment() const
     MoveAssignmentHelper<AStackString<>, AString,        1,     AString>(); // Src as AString, behave the same
 }
 
+// SmallString
+//------------------------------------------------------------------------------
+void TestAString::SmallString() const
+{
+    // Short strings are held in the string itself
+    {
+        TEST_MEMORY_SNAPSHOT( s1 );
+
+        AString name( "Settlement 42" );
+        AString copy( name );
+        AString moved( Move( copy ) );
+        AString formatted;
+        formatted.Format( "Farm %u", 7 );
+        formatted += " Hut";
+        TEST_ASSERT( moved == "Settlement 42" );
+        TEST_ASSERT( formatted == "Farm 7 Hut" );
+        PRAGMA_DISABLE_PUSH_MSVC(26800) // Use of a moved from object here is deliberate
+        TEST_ASSERT( copy.IsEmpty() );
+        PRAGMA_DISABLE_POP_MSVC
+
+        TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+    }
+
+    // And move to the heap when they grow
+    {
+        AString name( "Settlement" );
+        TEST_ASSERT( name.MemoryMustBeFreed() == false );
+        name += " of the long name";
+        TEST_ASSERT( name == "Settlement of the long name" );
+        TEST_ASSERT( name.MemoryMustBeFreed() == true );
+
+        // A moved-from string can still hold a short string itself
+        AString moved( Move( name ) );
+        PRAGMA_DISABLE_PUSH_MSVC(26800) // Use of a moved from object here is deliberate
+        name = "Reused";
+        PRAGMA_DISABLE_POP_MSVC
+        TEST_ASSERT( name.MemoryMustBeFreed() == false );
+        TEST_ASSERT( name == "Reused" );
+    }
+
+    // Arrays of short strings only allocate the array
+    {
+        Array< AString > names;
+        names.SetCapacity( 100 );
+
+        TEST_MEMORY_SNAPSHOT( s1 );
+
+        for ( uint32_t i = 0; i < 100; ++i )
+        {
+            AString name;
+            name.Format( "Building %u", i );
+            names.Append( Move( name ) );
+        }
+        names.Sort();
+        TEST_ASSERT( names[ 0 ] == "Building 0" );
+        TEST_ASSERT( names[ 99 ] == "Building 99" );
+
+        TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+    }
+}
+
 //------------------------------------------------------------------------------
@@ -8,6 +8,24 @@
 #include "Core/Containers/Array.h"
 #include "Core/Strings/AString.h"
 
+// TestArrayRelocatable
+//------------------------------------------------------------------------------
+// Counts its moves and destructions, which relocation doesn't do
+class TestArrayRelocatable
+{
+public:
+    explicit TestArrayRelocatable( uint32_t value = 0 ) : m_Value( value ) {}
+    TestArrayRelocatable( TestArrayRelocatable && other ) : m_Value( other.m_Value ) { ++s_NumMoves; }
+    ~TestArrayRelocatable() { ++s_NumDestructs; }
+
+    uint32_t        m_Value;
+    static uint32_t s_NumMoves;
+    static uint32_t s_NumDestructs;
+};
+/*static*/ uint32_t TestArrayRelocatable::s_NumMoves = 0;
+/*static*/ uint32_t TestArrayRelocatable::s_NumDestructs = 0;
+DECLARE_TRIVIALLY_RELOCATABLE( TestArrayRelocatable );
+
 // TestArray
 //------------------------------------------------------------------------------
 class TestArray : public TestGroup
@@ -45,6 +63,7 @@ private:
     void Append_Item() const;
     void Append_OtherArray() const;
     void Append_Range() const;
+    void Append_RangeGrowsOnce() const;
 
     void Pop() const;
     void PopFront() const;
@@ -70,6 +89,12 @@ private:
     void MoveErase() const;
 
     void StackArrayOverflowToHeap() const;
+    void InlineArrayOverflowToHeap() const;
+    void InlineArrayCopyAndMove() const;
+    void InlineArrayAsMember() const;
+
+    void RelocateWhenGrowing() const;
+    void RelocateArrayOfArrays() const;
 
     // Helper functions
     template <typename T>
@@ -113,6 +138,7 @@ REGISTER_TESTS_BEGIN( TestArray )
     REGISTER_TEST( Append_Item )
     REGISTER_TEST( Append_OtherArray )
     REGISTER_TEST( Append_Range )
+    REGISTER_TEST( Append_RangeGrowsOnce )
 
     REGISTER_TEST( Pop )
     REGISTER_TEST( PopFront )
@@ -138,6 +164,12 @@ REGISTER_TESTS_BEGIN( TestArray )
     REGISTER_TEST( MoveErase )
 
     REGISTER_TEST( StackArrayOverflowToHeap )
+    REGISTER_TEST( InlineArrayOverflowToHeap )
+    REGISTER_TEST( InlineArrayCopyAndMove )
+    REGISTER_TEST( InlineArrayAsMember )
+
+    REGISTER_TEST( RelocateWhenGrowing )
+    REGISTER_TEST( RelocateArrayOfArrays )
 REGISTER_TESTS_END
 
 // Construct_Empty
@@ -1080,6 +1112,58 @@ void TestArray::Append_Range() const
     }
 }
 
+// Append_RangeGrowsOnce
+//------------------------------------------------------------------------------
+void TestArray::Append_RangeGrowsOnce() const
+{
+    uint32_t values[ 100 ];
+    for ( uint32_t i = 0; i < 100; ++i )
+    {
+        values[ i ] = i;
+    }
+
+    // POD
+    {
+        Array<uint32_t> array;
+        array.Append( 7u );
+
+        TEST_MEMORY_SNAPSHOT( s1 );
+
+        array.Append( values, values + 100 );
+
+        // Space for all the items is made at once
+        TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 )
+
+        TEST_ASSERT( array.GetSize() == 101 );
+        TEST_ASSERT( array[ 0 ] == 7 );
+        TEST_ASSERT( array[ 100 ] == 99 );
+        CheckConsistency( array );
+    }
+
+    // Complex Type
+    {
+        Array<AString> strings;
+        strings.Append( AString( "string1 too long to be small" ) );
+        strings.Append( AString( "string2 too long to be small" ) );
+        strings.Append( AString( "string3 too long to be small" ) );
+        Array<AString> array;
+        array.Append( AString( "string0" ) );
+
+        TEST_MEMORY_SNAPSHOT( s1 );
+
+        array.Append( strings );
+
+        // One to make space, and one for each copy of a string
+        TEST_EXPECT_ALLOCATION_EVENTS( s1, 4 )
+
+        TEST_ASSERT( array.GetSize() == 4 );
+        TEST_ASSERT( array[ 0 ] == "string0" );
+        TEST_ASSERT( array[ 1 ] == "string1 too long to be small" );
+        TEST_ASSERT( array[ 3 ] == "string3 too long to be small" );
+        CheckConsistency( array );
+    }
+}
+
 // Pop
 //------------------------------------------------------------------------------
 void TestArray::Pop() const
@@ -1340,7 +1424,7 @@ void TestArray::EmplaceBack() const
 
         TEST_MEMORY_SNAPSHOT( s1 ); // Take note of memory state before
 
-        TEST_ASSERT( array.EmplaceBack( "string1" ) == "string1" );
+        TEST_ASSERT( array.EmplaceBack( "string1 allocated on the heap" ) == "string1 allocated on the heap" );
 
         TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 ) // Check expected amount of allocs occurred
 
@@ -1348,7 +1432,7 @@ void TestArray::EmplaceBack() const
         TEST_ASSERT( array.IsEmpty() == false );
         TEST_ASSERT( array.GetSize() == 1 );
         TEST_ASSERT( array.GetCapacity() >= 1 );
-        TEST_ASSERT( array[ 0 ] == "string1" );
+        TEST_ASSERT( array[ 0 ] == "string1 allocated on the heap" );
     }
     {
         // Emplace one item (Move)
@@ -1356,7 +1440,7 @@ void TestArray::EmplaceBack() const
 
         TEST_MEMORY_SNAPSHOT( s1 ); // Take note of memory state before
 
-        TEST_ASSERT( array.EmplaceBack( Move( AString( "string1" ) ) ) == "string1" );
+        TEST_ASSERT( array.EmplaceBack( Move( AString( "string1 allocated on the heap" ) ) ) == "string1 allocated on the heap" );
 
         TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 ) // Check expected amount of allocs occurred
 
@@ -1364,7 +1448,7 @@ void TestArray::EmplaceBack() const
         TEST_ASSERT( array.IsEmpty() == false );
         TEST_ASSERT( array.GetSize() == 1 );
         TEST_ASSERT( array.GetCapacity() >= 1 );
-        TEST_ASSERT( array[ 0 ] == "string1" );
+        TEST_ASSERT( array[ 0 ] == "string1 allocated on the heap" );
     }
     {
         // Emplace several items
@@ -1372,9 +1456,9 @@ void TestArray::EmplaceBack() const
 
         TEST_MEMORY_SNAPSHOT( s1 ); // Take note of memory state before
 
-        TEST_ASSERT( array.EmplaceBack( "string1" ) == "string1" );
-        TEST_ASSERT( array.EmplaceBack( "string2" ) == "string2" );
-        TEST_ASSERT( array.EmplaceBack( "string3" ) == "string3" );
+        TEST_ASSERT( array.EmplaceBack( "string1 allocated on the heap" ) == "string1 allocated on the heap" );
+        TEST_ASSERT( array.EmplaceBack( "string2 allocated on the heap" ) == "string2 allocated on the heap" );
+        TEST_ASSERT( array.EmplaceBack( "string3 allocated on the heap" ) == "string3 allocated on the heap" );
 
         TEST_EXPECT_ALLOCATION_EVENTS( s1, 3 ) // Check expected amount of allocs occurred
 
@@ -1382,8 +1466,8 @@ void TestArray::EmplaceBack() const
         TEST_ASSERT( array.IsEmpty() == false );
         TEST_ASSERT( array.GetSize() == 3 );
         TEST_ASSERT( array.GetCapacity() >= 3 ); // Capacity unchanged
-        TEST_ASSERT( array[ 0 ] == "string1" );
-        TEST_ASSERT( array[ 2 ] == "string3" );
+        TEST_ASSERT( array[ 0 ] == "string1 allocated on the heap" );
+        TEST_ASSERT( array[ 2 ] == "string3 allocated on the heap" );
     }
 }
 
@@ -2009,7 +2093,7 @@ void TestArray::MoveWhenGrowing() const
     array.Append( AString( "string3" ) );
     array.Append( AString( "string4" ) );
 
-    const AString string5( "string4" );
+    const AString string5( "string5 allocated on the heap" );
 
     // Take note of memory state before
     TEST_MEMORY_SNAPSHOT( s1 );
@@ -2166,6 +2250,212 @@ void TestArray::StackArrayOverflowToHeap() const
     }
 }
 
+// InlineArrayOverflowToHeap
+//------------------------------------------------------------------------------
+void TestArray::InlineArrayOverflowToHeap() const
+{
+    TEST_MEMORY_SNAPSHOT( s1 );
+
+    InlineArray<AString, 4> array;
+    for ( uint32_t i = 0; i < 4; ++i )
+    {
+        AString string;
+        string.Format( "%u", i );
+        array.Append( string );
+    }
+    TEST_ASSERT( array.IsInline() );
+    TEST_ASSERT( array.IsAtCapacity() );
+    CheckConsistency( array );
+    TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+
+    // Usable wherever an Array is
+    Array<AString> & asArray = array;
+    asArray.Append( AString( "4" ) );
+    TEST_ASSERT( array.IsInline() == false );
+    TEST_ASSERT( array.GetSize() == 5 );
+    TEST_ASSERT( array[ 0 ] == "0" );
+    TEST_ASSERT( array[ 4 ] == "4" );
+    CheckConsistency( array );
+}
+
+// InlineArrayCopyAndMove
+//------------------------------------------------------------------------------
+void TestArray::InlineArrayCopyAndMove() const
+{
+    InlineArray<uint32_t, 4> small;
+    small.Append( 1 );
+    small.Append( 2 );
+
+    // Copies and moves of inline elements keep to their own storage
+    {
+        TEST_MEMORY_SNAPSHOT( s1 );
+
+        InlineArray<uint32_t, 4> copy( small );
+        InlineArray<uint32_t, 4> moved( Move( copy ) );
+        TEST_ASSERT( copy.IsEmpty() );
+        TEST_ASSERT( copy.IsInline() );
+        TEST_ASSERT( moved.IsInline() );
+        TEST_ASSERT( moved.GetSize() == 2 );
+        TEST_ASSERT( moved[ 1 ] == 2 );
+
+        InlineArray<uint32_t, 4> assigned;
+        assigned = small;
+        assigned = Move( moved );
+        TEST_ASSERT( assigned.IsInline() );
+        TEST_ASSERT( assigned.GetSize() == 2 );
+
+        TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+    }
+
+    // Moving elements that spilled to the heap takes the heap memory, and the
+    // moved-from array goes back to its own storage
+    {
+        InlineArray<uint32_t, 4> big;
+        for ( uint32_t i = 0; i < 10; ++i )
+        {
+            big.Append( i );
+        }
+        const uint32_t * heapMemory = big.Begin();
+
+        TEST_MEMORY_SNAPSHOT( s1 );
+
+        InlineArray<uint32_t, 4> moved( Move( big ) );
+        TEST_ASSERT( moved.Begin() == heapMemory );
+        TEST_ASSERT( moved.GetSize() == 10 );
+        TEST_ASSERT( big.IsInline() );
+        big.Append( 1 );
+        TEST_ASSERT( big.IsInline() );
+
+        TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+
+        // Arrays copied from it spill as needed
+        InlineArray<uint32_t, 4> copy( moved );
+        TEST_ASSERT( copy.IsInline() == false );
+        TEST_ASSERT( copy.GetSize() == 10 );
+        TEST_ASSERT( copy[ 9 ] == 9 );
+
+        // And to and from Arrays
+        Array<uint32_t> array( Move( copy ) );
+        TEST_ASSERT( array.GetSize() == 10 );
+        InlineArray<uint32_t, 4> fromArray( Move( array ) );
+        TEST_ASSERT( fromArray.GetSize() == 10 );
+        TEST_ASSERT( array.IsEmpty() );
+
+        // Destruct frees the heap memory and goes back to the array's own storage
+        fromArray.Destruct();
+        TEST_ASSERT( fromArray.IsEmpty() );
+        TEST_ASSERT( fromArray.IsInline() );
+    }
+}
+
+// InlineArrayAsMember
+//------------------------------------------------------------------------------
+void TestArray::InlineArrayAsMember() const
+{
+    // Objects holding InlineArrays can live in Arrays, which move them as they grow
+    struct Settlement
+    {
+        uint32_t                    m_Id;
+        InlineArray<uint32_t, 4>    m_Buildings;
+    };
+    Array<Settlement> settlements;
+    for ( uint32_t i = 0; i < 100; ++i )
+    {
+        Settlement & settlement = settlements.EmplaceBack();
+        settlement.m_Id = i;
+        for ( uint32_t j = 0; j < ( i % 6 ); ++j )
+        {
+            settlement.m_Buildings.Append( i * 10 + j );
+        }
+    }
+    for ( uint32_t i = 0; i < 100; ++i )
+    {
+        const Settlement & settlement = settlements[ i ];
+        TEST_ASSERT( settlement.m_Id == i );
+        TEST_ASSERT( settlement.m_Buildings.GetSize() == ( i % 6 ) );
+        TEST_ASSERT( settlement.m_Buildings.IsInline() == ( ( i % 6 ) <= 4 ) );
+        for ( uint32_t j = 0; j < ( i % 6 ); ++j )
+        {
+            TEST_ASSERT( settlement.m_Buildings[ j ] == ( i * 10 + j ) );
+        }
+    }
+}
+
+// RelocateWhenGrowing
+//------------------------------------------------------------------------------
+void TestArray::RelocateWhenGrowing() const
+{
+    TestArrayRelocatable::s_NumMoves = 0;
+    TestArrayRelocatable::s_NumDestructs = 0;
+
+    // Heap
+    {
+        Array<TestArrayRelocatable> array;
+        for ( uint32_t i = 0; i < 1000; ++i )
+        {
+            array.EmplaceBack( i );
+        }
+        array.SetCapacity( 5000 );
+
+        // Elements are copied across as memory, not moved and destroyed one at a time
+        TEST_ASSERT( TestArrayRelocatable::s_NumMoves == 0 );
+        TEST_ASSERT( TestArrayRelocatable::s_NumDestructs == 0 );
+        for ( uint32_t i = 0; i < 1000; ++i )
+        {
+            TEST_ASSERT( array[ i ].m_Value == i );
+        }
+        CheckConsistency( array );
+    }
+    TEST_ASSERT( TestArrayRelocatable::s_NumDestructs == 1000 );
+
+    // Stack to heap
+    {
+        StackArray<TestArrayRelocatable, 4> array;
+        for ( uint32_t i = 0; i < 100; ++i )
+        {
+            array.EmplaceBack( i );
+        }
+        TEST_ASSERT( TestArrayRelocatable::s_NumMoves == 0 );
+        TEST_ASSERT( array[ 0 ].m_Value == 0 );
+        TEST_ASSERT( array[ 99 ].m_Value == 99 );
+        CheckConsistency( array );
+    }
+    TEST_ASSERT( TestArrayRelocatable::s_NumDestructs == 1100 );
+}
+
+// RelocateArrayOfArrays
+//------------------------------------------------------------------------------
+void TestArray::RelocateArrayOfArrays() const
+{
+    Array<Array<uint32_t>> arrays( 1, true );
+    arrays.SetSize( 1 );
+    arrays[ 0 ].SetSize( 10 );
+    arrays[ 0 ][ 9 ] = 99;
+    const uint32_t * const innerMemory = arrays[ 0 ].Begin();
+
+    TEST_MEMORY_SNAPSHOT( s1 );
+
+    arrays.SetCapacity( 1000 );
+
+    // Only the outer array's memory changes
+    TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 )
+    TEST_ASSERT( arrays[ 0 ].Begin() == innerMemory );
+    TEST_ASSERT( arrays[ 0 ][ 9 ] == 99 );
+
+    // Growing one at a time
+    for ( uint32_t i = 1; i < 2000; ++i )
+    {
+        arrays.EmplaceBack();
+        arrays.Top().Append( i );
+    }
+    for ( uint32_t i = 1; i < 2000; ++i )
+    {
+        TEST_ASSERT( arrays[ i ].GetSize() == 1 );
+        TEST_ASSERT( arrays[ i ][ 0 ] == i );
+    }
+    TEST_ASSERT( arrays[ 0 ].Begin() == innerMemory );
+}
+
 // CheckConsistency
 //------------------------------------------------------------------------------
 template <typename T>
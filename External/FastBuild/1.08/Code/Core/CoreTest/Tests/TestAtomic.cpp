@@ -120,6 +120,14 @@ private:
 
     // Pointer
     void Pointer() const;
+
+    // Bits
+    void Bits() const;
+    static uint32_t ThreadFunction_Bits( void * userData );
+
+    // CompareExchange
+    void CompareExchange() const;
+    static uint32_t ThreadFunction_CompareExchange( void * userData );
 };
 
 // Register Tests
@@ -139,6 +147,10 @@ REGISTER_TESTS_BEGIN( TestAtomic )
 
     // Pointer
     REGISTER_TEST( Pointer )
+
+    // Bits
+    REGISTER_TEST( Bits )
+    REGISTER_TEST( CompareExchange )
 REGISTER_TESTS_END
 
 // Boolean
@@ -169,6 +181,16 @@ void TestAtomic::Pointer() const
         const TestAtomic * volatile pointer;
         AtomicStoreRelease( &pointer, this );
         TEST_ASSERT( AtomicLoadAcquire( &pointer ) == this );
+
+        // Exchange
+        TEST_ASSERT( AtomicExchange( &pointer, (const TestAtomic *)nullptr ) == this );
+        TEST_ASSERT( AtomicLoadAcquire( &pointer ) == nullptr );
+
+        // CompareExchange
+        TEST_ASSERT( AtomicCompareExchange( &pointer, (const TestAtomic *)this, (const TestAtomic *)this ) == false );
+        TEST_ASSERT( AtomicLoadAcquire( &pointer ) == nullptr );
+        TEST_ASSERT( AtomicCompareExchange( &pointer, (const TestAtomic *)this, (const TestAtomic *)nullptr ) );
+        TEST_ASSERT( AtomicLoadAcquire( &pointer ) == this );
     }
 
     // Atomic
@@ -179,4 +201,98 @@ void TestAtomic::Pointer() const
     }
 }
 
+// Bits
+//------------------------------------------------------------------------------
+void TestAtomic::Bits() const
+{
+    // Direct operations
+    {
+        volatile uint32_t bits = 0x0F;
+        TEST_ASSERT( AtomicOr( &bits, 0xF0u ) == 0xFFu ); // Returns new value
+        TEST_ASSERT( AtomicAnd( &bits, 0x3Cu ) == 0x3Cu ); // Returns new value
+    }
+
+    // Setting and clearing different bits of the same word on two threads
+    volatile uint64_t bits = 0;
+    Thread::ThreadHandle h = Thread::CreateThread( ThreadFunction_Bits,
+                                                   "TestAtomicBits",
+                                                   ( 64 * KILOBYTE ),
+                                                   (void *)&bits );
+    for ( size_t i = 0; i < 100000; ++i )
+    {
+        AtomicOr( &bits, (uint64_t)0x1 );
+        AtomicAnd( &bits, ~(uint64_t)0x1 );
+    }
+    AtomicOr( &bits, (uint64_t)0x1 );
+
+    bool timedOut = false;
+    Thread::WaitForThread( h, 1000, timedOut );
+    TEST_ASSERT( timedOut == false );
+    Thread::CloseHandle( h );
+
+    // Neither thread lost the other's last update
+    TEST_ASSERT( AtomicLoadAcquire( &bits ) == ( ( (uint64_t)1 << 63 ) | 0x1 ) );
+}
+
+// ThreadFunction_Bits
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestAtomic::ThreadFunction_Bits( void * userData )
+{
+    volatile uint64_t * bits = static_cast< volatile uint64_t * >( userData );
+    const uint64_t bit = ( (uint64_t)1 << 63 );
+    for ( size_t i = 0; i < 100000; ++i )
+    {
+        AtomicOr( bits, bit );
+        AtomicAnd( bits, ~bit );
+    }
+    AtomicOr( bits, bit );
+    return 0;
+}
+
+// CompareExchange
+//------------------------------------------------------------------------------
+void TestAtomic::CompareExchange() const
+{
+    // Direct operations
+    {
+        volatile uint32_t value = 5;
+        TEST_ASSERT( AtomicCompareExchange( &value, 7u, 6u ) == false );
+        TEST_ASSERT( value == 5 );
+        TEST_ASSERT( AtomicCompareExchange( &value, 7u, 5u ) );
+        TEST_ASSERT( value == 7 );
+    }
+
+    // Incrementing the same value on two threads, retrying when the other got there first
+    volatile uint64_t value = 0;
+    Thread::ThreadHandle h = Thread::CreateThread( ThreadFunction_CompareExchange,
+                                                   "TestAtomicCompareExchange",
+                                                   ( 64 * KILOBYTE ),
+                                                   (void *)&value );
+    ThreadFunction_CompareExchange( (void *)&value );
+
+    bool timedOut = false;
+    Thread::WaitForThread( h, 1000, timedOut );
+    TEST_ASSERT( timedOut == false );
+    Thread::CloseHandle( h );
+
+    // Neither thread lost an increment
+    TEST_ASSERT( AtomicLoadAcquire( &value ) == 200000 );
+}
+
+// ThreadFunction_CompareExchange
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestAtomic::ThreadFunction_CompareExchange( void * userData )
+{
+    volatile uint64_t * value = static_cast< volatile uint64_t * >( userData );
+    for ( size_t i = 0; i < 100000; ++i )
+    {
+        uint64_t expected = AtomicLoadRelaxed( value );
+        while ( AtomicCompareExchange( value, expected + 1, expected ) == false )
+        {
+            expected = AtomicLoadRelaxed( value );
+        }
+    }
+    return 0;
+}
+
 //------------------------------------------------------------------------------
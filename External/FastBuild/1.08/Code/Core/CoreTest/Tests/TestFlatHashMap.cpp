@@ -0,0 +1,298 @@
+// TestFlatHashMap.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Containers/FlatHashMap.h"
+#include "Core/Math/Random.h"
+#include "Core/Strings/AString.h"
+
+// TestFlatHashMap
+//------------------------------------------------------------------------------
+class TestFlatHashMap : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void ConstructEmpty() const;
+    void Destruct() const;
+    void Clear() const;
+    void Insert() const;
+    void Find() const;
+    void FindHeterogeneous() const;
+    void Erase() const;
+    void EraseAndInsertMany() const;
+    void Grow() const;
+    void Reserve() const;
+    void SmallMapMemory() const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestFlatHashMap )
+    REGISTER_TEST( ConstructEmpty )
+    REGISTER_TEST( Insert )
+    REGISTER_TEST( Find )
+    REGISTER_TEST( FindHeterogeneous )
+    REGISTER_TEST( Erase )
+    REGISTER_TEST( EraseAndInsertMany )
+    REGISTER_TEST( Grow )
+    REGISTER_TEST( Reserve )
+    REGISTER_TEST( SmallMapMemory )
+    REGISTER_TEST( Clear )
+    REGISTER_TEST( Destruct )
+REGISTER_TESTS_END
+
+// ConstructEmpty
+//------------------------------------------------------------------------------
+void TestFlatHashMap::ConstructEmpty() const
+{
+    TEST_MEMORY_SNAPSHOT( s1 );
+
+    FlatHashMap<AString, AString> map;
+    TEST_ASSERT( map.IsEmpty() );
+    TEST_ASSERT( map.GetSize() == 0 );
+    TEST_ASSERT( map.GetCapacity() == 0 );
+
+    TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 ) // Nothing is allocated until the first insert
+}
+
+// Insert
+//------------------------------------------------------------------------------
+void TestFlatHashMap::Insert() const
+{
+    FlatHashMap<AString, AString> map;
+    map.Insert( AString( "Hello" ), AString( "there" ) );
+    TEST_ASSERT( map.IsEmpty() == false );
+    TEST_ASSERT( map.GetSize() == 1 );
+    map.Insert( AString( "Key" ), AString( "Value" ) );
+    TEST_ASSERT( map.IsEmpty() == false );
+    TEST_ASSERT( map.GetSize() == 2 );
+}
+
+// Find
+//------------------------------------------------------------------------------
+void TestFlatHashMap::Find() const
+{
+    // empty
+    {
+        FlatHashMap<AString, AString> map;
+        TEST_ASSERT( map.Find( AString( "thing" ) ) == nullptr );
+    }
+
+    // not empty
+    {
+        FlatHashMap<AString, AString> map;
+        map.Insert( AString( "Hello" ), AString( "there" ) );
+
+        // found
+        {
+            auto * pair = map.Find( AString( "Hello" ) );
+            TEST_ASSERT( pair );
+            TEST_ASSERT( pair->m_Key == "Hello" );
+            TEST_ASSERT( pair->m_Value == "there" );
+        }
+
+        // not found
+        {
+            auto * pair = map.Find( AString( "Thing" ) );
+            TEST_ASSERT( pair == nullptr );
+        }
+    }
+}
+
+// FindHeterogeneous
+//------------------------------------------------------------------------------
+void TestFlatHashMap::FindHeterogeneous() const
+{
+    FlatHashMap<AString, uint32_t> map;
+    map.Insert( AString( "Hello" ), 1 );
+    map.Insert( AString( "Key" ), 2 );
+
+    TEST_MEMORY_SNAPSHOT( s1 );
+
+    // Looking up by const char * doesn't construct an AString
+    const char * key = "Key";
+    TEST_ASSERT( map.Find( key ) );
+    TEST_ASSERT( map.Find( key )->m_Value == 2 );
+    TEST_ASSERT( map.Find( "Hello" )->m_Value == 1 );
+    TEST_ASSERT( map.Find( "Thing" ) == nullptr );
+
+    TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+
+    TEST_ASSERT( map.Erase( "Hello" ) );
+    TEST_ASSERT( map.Find( "Hello" ) == nullptr );
+    TEST_ASSERT( map.GetSize() == 1 );
+}
+
+// Erase
+//------------------------------------------------------------------------------
+void TestFlatHashMap::Erase() const
+{
+    // empty
+    {
+        FlatHashMap<AString, AString> map;
+        TEST_ASSERT( map.Erase( AString( "thing" ) ) == false );
+    }
+
+    // not empty
+    {
+        FlatHashMap<AString, AString> map;
+        map.Insert( AString( "Hello" ), AString( "there" ) );
+        map.Insert( AString( "Key" ), AString( "Value" ) );
+
+        TEST_ASSERT( map.Erase( AString( "Thing" ) ) == false );
+        TEST_ASSERT( map.GetSize() == 2 );
+
+        TEST_ASSERT( map.Erase( AString( "Hello" ) ) );
+        TEST_ASSERT( map.GetSize() == 1 );
+        TEST_ASSERT( map.Find( AString( "Hello" ) ) == nullptr );
+        TEST_ASSERT( map.Find( AString( "Key" ) )->m_Value == "Value" );
+
+        // Erased keys can be inserted again
+        map.Insert( AString( "Hello" ), AString( "again" ) );
+        TEST_ASSERT( map.Find( AString( "Hello" ) )->m_Value == "again" );
+    }
+}
+
+// EraseAndInsertMany
+//------------------------------------------------------------------------------
+void TestFlatHashMap::EraseAndInsertMany() const
+{
+    // Keys come and go at random, with enough entries that groups fill and entries
+    // are placed past their first group, checked against a flag per key
+    const uint32_t numKeys = 8192;
+    Array<bool> present;
+    present.SetSize( numKeys );
+    for ( bool & flag : present )
+    {
+        flag = false;
+    }
+
+    FlatHashMap<uint32_t, uint32_t> map;
+    map.Reserve( numKeys / 4 );
+    const size_t capacity = map.GetCapacity();
+    Random random( 1234 );
+    uint32_t count = 0;
+    for ( uint32_t i = 0; i < 100000; ++i )
+    {
+        const uint32_t key = random.GetRandIndex( numKeys );
+        if ( present[ key ] )
+        {
+            TEST_ASSERT( map.Erase( key ) );
+            present[ key ] = false;
+            --count;
+        }
+        else if ( count < ( capacity * 7 / 8 ) )
+        {
+            map.Insert( key, key * 3 );
+            present[ key ] = true;
+            ++count;
+        }
+    }
+    TEST_ASSERT( map.GetSize() == count );
+    TEST_ASSERT( map.GetCapacity() == capacity ); // Never grew
+    for ( uint32_t key = 0; key < numKeys; ++key )
+    {
+        const auto * pair = map.Find( key );
+        TEST_ASSERT( ( pair != nullptr ) == present[ key ] );
+        TEST_ASSERT( ( pair == nullptr ) || ( pair->m_Value == key * 3 ) );
+    }
+}
+
+// Grow
+//------------------------------------------------------------------------------
+void TestFlatHashMap::Grow() const
+{
+    FlatHashMap<uint32_t, uint32_t> map;
+    for ( uint32_t i = 0; i < 10000; ++i )
+    {
+        map.Insert( i, i + 1 );
+        TEST_ASSERT( map.GetSize() * 8 <= map.GetCapacity() * 7 );
+    }
+    for ( uint32_t i = 0; i < 10000; ++i )
+    {
+        TEST_ASSERT( map.Find( i )->m_Value == i + 1 );
+    }
+    TEST_ASSERT( map.Find( 10000u ) == nullptr );
+}
+
+// Reserve
+//------------------------------------------------------------------------------
+void TestFlatHashMap::Reserve() const
+{
+    FlatHashMap<uint32_t, uint32_t> map;
+    map.Reserve( 1000 );
+    TEST_ASSERT( map.GetCapacity() * 7 / 8 >= 1000 );
+
+    TEST_MEMORY_SNAPSHOT( s1 );
+
+    for ( uint32_t i = 0; i < 1000; ++i )
+    {
+        map.Insert( i, i );
+    }
+
+    TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 ) // No growth or per item allocations
+}
+
+// SmallMapMemory
+//------------------------------------------------------------------------------
+void TestFlatHashMap::SmallMapMemory() const
+{
+    FlatHashMap<uint32_t, uint32_t> map;
+
+    TEST_MEMORY_SNAPSHOT( s1 );
+
+    for ( uint32_t i = 0; i < 10; ++i )
+    {
+        map.Insert( i, i );
+    }
+
+    TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 ) // One group of slots holds them all
+
+    TEST_ASSERT( map.GetCapacity() == 16 );
+    TEST_ASSERT( map.GetMemoryUsage() < 256 );
+}
+
+// Clear
+//------------------------------------------------------------------------------
+void TestFlatHashMap::Clear() const
+{
+    FlatHashMap<AString, AString> map;
+    map.Insert( AString( "Key" ), AString( "Value" ) );
+    const size_t capacity = map.GetCapacity();
+    map.Clear();
+    TEST_ASSERT( map.IsEmpty() );
+    TEST_ASSERT( map.GetCapacity() == capacity );
+    TEST_ASSERT( map.Find( AString( "Key" ) ) == nullptr );
+    map.Insert( AString( "Key" ), AString( "Value" ) );
+    TEST_ASSERT( map.GetSize() == 1 );
+}
+
+// Destruct
+//------------------------------------------------------------------------------
+void TestFlatHashMap::Destruct() const
+{
+    // empty
+    {
+        FlatHashMap<AString, AString> map;
+        map.Destruct();
+        TEST_ASSERT( map.IsEmpty() );
+        TEST_ASSERT( map.GetSize() == 0 );
+    }
+
+    // not empty
+    {
+        FlatHashMap<AString, AString> map;
+        map.Insert( AString( "Key" ), AString( "Value" ) );
+        map.Destruct();
+        TEST_ASSERT( map.IsEmpty() );
+        TEST_ASSERT( map.GetSize() == 0 );
+        TEST_ASSERT( map.GetCapacity() == 0 );
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,308 @@
+// TestFrameArena.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Mem/FrameArena.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AString.h"
+
+// TestFrameArena
+//------------------------------------------------------------------------------
+class TestFrameArena : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void Alignment() const;
+    void Scope() const;
+    void EndFrame() const;
+    void LargeAllocation() const;
+    void FrameArrayGrow() const;
+    void FrameArrayAsArray() const;
+    void FrameArrayMove() const;
+    void FrameArrayNoHeap() const;
+    void SteadyState() const;
+    void Threads() const;
+
+    static void     FillArray( Array< uint32_t > & array, uint32_t count );
+    static uint32_t ThreadFunction_Alloc( void * userData );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestFrameArena )
+    REGISTER_TEST( Alignment )
+    REGISTER_TEST( Scope )
+    REGISTER_TEST( EndFrame )
+    REGISTER_TEST( LargeAllocation )
+    REGISTER_TEST( FrameArrayGrow )
+    REGISTER_TEST( FrameArrayAsArray )
+    REGISTER_TEST( FrameArrayMove )
+    REGISTER_TEST( FrameArrayNoHeap )
+    REGISTER_TEST( SteadyState )
+    REGISTER_TEST( Threads )
+REGISTER_TESTS_END
+
+// Alignment
+//------------------------------------------------------------------------------
+void TestFrameArena::Alignment() const
+{
+    for ( size_t alignment = 1; alignment <= 256; alignment *= 2 )
+    {
+        (void)FrameArena::Alloc( 1, 1 ); // Misalign the next allocation
+        const void * mem = FrameArena::Alloc( 3, alignment );
+        TEST_ASSERT( ( reinterpret_cast< size_t >( mem ) % alignment ) == 0 );
+    }
+    FrameArena::FreeThreadMemory();
+}
+
+// Scope
+//------------------------------------------------------------------------------
+void TestFrameArena::Scope() const
+{
+    void * before = FrameArena::Alloc( 16 );
+    void * inScope;
+    {
+        FrameArenaScope scope;
+        inScope = FrameArena::Alloc( 16 );
+        TEST_ASSERT( inScope != before );
+        {
+            FrameArenaScope innerScope;
+            (void)FrameArena::Alloc( 1024 );
+        }
+        TEST_ASSERT( FrameArena::Alloc( 16 ) != inScope );
+    }
+
+    // Memory allocated in the scope is handed out again
+    TEST_ASSERT( FrameArena::Alloc( 16 ) == inScope );
+
+    // Including when it took the thread onto another chunk
+    {
+        FrameArenaScope scope;
+        (void)FrameArena::Alloc( 1024 * 1024 );
+    }
+    TEST_ASSERT( FrameArena::Alloc( 16 ) == static_cast< char * >( inScope ) + 16 );
+    FrameArena::FreeThreadMemory();
+}
+
+// EndFrame
+//------------------------------------------------------------------------------
+void TestFrameArena::EndFrame() const
+{
+    FrameArena::EndFrame();
+    void * first = FrameArena::Alloc( 100 );
+    (void)FrameArena::Alloc( 100 );
+
+    // Everything is released and the thread starts again from the beginning
+    FrameArena::EndFrame();
+    TEST_ASSERT( FrameArena::Alloc( 100 ) == first );
+
+    // A scope open over the end of a frame doesn't rewind into the next one
+    void * inNextFrame;
+    {
+        FrameArenaScope scope;
+        (void)FrameArena::Alloc( 100 );
+        FrameArena::EndFrame();
+        inNextFrame = FrameArena::Alloc( 100 );
+        TEST_ASSERT( inNextFrame == first );
+    }
+    TEST_ASSERT( FrameArena::Alloc( 100 ) != inNextFrame );
+    FrameArena::FreeThreadMemory();
+}
+
+// LargeAllocation
+//------------------------------------------------------------------------------
+void TestFrameArena::LargeAllocation() const
+{
+    FrameArena::EndFrame();
+    (void)FrameArena::Alloc( 16 );
+    char * mem = static_cast< char * >( FrameArena::Alloc( 1024 * 1024, 64 ) );
+    mem[ 0 ] = 1;
+    mem[ 1024 * 1024 - 1 ] = 1;
+    TEST_ASSERT( FrameArena::GetThreadCapacity() > 1024 * 1024 );
+
+    // A frame that needed several chunks leaves one that holds them all
+    const size_t capacity = FrameArena::GetThreadCapacity();
+    FrameArena::EndFrame();
+    TEST_MEMORY_SNAPSHOT( s1 );
+    (void)FrameArena::Alloc( 16 );
+    TEST_EXPECT_ALLOCATION_EVENTS( s1, 1 )
+    TEST_ASSERT( FrameArena::GetThreadCapacity() == capacity );
+    FrameArena::FreeThreadMemory();
+    TEST_ASSERT( FrameArena::GetThreadCapacity() == 0 );
+}
+
+// FrameArrayGrow
+//------------------------------------------------------------------------------
+void TestFrameArena::FrameArrayGrow() const
+{
+    {
+        FrameArray< AString > strings;
+        for ( uint32_t i = 0; i < 1000; ++i )
+        {
+            AString string;
+            string.Format( "String %u", i );
+            strings.Append( string );
+        }
+        TEST_ASSERT( strings.GetSize() == 1000 );
+        for ( uint32_t i = 0; i < 1000; ++i )
+        {
+            AString string;
+            string.Format( "String %u", i );
+            TEST_ASSERT( strings[ i ] == string );
+        }
+
+        // Copies stay in frame memory too
+        FrameArray< AString > copy( strings );
+        TEST_ASSERT( copy.GetSize() == 1000 );
+        TEST_ASSERT( copy[ 999 ] == "String 999" );
+    }
+    FrameArena::FreeThreadMemory();
+}
+
+// FrameArrayAsArray
+//------------------------------------------------------------------------------
+void TestFrameArena::FrameArrayAsArray() const
+{
+    {
+        FrameArray< uint32_t > array;
+        FillArray( array, 100 );
+        TEST_ASSERT( array.GetSize() == 100 );
+        TEST_ASSERT( array[ 99 ] == 99 );
+    }
+    FrameArena::FreeThreadMemory();
+}
+
+// FrameArrayMove
+//------------------------------------------------------------------------------
+void TestFrameArena::FrameArrayMove() const
+{
+    {
+        FrameArray< AString > strings( 4 );
+        strings.EmplaceBack( "A" );
+        strings.EmplaceBack( "B" );
+
+        // Moving into a heap Array copies the elements out of frame memory
+        Array< AString > heapStrings( Move( strings ) );
+        TEST_ASSERT( heapStrings.GetSize() == 2 );
+        TEST_ASSERT( heapStrings[ 1 ] == "B" );
+        TEST_ASSERT( strings.IsEmpty() );
+
+        // The heap Array outlives the frame
+        FrameArena::EndFrame();
+        (void)FrameArena::Alloc( 64 );
+        TEST_ASSERT( heapStrings[ 0 ] == "A" );
+    }
+    FrameArena::FreeThreadMemory();
+}
+
+// FrameArrayNoHeap
+//------------------------------------------------------------------------------
+void TestFrameArena::FrameArrayNoHeap() const
+{
+    // The first frame grows the thread's memory and the next gathers it into one chunk.
+    // After that, filling, growing and copying frame arrays within a scope doesn't touch
+    // the heap.
+    for ( uint32_t frame = 0; frame < 4; ++frame )
+    {
+        TEST_MEMORY_SNAPSHOT( s1 );
+        {
+            FrameArenaScope scope;
+            FrameArray< uint32_t > array;
+            FillArray( array, 20000 );
+            array.SetCapacity( 30000 );
+            array.SetSize( 30000 );
+            FrameArray< uint32_t > copy( array );
+            TEST_ASSERT( copy.GetSize() == 30000 );
+            TEST_ASSERT( copy[ 19999 ] == 19999 );
+        }
+        if ( frame > 1 )
+        {
+            TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+        }
+        FrameArena::EndFrame();
+    }
+    FrameArena::FreeThreadMemory();
+}
+
+// SteadyState
+//------------------------------------------------------------------------------
+void TestFrameArena::SteadyState() const
+{
+    // Once the thread's memory has grown to what a frame needs, frames don't allocate
+    // from the heap, even if the first needed several chunks
+    for ( uint32_t frame = 0; frame < 10; ++frame )
+    {
+        TEST_MEMORY_SNAPSHOT( s1 );
+        for ( uint32_t query = 0; query < 10; ++query )
+        {
+            FrameArenaScope scope;
+            FrameArray< uint32_t > array;
+            FillArray( array, 10000 );
+            FrameArray< uint64_t > other( 100 );
+            other.SetSize( 100 );
+        }
+        FrameArray< uint32_t > array;
+        FillArray( array, 50000 );
+        if ( frame > 1 )
+        {
+            TEST_EXPECT_ALLOCATION_EVENTS( s1, 0 )
+        }
+        FrameArena::EndFrame();
+    }
+    FrameArena::FreeThreadMemory();
+}
+
+// Threads
+//------------------------------------------------------------------------------
+void TestFrameArena::Threads() const
+{
+    // Each thread allocates from its own memory, freed when the thread exits
+    void * mem = FrameArena::Alloc( 16 );
+    void * threadMem[ 4 ] = {};
+    Thread::ThreadHandle handles[ 4 ];
+    for ( size_t i = 0; i < 4; ++i )
+    {
+        handles[ i ] = Thread::CreateThread( ThreadFunction_Alloc, "FrameArena", ( 64 * KILOBYTE ), (void*)&threadMem[ i ] );
+        TEST_ASSERT( handles[ i ] != INVALID_THREAD_HANDLE );
+    }
+    for ( size_t i = 0; i < 4; ++i )
+    {
+        bool timedOut;
+        Thread::WaitForThread( handles[ i ], 500 * 1000, timedOut );
+        Thread::CloseHandle( handles[ i ] );
+        TEST_ASSERT( timedOut == false );
+        TEST_ASSERT( threadMem[ i ] != nullptr );
+        TEST_ASSERT( threadMem[ i ] != mem );
+    }
+    FrameArena::FreeThreadMemory();
+}
+
+// FillArray
+//------------------------------------------------------------------------------
+/*static*/ void TestFrameArena::FillArray( Array< uint32_t > & array, uint32_t count )
+{
+    for ( uint32_t i = 0; i < count; ++i )
+    {
+        array.Append( i );
+    }
+}
+
+// ThreadFunction_Alloc
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestFrameArena::ThreadFunction_Alloc( void * userData )
+{
+    uint32_t * mem = static_cast< uint32_t * >( FrameArena::Alloc( 1024 * sizeof( uint32_t ) ) );
+    for ( uint32_t i = 0; i < 1024; ++i )
+    {
+        mem[ i ] = i;
+    }
+    *static_cast< void ** >( userData ) = mem;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,213 @@
+// TestLargePages.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Mem/LargePages.h"
+
+#include <string.h>
+
+// TestLargePages
+//------------------------------------------------------------------------------
+class TestLargePages : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void SmallAllocation() const;
+    void LargeAllocation() const;
+    void ReserveAndCommit() const;
+    void ExplicitPool() const;
+    void Stats() const;
+    void LargePageArrayGrow() const;
+    void LargePageArrayCopyAndMove() const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestLargePages )
+    REGISTER_TEST( SmallAllocation )
+    REGISTER_TEST( LargeAllocation )
+    REGISTER_TEST( ReserveAndCommit )
+    REGISTER_TEST( ExplicitPool )
+    REGISTER_TEST( Stats )
+    REGISTER_TEST( LargePageArrayGrow )
+    REGISTER_TEST( LargePageArrayCopyAndMove )
+REGISTER_TESTS_END
+
+// SmallAllocation
+//------------------------------------------------------------------------------
+void TestLargePages::SmallAllocation() const
+{
+    // Memory smaller than a large page comes from the heap
+    LargePages::Stats before;
+    LargePages::GetStats( before );
+    void * mem = LargePages::Alloc( 1000, 64 );
+    TEST_ASSERT( ( (size_t)mem % 64 ) == 0 );
+    memset( mem, 0xAB, 1000 );
+    LargePages::Stats after;
+    LargePages::GetStats( after );
+    TEST_ASSERT( after.m_NumRegions == before.m_NumRegions );
+    LargePages::Free( mem );
+    LargePages::Free( nullptr );
+}
+
+// LargeAllocation
+//------------------------------------------------------------------------------
+void TestLargePages::LargeAllocation() const
+{
+    LargePages::Stats before;
+    LargePages::GetStats( before );
+
+    // Starts on a large page, and is usable to the end of the requested size
+    const size_t size = ( 3 * LargePages::LARGE_PAGE_SIZE ) + 100;
+    char * mem = static_cast< char * >( LargePages::Alloc( size ) );
+    TEST_ASSERT( ( (size_t)mem % LargePages::LARGE_PAGE_SIZE ) == 0 );
+    memset( mem, 0xAB, size );
+    TEST_ASSERT( mem[ size - 1 ] == (char)0xAB );
+
+    LargePages::Stats during;
+    LargePages::GetStats( during );
+    TEST_ASSERT( during.m_NumRegions == ( before.m_NumRegions + 1 ) );
+    TEST_ASSERT( during.m_MappedBytes >= ( before.m_MappedBytes + size ) );
+
+    LargePages::Free( mem );
+    LargePages::Stats after;
+    LargePages::GetStats( after );
+    TEST_ASSERT( after.m_NumRegions == before.m_NumRegions );
+    TEST_ASSERT( after.m_MappedBytes == before.m_MappedBytes );
+}
+
+// ReserveAndCommit
+//------------------------------------------------------------------------------
+void TestLargePages::ReserveAndCommit() const
+{
+    // Reserve more than is used, and commit parts of it as they're needed
+    const size_t size = ( 64 * LargePages::LARGE_PAGE_SIZE );
+    char * mem = static_cast< char * >( LargePages::Reserve( size ) );
+    TEST_ASSERT( mem );
+    TEST_ASSERT( ( (size_t)mem % LargePages::LARGE_PAGE_SIZE ) == 0 );
+
+    // A part in the middle of a large page commits the whole page
+    LargePages::Commit( mem + 4096, 100 );
+    memset( mem, 1, LargePages::LARGE_PAGE_SIZE );
+    LargePages::Commit( mem + ( 10 * LargePages::LARGE_PAGE_SIZE ) - 100, 200 );
+    memset( mem + ( 9 * LargePages::LARGE_PAGE_SIZE ), 2, 2 * LargePages::LARGE_PAGE_SIZE );
+
+    // Committing memory again is fine
+    LargePages::Commit( mem, LargePages::LARGE_PAGE_SIZE );
+    TEST_ASSERT( mem[ 0 ] == 1 );
+    TEST_ASSERT( mem[ ( 11 * LargePages::LARGE_PAGE_SIZE ) - 1 ] == 2 );
+
+    LargePages::Free( mem );
+}
+
+// ExplicitPool
+//------------------------------------------------------------------------------
+void TestLargePages::ExplicitPool() const
+{
+    // Whether or not the system has huge pages set aside, allocations succeed
+    LargePages::SetUseExplicitPool( true );
+    const size_t size = ( 2 * LargePages::LARGE_PAGE_SIZE ) + 1;
+    char * mem = static_cast< char * >( LargePages::Alloc( size ) );
+    LargePages::SetUseExplicitPool( false );
+    TEST_ASSERT( ( (size_t)mem % LargePages::LARGE_PAGE_SIZE ) == 0 );
+    memset( mem, 0xAB, size );
+
+    LargePages::Stats stats;
+    LargePages::GetStats( stats );
+    TEST_ASSERT( stats.m_ExplicitBytes <= stats.m_LargePageBytes );
+    LargePages::Free( mem );
+}
+
+// Stats
+//------------------------------------------------------------------------------
+void TestLargePages::Stats() const
+{
+    LargePages::Stats before;
+    LargePages::GetStats( before );
+
+    const size_t size = ( 8 * LargePages::LARGE_PAGE_SIZE );
+    char * mem = static_cast< char * >( LargePages::Alloc( size ) );
+    memset( mem, 0xAB, size );
+
+    LargePages::Stats stats;
+    LargePages::GetStats( stats );
+    TEST_ASSERT( stats.m_LargePageBytes <= stats.m_MappedBytes );
+    #if defined( __LINUX__ )
+        // Whether huge pages are used depends on the system, but the memory is resident
+        TEST_ASSERT( stats.m_ResidentBytes >= ( before.m_ResidentBytes + size ) );
+        TEST_ASSERT( stats.m_LargePageBytes <= stats.m_ResidentBytes );
+    #endif
+
+    LargePages::Free( mem );
+}
+
+// LargePageArrayGrow
+//------------------------------------------------------------------------------
+void TestLargePages::LargePageArrayGrow() const
+{
+    LargePages::Stats before;
+    LargePages::GetStats( before );
+    {
+        // Grows from the heap into large page memory, keeping its elements
+        LargePageArray< uint32_t > array;
+        const uint32_t count = (uint32_t)( ( 3 * LargePages::LARGE_PAGE_SIZE ) / sizeof( uint32_t ) );
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            array.Append( i );
+        }
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            TEST_ASSERT( array[ i ] == i );
+        }
+        LargePages::Stats during;
+        LargePages::GetStats( during );
+        TEST_ASSERT( during.m_NumRegions == ( before.m_NumRegions + 1 ) );
+
+        // Usable as an Array
+        Array< uint32_t > & asArray = array;
+        asArray.SetSize( 10 );
+        TEST_ASSERT( asArray[ 9 ] == 9 );
+    }
+    LargePages::Stats after;
+    LargePages::GetStats( after );
+    TEST_ASSERT( after.m_NumRegions == before.m_NumRegions );
+}
+
+// LargePageArrayCopyAndMove
+//------------------------------------------------------------------------------
+void TestLargePages::LargePageArrayCopyAndMove() const
+{
+    LargePages::Stats before;
+    LargePages::GetStats( before );
+    {
+        LargePageArray< uint64_t > array( LargePages::LARGE_PAGE_SIZE / sizeof( uint64_t ) );
+        array.SetSize( array.GetCapacity() );
+        for ( size_t i = 0; i < array.GetSize(); ++i )
+        {
+            array[ i ] = i;
+        }
+
+        // A copy has large page memory of its own
+        const LargePageArray< uint64_t > copy( array );
+        TEST_ASSERT( copy.GetSize() == array.GetSize() );
+        TEST_ASSERT( copy[ 100 ] == 100 );
+        LargePages::Stats stats;
+        LargePages::GetStats( stats );
+        TEST_ASSERT( stats.m_NumRegions == ( before.m_NumRegions + 2 ) );
+
+        // Moving into an Array takes the memory, which it frees
+        Array< uint64_t > moved( Move( array ) );
+        TEST_ASSERT( moved[ 100 ] == 100 );
+        TEST_ASSERT( array.IsEmpty() );
+    }
+    LargePages::Stats after;
+    LargePages::GetStats( after );
+    TEST_ASSERT( after.m_NumRegions == before.m_NumRegions );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,404 @@
+// TestMemStats.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+#include "Core/Mem/LargePages.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Mem/MemStats.h"
+#include "Core/Process/Thread.h"
+
+#include <string.h>
+
+// TestMemStats
+//------------------------------------------------------------------------------
+class TestMemStats : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void Categories() const;
+    void CountAllocations() const;
+    void Scopes() const;
+    void ReallocKeepsCategory() const;
+    void ReallocKeepsContents() const;
+    void ManyAlignedAllocations() const;
+    void PeaksAndBudgets() const;
+    void LargePageAllocations() const;
+    void FreeOnAnotherThread() const;
+    void FlushInBatches() const;
+
+    static uint32_t ThreadFunction_Alloc( void * userData );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestMemStats )
+    REGISTER_TEST( Categories )
+    REGISTER_TEST( CountAllocations )
+    REGISTER_TEST( Scopes )
+    REGISTER_TEST( ReallocKeepsCategory )
+    REGISTER_TEST( ReallocKeepsContents )
+    REGISTER_TEST( ManyAlignedAllocations )
+    REGISTER_TEST( PeaksAndBudgets )
+    REGISTER_TEST( LargePageAllocations )
+    REGISTER_TEST( FreeOnAnotherThread )
+    REGISTER_TEST( FlushInBatches )
+REGISTER_TESTS_END
+
+namespace
+{
+    // Counted so far on this thread
+    uint64_t GetBytes( uint8_t category )
+    {
+        MemStats::FlushThreadCounters();
+        MemStats::CategoryStats stats;
+        MemStats::GetStats( category, stats );
+        return stats.m_Bytes;
+    }
+
+    uint64_t GetNumAllocs( uint8_t category )
+    {
+        MemStats::FlushThreadCounters();
+        MemStats::CategoryStats stats;
+        MemStats::GetStats( category, stats );
+        return stats.m_NumAllocs;
+    }
+}
+
+// Categories
+//------------------------------------------------------------------------------
+void TestMemStats::Categories() const
+{
+    const uint8_t a = MemStats::GetCategory( "TestMemStats A" );
+    const uint8_t b = MemStats::GetCategory( "TestMemStats B" );
+    TEST_ASSERT( a != MemStats::DEFAULT_CATEGORY );
+    TEST_ASSERT( b != MemStats::DEFAULT_CATEGORY );
+    TEST_ASSERT( a != b );
+
+    // Found by name, even when the name is another copy of it
+    char name[ 32 ];
+    strcpy( name, "TestMemStats A" );
+    TEST_ASSERT( MemStats::GetCategory( name ) == a );
+    TEST_ASSERT( MemStats::GetNumCategories() > b );
+
+    MemStats::CategoryStats stats;
+    MemStats::GetStats( b, stats );
+    TEST_ASSERT( strcmp( stats.m_Name, "TestMemStats B" ) == 0 );
+    MemStats::GetStats( MemStats::DEFAULT_CATEGORY, stats );
+    TEST_ASSERT( strcmp( stats.m_Name, "Other" ) == 0 );
+}
+
+// CountAllocations
+//------------------------------------------------------------------------------
+void TestMemStats::CountAllocations() const
+{
+    const uint8_t category = MemStats::GetCategory( "TestMemStats A" );
+    const uint64_t bytes = GetBytes( category );
+    const uint64_t numAllocs = GetNumAllocs( category );
+
+    void * small;
+    void * aligned;
+    void * pageAligned;
+    {
+        const MemCategoryScope scope( category );
+        small = ALLOC( 100 );
+        aligned = ALLOC( 1000, 64 );
+        pageAligned = ALLOC( 64 * KILOBYTE, 64 * KILOBYTE );
+    }
+    TEST_ASSERT( ( (size_t)aligned % 64 ) == 0 );
+    TEST_ASSERT( ( (size_t)pageAligned % ( 64 * KILOBYTE ) ) == 0 );
+    memset( small, 1, 100 );
+    memset( aligned, 2, 1000 );
+    memset( pageAligned, 3, 64 * KILOBYTE );
+    TEST_ASSERT( GetMemCategory( small ) == category );
+    TEST_ASSERT( GetMemCategory( pageAligned ) == category );
+
+    // Counted in the requested sizes
+    TEST_ASSERT( GetBytes( category ) == ( bytes + 100 + 1000 + ( 64 * KILOBYTE ) ) );
+    TEST_ASSERT( GetNumAllocs( category ) == ( numAllocs + 3 ) );
+
+    // Freeing outside the scope counts them out of the category they were made in
+    FREE( small );
+    FREE( aligned );
+    FREE( pageAligned );
+    TEST_ASSERT( GetBytes( category ) == bytes );
+    TEST_ASSERT( GetNumAllocs( category ) == numAllocs );
+}
+
+// Scopes
+//------------------------------------------------------------------------------
+void TestMemStats::Scopes() const
+{
+    const uint8_t a = MemStats::GetCategory( "TestMemStats A" );
+    const uint8_t b = MemStats::GetCategory( "TestMemStats B" );
+    const uint8_t previous = MemStats::GetCurrentCategory();
+    {
+        const MemCategoryScope scopeA( a );
+        TEST_ASSERT( MemStats::GetCurrentCategory() == a );
+        {
+            const MemCategoryScope scopeB( b );
+            TEST_ASSERT( MemStats::GetCurrentCategory() == b );
+            void * mem = ALLOC( 16 );
+            TEST_ASSERT( GetMemCategory( mem ) == b );
+            FREE( mem );
+        }
+        TEST_ASSERT( MemStats::GetCurrentCategory() == a );
+    }
+    TEST_ASSERT( MemStats::GetCurrentCategory() == previous );
+}
+
+// ReallocKeepsCategory
+//------------------------------------------------------------------------------
+void TestMemStats::ReallocKeepsCategory() const
+{
+    const uint8_t category = MemStats::GetCategory( "TestMemStats A" );
+    const uint64_t bytes = GetBytes( category );
+
+    // Small, grown past the small block allocator, and grown in place or remapped
+    void * mem;
+    {
+        const MemCategoryScope scope( category );
+        mem = ALLOC( 16, 16 );
+    }
+    memset( mem, 0xAB, 16 );
+    const size_t sizes[] = { 16, 1000, 100 * KILOBYTE, 4 * MEGABYTE, 100 };
+    for ( size_t i = 1; i < ( sizeof( sizes ) / sizeof( sizes[ 0 ] ) ); ++i )
+    {
+        mem = REALLOC( mem, sizes[ i - 1 ], sizes[ i ], 16 );
+        TEST_ASSERT( ( (size_t)mem % 16 ) == 0 );
+        TEST_ASSERT( static_cast< uint8_t * >( mem )[ 15 ] == 0xAB );
+        TEST_ASSERT( GetMemCategory( mem ) == category );
+        TEST_ASSERT( GetBytes( category ) == ( bytes + sizes[ i ] ) );
+    }
+    FREE( mem );
+    TEST_ASSERT( GetBytes( category ) == bytes );
+}
+
+// ReallocKeepsContents
+//------------------------------------------------------------------------------
+void TestMemStats::ReallocKeepsContents() const
+{
+    // Heap blocks can move to either side of a 32 byte boundary as they grow, and the
+    // allocation moves with them
+    const uint8_t category = MemStats::GetCategory( "TestMemStats A" );
+    const uint64_t bytes = GetBytes( category );
+    size_t size = 300;
+    uint8_t * mem;
+    {
+        const MemCategoryScope scope( category );
+        mem = static_cast< uint8_t * >( ALLOC( size ) );
+    }
+    for ( size_t i = 0; i < size; ++i )
+    {
+        mem[ i ] = (uint8_t)i;
+    }
+    for ( uint32_t step = 0; step < 40; ++step )
+    {
+        const size_t newSize = ( size + 257 + ( step * 1000 ) );
+        mem = static_cast< uint8_t * >( REALLOC( mem, size, newSize, sizeof( void * ) ) );
+        TEST_ASSERT( ( (size_t)mem % 16 ) == 0 );
+        for ( size_t i = 0; i < size; ++i )
+        {
+            TEST_ASSERT( mem[ i ] == (uint8_t)i );
+        }
+        for ( size_t i = size; i < newSize; ++i )
+        {
+            mem[ i ] = (uint8_t)i;
+        }
+        size = newSize;
+        TEST_ASSERT( GetMemCategory( mem ) == category );
+    }
+    TEST_ASSERT( GetBytes( category ) == ( bytes + size ) );
+    FREE( mem );
+    TEST_ASSERT( GetBytes( category ) == bytes );
+}
+
+// ManyAlignedAllocations
+//------------------------------------------------------------------------------
+void TestMemStats::ManyAlignedAllocations() const
+{
+    // Allocations aligned to more than 16 bytes are recorded in a table rather than by a
+    // header, and are found whatever order they're freed in
+    const uint8_t category = MemStats::GetCategory( "TestMemStats B" );
+    const uint64_t bytes = GetBytes( category );
+    const uint32_t numAllocs = 1000;
+    void * mems[ numAllocs ];
+    {
+        const MemCategoryScope scope( category );
+        for ( uint32_t i = 0; i < numAllocs; ++i )
+        {
+            const size_t alignment = ( (size_t)32 << ( i % 8 ) );
+            mems[ i ] = ALLOC( i, alignment );
+            TEST_ASSERT( ( (size_t)mems[ i ] % alignment ) == 0 );
+        }
+    }
+    for ( uint32_t i = 0; i < numAllocs; ++i )
+    {
+        memset( mems[ i ], (int)i, i );
+        TEST_ASSERT( GetMemCategory( mems[ i ] ) == category );
+    }
+    TEST_ASSERT( GetBytes( category ) == ( bytes + ( ( numAllocs * ( numAllocs - 1 ) ) / 2 ) ) );
+    for ( uint32_t i = 0; i < numAllocs; i += 2 )
+    {
+        FREE( mems[ i ] );
+    }
+    for ( uint32_t i = 1; i < numAllocs; i += 2 )
+    {
+        FREE( mems[ i ] );
+    }
+    TEST_ASSERT( GetBytes( category ) == bytes );
+}
+
+// PeaksAndBudgets
+//------------------------------------------------------------------------------
+void TestMemStats::PeaksAndBudgets() const
+{
+    const uint8_t category = MemStats::GetCategory( "TestMemStats Peaks" );
+    MemStats::ResetPeaks();
+    MemStats::SetBudget( category, 10000 );
+
+    void * a;
+    void * b;
+    {
+        const MemCategoryScope scope( category );
+        a = ALLOC( 8000 );
+        b = ALLOC( 4000 );
+    }
+    MemStats::FlushThreadCounters(); // Over budget, which warns
+    FREE( b );
+    MemStats::FlushThreadCounters();
+
+    MemStats::CategoryStats stats;
+    MemStats::GetStats( category, stats );
+    TEST_ASSERT( stats.m_Bytes == 8000 );
+    TEST_ASSERT( stats.m_PeakBytes == 12000 );
+    TEST_ASSERT( stats.m_TotalAllocs == 2 );
+    TEST_ASSERT( stats.m_Budget == 10000 );
+
+    // The high-water mark starts again from what's allocated
+    MemStats::ResetPeaks();
+    MemStats::GetStats( category, stats );
+    TEST_ASSERT( stats.m_PeakBytes == 8000 );
+    FREE( a );
+    MemStats::FlushThreadCounters();
+    MemStats::GetStats( category, stats );
+    TEST_ASSERT( stats.m_PeakBytes == 8000 );
+    TEST_ASSERT( stats.m_NumAllocs == 0 );
+}
+
+// LargePageAllocations
+//------------------------------------------------------------------------------
+void TestMemStats::LargePageAllocations() const
+{
+    const uint8_t category = MemStats::GetCategory( "TestMemStats A" );
+    const uint64_t bytes = GetBytes( category );
+    void * mem;
+    void * reserved;
+    {
+        const MemCategoryScope scope( category );
+        mem = LargePages::Alloc( LargePages::LARGE_PAGE_SIZE );
+        reserved = LargePages::Reserve( 4 * LargePages::LARGE_PAGE_SIZE );
+    }
+
+    // What's reserved isn't allocated yet
+    TEST_ASSERT( GetBytes( category ) >= ( bytes + LargePages::LARGE_PAGE_SIZE ) );
+    TEST_ASSERT( GetBytes( category ) < ( bytes + ( 2 * LargePages::LARGE_PAGE_SIZE ) ) );
+    LargePages::Free( mem );
+    LargePages::Free( reserved );
+    TEST_ASSERT( GetBytes( category ) == bytes );
+}
+
+// FreeOnAnotherThread
+//------------------------------------------------------------------------------
+void TestMemStats::FreeOnAnotherThread() const
+{
+    // Threads don't inherit the category, so each sets its own
+    const uint8_t category = MemStats::GetCategory( "TestMemStats Threads" );
+
+    const uint32_t numThreads = 4;
+    void * allocs[ numThreads ][ 1000 ];
+    Thread::ThreadHandle handles[ numThreads ];
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        handles[ i ] = Thread::CreateThread( ThreadFunction_Alloc, "TestMemStats", ( 64 * KILOBYTE ), allocs[ i ] );
+        TEST_ASSERT( handles[ i ] != INVALID_THREAD_HANDLE );
+    }
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        bool timedOut;
+        Thread::WaitForThread( handles[ i ], 10 * 1000, timedOut );
+        Thread::CloseHandle( handles[ i ] );
+        TEST_ASSERT( timedOut == false );
+    }
+    TEST_ASSERT( GetBytes( category ) == ( numThreads * 1000 * 24 ) );
+    TEST_ASSERT( GetNumAllocs( category ) == ( numThreads * 1000 ) );
+
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        for ( void * mem : allocs[ i ] )
+        {
+            FREE( mem );
+        }
+    }
+    TEST_ASSERT( GetBytes( category ) == 0 );
+    TEST_ASSERT( GetNumAllocs( category ) == 0 );
+}
+
+// FlushInBatches
+//------------------------------------------------------------------------------
+void TestMemStats::FlushInBatches() const
+{
+    const uint8_t category = MemStats::GetCategory( "TestMemStats Batches" );
+    MemStats::FlushThreadCounters();
+    MemStats::CategoryStats stats;
+
+    // Small allocations are added to the totals in batches
+    void * allocs[ MemStats::FLUSH_ALLOCS ];
+    {
+        const MemCategoryScope scope( category );
+        for ( int64_t i = 0; i < ( MemStats::FLUSH_ALLOCS - 1 ); ++i )
+        {
+            allocs[ i ] = ALLOC( 8 );
+        }
+        MemStats::GetStats( category, stats );
+        TEST_ASSERT( stats.m_NumAllocs == 0 );
+        allocs[ MemStats::FLUSH_ALLOCS - 1 ] = ALLOC( 8 );
+    }
+    MemStats::GetStats( category, stats );
+    TEST_ASSERT( stats.m_NumAllocs == MemStats::FLUSH_ALLOCS );
+    TEST_ASSERT( stats.m_Bytes == ( MemStats::FLUSH_ALLOCS * 8 ) );
+
+    // Large ones straight away
+    void * large;
+    {
+        const MemCategoryScope scope( category );
+        large = ALLOC( MemStats::FLUSH_BYTES );
+    }
+    MemStats::GetStats( category, stats );
+    TEST_ASSERT( stats.m_Bytes == ( ( MemStats::FLUSH_ALLOCS * 8 ) + MemStats::FLUSH_BYTES ) );
+
+    FREE( large );
+    for ( void * mem : allocs )
+    {
+        FREE( mem );
+    }
+    TEST_ASSERT( GetBytes( category ) == 0 );
+}
+
+// ThreadFunction_Alloc
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestMemStats::ThreadFunction_Alloc( void * userData )
+{
+    void ** allocs = static_cast< void ** >( userData );
+    const MemCategoryScope scope( MemStats::GetCategory( "TestMemStats Threads" ) );
+    for ( uint32_t i = 0; i < 1000; ++i )
+    {
+        allocs[ i ] = ALLOC( 24 );
+    }
+    return 0; // Counts are flushed as the thread exits
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,323 @@
+// TestObjectPool.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Mem/ObjectPool.h"
+#include "Core/Process/Thread.h"
+
+// TestObjectPool
+//------------------------------------------------------------------------------
+class TestObjectPool : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void CreateAndDestroy() const;
+    void StableAddresses() const;
+    void ForEachInAddressOrder() const;
+    void ReleaseEmptyPages() const;
+    void Alignment() const;
+    void ThreadCaches() const;
+
+    static uint32_t ThreadFunction_CreateAndDestroy( void * userData );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestObjectPool )
+    REGISTER_TEST( CreateAndDestroy )
+    REGISTER_TEST( StableAddresses )
+    REGISTER_TEST( ForEachInAddressOrder )
+    REGISTER_TEST( ReleaseEmptyPages )
+    REGISTER_TEST( Alignment )
+    REGISTER_TEST( ThreadCaches )
+REGISTER_TESTS_END
+
+namespace
+{
+    // Counts how many are alive
+    class PooledObject
+    {
+    public:
+        explicit PooledObject( uint32_t value ) : m_Value( value ) { ++s_NumAlive; }
+        ~PooledObject() { --s_NumAlive; }
+
+        uint32_t        m_Value;
+        uint32_t        m_Padding[ 7 ] = {};
+
+        static uint32_t s_NumAlive;
+    };
+    /*static*/ uint32_t PooledObject::s_NumAlive = 0;
+
+    PRAGMA_DISABLE_PUSH_MSVC( 4324 ) // structure was padded due to alignment specifier
+    struct alignas( 64 ) AlignedObject
+    {
+        char m_Data[ 8 ];
+    };
+    PRAGMA_DISABLE_POP_MSVC // 4324
+
+    struct ThreadCacheTest
+    {
+        ObjectPool< uint64_t > *    m_Pool;
+        uint64_t                    m_ThreadIndex;
+        Array< uint64_t * > *       m_Kept;     // Objects created on this thread and kept
+        Array< uint64_t * > *       m_ToDestroy; // Objects another thread created, to destroy on this one
+    };
+}
+
+// CreateAndDestroy
+//------------------------------------------------------------------------------
+void TestObjectPool::CreateAndDestroy() const
+{
+    {
+        ObjectPool< PooledObject > pool;
+        PooledObject * a = pool.Create( 1u );
+        PooledObject * b = pool.Create( 2u );
+        TEST_ASSERT( PooledObject::s_NumAlive == 2 );
+        TEST_ASSERT( a->m_Value == 1 );
+        TEST_ASSERT( b->m_Value == 2 );
+        TEST_ASSERT( pool.IsLive( a ) && pool.IsLive( b ) );
+
+        pool.Destroy( a );
+        TEST_ASSERT( PooledObject::s_NumAlive == 1 );
+        TEST_ASSERT( pool.IsLive( a ) == false );
+
+        // The freed block is reused
+        PooledObject * c = pool.Create( 3u );
+        TEST_ASSERT( c == a );
+        TEST_ASSERT( pool.GetNumPages() == 1 );
+
+        // Destroying the pool destroys what's left
+    }
+    TEST_ASSERT( PooledObject::s_NumAlive == 0 );
+}
+
+// StableAddresses
+//------------------------------------------------------------------------------
+void TestObjectPool::StableAddresses() const
+{
+    ObjectPool< PooledObject > pool;
+    Array< PooledObject * > objects;
+    for ( uint32_t i = 0; i < 10000; ++i )
+    {
+        objects.Append( pool.Create( i ) );
+    }
+    TEST_ASSERT( pool.GetNumPages() > 1 );
+
+    // Growing the pool and destroying other objects doesn't move any
+    for ( uint32_t i = 0; i < 10000; i += 2 )
+    {
+        pool.Destroy( objects[ i ] );
+    }
+    for ( uint32_t i = 0; i < 20000; ++i )
+    {
+        (void)pool.Create( i );
+    }
+    for ( uint32_t i = 1; i < 10000; i += 2 )
+    {
+        TEST_ASSERT( objects[ i ]->m_Value == i );
+    }
+
+    pool.Clear();
+    TEST_ASSERT( PooledObject::s_NumAlive == 0 );
+}
+
+// ForEachInAddressOrder
+//------------------------------------------------------------------------------
+void TestObjectPool::ForEachInAddressOrder() const
+{
+    ObjectPool< PooledObject > pool;
+    Array< PooledObject * > objects;
+    for ( uint32_t i = 0; i < 10000; ++i )
+    {
+        objects.Append( pool.Create( i ) );
+    }
+    for ( uint32_t i = 0; i < 10000; i += 3 )
+    {
+        pool.Destroy( objects[ i ] );
+    }
+
+    // Each remaining object is visited once, in address order
+    uint32_t numVisited = 0;
+    const PooledObject * previous = nullptr;
+    uint64_t sum = 0;
+    pool.ForEach( [ & ]( PooledObject & object )
+    {
+        TEST_ASSERT( &object > previous );
+        TEST_ASSERT( ( object.m_Value % 3 ) != 0 );
+        previous = &object;
+        sum += object.m_Value;
+        ++numVisited;
+    } );
+    TEST_ASSERT( numVisited == PooledObject::s_NumAlive );
+    uint64_t expectedSum = 0;
+    for ( uint32_t i = 0; i < 10000; ++i )
+    {
+        expectedSum += ( ( i % 3 ) != 0 ) ? i : 0;
+    }
+    TEST_ASSERT( sum == expectedSum );
+
+    // Objects can be destroyed as they're visited
+    const ObjectPool< PooledObject > & constPool = pool;
+    pool.ForEach( [ & ]( PooledObject & object )
+    {
+        if ( object.m_Value & 1 )
+        {
+            pool.Destroy( &object );
+        }
+    } );
+    constPool.ForEach( [ & ]( const PooledObject & object )
+    {
+        TEST_ASSERT( ( object.m_Value & 1 ) == 0 );
+    } );
+}
+
+// ReleaseEmptyPages
+//------------------------------------------------------------------------------
+void TestObjectPool::ReleaseEmptyPages() const
+{
+    ObjectPool< PooledObject > pool;
+    Array< PooledObject * > objects;
+    for ( uint32_t i = 0; i < 10000; ++i )
+    {
+        objects.Append( pool.Create( i ) );
+    }
+    const size_t numPages = pool.GetNumPages();
+    TEST_ASSERT( numPages >= 3 );
+    TEST_ASSERT( pool.ReleaseEmptyPages() == 0 );
+
+    // Empty every page but the one holding the last object
+    for ( uint32_t i = 0; i < 9999; ++i )
+    {
+        pool.Destroy( objects[ i ] );
+    }
+    TEST_ASSERT( pool.ReleaseEmptyPages() == ( numPages - 1 ) );
+    TEST_ASSERT( pool.GetNumPages() == 1 );
+    TEST_ASSERT( objects[ 9999 ]->m_Value == 9999 );
+
+    // The remaining page's free blocks are used before new pages are made
+    for ( uint32_t i = 0; i < 100; ++i )
+    {
+        (void)pool.Create( i );
+    }
+    TEST_ASSERT( pool.GetNumPages() == 1 );
+
+    // And everything can be released
+    pool.Clear();
+    TEST_ASSERT( pool.ReleaseEmptyPages() == 1 );
+    TEST_ASSERT( pool.GetNumPages() == 0 );
+    (void)pool.Create( 1u );
+    TEST_ASSERT( pool.GetNumPages() == 1 );
+}
+
+// Alignment
+//------------------------------------------------------------------------------
+void TestObjectPool::Alignment() const
+{
+    {
+        ObjectPool< AlignedObject > pool;
+        for ( uint32_t i = 0; i < 2000; ++i )
+        {
+            const AlignedObject * object = pool.Create();
+            TEST_ASSERT( ( (size_t)object % 64 ) == 0 );
+        }
+    }
+
+    // Objects smaller than a pointer
+    {
+        ObjectPool< uint8_t > pool;
+        Array< uint8_t * > objects;
+        for ( uint32_t i = 0; i < 20000; ++i )
+        {
+            objects.Append( pool.Create( (uint8_t)i ) );
+        }
+        for ( uint32_t i = 0; i < 20000; ++i )
+        {
+            TEST_ASSERT( *objects[ i ] == (uint8_t)i );
+        }
+    }
+}
+
+// ThreadCaches
+//------------------------------------------------------------------------------
+void TestObjectPool::ThreadCaches() const
+{
+    const uint32_t numThreads = 4;
+    ObjectPool< uint64_t > pool( true );
+    Array< uint64_t * > kept[ numThreads ];
+    Array< uint64_t * > toDestroy[ numThreads ];
+    ThreadCacheTest tests[ numThreads ];
+    for ( uint32_t round = 0; round < 2; ++round )
+    {
+        // Each thread creates objects, some of them destroyed on the same thread and some
+        // in the next round by another thread
+        Thread::ThreadHandle handles[ numThreads ];
+        for ( uint32_t i = 0; i < numThreads; ++i )
+        {
+            tests[ i ].m_Pool = &pool;
+            tests[ i ].m_ThreadIndex = i;
+            tests[ i ].m_Kept = &kept[ i ];
+            tests[ i ].m_ToDestroy = &toDestroy[ i ];
+            handles[ i ] = Thread::CreateThread( ThreadFunction_CreateAndDestroy, "ObjectPool", ( 64 * KILOBYTE ), &tests[ i ] );
+            TEST_ASSERT( handles[ i ] != INVALID_THREAD_HANDLE );
+        }
+        for ( uint32_t i = 0; i < numThreads; ++i )
+        {
+            bool timedOut;
+            Thread::WaitForThread( handles[ i ], 10 * 1000, timedOut );
+            Thread::CloseHandle( handles[ i ] );
+            TEST_ASSERT( timedOut == false );
+        }
+
+        // Only the kept objects are left, with the values they were created with
+        uint32_t numVisited = 0;
+        pool.ForEach( [ & ]( uint64_t & object )
+        {
+            const uint64_t thread = ( object >> 32 );
+            TEST_ASSERT( thread < numThreads );
+            TEST_ASSERT( kept[ thread ].Find( &object ) != nullptr );
+            ++numVisited;
+        } );
+        TEST_ASSERT( numVisited == ( kept[ 0 ].GetSize() * numThreads ) );
+
+        // Hand each thread's objects to the next one to destroy
+        for ( uint32_t i = 0; i < numThreads; ++i )
+        {
+            toDestroy[ ( i + 1 ) % numThreads ] = Move( kept[ i ] );
+        }
+    }
+}
+
+// ThreadFunction_CreateAndDestroy
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestObjectPool::ThreadFunction_CreateAndDestroy( void * userData )
+{
+    ThreadCacheTest & test = *static_cast< ThreadCacheTest * >( userData );
+    ObjectPool< uint64_t >::ThreadCache cache( *test.m_Pool );
+
+    for ( uint64_t * object : *test.m_ToDestroy )
+    {
+        cache.Destroy( object );
+    }
+    test.m_ToDestroy->Clear();
+
+    for ( uint64_t i = 0; i < 5000; ++i )
+    {
+        uint64_t * object = cache.Create( ( test.m_ThreadIndex << 32 ) | i );
+        if ( i & 1 )
+        {
+            test.m_Kept->Append( object );
+        }
+        else
+        {
+            cache.Destroy( object );
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,362 @@
+// TestQueues.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Containers/IntrusiveMPSCQueue.h"
+#include "Core/Containers/MPSCQueue.h"
+#include "Core/Containers/SPSCQueue.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AString.h"
+
+// TestQueues
+//------------------------------------------------------------------------------
+class TestQueues : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void SPSCFullAndEmpty() const;
+    void SPSCElementLifetimes() const;
+    void SPSCThreads() const;
+    void MPSCFullAndEmpty() const;
+    void MPSCElementLifetimes() const;
+    void MPSCThreads() const;
+    void IntrusiveOrder() const;
+    void IntrusiveThreads() const;
+
+    static const uint32_t NUM_PRODUCERS = 4;
+    static const uint32_t ITEMS_PER_PRODUCER = 50000;
+
+    struct Item : public IntrusiveMPSCQueueNode
+    {
+        uint32_t m_Producer;
+        uint32_t m_Sequence;
+    };
+
+    struct ProducerData
+    {
+        void *      m_Queue;
+        Item *      m_Items;
+        uint32_t    m_Producer;
+    };
+
+    static uint32_t ThreadFunction_SPSC( void * userData );
+    static uint32_t ThreadFunction_MPSC( void * userData );
+    static uint32_t ThreadFunction_Intrusive( void * userData );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestQueues )
+    REGISTER_TEST( SPSCFullAndEmpty )
+    REGISTER_TEST( SPSCElementLifetimes )
+    REGISTER_TEST( SPSCThreads )
+    REGISTER_TEST( MPSCFullAndEmpty )
+    REGISTER_TEST( MPSCElementLifetimes )
+    REGISTER_TEST( MPSCThreads )
+    REGISTER_TEST( IntrusiveOrder )
+    REGISTER_TEST( IntrusiveThreads )
+REGISTER_TESTS_END
+
+// SPSCFullAndEmpty
+//------------------------------------------------------------------------------
+void TestQueues::SPSCFullAndEmpty() const
+{
+    // Capacity is rounded up to a power of 2
+    SPSCQueue< uint32_t > queue( 5 );
+    TEST_ASSERT( queue.GetCapacity() == 8 );
+    TEST_ASSERT( queue.IsEmpty() );
+
+    uint32_t value;
+    TEST_ASSERT( queue.Pop( value ) == false );
+
+    // Around the ring several times, in order
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    for ( uint32_t lap = 0; lap < 4; ++lap )
+    {
+        while ( queue.Push( next ) )
+        {
+            ++next;
+        }
+        TEST_ASSERT( ( next - expected ) == 8 );
+        for ( uint32_t i = 0; i < 5; ++i )
+        {
+            TEST_ASSERT( queue.Pop( value ) );
+            TEST_ASSERT( value == expected++ );
+        }
+    }
+    while ( queue.Pop( value ) )
+    {
+        TEST_ASSERT( value == expected++ );
+    }
+    TEST_ASSERT( expected == next );
+    TEST_ASSERT( queue.IsEmpty() );
+}
+
+// SPSCElementLifetimes
+//------------------------------------------------------------------------------
+void TestQueues::SPSCElementLifetimes() const
+{
+    // Elements are moved in and out, and those left are destroyed with the queue
+    SPSCQueue< AString > queue( 4 );
+    AString string( "A string long enough to be allocated on the heap" );
+    TEST_ASSERT( queue.Push( string ) );
+    TEST_ASSERT( queue.Push( Move( string ) ) );
+    TEST_ASSERT( queue.Push( AString( "Left in the queue" ) ) );
+
+    AString popped;
+    TEST_ASSERT( queue.Pop( popped ) );
+    TEST_ASSERT( popped == "A string long enough to be allocated on the heap" );
+    TEST_ASSERT( queue.Pop( popped ) );
+    TEST_ASSERT( popped == "A string long enough to be allocated on the heap" );
+}
+
+// SPSCThreads
+//------------------------------------------------------------------------------
+void TestQueues::SPSCThreads() const
+{
+    // A queue much smaller than the number of items, so it's often full and empty
+    SPSCQueue< uint32_t > queue( 64 );
+    ProducerData data = { &queue, nullptr, 0 };
+    Thread::ThreadHandle h = Thread::CreateThread( ThreadFunction_SPSC, "TestQueuesSPSC", ( 64 * KILOBYTE ), &data );
+
+    uint32_t expected = 0;
+    while ( expected < ITEMS_PER_PRODUCER )
+    {
+        uint32_t value;
+        if ( queue.Pop( value ) )
+        {
+            TEST_ASSERT( value == expected );
+            ++expected;
+        }
+        else
+        {
+            Thread::Sleep( 0 );
+        }
+    }
+
+    Thread::WaitForThread( h );
+    Thread::CloseHandle( h );
+    TEST_ASSERT( queue.IsEmpty() );
+}
+
+// MPSCFullAndEmpty
+//------------------------------------------------------------------------------
+void TestQueues::MPSCFullAndEmpty() const
+{
+    MPSCQueue< uint32_t > queue( 5 );
+    TEST_ASSERT( queue.GetCapacity() == 8 );
+
+    uint32_t value;
+    TEST_ASSERT( queue.Pop( value ) == false );
+
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    for ( uint32_t lap = 0; lap < 4; ++lap )
+    {
+        while ( queue.Push( next ) )
+        {
+            ++next;
+        }
+        TEST_ASSERT( ( next - expected ) == 8 );
+        for ( uint32_t i = 0; i < 5; ++i )
+        {
+            TEST_ASSERT( queue.Pop( value ) );
+            TEST_ASSERT( value == expected++ );
+        }
+    }
+    while ( queue.Pop( value ) )
+    {
+        TEST_ASSERT( value == expected++ );
+    }
+    TEST_ASSERT( expected == next );
+}
+
+// MPSCElementLifetimes
+//------------------------------------------------------------------------------
+void TestQueues::MPSCElementLifetimes() const
+{
+    MPSCQueue< AString > queue( 4 );
+    AString string( "A string long enough to be allocated on the heap" );
+    TEST_ASSERT( queue.Push( string ) );
+    TEST_ASSERT( queue.Push( Move( string ) ) );
+    TEST_ASSERT( queue.Push( AString( "Left in the queue" ) ) );
+
+    AString popped;
+    TEST_ASSERT( queue.Pop( popped ) );
+    TEST_ASSERT( popped == "A string long enough to be allocated on the heap" );
+    TEST_ASSERT( queue.Pop( popped ) );
+    TEST_ASSERT( popped == "A string long enough to be allocated on the heap" );
+}
+
+// MPSCThreads
+//------------------------------------------------------------------------------
+void TestQueues::MPSCThreads() const
+{
+    MPSCQueue< uint64_t > queue( 64 );
+    ProducerData data[ NUM_PRODUCERS ];
+    Thread::ThreadHandle handles[ NUM_PRODUCERS ];
+    for ( uint32_t i = 0; i < NUM_PRODUCERS; ++i )
+    {
+        data[ i ] = { &queue, nullptr, i };
+        handles[ i ] = Thread::CreateThread( ThreadFunction_MPSC, "TestQueuesMPSC", ( 64 * KILOBYTE ), &data[ i ] );
+    }
+
+    // Each producer's items arrive in the order it pushed them
+    uint32_t expected[ NUM_PRODUCERS ] = {};
+    uint32_t numPopped = 0;
+    while ( numPopped < ( NUM_PRODUCERS * ITEMS_PER_PRODUCER ) )
+    {
+        uint64_t value;
+        if ( queue.Pop( value ) )
+        {
+            const uint32_t producer = (uint32_t)( value >> 32 );
+            TEST_ASSERT( producer < NUM_PRODUCERS );
+            TEST_ASSERT( (uint32_t)value == expected[ producer ] );
+            ++expected[ producer ];
+            ++numPopped;
+        }
+        else
+        {
+            Thread::Sleep( 0 );
+        }
+    }
+
+    for ( const Thread::ThreadHandle h : handles )
+    {
+        Thread::WaitForThread( h );
+        Thread::CloseHandle( h );
+    }
+    uint64_t value;
+    TEST_ASSERT( queue.Pop( value ) == false );
+}
+
+// IntrusiveOrder
+//------------------------------------------------------------------------------
+void TestQueues::IntrusiveOrder() const
+{
+    IntrusiveMPSCQueue< Item > queue;
+    TEST_ASSERT( queue.Pop() == nullptr );
+
+    // Objects can be pushed again once popped, including the last one
+    Item items[ 3 ];
+    for ( uint32_t round = 0; round < 3; ++round )
+    {
+        for ( Item & item : items )
+        {
+            queue.Push( &item );
+        }
+        for ( Item & item : items )
+        {
+            TEST_ASSERT( queue.Pop() == &item );
+        }
+        TEST_ASSERT( queue.Pop() == nullptr );
+    }
+
+    // Interleaved
+    queue.Push( &items[ 0 ] );
+    TEST_ASSERT( queue.Pop() == &items[ 0 ] );
+    queue.Push( &items[ 1 ] );
+    queue.Push( &items[ 0 ] );
+    TEST_ASSERT( queue.Pop() == &items[ 1 ] );
+    queue.Push( &items[ 2 ] );
+    TEST_ASSERT( queue.Pop() == &items[ 0 ] );
+    TEST_ASSERT( queue.Pop() == &items[ 2 ] );
+    TEST_ASSERT( queue.Pop() == nullptr );
+}
+
+// IntrusiveThreads
+//------------------------------------------------------------------------------
+void TestQueues::IntrusiveThreads() const
+{
+    IntrusiveMPSCQueue< Item > queue;
+    Array< Item > items;
+    items.SetSize( NUM_PRODUCERS * ITEMS_PER_PRODUCER );
+    ProducerData data[ NUM_PRODUCERS ];
+    Thread::ThreadHandle handles[ NUM_PRODUCERS ];
+    for ( uint32_t i = 0; i < NUM_PRODUCERS; ++i )
+    {
+        data[ i ] = { &queue, &items[ i * ITEMS_PER_PRODUCER ], i };
+        handles[ i ] = Thread::CreateThread( ThreadFunction_Intrusive, "TestQueuesIntrusive", ( 64 * KILOBYTE ), &data[ i ] );
+    }
+
+    uint32_t expected[ NUM_PRODUCERS ] = {};
+    uint32_t numPopped = 0;
+    while ( numPopped < ( NUM_PRODUCERS * ITEMS_PER_PRODUCER ) )
+    {
+        const Item * item = queue.Pop();
+        if ( item )
+        {
+            TEST_ASSERT( item->m_Producer < NUM_PRODUCERS );
+            TEST_ASSERT( item->m_Sequence == expected[ item->m_Producer ] );
+            ++expected[ item->m_Producer ];
+            ++numPopped;
+        }
+        else
+        {
+            Thread::Sleep( 0 );
+        }
+    }
+
+    for ( const Thread::ThreadHandle h : handles )
+    {
+        Thread::WaitForThread( h );
+        Thread::CloseHandle( h );
+    }
+    TEST_ASSERT( queue.Pop() == nullptr );
+}
+
+// ThreadFunction_SPSC
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestQueues::ThreadFunction_SPSC( void * userData )
+{
+    const ProducerData & data = *static_cast< const ProducerData * >( userData );
+    SPSCQueue< uint32_t > & queue = *static_cast< SPSCQueue< uint32_t > * >( data.m_Queue );
+    for ( uint32_t i = 0; i < ITEMS_PER_PRODUCER; ++i )
+    {
+        while ( queue.Push( i ) == false )
+        {
+            Thread::Sleep( 0 );
+        }
+    }
+    return 0;
+}
+
+// ThreadFunction_MPSC
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestQueues::ThreadFunction_MPSC( void * userData )
+{
+    const ProducerData & data = *static_cast< const ProducerData * >( userData );
+    MPSCQueue< uint64_t > & queue = *static_cast< MPSCQueue< uint64_t > * >( data.m_Queue );
+    for ( uint32_t i = 0; i < ITEMS_PER_PRODUCER; ++i )
+    {
+        while ( queue.Push( ( (uint64_t)data.m_Producer << 32 ) | i ) == false )
+        {
+            Thread::Sleep( 0 );
+        }
+    }
+    return 0;
+}
+
+// ThreadFunction_Intrusive
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestQueues::ThreadFunction_Intrusive( void * userData )
+{
+    const ProducerData & data = *static_cast< const ProducerData * >( userData );
+    IntrusiveMPSCQueue< Item > & queue = *static_cast< IntrusiveMPSCQueue< Item > * >( data.m_Queue );
+    for ( uint32_t i = 0; i < ITEMS_PER_PRODUCER; ++i )
+    {
+        Item & item = data.m_Items[ i ];
+        item.m_Producer = data.m_Producer;
+        item.m_Sequence = i;
+        queue.Push( &item );
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
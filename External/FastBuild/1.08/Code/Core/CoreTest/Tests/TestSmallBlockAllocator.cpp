@@ -25,6 +25,7 @@ private:
 
     void SingleThreaded() const;
     void MultiThreaded() const;
+    void FreeOnOtherThread() const;
 
     // struct for managing threads
     class ThreadInfo
@@ -42,6 +43,7 @@ private:
     static float    AllocateFromSmallBlockAllocator( const Array< uint32_t > & allocSizes, const uint32_t repeatCount, const bool threadSafe = true );
     static uint32_t ThreadFunction_System( void * userData );
     static uint32_t ThreadFunction_SmallBlock( void * userData );
+    static uint32_t ThreadFunction_AllocAndFill( void * userData );
 };
 
 // Register Tests
@@ -49,6 +51,7 @@ private:
 REGISTER_TESTS_BEGIN( TestSmallBlockAllocator )
     REGISTER_TEST( SingleThreaded )
     REGISTER_TEST( MultiThreaded )
+    REGISTER_TEST( FreeOnOtherThread )
 REGISTER_TESTS_END
 
 // SingleThreaded
@@ -145,6 +148,38 @@ void TestSmallBlockAllocator::MultiThreaded() const
     OUTPUT( "SmallBlockAllocator    : %2.3fs - %u allocs @ %u allocs/sec\n", (double)time2, ( numAllocs * repeatCount ), (uint32_t)( float( numAllocs * repeatCount ) / time2 ) );
 }
 
+// FreeOnOtherThread
+//------------------------------------------------------------------------------
+void TestSmallBlockAllocator::FreeOnOtherThread() const
+{
+    // Blocks allocated on one thread and freed on another go through the freeing thread's
+    // cache and back to the shared bucket, to be handed out again on a third
+    const uint32_t numAllocs( 10 * 1000 );
+    for ( uint32_t pass = 0; pass < 2; ++pass )
+    {
+        Array< uint32_t * > allocs( numAllocs, false );
+        Thread::ThreadHandle h = Thread::CreateThread( ThreadFunction_AllocAndFill, "SmallBlock", ( 64 * KILOBYTE ), (void*)&allocs );
+        TEST_ASSERT( h != INVALID_THREAD_HANDLE );
+        bool timedOut;
+        Thread::WaitForThread( h, 500 * 1000, timedOut );
+        Thread::CloseHandle( h );
+        TEST_ASSERT( timedOut == false );
+
+        // Each block still holds what was written, so none were handed out twice
+        TEST_ASSERT( allocs.GetSize() == numAllocs );
+        for ( uint32_t i = 0; i < numAllocs; ++i )
+        {
+            TEST_ASSERT( allocs[ i ][ 0 ] == i );
+            TEST_ASSERT( allocs[ i ][ 7 ] == ~i );
+        }
+        for ( uint32_t * mem : allocs )
+        {
+            FREE( mem );
+        }
+        SmallBlockAllocator::FlushThreadCache();
+    }
+}
+
 // GetRandomAllocSizes
 //------------------------------------------------------------------------------
 /*static*/ void TestSmallBlockAllocator::GetRandomAllocSizes( const uint32_t numAllocs, Array< uint32_t > & allocSizes )
@@ -256,4 +291,19 @@ void TestSmallBlockAllocator::MultiThreaded() const
     return 0;
 }
 
+// ThreadFunction_AllocAndFill
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestSmallBlockAllocator::ThreadFunction_AllocAndFill( void * userData )
+{
+    Array< uint32_t * > & allocs = *( static_cast< Array< uint32_t * > * >( userData ) );
+    for ( uint32_t i = 0; i < allocs.GetCapacity(); ++i )
+    {
+        uint32_t * mem = (uint32_t *)ALLOC( 8 * sizeof( uint32_t ) );
+        mem[ 0 ] = i;
+        mem[ 7 ] = ~i;
+        allocs.Append( mem );
+    }
+    return 0;
+}
+
 //------------------------------------------------------------------------------
@@ -0,0 +1,312 @@
+// TestSort.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Containers/Sort.h"
+#include "Core/Math/Random.h"
+#include "Core/Strings/AString.h"
+
+#include <stdint.h>
+
+// TestSort
+//------------------------------------------------------------------------------
+class TestSort : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void IntroSortPatterns() const;
+    void IntroSortCompareCount() const;
+    void IntroSortStrings() const;
+    void RadixSortIntegers() const;
+    void RadixSortFloats() const;
+    void RadixSortStable() const;
+    void ParallelSortIntegers() const;
+    void ParallelSortStrings() const;
+
+    enum Pattern : uint32_t
+    {
+        RANDOM,
+        SORTED,
+        REVERSED,
+        ALL_EQUAL,
+        FEW_DISTINCT,
+        ORGAN_PIPE,
+        NUM_PATTERNS
+    };
+    static void     Fill( Array< uint32_t > & array, Pattern pattern, uint32_t count, uint32_t seed );
+    template < class T, class COMPARE >
+    static bool     IsSorted( const Array< T > & array, const COMPARE & compare );
+    static uint64_t Sum( const Array< uint32_t > & array );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestSort )
+    REGISTER_TEST( IntroSortPatterns )
+    REGISTER_TEST( IntroSortCompareCount )
+    REGISTER_TEST( IntroSortStrings )
+    REGISTER_TEST( RadixSortIntegers )
+    REGISTER_TEST( RadixSortFloats )
+    REGISTER_TEST( RadixSortStable )
+    REGISTER_TEST( ParallelSortIntegers )
+    REGISTER_TEST( ParallelSortStrings )
+REGISTER_TESTS_END
+
+// IntroSortPatterns
+//------------------------------------------------------------------------------
+void TestSort::IntroSortPatterns() const
+{
+    const uint32_t counts[] = { 0, 1, 2, 3, 16, 17, 100, 1000, 10000 };
+    for ( uint32_t pattern = 0; pattern < NUM_PATTERNS; ++pattern )
+    {
+        for ( const uint32_t count : counts )
+        {
+            Array< uint32_t > array;
+            Fill( array, (Pattern)pattern, count, 1234 );
+            const uint64_t sum = Sum( array );
+            array.Sort();
+            TEST_ASSERT( array.GetSize() == count );
+            TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+            TEST_ASSERT( Sum( array ) == sum );
+        }
+    }
+}
+
+// IntroSortCompareCount
+//------------------------------------------------------------------------------
+void TestSort::IntroSortCompareCount() const
+{
+    // Every pattern sorts in O(n log n) comparisons, including those that are slow for
+    // a quicksort with a fixed pivot or a shell sort
+    const uint32_t count = 100000;
+    for ( uint32_t pattern = 0; pattern < NUM_PATTERNS; ++pattern )
+    {
+        Array< uint32_t > array;
+        Fill( array, (Pattern)pattern, count, 5678 );
+        uint64_t numCompares = 0;
+        array.Sort( [ &numCompares ]( uint32_t a, uint32_t b ) { ++numCompares; return ( a < b ); } );
+        TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+        TEST_ASSERT( numCompares < ( 4ull * count * 17 ) ); // 17 ~= log2( count )
+    }
+}
+
+// IntroSortStrings
+//------------------------------------------------------------------------------
+void TestSort::IntroSortStrings() const
+{
+    Random random( 42 );
+    Array< AString > array;
+    for ( uint32_t i = 0; i < 1000; ++i )
+    {
+        AString string;
+        string.Format( "String %u", random.GetRand() % 500 );
+        array.Append( string );
+    }
+    array.Sort();
+    TEST_ASSERT( array.GetSize() == 1000 );
+    TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+}
+
+// RadixSortIntegers
+//------------------------------------------------------------------------------
+void TestSort::RadixSortIntegers() const
+{
+    for ( uint32_t pattern = 0; pattern < NUM_PATTERNS; ++pattern )
+    {
+        Array< uint32_t > array;
+        Fill( array, (Pattern)pattern, 10000, 91011 );
+        const uint64_t sum = Sum( array );
+        array.SortByKey( []( uint32_t value ) { return value; } );
+        TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+        TEST_ASSERT( Sum( array ) == sum );
+
+        // Keys of a different type, and descending
+        array.SortByKey( []( uint32_t value ) { return -(int64_t)value; } );
+        TEST_ASSERT( IsSorted( array, []( uint32_t a, uint32_t b ) { return ( a > b ); } ) );
+    }
+
+    // Negative keys sort before positive ones
+    {
+        Array< int32_t > array;
+        Random random( 1 );
+        for ( uint32_t i = 0; i < 1000; ++i )
+        {
+            array.Append( (int32_t)( random.GetRand() << 17 ) - (int32_t)random.GetRand() );
+        }
+        array.Append( INT32_MIN );
+        array.Append( INT32_MAX );
+        array.Append( 0 );
+        array.Append( -1 );
+        array.SortByKey( []( int32_t value ) { return value; } );
+        TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+        TEST_ASSERT( array[ 0 ] == INT32_MIN );
+        TEST_ASSERT( array.Top() == INT32_MAX );
+    }
+    {
+        Array< uint64_t > array;
+        array.Append( 0xFFFFFFFF00000000ull );
+        array.Append( 1 );
+        array.Append( 0x100000000ull );
+        array.Append( 0 );
+        array.SortByKey( []( uint64_t value ) { return value; } );
+        TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+    }
+}
+
+// RadixSortFloats
+//------------------------------------------------------------------------------
+void TestSort::RadixSortFloats() const
+{
+    Random random( 7 );
+    Array< float > array;
+    for ( uint32_t i = 0; i < 1000; ++i )
+    {
+        array.Append( ( random.GetRandFloat() - 0.5f ) * 1000.0f );
+    }
+    array.Append( -1e30f );
+    array.Append( 1e30f );
+    array.Append( 0.0f );
+    array.Append( -0.0f );
+    array.Append( 1e-40f ); // denormal
+    array.Append( -1e-40f );
+    array.SortByKey( []( float value ) { return value; } );
+    TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+    TEST_ASSERT( array[ 0 ] == -1e30f );
+    TEST_ASSERT( array.Top() == 1e30f );
+
+    Array< double > doubles;
+    for ( const float value : array )
+    {
+        doubles.Append( -(double)value );
+    }
+    doubles.SortByKey( []( double value ) { return value; } );
+    TEST_ASSERT( IsSorted( doubles, AscendingCompare() ) );
+}
+
+// RadixSortStable
+//------------------------------------------------------------------------------
+void TestSort::RadixSortStable() const
+{
+    // Items with equal keys keep their order, including items that aren't trivially
+    // copyable
+    struct Item
+    {
+        uint16_t    m_Key;
+        uint32_t    m_Index;
+        AString     m_Name;
+    };
+    Random random( 99 );
+    Array< Item > array;
+    for ( uint32_t i = 0; i < 2000; ++i )
+    {
+        Item item;
+        item.m_Key = (uint16_t)( random.GetRand() % 50 );
+        item.m_Index = i;
+        item.m_Name.Format( "Item %u", i );
+        array.Append( Move( item ) );
+    }
+    array.SortByKey( []( const Item & item ) { return item.m_Key; } );
+    for ( size_t i = 1; i < array.GetSize(); ++i )
+    {
+        const Item & a = array[ i - 1 ];
+        const Item & b = array[ i ];
+        TEST_ASSERT( ( a.m_Key < b.m_Key ) || ( ( a.m_Key == b.m_Key ) && ( a.m_Index < b.m_Index ) ) );
+    }
+    AString name;
+    name.Format( "Item %u", array[ 0 ].m_Index );
+    TEST_ASSERT( array[ 0 ].m_Name == name );
+}
+
+// ParallelSortIntegers
+//------------------------------------------------------------------------------
+void TestSort::ParallelSortIntegers() const
+{
+    const uint32_t counts[] = { 1000, 200000 };
+    for ( uint32_t pattern = 0; pattern < NUM_PATTERNS; ++pattern )
+    {
+        for ( const uint32_t count : counts )
+        {
+            Array< uint32_t > array;
+            Fill( array, (Pattern)pattern, count, 1213 );
+            const uint64_t sum = Sum( array );
+            array.SortParallel( AscendingCompare(), 4 );
+            TEST_ASSERT( array.GetSize() == count );
+            TEST_ASSERT( IsSorted( array, AscendingCompare() ) );
+            TEST_ASSERT( Sum( array ) == sum );
+        }
+    }
+}
+
+// ParallelSortStrings
+//------------------------------------------------------------------------------
+void TestSort::ParallelSortStrings() const
+{
+    Random random( 1415 );
+    Array< AString > array;
+    for ( uint32_t i = 0; i < 100000; ++i )
+    {
+        AString string;
+        string.Format( "String %u", random.GetRand() );
+        array.Append( string );
+    }
+    array.SortParallel( []( const AString & a, const AString & b ) { return ( b < a ); }, 3 );
+    TEST_ASSERT( array.GetSize() == 100000 );
+    TEST_ASSERT( IsSorted( array, []( const AString & a, const AString & b ) { return ( b < a ); } ) );
+}
+
+// Fill
+//------------------------------------------------------------------------------
+/*static*/ void TestSort::Fill( Array< uint32_t > & array, Pattern pattern, uint32_t count, uint32_t seed )
+{
+    Random random( seed );
+    array.SetCapacity( count );
+    for ( uint32_t i = 0; i < count; ++i )
+    {
+        uint32_t value = 0;
+        switch ( pattern )
+        {
+            case RANDOM:        value = ( random.GetRand() << 15 ) | random.GetRand(); break;
+            case SORTED:        value = i; break;
+            case REVERSED:      value = ( count - i ); break;
+            case ALL_EQUAL:     value = 7; break;
+            case FEW_DISTINCT:  value = random.GetRand() % 4; break;
+            case ORGAN_PIPE:    value = ( i < count / 2 ) ? i : ( count - i ); break;
+            case NUM_PATTERNS:  break;
+        }
+        array.Append( value );
+    }
+}
+
+// IsSorted
+//------------------------------------------------------------------------------
+template < class T, class COMPARE >
+/*static*/ bool TestSort::IsSorted( const Array< T > & array, const COMPARE & compare )
+{
+    for ( size_t i = 1; i < array.GetSize(); ++i )
+    {
+        if ( compare( array[ i ], array[ i - 1 ] ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sum
+//------------------------------------------------------------------------------
+/*static*/ uint64_t TestSort::Sum( const Array< uint32_t > & array )
+{
+    uint64_t sum = 0;
+    for ( const uint32_t value : array )
+    {
+        sum += value;
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
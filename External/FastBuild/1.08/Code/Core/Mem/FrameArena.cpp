@@ -0,0 +1,182 @@
+// FrameArena.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FrameArena.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/LargePages.h"
+#include "Core/Mem/MemStats.h"
+#include "Core/Process/Atomic.h"
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ volatile uint32_t                FrameArena::s_Frame( 0 );
+/*static*/ THREAD_LOCAL FrameArena::ThreadState FrameArena::s_ThreadState = {};
+
+// Alloc
+//------------------------------------------------------------------------------
+/*static*/ void * FrameArena::Alloc( size_t size, size_t alignment )
+{
+    ASSERT( size > 0 );
+    ASSERT( Math::IsPowerOf2( alignment ) );
+
+    ThreadState & state = GetThreadState();
+    char * pos = reinterpret_cast< char * >( Math::RoundUp( reinterpret_cast< size_t >( state.m_Pos ), alignment ) );
+    if ( size > (size_t)( state.m_End - pos ) )
+    {
+        return AllocFromNextChunk( state, size, alignment );
+    }
+    state.m_Pos = ( pos + size );
+    return pos;
+}
+
+// EndFrame
+//------------------------------------------------------------------------------
+/*static*/ void FrameArena::EndFrame()
+{
+    AtomicInc( &s_Frame );
+}
+
+// FreeThreadMemory
+//------------------------------------------------------------------------------
+/*static*/ void FrameArena::FreeThreadMemory()
+{
+    ThreadState & state = s_ThreadState;
+    Chunk * chunk = state.m_First;
+    while ( chunk )
+    {
+        Chunk * next = chunk->m_Next;
+        LargePages::Free( chunk );
+        chunk = next;
+    }
+    state.m_First = nullptr;
+    SetCurrentChunk( state, nullptr );
+}
+
+// GetThreadCapacity
+//------------------------------------------------------------------------------
+/*static*/ size_t FrameArena::GetThreadCapacity()
+{
+    size_t capacity = 0;
+    for ( const Chunk * chunk = s_ThreadState.m_First; chunk; chunk = chunk->m_Next )
+    {
+        capacity += chunk->m_Size;
+    }
+    return capacity;
+}
+
+// GetThreadState
+//------------------------------------------------------------------------------
+// The calling thread's state, starting again from the beginning of its memory if a
+// frame has ended since it last allocated
+/*static*/ FrameArena::ThreadState & FrameArena::GetThreadState()
+{
+    ThreadState & state = s_ThreadState;
+    const uint32_t frame = AtomicLoadRelaxed( &s_Frame );
+    if ( state.m_Frame != frame )
+    {
+        state.m_Frame = frame;
+
+        // A frame that needed more than one chunk gets one that holds them all, so the
+        // next frames don't have to move between them
+        if ( state.m_First && state.m_First->m_Next )
+        {
+            const size_t capacity = GetThreadCapacity();
+            FreeThreadMemory();
+            state.m_First = AllocChunk( capacity );
+            state.m_First->m_Next = nullptr;
+        }
+        SetCurrentChunk( state, state.m_First );
+    }
+    return state;
+}
+
+// AllocFromNextChunk
+//------------------------------------------------------------------------------
+/*static*/ NO_INLINE void * FrameArena::AllocFromNextChunk( ThreadState & state, size_t size, size_t alignment )
+{
+    // The next chunk kept from earlier frames if it's big enough, or a new one ahead of it
+    Chunk * next = state.m_Current ? state.m_Current->m_Next : state.m_First;
+    const size_t neededSize = ( size + alignment );
+    if ( ( next == nullptr ) || ( next->m_Size < neededSize ) )
+    {
+        const size_t chunkSize = Math::Max( state.m_Current ? ( state.m_Current->m_Size * 2 ) : MIN_CHUNK_SIZE, neededSize );
+        Chunk * chunk = AllocChunk( chunkSize );
+        chunk->m_Next = next;
+        if ( state.m_Current )
+        {
+            state.m_Current->m_Next = chunk;
+        }
+        else
+        {
+            state.m_First = chunk;
+        }
+        next = chunk;
+    }
+    SetCurrentChunk( state, next );
+
+    char * pos = reinterpret_cast< char * >( Math::RoundUp( reinterpret_cast< size_t >( state.m_Pos ), alignment ) );
+    ASSERT( size <= (size_t)( state.m_End - pos ) );
+    state.m_Pos = ( pos + size );
+    return pos;
+}
+
+// AllocChunk
+//------------------------------------------------------------------------------
+// Chunks of a large page or more are made whole large pages, which they can be backed by.
+// Chunks are counted in a category of their own, whoever's allocation needed them.
+/*static*/ FrameArena::Chunk * FrameArena::AllocChunk( size_t size )
+{
+    static const uint8_t category = MemStats::GetCategory( "Frame Arena" );
+    const MemCategoryScope scope( category );
+
+    size_t allocSize = ( sizeof( Chunk ) + size );
+    if ( allocSize >= LargePages::LARGE_PAGE_SIZE )
+    {
+        allocSize = Math::RoundUp( allocSize, LargePages::LARGE_PAGE_SIZE );
+    }
+    Chunk * chunk = static_cast< Chunk * >( LargePages::Alloc( allocSize ) );
+    chunk->m_Size = ( allocSize - sizeof( Chunk ) );
+    return chunk;
+}
+
+// SetCurrentChunk
+//------------------------------------------------------------------------------
+/*static*/ void FrameArena::SetCurrentChunk( ThreadState & state, Chunk * chunk )
+{
+    state.m_Current = chunk;
+    state.m_Pos = chunk ? reinterpret_cast< char * >( chunk + 1 ) : nullptr;
+    state.m_End = chunk ? ( state.m_Pos + chunk->m_Size ) : nullptr;
+}
+
+// FrameArenaScope (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+FrameArenaScope::FrameArenaScope()
+{
+    const FrameArena::ThreadState & state = FrameArena::GetThreadState();
+    m_Chunk = state.m_Current;
+    m_Pos = state.m_Pos;
+    m_Frame = state.m_Frame;
+}
+
+// FrameArenaScope (DESTRUCTOR)
+//------------------------------------------------------------------------------
+FrameArenaScope::~FrameArenaScope()
+{
+    // Everything has already been released if the frame ended while the scope was open
+    FrameArena::ThreadState & state = FrameArena::s_ThreadState;
+    if ( state.m_Frame == m_Frame )
+    {
+        FrameArena::SetCurrentChunk( state, m_Chunk );
+        if ( m_Chunk )
+        {
+            state.m_Pos = m_Pos;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
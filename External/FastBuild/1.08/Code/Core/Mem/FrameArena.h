@@ -0,0 +1,81 @@
+// FrameArena.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+
+// FrameArena
+//------------------------------------------------------------------------------
+// A bump allocator per thread, for scratch memory that only lives until the end of
+// the frame. Nothing is freed on its own: EndFrame releases everything allocated on
+// every thread, and a FrameArenaScope releases what its thread allocated while it was
+// open. Each thread keeps its memory from frame to frame, so once it has grown to
+// what a frame needs, allocating from it doesn't touch the heap.
+class FrameArena
+{
+public:
+    // Allocate from the calling thread's arena
+    [[nodiscard]] static void * Alloc( size_t size, size_t alignment = sizeof( void * ) );
+
+    // Release everything allocated this frame, on all threads. Each thread starts again
+    // from the beginning of its memory when it next allocates.
+    static void                 EndFrame();
+
+    // Free the calling thread's memory. Threads started by Thread do this as they exit.
+    static void                 FreeThreadMemory();
+
+    // Bytes of memory held by the calling thread
+    [[nodiscard]] static size_t GetThreadCapacity();
+
+protected:
+    friend class FrameArenaScope;
+
+    static const size_t MIN_CHUNK_SIZE = ( 64 * 1024 );
+
+    // Memory is taken from the heap in chunks, with the space following the header
+    struct Chunk
+    {
+        Chunk *     m_Next;
+        size_t      m_Size;
+    };
+
+    struct ThreadState
+    {
+        Chunk *     m_First;
+        Chunk *     m_Current;
+        char *      m_Pos;
+        char *      m_End;
+        uint32_t    m_Frame;
+    };
+
+    static ThreadState &    GetThreadState();
+    static Chunk *          AllocChunk( size_t size );
+    static void *           AllocFromNextChunk( ThreadState & state, size_t size, size_t alignment );
+    static void             SetCurrentChunk( ThreadState & state, Chunk * chunk );
+
+    static volatile uint32_t            s_Frame;
+    static THREAD_LOCAL ThreadState     s_ThreadState;
+};
+
+// FrameArenaScope
+//------------------------------------------------------------------------------
+// Releases what the thread allocated from its FrameArena while the scope was open,
+// for scratch memory that doesn't outlive a function
+class FrameArenaScope
+{
+public:
+    FrameArenaScope();
+    ~FrameArenaScope();
+
+    FrameArenaScope( const FrameArenaScope & other ) = delete;
+    FrameArenaScope & operator = ( const FrameArenaScope & other ) = delete;
+
+private:
+    FrameArena::Chunk * m_Chunk;
+    char *              m_Pos;
+    uint32_t            m_Frame;
+};
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,345 @@
+// LargePages.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "LargePages.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#if defined( __WINDOWS__ )
+    #include "Core/Env/WindowsHeader.h"
+#endif
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Mem/MemStats.h"
+#include "Core/Process/Atomic.h"
+
+// system
+#if defined( __LINUX__ )
+    #include <stdio.h>
+    #include <stdlib.h>
+#endif
+#if !defined( __WINDOWS__ )
+    #include <sys/mman.h>
+#endif
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ void * volatile          LargePages::s_Lock( nullptr );
+/*static*/ bool                     LargePages::s_UseExplicitPool( false );
+/*static*/ uint32_t                 LargePages::s_NumRegions( 0 );
+/*static*/ LargePages::Region       LargePages::s_Regions[ MAX_REGIONS ];
+
+// Alloc
+//------------------------------------------------------------------------------
+/*static*/ void * LargePages::Alloc( size_t size, size_t alignment )
+{
+    ASSERT( alignment <= LARGE_PAGE_SIZE );
+    if ( size >= LARGE_PAGE_SIZE )
+    {
+        size_t mappedSize = size;
+        bool isExplicit = false;
+        void * mem = Map( mappedSize, false, isExplicit );
+        if ( mem )
+        {
+            if ( AddRegion( mem, mappedSize, isExplicit, false ) )
+            {
+                MemStats::OnAlloc( MemStats::GetCurrentCategory(), mappedSize );
+                return mem;
+            }
+            Unmap( mem, mappedSize );
+        }
+    }
+    return ALLOC( size, alignment );
+}
+
+// Free
+//------------------------------------------------------------------------------
+/*static*/ void LargePages::Free( void * ptr )
+{
+    if ( ptr == nullptr )
+    {
+        return;
+    }
+    Region region;
+    if ( RemoveRegion( ptr, region ) )
+    {
+        if ( region.m_Reserved == false )
+        {
+            MemStats::OnFree( region.m_Category, region.m_Size );
+        }
+        Unmap( region.m_Begin, region.m_Size );
+        return;
+    }
+    FREE( ptr );
+}
+
+// Reserve
+//------------------------------------------------------------------------------
+/*static*/ void * LargePages::Reserve( size_t size )
+{
+    // Whole large pages, so Commit can round out to them
+    size = Math::RoundUp( size, LARGE_PAGE_SIZE );
+    bool isExplicit = false;
+    void * mem = Map( size, true, isExplicit );
+    if ( mem && ( AddRegion( mem, size, false, true ) == false ) )
+    {
+        Unmap( mem, size );
+        mem = nullptr;
+    }
+    return mem;
+}
+
+// Commit
+//------------------------------------------------------------------------------
+/*static*/ void LargePages::Commit( void * ptr, size_t size )
+{
+    const size_t begin = ( (size_t)ptr & ~( LARGE_PAGE_SIZE - 1 ) );
+    const size_t end = Math::RoundUp( (size_t)ptr + size, LARGE_PAGE_SIZE );
+    #if defined( __WINDOWS__ )
+        VERIFY( ::VirtualAlloc( (void *)begin, end - begin, MEM_COMMIT, PAGE_READWRITE ) );
+    #else
+        VERIFY( ::mprotect( (void *)begin, end - begin, PROT_READ | PROT_WRITE ) == 0 );
+    #endif
+}
+
+// SetUseExplicitPool
+//------------------------------------------------------------------------------
+/*static*/ void LargePages::SetUseExplicitPool( bool useExplicitPool )
+{
+    s_UseExplicitPool = useExplicitPool;
+}
+
+// GetStats
+//------------------------------------------------------------------------------
+/*static*/ void LargePages::GetStats( Stats & stats )
+{
+    // Measure a copy of the regions, so memory can be mapped meanwhile
+    Region regions[ MAX_REGIONS ];
+    Lock();
+    const uint32_t numRegions = s_NumRegions;
+    for ( uint32_t i = 0; i < numRegions; ++i )
+    {
+        regions[ i ] = s_Regions[ i ];
+    }
+    Unlock();
+
+    stats.m_MappedBytes = 0;
+    stats.m_ResidentBytes = 0;
+    stats.m_LargePageBytes = 0;
+    stats.m_ExplicitBytes = 0;
+    stats.m_NumRegions = numRegions;
+    for ( uint32_t i = 0; i < numRegions; ++i )
+    {
+        stats.m_MappedBytes += regions[ i ].m_Size;
+        if ( regions[ i ].m_Explicit )
+        {
+            stats.m_ExplicitBytes += regions[ i ].m_Size;
+        }
+    }
+
+    #if defined( __LINUX__ )
+        // Each mapping's header line is followed by its sizes. Regions can be split into
+        // several mappings, where parts are committed or protected differently.
+        FILE * file = fopen( "/proc/self/smaps", "r" );
+        if ( file == nullptr )
+        {
+            stats.m_LargePageBytes = stats.m_ExplicitBytes;
+            return;
+        }
+        char line[ 1024 ];
+        bool inRegion = false;
+        while ( fgets( line, sizeof( line ), file ) )
+        {
+            const char c = line[ 0 ];
+            if ( ( ( c >= '0' ) && ( c <= '9' ) ) || ( ( c >= 'a' ) && ( c <= 'f' ) ) )
+            {
+                const size_t begin = (size_t)strtoull( line, nullptr, 16 );
+                inRegion = false;
+                for ( uint32_t i = 0; i < numRegions; ++i )
+                {
+                    if ( ( begin >= (size_t)regions[ i ].m_Begin ) && ( begin < ( (size_t)regions[ i ].m_Begin + regions[ i ].m_Size ) ) )
+                    {
+                        inRegion = true;
+                        break;
+                    }
+                }
+                continue;
+            }
+            if ( inRegion == false )
+            {
+                continue;
+            }
+
+            // Huge pages from the pool aren't counted in Rss
+            unsigned long long kb;
+            if ( sscanf( line, "Rss: %llu kB", &kb ) == 1 )
+            {
+                stats.m_ResidentBytes += ( kb * 1024 );
+            }
+            else if ( sscanf( line, "AnonHugePages: %llu kB", &kb ) == 1 )
+            {
+                stats.m_LargePageBytes += ( kb * 1024 );
+            }
+            else if ( ( sscanf( line, "Private_Hugetlb: %llu kB", &kb ) == 1 ) ||
+                      ( sscanf( line, "Shared_Hugetlb: %llu kB", &kb ) == 1 ) )
+            {
+                stats.m_ResidentBytes += ( kb * 1024 );
+                stats.m_LargePageBytes += ( kb * 1024 );
+            }
+        }
+        fclose( file );
+    #else
+        // Only pages from the pool are known to be large pages
+        stats.m_LargePageBytes = stats.m_ExplicitBytes;
+    #endif
+}
+
+// Map
+//------------------------------------------------------------------------------
+// The size is rounded up to what's mapped
+/*static*/ void * LargePages::Map( size_t & size, bool reserveOnly, bool & isExplicit )
+{
+    isExplicit = false;
+    #if defined( __WINDOWS__ )
+        if ( s_UseExplicitPool && ( reserveOnly == false ) )
+        {
+            // Needs the "Lock pages in memory" privilege, and fails without it
+            const size_t largePageSize = ::GetLargePageMinimum();
+            if ( largePageSize )
+            {
+                const size_t largePagesSize = Math::RoundUp( size, largePageSize );
+                void * mem = ::VirtualAlloc( nullptr, largePagesSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+                if ( mem )
+                {
+                    size = largePagesSize;
+                    isExplicit = true;
+                    return mem;
+                }
+            }
+        }
+
+        // Windows only uses large pages when asked for them explicitly, so the alignment
+        // of other memory doesn't matter
+        return ::VirtualAlloc( nullptr, size, reserveOnly ? MEM_RESERVE : ( MEM_RESERVE | MEM_COMMIT ), reserveOnly ? PAGE_NOACCESS : PAGE_READWRITE );
+    #else
+        #if defined( MAP_HUGETLB )
+            if ( s_UseExplicitPool && ( reserveOnly == false ) )
+            {
+                // Fails unless enough pages have been set aside in /proc/sys/vm/nr_hugepages
+                const size_t largePagesSize = Math::RoundUp( size, LARGE_PAGE_SIZE );
+                void * mem = ::mmap( nullptr, largePagesSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+                if ( mem != MAP_FAILED )
+                {
+                    size = largePagesSize;
+                    isExplicit = true;
+                    return mem;
+                }
+            }
+        #endif
+
+        // Whole pages whatever the system's page size, so the end can be unmapped
+        size = Math::RoundUp( size, (size_t)( 64 * 1024 ) );
+
+        // Map a large page more than needed, and trim it to start on a large page
+        const int prot = reserveOnly ? PROT_NONE : ( PROT_READ | PROT_WRITE );
+        const size_t paddedSize = ( size + LARGE_PAGE_SIZE );
+        void * mem = ::mmap( nullptr, paddedSize, prot, MAP_PRIVATE | MAP_ANON, -1, 0 );
+        if ( mem == MAP_FAILED )
+        {
+            return nullptr;
+        }
+        const size_t begin = Math::RoundUp( (size_t)mem, LARGE_PAGE_SIZE );
+        const size_t head = ( begin - (size_t)mem );
+        if ( head )
+        {
+            VERIFY( ::munmap( mem, head ) == 0 );
+        }
+        const size_t tail = ( paddedSize - head - size );
+        if ( tail )
+        {
+            VERIFY( ::munmap( (void *)( begin + size ), tail ) == 0 );
+        }
+
+        #if defined( MADV_HUGEPAGE )
+            // Kept by the parts of a reservation as they're committed
+            ::madvise( (void *)begin, size, MADV_HUGEPAGE );
+        #endif
+        return (void *)begin;
+    #endif
+}
+
+// Unmap
+//------------------------------------------------------------------------------
+/*static*/ void LargePages::Unmap( void * ptr, size_t size )
+{
+    #if defined( __WINDOWS__ )
+        (void)size;
+        VERIFY( ::VirtualFree( ptr, 0, MEM_RELEASE ) );
+    #else
+        VERIFY( ::munmap( ptr, size ) == 0 );
+    #endif
+}
+
+// AddRegion
+//------------------------------------------------------------------------------
+/*static*/ bool LargePages::AddRegion( void * ptr, size_t size, bool isExplicit, bool isReserved )
+{
+    Lock();
+    const bool added = ( s_NumRegions < MAX_REGIONS );
+    if ( added )
+    {
+        Region & region = s_Regions[ s_NumRegions++ ];
+        region.m_Begin = ptr;
+        region.m_Size = size;
+        region.m_Explicit = isExplicit;
+        region.m_Reserved = isReserved;
+        region.m_Category = MemStats::GetCurrentCategory();
+    }
+    Unlock();
+    return added;
+}
+
+// RemoveRegion
+//------------------------------------------------------------------------------
+/*static*/ bool LargePages::RemoveRegion( void * ptr, Region & outRegion )
+{
+    Lock();
+    bool removed = false;
+    for ( uint32_t i = 0; i < s_NumRegions; ++i )
+    {
+        if ( s_Regions[ i ].m_Begin == ptr )
+        {
+            outRegion = s_Regions[ i ];
+            s_Regions[ i ] = s_Regions[ --s_NumRegions ];
+            removed = true;
+            break;
+        }
+    }
+    Unlock();
+    return removed;
+}
+
+// Lock
+//------------------------------------------------------------------------------
+// A spin lock rather than a Mutex, as the small block allocator reserves its memory
+// here before static constructors may have run. It's only held to update the regions.
+/*static*/ void LargePages::Lock()
+{
+    while ( AtomicExchange( &s_Lock, static_cast< void * >( s_Regions ) ) != nullptr )
+    {
+        while ( AtomicLoadRelaxed( &s_Lock ) != nullptr )
+        {
+        }
+    }
+}
+
+// Unlock
+//------------------------------------------------------------------------------
+/*static*/ void LargePages::Unlock()
+{
+    AtomicStoreRelease( &s_Lock, (void *)nullptr );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,80 @@
+// LargePages.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+
+// LargePages
+//------------------------------------------------------------------------------
+// Memory for large arrays and allocator regions that the system can back with large
+// pages (2MB huge pages on Linux), so walking it takes far fewer TLB entries. Memory is
+// mapped aligned to LARGE_PAGE_SIZE and, on Linux, marked with MADV_HUGEPAGE so
+// transparent huge pages are used for it. When enabled, allocations are first taken
+// from the system's pool of reserved huge pages (hugetlbfs on Linux, MEM_LARGE_PAGES on
+// Windows), which are always large pages but must have been set aside by the admin.
+//
+// Allocations smaller than a large page gain nothing, and come from the heap. Allocated
+// memory is counted in MemStats like the heap's, reservations are not.
+class LargePages
+{
+public:
+    static const size_t LARGE_PAGE_SIZE = ( 2 * 1024 * 1024 );
+
+    // Allocate memory, which must be freed with Free
+    [[nodiscard]] static void * Alloc( size_t size, size_t alignment = sizeof( void * ) );
+    static void                 Free( void * ptr );
+
+    // Reserve address space to Commit parts of as it's needed, and free with Free. Returns
+    // nullptr if it can't be reserved.
+    [[nodiscard]] static void * Reserve( size_t size );
+
+    // Make part of a reservation usable. The whole large pages covering it are committed,
+    // so they can be backed by large pages.
+    static void                 Commit( void * ptr, size_t size );
+
+    // Whether Alloc tries the system's pool of reserved huge pages first. Off by default.
+    static void                 SetUseExplicitPool( bool useExplicitPool );
+
+    struct Stats
+    {
+        uint64_t    m_MappedBytes;      // Address space allocated or reserved here
+        uint64_t    m_ResidentBytes;    // How much of it is in memory
+        uint64_t    m_LargePageBytes;   // How much of it is backed by large pages
+        uint64_t    m_ExplicitBytes;    // Allocated from the pool of reserved huge pages
+        uint32_t    m_NumRegions;
+    };
+
+    // Measure how much memory is backed by large pages. Resident and large page bytes are
+    // read from /proc/self/smaps on Linux, so this is slow enough to not call every frame.
+    static void                 GetStats( Stats & stats );
+
+protected:
+    static const size_t MAX_REGIONS = 256;
+
+    // Memory mapped here, so Free can find its size and GetStats what to measure
+    struct Region
+    {
+        void *      m_Begin;
+        size_t      m_Size;
+        bool        m_Explicit;
+        bool        m_Reserved;
+        uint8_t     m_Category;     // MemStats category allocated memory is counted in
+    };
+
+    static void *   Map( size_t & size, bool reserveOnly, bool & isExplicit );
+    static void     Unmap( void * ptr, size_t size );
+    static bool     AddRegion( void * ptr, size_t size, bool isExplicit, bool isReserved );
+    static bool     RemoveRegion( void * ptr, Region & outRegion );
+
+    static void     Lock();
+    static void     Unlock();
+
+    static void * volatile  s_Lock;
+    static bool             s_UseExplicitPool;
+    static uint32_t         s_NumRegions;
+    static Region           s_Regions[ MAX_REGIONS ];
+};
+
+//------------------------------------------------------------------------------
@@ -6,79 +6,379 @@
 #include "Mem.h"
 #include "Core/Env/Assert.h"
 #include "Core/Env/Types.h"
+#if defined( __WINDOWS__ )
+    #include "Core/Env/WindowsHeader.h"
+#endif
+#include "Core/Math/Conversions.h"
 #include "Core/Mem/MemDebug.h"
+#include "Core/Mem/MemStats.h"
 #include "Core/Mem/MemTracker.h"
 #include "Core/Mem/SmallBlockAllocator.h"
+#include "Core/Process/Atomic.h"
 
 #include <stdlib.h>
+#include <string.h>
+#if defined( __X64__ )
+    #include <emmintrin.h>
+#endif
+#if !defined( __WINDOWS__ )
+    #include <sched.h>
+#endif
 
-// Alloc
+// Allocation Headers
 //------------------------------------------------------------------------------
-void * Alloc( size_t size )
+// Allocations are preceded by a header recording their size and category, so they can be
+// counted out of MemStats when they're freed. The header's fields are in the 8 bytes
+// before the allocation, and how far the allocation is from the start of its block
+// depends on where it came from, so Free can tell without reading the header:
+// - SmallBlockAllocator blocks, found by address, start a bucket's alignment before
+// - Heap blocks start 16 or 32 bytes before, whichever leaves the allocation 16 bytes
+//   past a 32 byte boundary
+// - Allocations aligned to more than 16 bytes, so on a 32 byte boundary, have no header,
+//   which would cost as much as their alignment. They're recorded in a table instead.
+namespace
 {
-    void * mem( nullptr );
+    const uint64_t  HEADER_SIZE_MASK        = 0x0000FFFFFFFFFFFFULL;
+    const uint32_t  HEADER_CATEGORY_SHIFT   = 48;
+    const uint32_t  HEADER_OFFSET_SHIFT     = 56; // Bytes from the start of the block
+    const size_t    HEAP_ALIGNMENT          = 16;
+    const size_t    HEAP_HEADER_SPACE       = ( 2 * HEAP_ALIGNMENT );
+    const uint32_t  LOCK_SPINS              = 64; // Pauses before a waiting thread yields
 
-    #if defined( SMALL_BLOCK_ALLOCATOR_ENABLED )
-        mem = SmallBlockAllocator::Alloc( size, sizeof( void * ) );
-        if ( mem == nullptr )
-    #endif
+    inline uint64_t MakeHeader( size_t size, uint8_t category, size_t offset )
+    {
+        ASSERT( size <= HEADER_SIZE_MASK );
+        return ( (uint64_t)size | ( (uint64_t)category << HEADER_CATEGORY_SHIFT ) | ( (uint64_t)offset << HEADER_OFFSET_SHIFT ) );
+    }
+
+    inline uint64_t & GetHeader( void * ptr )
+    {
+        return static_cast< uint64_t * >( ptr )[ -1 ];
+    }
+
+    inline size_t GetHeaderSize( uint64_t header )
+    {
+        return (size_t)( header & HEADER_SIZE_MASK );
+    }
+
+    inline uint8_t GetHeaderCategory( uint64_t header )
+    {
+        return static_cast< uint8_t >( header >> HEADER_CATEGORY_SHIFT );
+    }
+
+    inline size_t GetHeaderOffset( uint64_t header )
+    {
+        return (size_t)( header >> HEADER_OFFSET_SHIFT );
+    }
+
+    inline bool IsHeapAllocation( const void * ptr )
+    {
+        return ( ( (size_t)ptr & ( HEAP_HEADER_SPACE - 1 ) ) == HEAP_ALIGNMENT );
+    }
+
+    // Where an allocation goes in a heap block, leaving it 16 bytes past a 32 byte boundary
+    inline size_t GetHeapOffset( const void * block )
     {
-        #if defined( __LINUX__ ) || defined( __APPLE__ )
-            #if defined( __clang__ )
-                // Clang has a bug where class alignment is incorrectly reported, which
-                // results in unsafe mixes of alignment and SSE instruction use, so we
-                // enforce a minimum 16 byte alignment
-                // Last seen in Apple LLVM version 10.0.0 (clang-1000.11.45.5) but exists in
-                // other versions as well
-                VERIFY( posix_memalign( &mem, 16, size ) == 0 );
+        return ( ( (size_t)block & HEAP_ALIGNMENT ) ? HEAP_HEADER_SPACE : HEAP_ALIGNMENT );
+    }
+
+    // The headers of allocations aligned to more than the heap's alignment, by address.
+    // Open addressing with linear probing, in memory from the system so it doesn't
+    // allocate through itself. There are few of these allocations, pages for pools and
+    // the like, so one lock is enough.
+    class AlignedAllocations
+    {
+    public:
+        void Add( void * ptr, uint64_t header )
+        {
+            Lock();
+            if ( ( ( m_NumEntries + 1 ) * 2 ) > m_Capacity )
+            {
+                Grow();
+            }
+            size_t i = GetSlot( ptr );
+            while ( m_Entries[ i ].m_Ptr )
+            {
+                i = ( ( i + 1 ) & ( m_Capacity - 1 ) );
+            }
+            m_Entries[ i ].m_Ptr = ptr;
+            m_Entries[ i ].m_Header = header;
+            ++m_NumEntries;
+            Unlock();
+        }
+
+        uint64_t Remove( const void * ptr )
+        {
+            Lock();
+            size_t i = Find( ptr );
+            const uint64_t header = m_Entries[ i ].m_Header;
+
+            // Shift back the entries after it that would no longer be found past the gap
+            for ( size_t j = ( ( i + 1 ) & ( m_Capacity - 1 ) ); m_Entries[ j ].m_Ptr; j = ( ( j + 1 ) & ( m_Capacity - 1 ) ) )
+            {
+                const size_t slot = GetSlot( m_Entries[ j ].m_Ptr );
+                if ( ( ( j - slot ) & ( m_Capacity - 1 ) ) >= ( ( j - i ) & ( m_Capacity - 1 ) ) )
+                {
+                    m_Entries[ i ] = m_Entries[ j ];
+                    i = j;
+                }
+            }
+            m_Entries[ i ].m_Ptr = nullptr;
+            --m_NumEntries;
+            Unlock();
+            return header;
+        }
+
+        uint64_t Get( const void * ptr )
+        {
+            Lock();
+            const uint64_t header = m_Entries[ Find( ptr ) ].m_Header;
+            Unlock();
+            return header;
+        }
+
+    private:
+        struct Entry
+        {
+            const void *    m_Ptr;
+            uint64_t        m_Header;
+        };
+
+        size_t GetSlot( const void * ptr ) const
+        {
+            return (size_t)( ( ( (uint64_t)(size_t)ptr >> 5 ) * 0x9E3779B97F4A7C15ULL ) >> 32 ) & ( m_Capacity - 1 );
+        }
+
+        size_t Find( const void * ptr ) const
+        {
+            ASSERT( m_Capacity );
+            size_t i = GetSlot( ptr );
+            while ( m_Entries[ i ].m_Ptr != ptr )
+            {
+                ASSERT( m_Entries[ i ].m_Ptr ); // Not allocated by Alloc
+                i = ( ( i + 1 ) & ( m_Capacity - 1 ) );
+            }
+            return i;
+        }
+
+        void Grow()
+        {
+            Entry * oldEntries = m_Entries;
+            const size_t oldCapacity = m_Capacity;
+            m_Capacity = ( oldCapacity ? ( oldCapacity * 2 ) : 64 );
+            m_Entries = static_cast< Entry * >( calloc( m_Capacity, sizeof( Entry ) ) );
+            ASSERT( m_Entries );
+            for ( size_t j = 0; j < oldCapacity; ++j )
+            {
+                if ( oldEntries[ j ].m_Ptr )
+                {
+                    size_t i = GetSlot( oldEntries[ j ].m_Ptr );
+                    while ( m_Entries[ i ].m_Ptr )
+                    {
+                        i = ( ( i + 1 ) & ( m_Capacity - 1 ) );
+                    }
+                    m_Entries[ i ] = oldEntries[ j ];
+                }
+            }
+            free( oldEntries );
+        }
+
+        void Lock()
+        {
+            // Wait on a plain load so waiters don't take the cache line from the holder,
+            // and yield if the holder has been preempted
+            uint32_t spins = 0;
+            while ( AtomicCompareExchange( &m_Lock, 1u, 0u ) == false )
+            {
+                while ( AtomicLoadRelaxed( &m_Lock ) != 0 )
+                {
+                    if ( spins < LOCK_SPINS )
+                    {
+                        ++spins;
+                        #if defined( __X64__ )
+                            _mm_pause();
+                        #endif
+                    }
+                    else
+                    {
+                        #if defined( __WINDOWS__ )
+                            SwitchToThread();
+                        #else
+                            sched_yield();
+                        #endif
+                    }
+                }
+            }
+        }
+        void Unlock() { AtomicStoreRelease( &m_Lock, 0u ); }
+
+        // Constant initialized, as memory is allocated before static constructors run
+        volatile uint32_t   m_Lock;
+        Entry *             m_Entries;
+        size_t              m_Capacity;
+        size_t              m_NumEntries;
+    };
+    AlignedAllocations g_AlignedAllocations;
+
+    // Allocate from the system heap, with the header if the alignment leaves room for one
+    NO_INLINE void * AllocFromHeap( size_t size, size_t alignment, uint8_t category )
+    {
+        void * mem;
+        if ( alignment <= HEAP_ALIGNMENT )
+        {
+            void * block;
+            #if defined( __LINUX__ ) || defined( __APPLE__ )
+                VERIFY( posix_memalign( &block, HEAP_ALIGNMENT, HEAP_HEADER_SPACE + size ) == 0 );
             #else
-                VERIFY( posix_memalign( &mem, sizeof( void * ), size ) == 0 );
+                block = _aligned_malloc( HEAP_HEADER_SPACE + size, HEAP_ALIGNMENT );
+                __assume( block );
             #endif
-        #else
-            mem = _aligned_malloc( size, sizeof( void * ) );
-            __assume( mem );
-        #endif
+            const size_t offset = GetHeapOffset( block );
+            mem = static_cast< char * >( block ) + offset;
+            GetHeader( mem ) = MakeHeader( size, category, offset );
+        }
+        else
+        {
+            // At least a byte, so every allocation has an address of its own to be found by
+            const size_t blockSize = ( size ? size : 1 );
+            #if defined( __LINUX__ ) || defined( __APPLE__ )
+                VERIFY( posix_memalign( &mem, alignment, blockSize ) == 0 );
+            #else
+                mem = _aligned_malloc( blockSize, alignment );
+                __assume( mem );
+            #endif
+            g_AlignedAllocations.Add( mem, MakeHeader( size, category, 0 ) );
+        }
 
         #ifdef MEM_FILL_NEW_ALLOCATIONS
             MemDebug::FillMem( mem, size, MemDebug::MEM_FILL_NEW_ALLOCATION_PATTERN );
         #endif
+        return mem;
     }
 
-    return mem;
+    // Allocate the header and the memory after it, counted in the category
+    inline void * AllocWithHeader( size_t size, size_t alignment, uint8_t category )
+    {
+        #if defined( __clang__ )
+            // Clang has a bug where class alignment is incorrectly reported, which
+            // results in unsafe mixes of alignment and SSE instruction use, so we
+            // enforce a minimum 16 byte alignment
+            // Last seen in Apple LLVM version 10.0.0 (clang-1000.11.45.5) but exists in
+            // other versions as well
+            alignment = ( alignment < 16 ) ? 16 : alignment;
+        #endif
+
+        MemStats::OnAlloc( category, size );
+
+        #if defined( SMALL_BLOCK_ALLOCATOR_ENABLED )
+            if ( alignment <= SmallBlockAllocator::BUCKET_ALIGNMENT )
+            {
+                const size_t offset = SmallBlockAllocator::BUCKET_ALIGNMENT;
+                void * block = SmallBlockAllocator::Alloc( offset + size, alignment );
+                if ( block )
+                {
+                    void * mem = static_cast< char * >( block ) + offset;
+                    GetHeader( mem ) = MakeHeader( size, category, offset );
+                    return mem;
+                }
+            }
+        #endif
+
+        return AllocFromHeap( size, alignment, category );
+    }
+
+    // The header of any allocation
+    inline uint64_t ReadHeader( void * ptr )
+    {
+        #if defined( SMALL_BLOCK_ALLOCATOR_ENABLED )
+            if ( SmallBlockAllocator::IsBlock( ptr ) )
+            {
+                return GetHeader( ptr );
+            }
+        #endif
+        return IsHeapAllocation( ptr ) ? GetHeader( ptr ) : g_AlignedAllocations.Get( ptr );
+    }
+}
+
+// Alloc
+//------------------------------------------------------------------------------
+void * Alloc( size_t size )
+{
+    return AllocWithHeader( size, sizeof( void * ), MemStats::GetCurrentCategory() );
 }
 
 // Alloc
 //------------------------------------------------------------------------------
 void * Alloc( size_t size, size_t alignment )
 {
-    #if defined( __clang__ )
-        // Clang has a bug where class alignment is incorrectly reported, which
-        // results in unsafe mixes of alignment and SSE instruction use, so we
-        // enforce a minimum 16 byte alignment
-        // Last seen in Apple LLVM version 10.0.0 (clang-1000.11.45.5) but exists in
-        // other versions as well
-        alignment = ( alignment < 16 ) ? 16 : alignment;
-    #endif
+    return AllocWithHeader( size, alignment, MemStats::GetCurrentCategory() );
+}
 
-    void * mem;
+// Realloc
+//------------------------------------------------------------------------------
+// Large blocks are resized in place where possible, or moved by remapping their pages
+// rather than copying, depending on the system allocator. The memory stays in its
+// category.
+void * Realloc( void * ptr, size_t oldSize, size_t size, size_t alignment )
+{
+    if ( ptr == nullptr )
+    {
+        return Alloc( size, alignment );
+    }
+
+    const uint64_t header = ReadHeader( ptr );
+    const uint8_t category = GetHeaderCategory( header );
+    const size_t heldSize = GetHeaderSize( header );
+    ASSERT( oldSize <= heldSize );
+    (void)oldSize;
 
+    // Only heap blocks are resized, those from the SmallBlockAllocator and those aligned
+    // more than the heap need a new allocation and a copy
+    bool copy = ( IsHeapAllocation( ptr ) == false ) || ( alignment > HEAP_ALIGNMENT );
     #if defined( SMALL_BLOCK_ALLOCATOR_ENABLED )
-        mem = SmallBlockAllocator::Alloc( size, alignment );
-        if ( mem == nullptr )
+        copy = ( copy || SmallBlockAllocator::IsBlock( ptr ) );
     #endif
+    if ( copy )
     {
-        #if defined( __LINUX__ ) || defined( __APPLE__ )
-            VERIFY( posix_memalign( &mem, alignment, size ) == 0 );
-        #else
-            mem = _aligned_malloc( size, alignment );
-            __assume( mem );
-        #endif
+        void * mem = AllocWithHeader( size, alignment, category );
+        memcpy( mem, ptr, ( heldSize < size ) ? heldSize : size );
+        Free( ptr );
+        return mem;
+    }
 
-        #ifdef MEM_FILL_NEW_ALLOCATIONS
-            MemDebug::FillMem( mem, size, MemDebug::MEM_FILL_NEW_ALLOCATION_PATTERN );
-        #endif
+    MEMTRACKER_FREE( ptr );
+    MemStats::OnFree( category, heldSize );
+    MemStats::OnAlloc( category, size );
+
+    const size_t oldOffset = GetHeaderOffset( header );
+    void * block = static_cast< char * >( ptr ) - oldOffset;
+    #if defined( __LINUX__ ) || defined( __APPLE__ )
+        block = realloc( block, HEAP_HEADER_SPACE + size );
+        ASSERT( block );
+        ASSERT( ( (size_t)block % HEAP_ALIGNMENT ) == 0 );
+    #else
+        block = _aligned_realloc( block, HEAP_HEADER_SPACE + size, HEAP_ALIGNMENT );
+        __assume( block );
+    #endif
+
+    // The block may have moved to the other side of a 32 byte boundary, in which case the
+    // allocation moves with it. Blocks moved by remapping pages keep their offset.
+    const size_t offset = GetHeapOffset( block );
+    void * mem = static_cast< char * >( block ) + offset;
+    if ( offset != oldOffset )
+    {
+        memmove( mem, static_cast< char * >( block ) + oldOffset, ( heldSize < size ) ? heldSize : size );
     }
 
+    #ifdef MEM_FILL_NEW_ALLOCATIONS
+        const size_t fillStart = Math::RoundUp( heldSize, sizeof( uint64_t ) );
+        if ( size > fillStart )
+        {
+            MemDebug::FillMem( static_cast< char * >( mem ) + fillStart, size - fillStart, MemDebug::MEM_FILL_NEW_ALLOCATION_PATTERN );
+        }
+    #endif
+
+    GetHeader( mem ) = MakeHeader( size, category, offset );
     return mem;
 }
 
@@ -104,6 +404,17 @@ void * Alloc( size_t size, size_t alignment )
     }
 #endif
 
+// ReallocFileLine
+//------------------------------------------------------------------------------
+#if defined( MEMTRACKER_ENABLED )
+    void * ReallocFileLine( void * ptr, size_t oldSize, size_t size, size_t alignment, const char * file, int line )
+    {
+        void * mem = Realloc( ptr, oldSize, size, alignment );
+        MEMTRACKER_ALLOC( mem, size, file, line );
+        return mem;
+    }
+#endif
+
 // Free
 //------------------------------------------------------------------------------
 void Free( void * ptr )
@@ -116,15 +427,43 @@ void Free( void * ptr )
     MEMTRACKER_FREE( ptr );
 
     #if defined( SMALL_BLOCK_ALLOCATOR_ENABLED )
-        if ( SmallBlockAllocator::Free( ptr ) == false )
+        // The block is found without waiting to read the header, which may not be in
+        // the cache
+        if ( SmallBlockAllocator::IsBlock( ptr ) )
+        {
+            const uint64_t header = GetHeader( ptr );
+            MemStats::OnFree( GetHeaderCategory( header ), GetHeaderSize( header ) );
+            VERIFY( SmallBlockAllocator::Free( static_cast< char * >( ptr ) - SmallBlockAllocator::BUCKET_ALIGNMENT ) );
+            return;
+        }
     #endif
+
+    void * block;
+    if ( IsHeapAllocation( ptr ) )
     {
-        #if defined( __LINUX__ ) || defined( __APPLE__ )
-            free( ptr );
-        #else
-            _aligned_free( ptr );
-        #endif
+        const uint64_t header = GetHeader( ptr );
+        MemStats::OnFree( GetHeaderCategory( header ), GetHeaderSize( header ) );
+        block = static_cast< char * >( ptr ) - GetHeaderOffset( header );
+    }
+    else
+    {
+        const uint64_t header = g_AlignedAllocations.Remove( ptr );
+        MemStats::OnFree( GetHeaderCategory( header ), GetHeaderSize( header ) );
+        block = ptr;
     }
+
+    #if defined( __LINUX__ ) || defined( __APPLE__ )
+        free( block );
+    #else
+        _aligned_free( block );
+    #endif
+}
+
+// GetMemCategory
+//------------------------------------------------------------------------------
+uint8_t GetMemCategory( const void * ptr )
+{
+    return GetHeaderCategory( ReadHeader( const_cast< void * >( ptr ) ) );
 }
 
 // Operators
@@ -22,6 +22,7 @@
     #define FDELETE_ARRAY       delete[]
 
     #define ALLOC( ... )        ::AllocFileLine( __VA_ARGS__, __FILE__, __LINE__ )
+    #define REALLOC( ... )      ::ReallocFileLine( __VA_ARGS__, __FILE__, __LINE__ )
     #define FREE( ptr )         ::Free( ptr )
 #else
     #define FNEW( code )        new code
@@ -30,6 +31,7 @@
     #define FDELETE_ARRAY       delete[]
 
     #define ALLOC( ... )        ::Alloc( __VA_ARGS__ )
+    #define REALLOC( ... )      ::Realloc( __VA_ARGS__ )
     #define FREE( ptr )         ::Free( ptr )
 #endif
 
@@ -39,12 +41,17 @@
     // Functions are private when MemTracker is enabled
     void * Alloc( size_t size );
     void * Alloc( size_t size, size_t alignment );
+    void * Realloc( void * ptr, size_t oldSize, size_t size, size_t alignment );
 #else
     void * AllocFileLine( size_t size, const char * file, int line );
     void * AllocFileLine( size_t size, size_t alignment, const char * file, int line );
+    void * ReallocFileLine( void * ptr, size_t oldSize, size_t size, size_t alignment, const char * file, int line );
 #endif
 void Free( void * ptr );
 
+// The MemStats category memory from Alloc is counted in
+[[nodiscard]] uint8_t GetMemCategory( const void * ptr );
+
 // global new/delete
 //------------------------------------------------------------------------------
 #if defined( MEMTRACKER_ENABLED )
@@ -8,7 +8,7 @@
 
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
-MemPoolBlock::MemPoolBlock( size_t blockSize, size_t blockAlignment )
+MemPoolBlock::MemPoolBlock( size_t blockSize, size_t blockAlignment, size_t pageHeaderSize )
     : m_FreeBlockChain( nullptr )
     #ifdef DEBUG
         , m_NumActiveAllocations( 0 )
@@ -17,12 +17,14 @@ MemPoolBlock::MemPoolBlock( size_t blockSize, size_t blockAlignment )
     #endif
     , m_BlockSize( (uint32_t)blockSize )
     , m_BlockAlignment( (uint32_t)blockAlignment )
+    , m_PageHeaderSize( (uint32_t)pageHeaderSize )
     , m_Pages( 0, true )
 {
     ASSERT( blockSize >= sizeof( FreeBlock ) );
     ASSERT( blockSize <= MEMPOOLBLOCK_PAGE_SIZE );
     ASSERT( blockAlignment >= 4 );
     ASSERT( blockAlignment <= MEMPOOLBLOCK_PAGE_SIZE );
+    ASSERT( ( Math::RoundUp( pageHeaderSize, blockAlignment ) + blockSize ) <= MEMPOOLBLOCK_PAGE_SIZE );
 }
 
 // DESTRUCTOR
@@ -106,12 +108,13 @@ NO_INLINE bool MemPoolBlock::AllocPage()
     // sanity check page alignment can support block alignment
     ASSERT( ( (size_t)newPage % m_BlockAlignment ) == 0 );
 
-    // divide page into blocks
+    // divide page into blocks, after the header
     const size_t alignedSize( Math::RoundUp( (size_t)m_BlockSize, (size_t)m_BlockAlignment ) );
-    const size_t numBlocksInPage( MEMPOOLBLOCK_PAGE_SIZE / alignedSize );
+    const size_t firstBlockOffset( Math::RoundUp( (size_t)m_PageHeaderSize, (size_t)m_BlockAlignment ) );
+    const size_t numBlocksInPage( ( MEMPOOLBLOCK_PAGE_SIZE - firstBlockOffset ) / alignedSize );
 
     // build chain into new blocks
-    FreeBlock * block = reinterpret_cast< FreeBlock * >( (size_t)newPage );
+    FreeBlock * block = reinterpret_cast< FreeBlock * >( (size_t)newPage + firstBlockOffset );
     FreeBlock * const firstBlock = block;
     for ( size_t i = 0; i < ( numBlocksInPage - 1 ); ++i )
     {
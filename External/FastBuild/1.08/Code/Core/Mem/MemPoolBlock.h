@@ -11,7 +11,8 @@
 class MemPoolBlock
 {
 public:
-    MemPoolBlock( size_t blockSize, size_t blockAlignment );
+    // pageHeaderSize bytes at the start of each page are left for derived classes to use
+    MemPoolBlock( size_t blockSize, size_t blockAlignment, size_t pageHeaderSize = 0 );
     virtual ~MemPoolBlock();
 
     void *  Alloc();
@@ -42,6 +43,7 @@ protected:
     // internal control params
     uint32_t    m_BlockSize                 = 0;
     uint32_t    m_BlockAlignment            = 0;
+    uint32_t    m_PageHeaderSize            = 0;
 
     // allocated pages
     Array< void * > m_Pages;
@@ -0,0 +1,150 @@
+// MemStats.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "MemStats.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Tracing/Tracing.h"
+
+// system
+#include <string.h>
+
+// Static Data
+//------------------------------------------------------------------------------
+// Constant initialized, as memory is allocated before static constructors run
+/*static*/ volatile uint32_t        MemStats::s_Lock( 0 );
+/*static*/ volatile uint32_t        MemStats::s_NumCategories( 1 );
+/*static*/ const char *             MemStats::s_Names[ MAX_CATEGORIES ] = { "Other" };
+/*static*/ MemStats::Counters       MemStats::s_Counters[ MAX_CATEGORIES ];
+/*static*/ THREAD_LOCAL uint8_t     MemStats::s_CurrentCategory( DEFAULT_CATEGORY );
+/*static*/ THREAD_LOCAL MemStats::ThreadCounters MemStats::s_ThreadCounters[ MAX_CATEGORIES ] = {};
+
+// GetCategory
+//------------------------------------------------------------------------------
+/*static*/ uint8_t MemStats::GetCategory( const char * name )
+{
+    // Spin, as categories are added before static constructors may have run
+    while ( AtomicCompareExchange( &s_Lock, 1u, 0u ) == false )
+    {
+    }
+
+    uint8_t category = DEFAULT_CATEGORY;
+    const uint32_t numCategories = s_NumCategories;
+    uint32_t i = 0;
+    for ( ; i < numCategories; ++i )
+    {
+        if ( strcmp( s_Names[ i ], name ) == 0 )
+        {
+            category = static_cast< uint8_t >( i );
+            break;
+        }
+    }
+    if ( ( i == numCategories ) && ( numCategories < MAX_CATEGORIES ) )
+    {
+        // Named before it's visible to GetNumCategories
+        s_Names[ numCategories ] = name;
+        AtomicStoreRelease( &s_NumCategories, numCategories + 1 );
+        category = static_cast< uint8_t >( numCategories );
+    }
+
+    AtomicStoreRelease( &s_Lock, 0u );
+    return category;
+}
+
+// SetBudget
+//------------------------------------------------------------------------------
+/*static*/ void MemStats::SetBudget( uint8_t category, uint64_t budget )
+{
+    ASSERT( category < MAX_CATEGORIES );
+    AtomicStoreRelaxed( &s_Counters[ category ].m_Budget, budget );
+}
+
+// GetNumCategories
+//------------------------------------------------------------------------------
+/*static*/ uint32_t MemStats::GetNumCategories()
+{
+    return AtomicLoadAcquire( &s_NumCategories );
+}
+
+// GetStats
+//------------------------------------------------------------------------------
+/*static*/ void MemStats::GetStats( uint8_t category, CategoryStats & stats )
+{
+    ASSERT( category < GetNumCategories() );
+    const Counters & counters = s_Counters[ category ];
+    stats.m_Name = s_Names[ category ];
+    const int64_t bytes = AtomicLoadRelaxed( &counters.m_Bytes );
+    const int64_t numAllocs = AtomicLoadRelaxed( &counters.m_NumAllocs );
+    stats.m_Bytes = ( bytes > 0 ) ? (uint64_t)bytes : 0;
+    stats.m_NumAllocs = ( numAllocs > 0 ) ? (uint64_t)numAllocs : 0;
+    stats.m_PeakBytes = AtomicLoadRelaxed( &counters.m_PeakBytes );
+    stats.m_TotalAllocs = AtomicLoadRelaxed( &counters.m_TotalAllocs );
+    stats.m_Budget = AtomicLoadRelaxed( &counters.m_Budget );
+}
+
+// FlushThreadCounters
+//------------------------------------------------------------------------------
+/*static*/ void MemStats::FlushThreadCounters()
+{
+    const uint32_t numCategories = GetNumCategories();
+    for ( uint32_t i = 0; i < numCategories; ++i )
+    {
+        ThreadCounters & counters = s_ThreadCounters[ i ];
+        if ( counters.m_Bytes || counters.m_NumAllocs || counters.m_TotalAllocs )
+        {
+            Flush( static_cast< uint8_t >( i ), counters );
+        }
+    }
+}
+
+// ResetPeaks
+//------------------------------------------------------------------------------
+/*static*/ void MemStats::ResetPeaks()
+{
+    for ( uint32_t i = 0; i < MAX_CATEGORIES; ++i )
+    {
+        Counters & counters = s_Counters[ i ];
+        const int64_t bytes = AtomicLoadRelaxed( &counters.m_Bytes );
+        AtomicStoreRelaxed( &counters.m_PeakBytes, ( bytes > 0 ) ? (uint64_t)bytes : (uint64_t)0 );
+    }
+}
+
+// Flush
+//------------------------------------------------------------------------------
+/*static*/ void MemStats::Flush( uint8_t category, ThreadCounters & threadCounters )
+{
+    Counters & counters = s_Counters[ category ];
+    const int64_t bytes = AtomicAdd( &counters.m_Bytes, threadCounters.m_Bytes );
+    AtomicAdd( &counters.m_NumAllocs, threadCounters.m_NumAllocs );
+    AtomicAdd( &counters.m_TotalAllocs, (uint64_t)threadCounters.m_TotalAllocs );
+    const int64_t previousBytes = ( bytes - threadCounters.m_Bytes );
+    threadCounters = ThreadCounters();
+    if ( bytes <= previousBytes )
+    {
+        return;
+    }
+
+    // Raise the high-water mark, unless another thread raised it higher meanwhile
+    uint64_t peakBytes = AtomicLoadRelaxed( &counters.m_PeakBytes );
+    while ( ( bytes > 0 ) && ( (uint64_t)bytes > peakBytes ) )
+    {
+        if ( AtomicCompareExchange( &counters.m_PeakBytes, (uint64_t)bytes, peakBytes ) )
+        {
+            break;
+        }
+        peakBytes = AtomicLoadRelaxed( &counters.m_PeakBytes );
+    }
+
+    // Warn as the budget is crossed, rather than for every allocation over it
+    const int64_t budget = (int64_t)AtomicLoadRelaxed( &counters.m_Budget );
+    if ( budget && ( bytes > budget ) && ( previousBytes <= budget ) )
+    {
+        OUTPUT( "Warning: Memory category '%s' is over budget, %" PRIi64 " of %" PRIi64 " bytes\n", s_Names[ category ], bytes, budget );
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,160 @@
+// MemStats.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Assert.h"
+#include "Core/Env/Types.h"
+
+// MemStats
+//------------------------------------------------------------------------------
+// Counts the memory allocated in each of a set of categories, such as the systems of a
+// game, so it's known which of them owns memory growth. Counting is always on, in all
+// builds. Each thread counts into its own counters, which are added to the totals once
+// they reach FLUSH_BYTES or FLUSH_ALLOCS, so the totals lag each thread by less than that
+// per category. Threads started by Thread flush their counts as they exit.
+//
+// An allocation is counted in the category current on its thread when it's made, set by
+// a MemCategoryScope or by an allocator for its own memory, and stays in it until freed.
+// Memory that's reallocated stays in its category. Threads start in DEFAULT_CATEGORY, so
+// work handed to another thread should take its category with it and set it there.
+class MemStats
+{
+public:
+    static const uint32_t MAX_CATEGORIES = 32;
+    static const uint8_t DEFAULT_CATEGORY = 0; // "Other", for memory allocated outside any category
+    static const int64_t FLUSH_BYTES = ( 64 * 1024 );
+    static const int64_t FLUSH_ALLOCS = 256;
+
+    // Get the category with the given name, adding it if there isn't one. The name must
+    // outlive MemStats, a string literal usually. When all categories are in use, returns
+    // DEFAULT_CATEGORY.
+    [[nodiscard]] static uint8_t    GetCategory( const char * name );
+
+    // The category the thread's allocations are counted in
+    [[nodiscard]] static inline uint8_t GetCurrentCategory();
+    static inline void              SetCurrentCategory( uint8_t category );
+
+    // Warn when the category's memory grows past a budget in bytes, or 0 for no budget
+    static void                     SetBudget( uint8_t category, uint64_t budget );
+
+    struct CategoryStats
+    {
+        const char *    m_Name;
+        uint64_t        m_Bytes;        // Currently allocated, not counting allocator overhead
+        uint64_t        m_NumAllocs;    // Currently allocated
+        uint64_t        m_PeakBytes;    // High-water mark of m_Bytes since the last ResetPeaks
+        uint64_t        m_TotalAllocs;  // Made since startup, including those freed since
+        uint64_t        m_Budget;       // Or 0 for no budget
+    };
+
+    [[nodiscard]] static uint32_t   GetNumCategories();
+    static void                     GetStats( uint8_t category, CategoryStats & stats );
+
+    // Add the calling thread's counts to the totals
+    static void                     FlushThreadCounters();
+
+    // Start the high-water marks again from the memory allocated now
+    static void                     ResetPeaks();
+
+    // Count memory into and out of a category, for allocators
+    static inline void              OnAlloc( uint8_t category, size_t size );
+    static inline void              OnFree( uint8_t category, size_t size );
+
+private:
+    // Counts not yet added to the totals
+    struct ThreadCounters
+    {
+        int64_t     m_Bytes;
+        int64_t     m_NumAllocs;
+        int64_t     m_TotalAllocs;
+    };
+
+    // Each category's totals on their own cache line, as threads flushing different
+    // categories would otherwise contend. Totals can briefly be negative, when memory is
+    // freed and flushed by one thread before the thread that allocated it flushes.
+    PRAGMA_DISABLE_PUSH_MSVC( 4324 ) // structure was padded due to alignment specifier
+    struct alignas( 64 ) Counters
+    {
+        volatile int64_t    m_Bytes;
+        volatile int64_t    m_NumAllocs;
+        volatile uint64_t   m_PeakBytes;
+        volatile uint64_t   m_TotalAllocs;
+        volatile uint64_t   m_Budget;
+    };
+    PRAGMA_DISABLE_POP_MSVC // 4324
+
+    static void                 Flush( uint8_t category, ThreadCounters & counters );
+
+    static THREAD_LOCAL uint8_t s_CurrentCategory;
+    static THREAD_LOCAL ThreadCounters s_ThreadCounters[ MAX_CATEGORIES ];
+    static volatile uint32_t    s_Lock;
+    static volatile uint32_t    s_NumCategories;
+    static const char *         s_Names[ MAX_CATEGORIES ];
+    static Counters             s_Counters[ MAX_CATEGORIES ];
+};
+
+// GetCurrentCategory
+//------------------------------------------------------------------------------
+/*static*/ inline uint8_t MemStats::GetCurrentCategory()
+{
+    return s_CurrentCategory;
+}
+
+// SetCurrentCategory
+//------------------------------------------------------------------------------
+/*static*/ inline void MemStats::SetCurrentCategory( uint8_t category )
+{
+    ASSERT( category < MAX_CATEGORIES );
+    s_CurrentCategory = category;
+}
+
+// OnAlloc
+//------------------------------------------------------------------------------
+/*static*/ inline void MemStats::OnAlloc( uint8_t category, size_t size )
+{
+    ThreadCounters & counters = s_ThreadCounters[ category ];
+    counters.m_Bytes += (int64_t)size;
+    ++counters.m_NumAllocs;
+    ++counters.m_TotalAllocs;
+    if ( ( counters.m_Bytes >= FLUSH_BYTES ) || ( counters.m_TotalAllocs >= FLUSH_ALLOCS ) )
+    {
+        Flush( category, counters );
+    }
+}
+
+// OnFree
+//------------------------------------------------------------------------------
+/*static*/ inline void MemStats::OnFree( uint8_t category, size_t size )
+{
+    ThreadCounters & counters = s_ThreadCounters[ category ];
+    counters.m_Bytes -= (int64_t)size;
+    --counters.m_NumAllocs;
+    if ( ( counters.m_Bytes <= -FLUSH_BYTES ) || ( counters.m_NumAllocs <= -FLUSH_ALLOCS ) )
+    {
+        Flush( category, counters );
+    }
+}
+
+// MemCategoryScope
+//------------------------------------------------------------------------------
+// Counts the thread's allocations in a category until it goes out of scope
+class MemCategoryScope
+{
+public:
+    explicit MemCategoryScope( uint8_t category )
+        : m_Previous( MemStats::GetCurrentCategory() )
+    {
+        MemStats::SetCurrentCategory( category );
+    }
+    ~MemCategoryScope() { MemStats::SetCurrentCategory( m_Previous ); }
+
+    MemCategoryScope( const MemCategoryScope & ) = delete;
+    MemCategoryScope & operator = ( const MemCategoryScope & ) = delete;
+
+private:
+    uint8_t m_Previous;
+};
+
+//------------------------------------------------------------------------------
@@ -16,7 +16,9 @@
 #if defined( MEMTRACKER_ENABLED )
     // Includes
     //------------------------------------------------------------------------------
+    #include "Core/Mem/Mem.h"
     #include "Core/Mem/MemPoolBlock.h"
+    #include "Core/Mem/MemStats.h"
     #include "Core/Process/Atomic.h"
     #include "Core/Process/Thread.h"
     #include "Core/Tracing/Tracing.h"
@@ -42,6 +44,7 @@
     /*static*/ uint64_t         MemTracker::s_Mutex[];
     /*static*/ MemTracker::Allocation ** MemTracker::s_AllocationHashTable = nullptr;
     /*static*/ MemPoolBlock *   MemTracker::s_Allocations( nullptr );
+    /*static*/ uint8_t          MemTracker::s_Category( 0 );
 
     // Thread-Local Data
     //------------------------------------------------------------------------------
@@ -78,6 +81,7 @@
 
         {
             MutexHolder mh( GetMutex() );
+            const MemCategoryScope scope( s_Category );
 
             Allocation * a = (Allocation *)s_Allocations->Alloc();
             ++s_AllocationCount;
@@ -222,7 +226,10 @@
                 }
                 *dst = 0;
 
-                OUTPUT( "%s(%u): Id %u : %" PRIu64 " bytes @ 0x%016" PRIx64 " (Mem: %s)\n", a->m_File, a->m_Line, id, size, addr, memView );
+                MemStats::CategoryStats category;
+                MemStats::GetStats( GetMemCategory( a->m_Ptr ), category );
+
+                OUTPUT( "%s(%u): Id %u : %" PRIu64 " bytes @ 0x%016" PRIx64 " in %s (Mem: %s)\n", a->m_File, a->m_Line, id, size, addr, category.m_Name, memView );
 
                 ++numAllocs;
                 total += size;
@@ -283,6 +290,10 @@
         // construct primary mutex in-place
         INPLACE_NEW ( &GetMutex() ) Mutex;
 
+        // tracking memory is counted apart from what's tracked
+        s_Category = MemStats::GetCategory( "MemTracker" );
+        const MemCategoryScope scope( s_Category );
+
         // init hash table
         s_AllocationHashTable = new Allocation*[ ALLOCATION_HASH_SIZE ];
         memset( s_AllocationHashTable, 0, ALLOCATION_HASH_SIZE * sizeof( Allocation * ) );
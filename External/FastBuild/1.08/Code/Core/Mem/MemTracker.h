@@ -73,6 +73,7 @@
         static uint64_t         s_Mutex[ sizeof( Mutex ) / sizeof( uint64_t ) ];
         static Allocation **    s_AllocationHashTable;
         static MemPoolBlock *   s_Allocations;
+        static uint8_t          s_Category;     // MemStats category of the tracking's own memory
     };
 
 #endif // MEMTRACKER_ENABLED
@@ -0,0 +1,460 @@
+// ObjectPool.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Forward.h"
+#include "Core/Env/Assert.h"
+#include "Core/Env/Types.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Mem/MemPoolBlock.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Mutex.h"
+
+#if defined( __WINDOWS__ )
+    #include <intrin.h>
+#endif
+
+// ObjectPool
+//------------------------------------------------------------------------------
+// Objects of one type, constructed in place in the blocks of a MemPoolBlock. An object
+// never moves, so pointers to it stay valid until it's destroyed. Each page keeps a bit
+// per block saying whether it holds an object, so ForEach can visit the objects page by
+// page in address order, and ReleaseEmptyPages can give back pages that hold none.
+//
+// A pool is used from one thread unless it's made thread safe. Threads can then
+// create and destroy objects through a ThreadCache each, which keeps its own free
+// blocks and only takes the pool's lock to exchange a batch of them.
+template < class T >
+class ObjectPool : protected MemPoolBlock
+{
+public:
+    explicit ObjectPool( bool threadSafe = false );
+    virtual ~ObjectPool() override;
+
+    ObjectPool( const ObjectPool & other ) = delete;
+    ObjectPool & operator = ( const ObjectPool & other ) = delete;
+
+    template < typename ... ARGS >
+    [[nodiscard]] T *   Create( ARGS && ... args );
+    void                Destroy( T * object );
+
+    // Destroy all objects. Pages are kept to be reused.
+    void                Clear();
+
+    // Free the pages that hold no objects, returning how many were freed. Walks all the
+    // free blocks, so it's for after many objects have been destroyed rather than often.
+    uint32_t            ReleaseEmptyPages();
+
+    // Call func( T & ) for each object, in address order. func may destroy the object it's
+    // given but not create objects, and no other thread may create or destroy them.
+    template < class FUNC >
+    void                ForEach( const FUNC & func );
+    template < class FUNC >
+    void                ForEach( const FUNC & func ) const;
+
+    // Whether a block the pool gave out still holds its object
+    [[nodiscard]] bool      IsLive( const T * object ) const;
+    [[nodiscard]] size_t    GetNumPages() const { return m_Pages.GetSize(); }
+
+    // Free blocks kept by one thread, for a thread safe pool. Must be destroyed before
+    // the pool.
+    class ThreadCache
+    {
+    public:
+        explicit ThreadCache( ObjectPool & pool );
+        ~ThreadCache();
+
+        ThreadCache( const ThreadCache & other ) = delete;
+        ThreadCache & operator = ( const ThreadCache & other ) = delete;
+
+        template < typename ... ARGS >
+        [[nodiscard]] T *   Create( ARGS && ... args );
+        void                Destroy( T * object );
+
+        // Give all the free blocks back to the pool
+        void                Flush();
+
+    private:
+        ObjectPool &    m_Pool;
+        FreeBlock *     m_Blocks;
+        uint32_t        m_NumBlocks;
+    };
+
+protected:
+    static constexpr size_t BLOCK_ALIGNMENT = ( __alignof( T ) > __alignof( FreeBlock ) ) ? __alignof( T ) : __alignof( FreeBlock );
+    static constexpr size_t BLOCK_SIZE = ( ( ( sizeof( T ) > sizeof( FreeBlock ) ) ? sizeof( T ) : sizeof( FreeBlock ) ) + BLOCK_ALIGNMENT - 1 ) & ~( BLOCK_ALIGNMENT - 1 );
+    static constexpr size_t MAX_BLOCKS_PER_PAGE = ( MEMPOOLBLOCK_PAGE_SIZE / BLOCK_SIZE );
+    static constexpr size_t NUM_LIVE_WORDS = ( ( MAX_BLOCKS_PER_PAGE + 63 ) / 64 );
+    static constexpr uint32_t CACHE_BATCH_SIZE = 32; // Blocks a ThreadCache takes or gives back at once
+
+    // Pages are aligned to their size so the page holding a block is found from its
+    // address, and begin with this header
+    struct Page
+    {
+        uint64_t    m_Live[ NUM_LIVE_WORDS ];   // A bit per block holding an object
+        uint32_t    m_NumUsed;                  // Blocks not in the pool's free chain
+    };
+    static constexpr size_t FIRST_BLOCK_OFFSET = ( sizeof( Page ) + BLOCK_ALIGNMENT - 1 ) & ~( BLOCK_ALIGNMENT - 1 );
+    static_assert( ( FIRST_BLOCK_OFFSET + BLOCK_SIZE ) <= MEMPOOLBLOCK_PAGE_SIZE, "Objects are too big for an ObjectPool" );
+
+    virtual void *  AllocateMemoryForPage() override;
+
+    // Move a block out of or back into the free chain, with the lock held
+    FreeBlock *     TakeBlock();
+    void            ReturnBlock( void * block );
+
+    void            SetLive( const T * object, bool live );
+
+    void            Lock()      { if ( m_ThreadSafe ) { m_Mutex.Lock(); } }
+    void            Unlock()    { if ( m_ThreadSafe ) { m_Mutex.Unlock(); } }
+
+    [[nodiscard]] static Page *     GetPage( const void * block );
+    [[nodiscard]] static uint32_t   GetBlockIndex( const void * block );
+    [[nodiscard]] static uint32_t   CountTrailingZeros( uint64_t mask );
+
+    bool    m_ThreadSafe;
+    Mutex   m_Mutex;
+};
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+ObjectPool< T >::ObjectPool( bool threadSafe )
+    : MemPoolBlock( BLOCK_SIZE, BLOCK_ALIGNMENT, sizeof( Page ) )
+    , m_ThreadSafe( threadSafe )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+/*virtual*/ ObjectPool< T >::~ObjectPool()
+{
+    Clear();
+}
+
+// Create
+//------------------------------------------------------------------------------
+template < class T >
+template < typename ... ARGS >
+T * ObjectPool< T >::Create( ARGS && ... args )
+{
+    Lock();
+    FreeBlock * block = TakeBlock();
+    Unlock();
+
+    T * object = INPLACE_NEW ( block ) T( Forward( ARGS, args ) ... );
+    SetLive( object, true );
+    return object;
+}
+
+// Destroy
+//------------------------------------------------------------------------------
+template < class T >
+void ObjectPool< T >::Destroy( T * object )
+{
+    SetLive( object, false );
+    object->~T();
+
+    Lock();
+    ReturnBlock( object );
+    Unlock();
+}
+
+// Clear
+//------------------------------------------------------------------------------
+template < class T >
+void ObjectPool< T >::Clear()
+{
+    ForEach( [ this ]( T & object ) { Destroy( &object ); } );
+}
+
+// ReleaseEmptyPages
+//------------------------------------------------------------------------------
+template < class T >
+uint32_t ObjectPool< T >::ReleaseEmptyPages()
+{
+    Lock();
+
+    // Unlink the blocks of empty pages from the free chain
+    FreeBlock ** link = &m_FreeBlockChain;
+    while ( *link )
+    {
+        if ( GetPage( *link )->m_NumUsed == 0 )
+        {
+            *link = ( *link )->m_Next;
+        }
+        else
+        {
+            link = &( *link )->m_Next;
+        }
+    }
+
+    // Free them, keeping the others in address order
+    uint32_t numReleased = 0;
+    size_t numKept = 0;
+    for ( void * page : m_Pages )
+    {
+        if ( static_cast< Page * >( page )->m_NumUsed == 0 )
+        {
+            FREE( page );
+            ++numReleased;
+        }
+        else
+        {
+            m_Pages[ numKept++ ] = page;
+        }
+    }
+    m_Pages.SetSize( numKept );
+
+    Unlock();
+    return numReleased;
+}
+
+// ForEach
+//------------------------------------------------------------------------------
+template < class T >
+template < class FUNC >
+void ObjectPool< T >::ForEach( const FUNC & func )
+{
+    for ( void * page : m_Pages )
+    {
+        const uint64_t * live = static_cast< Page * >( page )->m_Live;
+        char * firstBlock = static_cast< char * >( page ) + FIRST_BLOCK_OFFSET;
+        for ( size_t word = 0; word < NUM_LIVE_WORDS; ++word )
+        {
+            // Copy the word so func can destroy the object it's given
+            uint64_t bits = live[ word ];
+            while ( bits )
+            {
+                const size_t index = ( word * 64 ) + CountTrailingZeros( bits );
+                bits &= ( bits - 1 );
+                func( *reinterpret_cast< T * >( firstBlock + ( index * BLOCK_SIZE ) ) );
+            }
+        }
+    }
+}
+
+// ForEach (const)
+//------------------------------------------------------------------------------
+template < class T >
+template < class FUNC >
+void ObjectPool< T >::ForEach( const FUNC & func ) const
+{
+    const_cast< ObjectPool * >( this )->ForEach( [ &func ]( const T & object ) { func( object ); } );
+}
+
+// IsLive
+//------------------------------------------------------------------------------
+template < class T >
+bool ObjectPool< T >::IsLive( const T * object ) const
+{
+    const uint32_t index = GetBlockIndex( object );
+    return ( ( GetPage( object )->m_Live[ index / 64 ] >> ( index % 64 ) ) & 1 ) != 0;
+}
+
+// AllocateMemoryForPage
+//------------------------------------------------------------------------------
+template < class T >
+/*virtual*/ void * ObjectPool< T >::AllocateMemoryForPage()
+{
+    void * newPage = ALLOC( MEMPOOLBLOCK_PAGE_SIZE, MEMPOOLBLOCK_PAGE_SIZE );
+    Page * page = static_cast< Page * >( newPage );
+    for ( uint64_t & word : page->m_Live )
+    {
+        word = 0;
+    }
+    page->m_NumUsed = 0;
+
+    // Keep pages in address order for ForEach
+    m_Pages.Append( newPage );
+    for ( void ** it = m_Pages.End() - 1; ( it != m_Pages.Begin() ) && ( *it < *( it - 1 ) ); --it )
+    {
+        void * swap = *it;
+        *it = *( it - 1 );
+        *( it - 1 ) = swap;
+    }
+
+    return newPage;
+}
+
+// TakeBlock
+//------------------------------------------------------------------------------
+template < class T >
+typename ObjectPool< T >::FreeBlock * ObjectPool< T >::TakeBlock()
+{
+    FreeBlock * block = static_cast< FreeBlock * >( MemPoolBlock::Alloc() );
+    ++GetPage( block )->m_NumUsed;
+    return block;
+}
+
+// ReturnBlock
+//------------------------------------------------------------------------------
+template < class T >
+void ObjectPool< T >::ReturnBlock( void * block )
+{
+    --GetPage( block )->m_NumUsed;
+    MemPoolBlock::Free( block );
+}
+
+// SetLive
+//------------------------------------------------------------------------------
+template < class T >
+void ObjectPool< T >::SetLive( const T * object, bool live )
+{
+    const uint32_t index = GetBlockIndex( object );
+    uint64_t * word = &GetPage( object )->m_Live[ index / 64 ];
+    const uint64_t bit = ( (uint64_t)1 << ( index % 64 ) );
+    ASSERT( ( ( *word & bit ) != 0 ) != live ); // Created twice or destroyed twice
+
+    // Blocks in the same word can be in different threads' caches
+    if ( m_ThreadSafe )
+    {
+        if ( live )
+        {
+            AtomicOr( word, bit );
+        }
+        else
+        {
+            AtomicAnd( word, ~bit );
+        }
+    }
+    else
+    {
+        *word = live ? ( *word | bit ) : ( *word & ~bit );
+    }
+}
+
+// GetPage
+//------------------------------------------------------------------------------
+template < class T >
+/*static*/ typename ObjectPool< T >::Page * ObjectPool< T >::GetPage( const void * block )
+{
+    return reinterpret_cast< Page * >( (size_t)block & ~( (size_t)MEMPOOLBLOCK_PAGE_SIZE - 1 ) );
+}
+
+// GetBlockIndex
+//------------------------------------------------------------------------------
+template < class T >
+/*static*/ uint32_t ObjectPool< T >::GetBlockIndex( const void * block )
+{
+    const size_t offset = ( (size_t)block & ( (size_t)MEMPOOLBLOCK_PAGE_SIZE - 1 ) );
+    ASSERT( ( offset >= FIRST_BLOCK_OFFSET ) && ( ( ( offset - FIRST_BLOCK_OFFSET ) % BLOCK_SIZE ) == 0 ) );
+    return (uint32_t)( ( offset - FIRST_BLOCK_OFFSET ) / BLOCK_SIZE );
+}
+
+// CountTrailingZeros
+//------------------------------------------------------------------------------
+template < class T >
+/*static*/ uint32_t ObjectPool< T >::CountTrailingZeros( uint64_t mask )
+{
+    ASSERT( mask );
+    #if defined( __WINDOWS__ )
+        unsigned long index;
+        _BitScanForward64( &index, mask );
+        return static_cast< uint32_t >( index );
+    #else
+        return static_cast< uint32_t >( __builtin_ctzll( mask ) );
+    #endif
+}
+
+// ThreadCache::CONSTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+ObjectPool< T >::ThreadCache::ThreadCache( ObjectPool & pool )
+    : m_Pool( pool )
+    , m_Blocks( nullptr )
+    , m_NumBlocks( 0 )
+{
+    ASSERT( pool.m_ThreadSafe );
+}
+
+// ThreadCache::DESTRUCTOR
+//------------------------------------------------------------------------------
+template < class T >
+ObjectPool< T >::ThreadCache::~ThreadCache()
+{
+    Flush();
+}
+
+// ThreadCache::Create
+//------------------------------------------------------------------------------
+template < class T >
+template < typename ... ARGS >
+T * ObjectPool< T >::ThreadCache::Create( ARGS && ... args )
+{
+    if ( m_Blocks == nullptr )
+    {
+        // Take a batch from the pool
+        m_Pool.Lock();
+        for ( uint32_t i = 0; i < CACHE_BATCH_SIZE; ++i )
+        {
+            FreeBlock * block = m_Pool.TakeBlock();
+            block->m_Next = m_Blocks;
+            m_Blocks = block;
+        }
+        m_Pool.Unlock();
+        m_NumBlocks = CACHE_BATCH_SIZE;
+    }
+
+    FreeBlock * block = m_Blocks;
+    m_Blocks = block->m_Next;
+    --m_NumBlocks;
+
+    T * object = INPLACE_NEW ( block ) T( Forward( ARGS, args ) ... );
+    m_Pool.SetLive( object, true );
+    return object;
+}
+
+// ThreadCache::Destroy
+//------------------------------------------------------------------------------
+template < class T >
+void ObjectPool< T >::ThreadCache::Destroy( T * object )
+{
+    m_Pool.SetLive( object, false );
+    object->~T();
+
+    FreeBlock * block = reinterpret_cast< FreeBlock * >( object );
+    block->m_Next = m_Blocks;
+    m_Blocks = block;
+    ++m_NumBlocks;
+
+    // Give a batch back when holding two
+    if ( m_NumBlocks >= ( CACHE_BATCH_SIZE * 2 ) )
+    {
+        m_Pool.Lock();
+        for ( uint32_t i = 0; i < CACHE_BATCH_SIZE; ++i )
+        {
+            FreeBlock * returned = m_Blocks;
+            m_Blocks = returned->m_Next;
+            m_Pool.ReturnBlock( returned );
+        }
+        m_Pool.Unlock();
+        m_NumBlocks -= CACHE_BATCH_SIZE;
+    }
+}
+
+// ThreadCache::Flush
+//------------------------------------------------------------------------------
+template < class T >
+void ObjectPool< T >::ThreadCache::Flush()
+{
+    if ( m_Blocks == nullptr )
+    {
+        return;
+    }
+
+    m_Pool.Lock();
+    while ( m_Blocks )
+    {
+        FreeBlock * returned = m_Blocks;
+        m_Blocks = returned->m_Next;
+        m_Pool.ReturnBlock( returned );
+    }
+    m_Pool.Unlock();
+    m_NumBlocks = 0;
+}
+
+//------------------------------------------------------------------------------
@@ -7,10 +7,8 @@
 
 // Core
 #include "Core/Env/Types.h"
-#if defined( __WINDOWS__ )
-    #include <Core/Env/WindowsHeader.h>
-#endif
 #include "Core/Math/Conversions.h"
+#include "Core/Mem/LargePages.h"
 #include "Core/Mem/MemDebug.h"
 #include "Core/Mem/MemPoolBlock.h"
 #include "Core/Process/Atomic.h"
@@ -19,10 +17,6 @@
 #include "Core/Strings/AStackString.h"
 #include "Core/Tracing/Tracing.h"
 
-#if !defined( __WINDOWS__ )
-    #include <sys/mman.h>
-#endif
-
 // Defines
 //------------------------------------------------------------------------------
 // An address with the MSB set is not a valid user-space address on Windows, Linux or OSX
@@ -41,6 +35,7 @@
 /*static*/ uint64_t                             SmallBlockAllocator::s_BucketMemBucketMemory[ BUCKET_NUM_BUCKETS * sizeof( MemBucket ) / sizeof (uint64_t) ];
 /*static*/ SmallBlockAllocator::MemBucket *     SmallBlockAllocator::s_Buckets( nullptr );
 /*static*/ uint8_t                              SmallBlockAllocator::s_BucketMappingTable[ BUCKET_MAPPING_TABLE_SIZE ] = { 0 };
+/*static*/ THREAD_LOCAL SmallBlockAllocator::Magazine SmallBlockAllocator::s_Magazines[ BUCKET_NUM_BUCKETS ] = {};
 
 // InitBuckets
 //------------------------------------------------------------------------------
@@ -48,14 +43,10 @@ NO_INLINE void SmallBlockAllocator::InitBuckets()
 {
     ASSERT( s_BucketMemoryStart == MEM_BUCKETS_NOT_INITIALIZED );
 
-    // Reserve the address space for the buckets to manage
-    #if defined( __WINDOWS__ )
-        s_BucketMemoryStart = ::VirtualAlloc( nullptr, BUCKET_ADDRESSSPACE_SIZE, MEM_RESERVE, PAGE_NOACCESS );
-        ASSERT( s_BucketMemoryStart );
-    #else
-        s_BucketMemoryStart = ::mmap( nullptr, BUCKET_ADDRESSSPACE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0 );
-        ASSERT( (size_t)s_BucketMemoryStart != (size_t)-1 );
-    #endif
+    // Reserve the address space for the buckets to manage, where pages are committed
+    // a large page at a time so they can be backed by them
+    s_BucketMemoryStart = LargePages::Reserve( BUCKET_ADDRESSSPACE_SIZE );
+    ASSERT( s_BucketMemoryStart );
 
     // Construct the bucket structures in the reservedspace
     // (Done this way to avoid memory allocations which would be re-entrant)
@@ -87,7 +78,7 @@ NO_INLINE void SmallBlockAllocator::InitBuckets()
         buffer += "    Size |      Num      Mem |      Num      Mem |   LifeTime\n";
         buffer += "-------------------------------------------------------------\n";
 
-        // Print info for eeach bucket
+        // Print info for eeach bucket (blocks cached by threads count as active)
         for ( uint32_t i = 0; i < BUCKET_NUM_BUCKETS; ++i )
         {
             const MemBucket & bucket = s_Buckets[ i ];
@@ -146,13 +137,24 @@ void * SmallBlockAllocator::Alloc( size_t size, size_t align )
     // Sanity check that we're being used safely
     ASSERT( s_ThreadSafeAllocs || ( s_ThreadSafeAllocsDebugOwnerThread == (uint64_t)Thread::GetCurrentThreadId() ) );
 
-        void* ptr;
+    void * ptr;
 
     // Alloc
     if ( s_ThreadSafeAllocs )
     {
-        MutexHolder mh(bucket.m_Mutex);
-        ptr = bucket.Alloc();
+        // From this thread's magazine if it has any blocks
+        Magazine & magazine = s_Magazines[ bucketIndex ];
+        CachedBlock * block = magazine.m_Blocks;
+        if ( block )
+        {
+            magazine.m_Blocks = block->m_Next;
+            --magazine.m_NumBlocks;
+            ptr = block;
+        }
+        else
+        {
+            ptr = RefillMagazine( magazine, bucket );
+        }
     }
     else
     {
@@ -199,19 +201,33 @@ bool SmallBlockAllocator::Free( void * ptr )
     // Free it
     if ( s_ThreadSafeAllocs )
     {
-        bucket.m_Mutex.Lock();
+        // Into this thread's magazine, whichever thread allocated it
+        Magazine & magazine = s_Magazines[ bucketIndex ];
+        CachedBlock * block = static_cast< CachedBlock * >( ptr );
+        block->m_Next = magazine.m_Blocks;
+        magazine.m_Blocks = block;
+        if ( ++magazine.m_NumBlocks >= ( 2 * bucket.m_BatchSize ) )
+        {
+            DrainMagazine( magazine, bucket );
+        }
     }
-
-    bucket.Free( ptr );
-
-    if ( s_ThreadSafeAllocs )
+    else
     {
-        bucket.m_Mutex.Unlock();
+        bucket.Free( ptr );
     }
 
     return true;
 }
 
+// IsBlock
+//------------------------------------------------------------------------------
+/*static*/ bool SmallBlockAllocator::IsBlock( const void * ptr )
+{
+    // As in Free, pointers outside the buckets' address space give an out of range page
+    const size_t pageIndex = (size_t)( ( (const char *)ptr - (const char *)s_BucketMemoryStart ) / MemPoolBlock::MEMPOOLBLOCK_PAGE_SIZE );
+    return ( pageIndex < BUCKET_MAPPING_TABLE_SIZE );
+}
+
 // SetSingleThreadedMode
 //------------------------------------------------------------------------------
 /*static*/ void SmallBlockAllocator::SetSingleThreadedMode( bool singleThreadedMode )
@@ -242,6 +258,139 @@ bool SmallBlockAllocator::Free( void * ptr )
     s_ThreadSafeAllocs = ( !singleThreadedMode );
 }
 
+// FlushThreadCache
+//------------------------------------------------------------------------------
+/*static*/ void SmallBlockAllocator::FlushThreadCache()
+{
+    if ( s_BucketMemoryStart == MEM_BUCKETS_NOT_INITIALIZED )
+    {
+        return; // Nothing can have been cached
+    }
+
+    // Straight into the buckets, as there may not be whole batches
+    for ( size_t i = 0; i < BUCKET_NUM_BUCKETS; ++i )
+    {
+        Magazine & magazine = s_Magazines[ i ];
+        if ( magazine.m_Blocks )
+        {
+            CachedBlock * last = magazine.m_Blocks;
+            while ( last->m_Next )
+            {
+                last = last->m_Next;
+            }
+            MemBucket & bucket = s_Buckets[ i ];
+            MutexHolder mh( bucket.m_Mutex );
+            bucket.FreeChain( magazine.m_Blocks, last, magazine.m_NumBlocks );
+            magazine.m_Blocks = nullptr;
+            magazine.m_NumBlocks = 0;
+        }
+    }
+}
+
+// RefillMagazine
+//------------------------------------------------------------------------------
+// Returns a block for the caller, with the magazine holding the rest of the batch
+/*static*/ NO_INLINE void * SmallBlockAllocator::RefillMagazine( Magazine & magazine, MemBucket & bucket )
+{
+    ASSERT( magazine.m_Blocks == nullptr );
+
+    // A batch given back by another thread, without locking
+    for ( uint32_t i = 0; i < BUCKET_NUM_RETURN_SLOTS; ++i )
+    {
+        const uint32_t slot = (uint32_t)( ( magazine.m_ReturnSlot + i ) % BUCKET_NUM_RETURN_SLOTS );
+        if ( AtomicLoadRelaxed( &bucket.m_ReturnList[ slot ] ) == nullptr )
+        {
+            continue;
+        }
+        CachedBlock * batch = AtomicExchange( &bucket.m_ReturnList[ slot ], static_cast< CachedBlock * >( nullptr ) );
+        if ( batch )
+        {
+            magazine.m_ReturnSlot = slot;
+            magazine.m_Blocks = batch->m_Next;
+            magazine.m_NumBlocks = ( bucket.m_BatchSize - 1 );
+            return batch;
+        }
+    }
+
+    // Otherwise a batch from the bucket, under one lock
+    MutexHolder mh( bucket.m_Mutex );
+    void * ptr = bucket.Alloc();
+    if ( ptr == nullptr )
+    {
+        return nullptr; // Out of address space
+    }
+    for ( uint32_t i = 1; i < bucket.m_BatchSize; ++i )
+    {
+        CachedBlock * block = static_cast< CachedBlock * >( bucket.Alloc() );
+        if ( block == nullptr )
+        {
+            break; // Out of address space, keeping what we have
+        }
+        block->m_Next = magazine.m_Blocks;
+        magazine.m_Blocks = block;
+        ++magazine.m_NumBlocks;
+    }
+    return ptr;
+}
+
+// DrainMagazine
+//------------------------------------------------------------------------------
+// Gives a batch from the front of the magazine back to the bucket
+/*static*/ NO_INLINE void SmallBlockAllocator::DrainMagazine( Magazine & magazine, MemBucket & bucket )
+{
+    ASSERT( magazine.m_NumBlocks >= bucket.m_BatchSize );
+
+    CachedBlock * batch = magazine.m_Blocks;
+    CachedBlock * last = batch;
+    for ( uint32_t i = 1; i < bucket.m_BatchSize; ++i )
+    {
+        last = last->m_Next;
+    }
+    magazine.m_Blocks = last->m_Next;
+    magazine.m_NumBlocks -= bucket.m_BatchSize;
+    last->m_Next = nullptr;
+
+    // Into an empty slot of the return list, without locking
+    for ( uint32_t i = 0; i < BUCKET_NUM_RETURN_SLOTS; ++i )
+    {
+        const uint32_t slot = (uint32_t)( ( magazine.m_ReturnSlot + i ) % BUCKET_NUM_RETURN_SLOTS );
+        if ( ( AtomicLoadRelaxed( &bucket.m_ReturnList[ slot ] ) == nullptr ) &&
+             AtomicCompareExchange( &bucket.m_ReturnList[ slot ], batch, static_cast< CachedBlock * >( nullptr ) ) )
+        {
+            magazine.m_ReturnSlot = slot;
+            return;
+        }
+    }
+
+    // Or into the bucket when the return list is full
+    MutexHolder mh( bucket.m_Mutex );
+    bucket.FreeChain( batch, last, bucket.m_BatchSize );
+}
+
+// MemBucket (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+SmallBlockAllocator::MemBucket::MemBucket( size_t size, size_t align )
+    : MemPoolBlock( size, align )
+    , m_BatchSize( (uint32_t)Math::Clamp<size_t>( BUCKET_BATCH_BYTES / size, 8, 64 ) )
+{
+}
+
+// MemBucket::FreeChain
+//------------------------------------------------------------------------------
+void SmallBlockAllocator::MemBucket::FreeChain( CachedBlock * first, CachedBlock * last, uint32_t numBlocks )
+{
+    #ifdef DEBUG
+        ASSERT( m_NumActiveAllocations >= numBlocks );
+        m_NumActiveAllocations -= numBlocks;
+    #else
+        (void)numBlocks;
+    #endif
+
+    // The free chain links blocks through their first bytes in the same way
+    last->m_Next = reinterpret_cast< CachedBlock * >( m_FreeBlockChain );
+    m_FreeBlockChain = reinterpret_cast< FreeBlock * >( first );
+}
+
 // AllocateMemoryForPage
 //------------------------------------------------------------------------------
 /*virtual*/ void * SmallBlockAllocator::MemBucket::AllocateMemoryForPage()
@@ -263,11 +412,7 @@ bool SmallBlockAllocator::Free( void * ptr )
 
     // Commit the page
     void * newPage = (void *)( ( (size_t)SmallBlockAllocator::s_BucketMemoryStart ) + ( (size_t)pageIndex * MemPoolBlock::MEMPOOLBLOCK_PAGE_SIZE ) );
-    #if defined( __WINDOWS__ )
-        VERIFY( ::VirtualAlloc( newPage, MemPoolBlock::MEMPOOLBLOCK_PAGE_SIZE, MEM_COMMIT, PAGE_READWRITE ) );
-    #else
-        VERIFY( ::mprotect( newPage, MemPoolBlock::MEMPOOLBLOCK_PAGE_SIZE, PROT_READ | PROT_WRITE ) == 0 );
-    #endif
+    LargePages::Commit( newPage, MemPoolBlock::MEMPOOLBLOCK_PAGE_SIZE );
 
     // Update page to bucket mapping table
     ASSERT( s_BucketMappingTable[ pageIndex ] ==  0 );
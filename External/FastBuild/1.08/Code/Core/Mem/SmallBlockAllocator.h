@@ -20,6 +20,7 @@
 // Includes
 //------------------------------------------------------------------------------
 #include "Core/Env/Assert.h"
+#include "Core/Env/Types.h"
 #include "Core/Mem/MemPoolBlock.h"
 #include "Core/Process/Mutex.h"
 
@@ -34,17 +35,21 @@
         // Attempt to free. Returns false if not a bucket owned allocation
         static bool     Free( void * ptr );
 
+        // Whether an allocation belongs to the buckets
+        [[nodiscard]] static bool IsBlock( const void * ptr );
+
         // Hint when operating only on a single thread as we can greatly reduce allocation cost
         static void     SetSingleThreadedMode( bool singleThreadedMode );
 
+        // Give the calling thread's cached free blocks back to be used by other threads.
+        // Threads started by Thread do this as they exit.
+        static void     FlushThreadCache();
+
         #if defined( DEBUG )
             static void DumpStats();
         #endif
 
-    protected:
-        static void InitBuckets();
-
-        static const size_t BUCKET_MAX_ALLOC_SIZE = 256;
+        // Alignment of every block, so the most an allocation from the buckets can ask for
         #if defined( __clang__ )
             // Last seen in Apple LLVM version 10.0.0 (clang-1000.11.45.5) but exists in
             // other versions as well
@@ -52,25 +57,61 @@
         #else
             static const size_t BUCKET_ALIGNMENT = sizeof( void * );
         #endif
+
+    protected:
+        static void InitBuckets();
+
+        // Blocks are chained through their first bytes while free
+        struct CachedBlock
+        {
+            CachedBlock *   m_Next;
+        };
+
+        // Each thread keeps a chain of free blocks for each bucket, so most allocations and
+        // frees don't touch shared state. An empty magazine is refilled with a batch at a time
+        // and a full one gives a batch back.
+        struct Magazine
+        {
+            CachedBlock *   m_Blocks;
+            uint32_t        m_NumBlocks;
+            uint32_t        m_ReturnSlot;   // Where to start looking in the bucket's return list
+        };
+
+        static const size_t BUCKET_MAX_ALLOC_SIZE = 256;
         static const size_t BUCKET_NUM_BUCKETS = ( BUCKET_MAX_ALLOC_SIZE / BUCKET_ALIGNMENT );
         static const size_t BUCKET_ADDRESSSPACE_SIZE = ( 200 * 1024 * 1024 );
         static const size_t BUCKET_NUM_PAGES = ( BUCKET_ADDRESSSPACE_SIZE / MemPoolBlock::MEMPOOLBLOCK_PAGE_SIZE );
         static const size_t BUCKET_MAPPING_TABLE_SIZE  = BUCKET_NUM_PAGES;
+        static const size_t BUCKET_BATCH_BYTES = 4096; // Roughly how much a magazine takes or gives back at once
+        static const size_t BUCKET_NUM_RETURN_SLOTS = 32;
 
         class MemBucket : public MemPoolBlock
         {
         public:
-            MemBucket( size_t size, size_t align ) : MemPoolBlock( size, align ) {}
+            MemBucket( size_t size, size_t align );
 
         protected:
+            // Free a chain of blocks at once, with the mutex held
+            void            FreeChain( CachedBlock * first, CachedBlock * last, uint32_t numBlocks );
+
             virtual void *  AllocateMemoryForPage() override;
 
             friend class SmallBlockAllocator;
             Mutex           m_Mutex;
+
+            // Batches given back by threads' magazines, of m_BatchSize blocks each. A batch
+            // is put in an empty slot or a slot's batch taken whole with a single atomic
+            // operation, without the mutex, and when the slots are full a batch is freed
+            // into the bucket instead.
+            CachedBlock * volatile  m_ReturnList[ BUCKET_NUM_RETURN_SLOTS ] = {};
+            uint32_t                m_BatchSize;
         };
 
         friend class MemBucket;
 
+        static void *   RefillMagazine( Magazine & magazine, MemBucket & bucket );
+        static void     DrainMagazine( Magazine & magazine, MemBucket & bucket );
+
         // Single Threaded Mode
         static bool         s_ThreadSafeAllocs;
         #if defined( ASSERTS_ENABLED )
@@ -88,6 +129,9 @@
 
         // A table to allow 0(1) conversion of any address to the bucket that owns it
         static uint8_t      s_BucketMappingTable[ BUCKET_MAPPING_TABLE_SIZE ];
+
+        // The calling thread's magazines
+        static THREAD_LOCAL Magazine s_Magazines[ BUCKET_NUM_BUCKETS ];
     };
 
 //------------------------------------------------------------------------------
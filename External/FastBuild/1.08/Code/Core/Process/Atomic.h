@@ -74,6 +74,29 @@ inline void AtomicStoreRelease( T * volatile * x, T * value )
         #error Unknown compiler
     #endif
 }
+template < class T >
+inline T * AtomicExchange( T * volatile * x, T * value )
+{
+    #if defined( __GNUC__ ) || defined( __clang__ )
+        return __atomic_exchange_n( x, value, __ATOMIC_ACQ_REL );
+    #elif defined( _MSC_VER )
+        return (T *)_InterlockedExchangePointer( (void * volatile *)x, (void *)value );
+    #else
+        #error Unknown compiler
+    #endif
+}
+// Replace the value with newValue if it's still expectedValue, returning whether it was
+template < class T >
+inline bool AtomicCompareExchange( T * volatile * x, T * newValue, T * expectedValue )
+{
+    #if defined( __GNUC__ ) || defined( __clang__ )
+        return __atomic_compare_exchange_n( x, &expectedValue, newValue, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED );
+    #elif defined( _MSC_VER )
+        return ( _InterlockedCompareExchangePointer( (void * volatile *)x, (void *)newValue, (void *)expectedValue ) == (void *)expectedValue );
+    #else
+        #error Unknown compiler
+    #endif
+}
 
 // Atomic Inc/Dec/Add/Sub
 //------------------------------------------------------------------------------
@@ -147,6 +170,43 @@ inline void AtomicStoreRelease( T * volatile * x, T * value )
     #undef IMPLEMENT_FUNCTIONS
 #endif
 
+// Atomic Or/And (returns result)
+//------------------------------------------------------------------------------
+#if defined( __GNUC__ ) || defined( __clang__ )
+    #if defined( __WINDOWS__ )
+        PRAGMA_DISABLE_PUSH_CLANG( "-Watomic-implicit-seq-cst" )
+    #endif
+    template<typename T> inline T AtomicOr( volatile T * x, T value )
+    {
+        return __sync_or_and_fetch( x, value );
+    }
+    template<typename T> inline T AtomicAnd( volatile T * x, T value )
+    {
+        return __sync_and_and_fetch( x, value );
+    }
+    #if defined( __WINDOWS__ )
+        PRAGMA_DISABLE_POP_CLANG
+    #endif
+#elif defined( _MSC_VER )
+    inline uint32_t AtomicOr( volatile uint32_t * x, uint32_t value )   { return ( static_cast<uint32_t>( _InterlockedOr( reinterpret_cast<volatile long *>( x ), static_cast<long>( value ) ) ) | value ); }
+    inline uint32_t AtomicAnd( volatile uint32_t * x, uint32_t value )  { return ( static_cast<uint32_t>( _InterlockedAnd( reinterpret_cast<volatile long *>( x ), static_cast<long>( value ) ) ) & value ); }
+    inline uint64_t AtomicOr( volatile uint64_t * x, uint64_t value )   { return ( static_cast<uint64_t>( _InterlockedOr64( reinterpret_cast<volatile __int64 *>( x ), static_cast<__int64>( value ) ) ) | value ); }
+    inline uint64_t AtomicAnd( volatile uint64_t * x, uint64_t value )  { return ( static_cast<uint64_t>( _InterlockedAnd64( reinterpret_cast<volatile __int64 *>( x ), static_cast<__int64>( value ) ) ) & value ); }
+#endif
+
+// AtomicCompareExchange
+//------------------------------------------------------------------------------
+// Replace the value with newValue if it's still expectedValue, returning whether it was
+#if defined( __GNUC__ ) || defined( __clang__ )
+    template<typename T> inline bool AtomicCompareExchange( volatile T * x, T newValue, T expectedValue )
+    {
+        return __atomic_compare_exchange_n( x, &expectedValue, newValue, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED );
+    }
+#elif defined( _MSC_VER )
+    inline bool AtomicCompareExchange( volatile uint32_t * x, uint32_t newValue, uint32_t expectedValue )   { return ( static_cast<uint32_t>( _InterlockedCompareExchange( reinterpret_cast<volatile long *>( x ), static_cast<long>( newValue ), static_cast<long>( expectedValue ) ) ) == expectedValue ); }
+    inline bool AtomicCompareExchange( volatile uint64_t * x, uint64_t newValue, uint64_t expectedValue )   { return ( static_cast<uint64_t>( _InterlockedCompareExchange64( reinterpret_cast<volatile __int64 *>( x ), static_cast<__int64>( newValue ), static_cast<__int64>( expectedValue ) ) ) == expectedValue ); }
+#endif
+
 // AtomicLoadRelaxed
 //------------------------------------------------------------------------------
 template<typename T>
@@ -5,7 +5,10 @@
 //------------------------------------------------------------------------------
 #include "Thread.h"
 #include "Core/Env/Assert.h"
+#include "Core/Mem/FrameArena.h"
 #include "Core/Mem/Mem.h"
+#include "Core/Mem/MemStats.h"
+#include "Core/Mem/SmallBlockAllocator.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Profile/Profile.h"
 
@@ -79,10 +82,20 @@ public:
         FDELETE( originalInfo );
 
         // enter into real thread function
+        const uint32_t result = (*realFunction)( realUserData );
+
+        // Free blocks cached for this thread, its frame memory, and its memory counts would
+        // otherwise be lost with it
+        #if defined( SMALL_BLOCK_ALLOCATOR_ENABLED )
+            SmallBlockAllocator::FlushThreadCache();
+        #endif
+        FrameArena::FreeThreadMemory();
+        MemStats::FlushThreadCounters();
+
         #if defined( __WINDOWS__ )
-            return (*realFunction)( realUserData );
+            return result;
         #else
-            return (void *)(size_t)( (*realFunction)( realUserData ) );
+            return (void *)(size_t)result;
         #endif
     }
 };
@@ -20,24 +20,22 @@
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 AString::AString()
-    : m_Contents( const_cast<char *>( s_EmptyString ) ) // cast to allow pointing to protected string
-    , m_Length( 0 )
-    , m_ReservedAndFlags( 0 )
 {
+    SetEmptySmallString();
 }
 
 // CONSTRUCTOR (uint32_t)
 //------------------------------------------------------------------------------
 AString::AString( uint32_t reserve )
 {
-    char * mem = const_cast<char *>( s_EmptyString ); // cast to allow pointing to protected string
-    if ( reserve > 0 )
+    if ( reserve <= SMALL_STRING_RESERVED )
     {
-        reserve = Math::RoundUp( reserve, (uint32_t)2 );
-        mem = (char *)ALLOC( reserve + 1 );
-        mem[ 0 ] = '\000';
+        SetEmptySmallString();
+        return;
     }
-    m_Contents = mem;
+    reserve = Math::RoundUp( reserve, (uint32_t)2 );
+    m_Contents = (char *)ALLOC( reserve + 1 );
+    m_Contents[ 0 ] = '\000';
     m_Length = 0;
     SetReserved( reserve, true );
 }
@@ -47,10 +45,7 @@ AString::AString( uint32_t reserve )
 AString::AString( const AString & string )
 {
     const uint32_t len = string.GetLength();
-    m_Length = len;
-    const uint32_t reserved = Math::RoundUp( len, (uint32_t)2 );
-    m_Contents = (char *)ALLOC( reserved + 1 );
-    SetReserved( reserved, true );
+    InitForLength( len );
     Copy( string.Get(), m_Contents, len ); // handles terminator (NOTE: Using len to support embedded nuls)
 }
 
@@ -62,9 +57,7 @@ AString::AString( AString && string )
     if ( string.MemoryMustBeFreed() == false )
     {
         // Copy
-        m_Contents = const_cast<char*>( s_EmptyString ); // cast to allow pointing to protected string
-        m_Length = 0;
-        m_ReservedAndFlags = 0;
+        SetEmptySmallString();
         Assign( string );
     }
     else
@@ -76,9 +69,7 @@ AString::AString( AString && string )
     }
 
     // Clear other string
-    string.m_Contents = const_cast<char*>( s_EmptyString );
-    string.m_Length = 0;
-    string.m_ReservedAndFlags = 0;
+    string.SetEmptySmallString();
 }
 
 // CONSTRUCTOR (const char *)
@@ -87,10 +78,7 @@ AString::AString( const char * string )
 {
     ASSERT( string );
     const uint32_t len = (uint32_t)StrLen( string );
-    m_Length = len;
-    const uint32_t reserved = Math::RoundUp( len, (uint32_t)2 );
-    m_Contents = (char *)ALLOC( reserved + 1 );
-    SetReserved( reserved, true );
+    InitForLength( len );
     Copy( string, m_Contents ); // copy handles terminator
 }
 
@@ -101,10 +89,7 @@ AString::AString( const char * start, const char * end )
     ASSERT( start );
     ASSERT( end >= start );
     const uint32_t len = uint32_t( end - start );
-    m_Length = len;
-    const uint32_t reserved = Math::RoundUp( len, (uint32_t)2 );
-    m_Contents = (char *)ALLOC( reserved + 1 );
-    SetReserved( reserved, true );
+    InitForLength( len );
     Copy( start, m_Contents, len ); // copy handles terminator
 }
 
@@ -128,8 +113,11 @@ AString::~AString()
         // if we don't own the memory, either:
         // a) We are an empty string, pointing to the special global empty string
         // OR:
-        // b) We are a StackString, and we should point to our internal buffer
+        // b) We are a short string, held in our own small storage
+        // OR:
+        // c) We are a StackString, and we should point to our internal buffer
         ASSERT( ( m_Contents == s_EmptyString ) ||
+                ( m_Contents == m_SmallStorage ) ||
                 ( (void *)m_Contents == (void *)( (char *)this + sizeof( AString ) ) ) );
     }
 }
@@ -453,9 +441,7 @@ void AString::Assign( AString && string )
     }
 
     // Clear other string
-    string.m_Contents = const_cast<char*>( s_EmptyString );
-    string.m_Length = 0;
-    string.m_ReservedAndFlags = 0;
+    string.SetEmptySmallString();
 }
 
 // Clear
@@ -483,9 +469,7 @@ void AString::ClearAndFreeMemory()
         FREE( m_Contents );
 
         // Reset to new empty string state
-        m_Contents = const_cast<char*>( s_EmptyString );
-        m_Length = 0;
-        m_ReservedAndFlags = 0;
+        SetEmptySmallString();
     }
     else
     {
@@ -1448,6 +1432,23 @@ void AString::Grow( uint32_t newLength )
     SetReserved( reserve, true );
 }
 
+// InitForLength
+//------------------------------------------------------------------------------
+// Point a string being constructed at memory for len characters, which the caller fills
+void AString::InitForLength( uint32_t len )
+{
+    m_Length = len;
+    if ( len <= SMALL_STRING_RESERVED )
+    {
+        m_Contents = m_SmallStorage;
+        SetReserved( SMALL_STRING_RESERVED, false );
+        return;
+    }
+    const uint32_t reserved = Math::RoundUp( len, (uint32_t)2 );
+    m_Contents = (char *)ALLOC( reserved + 1 );
+    SetReserved( reserved, true );
+}
+
 // GrowNoCopy
 //------------------------------------------------------------------------------
 void AString::GrowNoCopy( uint32_t newLength )
@@ -184,17 +184,29 @@ protected:
     enum : uint32_t { MEM_MUST_BE_FREED_FLAG    = 0x00000001 };
     enum : uint32_t { RESERVED_MASK             = 0xFFFFFFFE };
 
+    // Strings this short are kept in the string itself rather than allocated
+    enum : uint32_t { SMALL_STRING_RESERVED     = 14 };
+
     void SetReserved( uint32_t reserved, bool mustFreeMemory )
     {
         ASSERT( ( reserved & MEM_MUST_BE_FREED_FLAG ) == 0 ); // ensure reserved does not use lower bit
         m_ReservedAndFlags = ( reserved ^ ( mustFreeMemory ? (uint32_t)MEM_MUST_BE_FREED_FLAG : 0 ) );
     }
+    void SetEmptySmallString()
+    {
+        m_Contents = m_SmallStorage;
+        m_Contents[ 0 ] = '\000';
+        m_Length = 0;
+        SetReserved( SMALL_STRING_RESERVED, false );
+    }
+    void InitForLength( uint32_t len );
     NO_INLINE void Grow( uint32_t newLen );     // Grow capacity, transferring existing string data (for concatenation)
     NO_INLINE void GrowNoCopy( uint32_t newLen ); // Grow capacity, discarding existing string data (for assignment/construction)
 
     char *      m_Contents;         // always points to valid null terminated string (even when empty)
     uint32_t    m_Length;           // length in characters
     uint32_t    m_ReservedAndFlags; // reserved space in characters (even) and least significant bit used for static flag
+    char        m_SmallStorage[ SMALL_STRING_RESERVED + 2 ]; // rounded up so derived members follow with no gap
 
     static const char * const   s_EmptyString;
     static const AString    s_EmptyAString;